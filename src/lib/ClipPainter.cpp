@@ -14,6 +14,8 @@
 
 #include <cmath>
 
+#include <QtCore/QPair>
+
 #include "MarbleDebug.h"
 
 // #define DEBUG_DRAW_NODES
@@ -46,6 +48,21 @@ class ClipPainterPrivate
     QPointF    m_currentPoint;
     QPointF    m_previousPoint; 
 
+    // The clipped poly objects are kept across calls so that their memory
+    // gets reused: all points are stored back to back in m_clippedPoints,
+    // m_clippedPolyObjects holds the start index and size of each object.
+    QPolygonF                 m_clippedPoints;
+    QVector<QPair<int, int> > m_clippedPolyObjects;
+    int                       m_clippedPolyObjectStart;
+
+    enum BoundingBoxTest {
+        Outside,
+        Inside,
+        Intersecting
+    };
+
+    inline BoundingBoxTest boundingBoxTest( const QPolygonF & polygon ) const;
+
     inline int sector( const QPointF & point ) const;
 
     inline QPointF clipTop( qreal m, const QPointF & point ) const;
@@ -56,23 +73,14 @@ class ClipPainterPrivate
     inline void initClipRect();
 
     inline void clipPolyObject ( const QPolygonF & sourcePolygon, 
-                                 QVector<QPolygonF> & clippedPolyObjects,
                                  bool isClosed );
+    inline void finishPolyObject();
 
-    inline void clipMultiple( QPolygonF & clippedPolyObject,
-                              QVector<QPolygonF> & clippedPolyObjects,
-                              bool isClosed );
-    inline void clipOnce( QPolygonF & clippedPolyObject,
-                              QVector<QPolygonF> & clippedPolyObjects,
-                              bool isClosed );
-    inline void clipOnceCorner( QPolygonF & clippedPolyObject,
-                                QVector<QPolygonF> & clippedPolyObjects,
-                                const QPointF& corner,
-                                const QPointF& point,
-                                bool isClosed );
-    inline void clipOnceEdge(   QPolygonF & clippedPolyObject,
-                                QVector<QPolygonF> & clippedPolyObjects,
-                                const QPointF& point,
+    inline void clipMultiple();
+    inline void clipOnce( bool isClosed );
+    inline void clipOnceCorner( const QPointF& corner,
+                                const QPointF& point );
+    inline void clipOnceEdge(   const QPointF& point,
                                 bool isClosed );
 
 
@@ -87,7 +95,7 @@ class ClipPainterPrivate
     inline qreal _m( const QPointF & start, const QPointF & end ) const;
 
 #ifdef DEBUG_DRAW_NODES
-    void debugDrawNodes( const QPolygonF & ); 
+    void debugDrawNodes( const QPointF * points, int size ); 
 #endif
 
     qreal m_labelAreaMargin;
@@ -138,18 +146,27 @@ void ClipPainter::drawPolygon ( const QPolygonF & polygon,
 {
     d->initClipRect();
 
-    if ( d->m_doClip ) {	
-        QVector<QPolygonF> clippedPolyObjects;
+    const ClipPainterPrivate::BoundingBoxTest boundingBoxTest = d->m_doClip
+                                                               ? d->boundingBoxTest( polygon )
+                                                               : ClipPainterPrivate::Inside;
+
+    if ( boundingBoxTest == ClipPainterPrivate::Outside ) {
+        // A polygon whose bounding box misses the viewport can't cover it either.
+        return;
+    }
 
-        d->clipPolyObject( polygon, clippedPolyObjects, true );
+    if ( boundingBoxTest == ClipPainterPrivate::Intersecting ) {
+        d->clipPolyObject( polygon, true );
 
-        foreach( const QPolygonF & clippedPolyObject, clippedPolyObjects ) { 
-            if ( clippedPolyObject.size() > 2 ) {
-                // mDebug() << "Size: " << clippedPolyObject.size();
-                QPainter::drawPolygon ( clippedPolyObject, fillRule );
+        for ( int i = 0; i < d->m_clippedPolyObjects.size(); ++i ) {
+            const QPointF *points = d->m_clippedPoints.constData() + d->m_clippedPolyObjects.at( i ).first;
+            const int size = d->m_clippedPolyObjects.at( i ).second;
+            if ( size > 2 ) {
+                // mDebug() << "Size: " << size;
+                QPainter::drawPolygon ( points, size, fillRule );
                 // mDebug() << "done";
                 #ifdef DEBUG_DRAW_NODES
-                    d->debugDrawNodes( clippedPolyObject );
+                    d->debugDrawNodes( points, size );
                 #endif
             }
         }
@@ -158,7 +175,7 @@ void ClipPainter::drawPolygon ( const QPolygonF & polygon,
         QPainter::drawPolygon ( polygon, fillRule );
 
         #ifdef DEBUG_DRAW_NODES
-            d->debugDrawNodes( polygon );
+            d->debugDrawNodes( polygon.constData(), polygon.size() );
         #endif
     }
 }
@@ -167,19 +184,27 @@ void ClipPainter::drawPolyline( const QPolygonF & polygon )
 {
     d->initClipRect();
 
-    if ( d->m_doClip ) {
-        QVector<QPolygonF> clippedPolyObjects;
+    const ClipPainterPrivate::BoundingBoxTest boundingBoxTest = d->m_doClip
+                                                               ? d->boundingBoxTest( polygon )
+                                                               : ClipPainterPrivate::Inside;
+
+    if ( boundingBoxTest == ClipPainterPrivate::Outside ) {
+        return;
+    }
 
-        d->clipPolyObject( polygon, clippedPolyObjects, false );
+    if ( boundingBoxTest == ClipPainterPrivate::Intersecting ) {
+        d->clipPolyObject( polygon, false );
 
-        foreach( const QPolygonF & clippedPolyObject, clippedPolyObjects ) { 
-            if ( clippedPolyObject.size() > 1 ) {
-                // mDebug() << "Size: " << clippedPolyObject.size();
-                QPainter::drawPolyline ( clippedPolyObject );
+        for ( int i = 0; i < d->m_clippedPolyObjects.size(); ++i ) {
+            const QPointF *points = d->m_clippedPoints.constData() + d->m_clippedPolyObjects.at( i ).first;
+            const int size = d->m_clippedPolyObjects.at( i ).second;
+            if ( size > 1 ) {
+                // mDebug() << "Size: " << size;
+                QPainter::drawPolyline ( points, size );
                 // mDebug() << "done";
 
                 #ifdef DEBUG_DRAW_NODES
-                    d->debugDrawNodes( clippedPolyObject );
+                    d->debugDrawNodes( points, size );
                 #endif
             }
         }
@@ -188,7 +213,7 @@ void ClipPainter::drawPolyline( const QPolygonF & polygon )
         QPainter::drawPolyline( polygon );
 
         #ifdef DEBUG_DRAW_NODES
-            d->debugDrawNodes( polygon );
+            d->debugDrawNodes( polygon.constData(), polygon.size() );
         #endif
     }
 }
@@ -198,23 +223,31 @@ void ClipPainter::drawPolyline( const QPolygonF & polygon, QVector<QPointF>& lab
 {
     d->initClipRect();
 
-    if ( d->m_doClip ) {
- 
-        QVector<QPolygonF> clippedPolyObjects;
+    const ClipPainterPrivate::BoundingBoxTest boundingBoxTest = d->m_doClip
+                                                               ? d->boundingBoxTest( polygon )
+                                                               : ClipPainterPrivate::Inside;
+
+    if ( boundingBoxTest == ClipPainterPrivate::Outside ) {
+        return;
+    }
 
-        d->clipPolyObject( polygon, clippedPolyObjects, false );
+    if ( boundingBoxTest == ClipPainterPrivate::Intersecting ) {
+        d->clipPolyObject( polygon, false );
 
-        foreach( const QPolygonF & clippedPolyObject, clippedPolyObjects ) { 
-            if ( clippedPolyObject.size() > 1 ) {
-                // mDebug() << "Size: " << clippedPolyObject.size();
-                QPainter::drawPolyline ( clippedPolyObject );
+        for ( int i = 0; i < d->m_clippedPolyObjects.size(); ++i ) {
+            const int start = d->m_clippedPolyObjects.at( i ).first;
+            const int size = d->m_clippedPolyObjects.at( i ).second;
+            if ( size > 1 ) {
+                // mDebug() << "Size: " << size;
+                QPainter::drawPolyline ( d->m_clippedPoints.constData() + start, size );
                 // mDebug() << "done";
 
                 #ifdef DEBUG_DRAW_NODES
-                    d->debugDrawNodes( clippedPolyObject );
+                    d->debugDrawNodes( d->m_clippedPoints.constData() + start, size );
                 #endif
 
-                d->labelPosition( clippedPolyObject, labelNodes, positionFlags );
+                d->labelPosition( QPolygonF( d->m_clippedPoints.mid( start, size ) ),
+                                  labelNodes, positionFlags );
             }
         }
     }
@@ -222,7 +255,7 @@ void ClipPainter::drawPolyline( const QPolygonF & polygon, QVector<QPointF>& lab
         QPainter::drawPolyline( polygon );
 
         #ifdef DEBUG_DRAW_NODES
-            d->debugDrawNodes( polygon );
+            d->debugDrawNodes( polygon.constData(), polygon.size() );
         #endif
 
         d->labelPosition( polygon, labelNodes, positionFlags );
@@ -351,9 +384,14 @@ ClipPainterPrivate::ClipPainterPrivate( ClipPainter * parent )
       m_previousSector(4),
       m_currentPoint(QPointF()),
       m_previousPoint(QPointF()), 
+      m_clippedPolyObjectStart(0),
       m_labelAreaMargin(10.0)
 {
     q = parent;
+
+    // reserve() makes resize( 0 ) keep the allocated memory
+    m_clippedPoints.reserve( 256 );
+    m_clippedPolyObjects.reserve( 16 );
 }
 
 void ClipPainterPrivate::initClipRect ()
@@ -400,6 +438,28 @@ QPointF ClipPainterPrivate::clipRight( qreal m, const QPointF & point ) const
     return QPointF( m_right, ( m_right - point.x() ) * m + point.y() );
 }
 
+ClipPainterPrivate::BoundingBoxTest ClipPainterPrivate::boundingBoxTest( const QPolygonF & polygon ) const
+{
+    if ( polygon.isEmpty() ) {
+        return Outside;
+    }
+
+    const QRectF box = polygon.boundingRect();
+
+    if ( box.right() < m_left || box.left() > m_right
+         || box.bottom() < m_top || box.top() > m_bottom ) {
+        return Outside;
+    }
+
+    // Same bounds as sector(): points on the clip rect count as onscreen.
+    if ( box.left() >= m_left && box.right() <= m_right
+         && box.top() >= m_top && box.bottom() <= m_bottom ) {
+        return Inside;
+    }
+
+    return Intersecting;
+}
+
 int ClipPainterPrivate::sector( const QPointF & point ) const
 {
     // If we think of the image borders as (infinitely long) parallel
@@ -433,14 +493,15 @@ int ClipPainterPrivate::sector( const QPointF & point ) const
 }
 
 void ClipPainterPrivate::clipPolyObject ( const QPolygonF & polygon, 
-                                          QVector<QPolygonF> & clippedPolyObjects,
                                           bool isClosed )
 {
     //	mDebug() << "ClipPainter enabled." ;
 
     // Only create a new polyObject as soon as we know for sure that 
     // the current point is on the screen. 
-    QPolygonF clippedPolyObject = QPolygonF();
+    m_clippedPoints.resize( 0 );
+    m_clippedPolyObjects.resize( 0 );
+    m_clippedPolyObjectStart = 0;
 
     const QVector<QPointF>::const_iterator  itStartPoint = polygon.constBegin();
     const QVector<QPointF>::const_iterator  itEndPoint   = polygon.constEnd();
@@ -479,14 +540,14 @@ void ClipPainterPrivate::clipPolyObject ( const QPolygonF & polygon,
                 // screen but not both. Hence we only need to clip once and require
                 // only one interpolation for both cases.
 
-                clipOnce( clippedPolyObject, clippedPolyObjects, isClosed );
+                clipOnce( isClosed );
             }
             else {
                 // This case mostly deals with lines that reach from one
                 // sector that is located off screen to another one that
                 // is located off screen. In this situation the line 
                 // can get clipped once, twice, or not at all.
-                clipMultiple( clippedPolyObject, clippedPolyObjects, isClosed );
+                clipMultiple();
             }
 
             m_previousSector = m_currentSector;
@@ -495,7 +556,7 @@ void ClipPainterPrivate::clipPolyObject ( const QPolygonF & polygon,
         // If the current point is onscreen, just add it to our final polygon.
         if ( m_currentSector == 4 ) {
 
-            clippedPolyObject << m_currentPoint;
+            m_clippedPoints << m_currentPoint;
 #ifdef MARBLE_DEBUG
             ++(m_debugNodeCount);
 #endif
@@ -517,20 +578,21 @@ void ClipPainterPrivate::clipPolyObject ( const QPolygonF & polygon,
         }
     }
 
-    // Only add the pointer if there's node data available.
-    if ( !clippedPolyObject.isEmpty() ) {
-        clippedPolyObjects << clippedPolyObject;
+    // Only add the poly object if there's node data available.
+    if ( m_clippedPoints.size() > m_clippedPolyObjectStart ) {
+        finishPolyObject();
     }
 }
 
-
-void ClipPainterPrivate::clipMultiple( QPolygonF & clippedPolyObject,
-                                       QVector<QPolygonF> & clippedPolyObjects,
-                                       bool isClosed )
+void ClipPainterPrivate::finishPolyObject()
 {
-    Q_UNUSED( clippedPolyObjects )
-    Q_UNUSED( isClosed )
+    m_clippedPolyObjects << qMakePair( m_clippedPolyObjectStart,
+                                       m_clippedPoints.size() - m_clippedPolyObjectStart );
+}
+
 
+void ClipPainterPrivate::clipMultiple()
+{
     // Take care of adding nodes in the image corners if the iterator 
     // traverses off screen sections.
 
@@ -544,14 +606,14 @@ void ClipPainterPrivate::clipMultiple( QPolygonF & clippedPolyObject,
             QPointF pointLeft = clipLeft( m, m_currentPoint );
 
             if ( pointRight.y() > m_top ) {
-                clippedPolyObject << pointRight;
+                m_clippedPoints << pointRight;
             } else {
-                clippedPolyObject << QPointF( m_right, m_top );
+                m_clippedPoints << QPointF( m_right, m_top );
             }
             if ( pointTop.x() >= m_left && pointTop.x() < m_right )
-                clippedPolyObject << pointTop;
+                m_clippedPoints << pointTop;
             if ( pointLeft.y() > m_top ) 
-                clippedPolyObject << pointLeft;
+                m_clippedPoints << pointLeft;
         }
         else if ( m_previousSector == 7 ) {
             QPointF pointBottom = clipBottom( m, m_previousPoint );
@@ -559,14 +621,14 @@ void ClipPainterPrivate::clipMultiple( QPolygonF & clippedPolyObject,
             QPointF pointLeft = clipLeft( m, m_currentPoint );
 
             if ( pointBottom.x() > m_left ) {
-                clippedPolyObject << pointBottom;
+                m_clippedPoints << pointBottom;
             } else {
-                clippedPolyObject << QPointF( m_left, m_bottom );
+                m_clippedPoints << QPointF( m_left, m_bottom );
             }
             if ( pointLeft.y() >= m_top && pointLeft.y() < m_bottom ) 
-                clippedPolyObject << pointLeft;
+                m_clippedPoints << pointLeft;
             if ( pointTop.x() > m_left )
-                clippedPolyObject << pointTop;
+                m_clippedPoints << pointTop;
         }
         else if ( m_previousSector == 8 ) {
             QPointF pointBottom = clipBottom( m, m_previousPoint );
@@ -575,21 +637,21 @@ void ClipPainterPrivate::clipMultiple( QPolygonF & clippedPolyObject,
             QPointF pointLeft = clipLeft( m, m_currentPoint );
 
             if ( pointBottom.x() > m_left && pointBottom.x() < m_right )
-                clippedPolyObject << pointBottom;
+                m_clippedPoints << pointBottom;
             if ( pointRight.y() > m_top && pointRight.y() < m_bottom ) 
-                clippedPolyObject << pointRight;
+                m_clippedPoints << pointRight;
             if ( pointTop.x() > m_left && pointTop.x() < m_right ) 
-                clippedPolyObject << pointTop;
+                m_clippedPoints << pointTop;
             if ( pointLeft.y() > m_top && pointLeft.y() < m_bottom ) 
-                clippedPolyObject << pointLeft;
+                m_clippedPoints << pointLeft;
    
             if ( pointBottom.x() <= m_left && pointLeft.y() >= m_bottom )
-                clippedPolyObject << QPointF( m_left, m_bottom );
+                m_clippedPoints << QPointF( m_left, m_bottom );
             if ( pointTop.x() >= m_right && pointRight.y() <= m_top )
-                clippedPolyObject << QPointF( m_right, m_top );
+                m_clippedPoints << QPointF( m_right, m_top );
         }
 
-        clippedPolyObject << QPointF( m_left, m_top );
+        m_clippedPoints << QPointF( m_left, m_top );
         break;
 
     case 1:
@@ -598,24 +660,24 @@ void ClipPainterPrivate::clipMultiple( QPolygonF & clippedPolyObject,
             QPointF pointTop = clipTop( m, m_currentPoint );
 
             if ( pointLeft.y() > m_top ) {
-                clippedPolyObject << pointLeft;
+                m_clippedPoints << pointLeft;
             } else {
-                clippedPolyObject << QPointF( m_left, m_top );
+                m_clippedPoints << QPointF( m_left, m_top );
             }
             if ( pointTop.x() > m_left )
-                clippedPolyObject << pointTop;
+                m_clippedPoints << pointTop;
         }
         else if ( m_previousSector == 5 ) {
             QPointF pointRight = clipRight( m, m_previousPoint );
             QPointF pointTop = clipTop( m, m_currentPoint );
 
             if ( pointRight.y() > m_top ) {
-                clippedPolyObject << pointRight;
+                m_clippedPoints << pointRight;
             } else {
-                clippedPolyObject << QPointF( m_right, m_top );
+                m_clippedPoints << QPointF( m_right, m_top );
             }
             if ( pointTop.x() < m_right )
-                clippedPolyObject << pointTop;
+                m_clippedPoints << pointTop;
         }
         else if ( m_previousSector == 6 ) {
             QPointF pointBottom = clipBottom( m, m_previousPoint );
@@ -623,18 +685,18 @@ void ClipPainterPrivate::clipMultiple( QPolygonF & clippedPolyObject,
             QPointF pointTop = clipTop( m, m_currentPoint );
 
             if ( pointBottom.x() > m_left )
-                clippedPolyObject << pointBottom;
+                m_clippedPoints << pointBottom;
             if ( pointLeft.y() > m_top && pointLeft.y() <= m_bottom ) 
-                clippedPolyObject << pointLeft;
+                m_clippedPoints << pointLeft;
             if ( pointTop.x() > m_left ) {
-                clippedPolyObject << pointTop;
+                m_clippedPoints << pointTop;
             } else {
-                clippedPolyObject << QPointF( m_left, m_top );
+                m_clippedPoints << QPointF( m_left, m_top );
             }
         }
         else if ( m_previousSector == 7 ) {
-            clippedPolyObject << clipBottom( m, m_previousPoint );
-            clippedPolyObject << clipTop( m, m_currentPoint );
+            m_clippedPoints << clipBottom( m, m_previousPoint );
+            m_clippedPoints << clipTop( m, m_currentPoint );
         }
         else if ( m_previousSector == 8 ) {
             QPointF pointBottom = clipBottom( m, m_previousPoint );
@@ -642,13 +704,13 @@ void ClipPainterPrivate::clipMultiple( QPolygonF & clippedPolyObject,
             QPointF pointTop = clipTop( m, m_currentPoint );
 
             if ( pointBottom.x() < m_right )
-                clippedPolyObject << pointBottom;
+                m_clippedPoints << pointBottom;
             if ( pointRight.y() > m_top && pointRight.y() <= m_bottom ) 
-                clippedPolyObject << pointRight;
+                m_clippedPoints << pointRight;
             if ( pointTop.x() < m_right ) {
-                clippedPolyObject << pointTop;
+                m_clippedPoints << pointTop;
             } else {
-                clippedPolyObject << QPointF( m_right, m_top );
+                m_clippedPoints << QPointF( m_right, m_top );
             }
         }
         break;
@@ -660,14 +722,14 @@ void ClipPainterPrivate::clipMultiple( QPolygonF & clippedPolyObject,
             QPointF pointRight = clipRight( m, m_currentPoint );
 
             if ( pointLeft.y() > m_top ) {
-                clippedPolyObject << pointLeft;
+                m_clippedPoints << pointLeft;
             } else {
-                clippedPolyObject << QPointF( m_left, m_top );
+                m_clippedPoints << QPointF( m_left, m_top );
             }
             if ( pointTop.x() > m_left && pointTop.x() <= m_right )
-                clippedPolyObject << pointTop;
+                m_clippedPoints << pointTop;
             if ( pointRight.y() > m_top ) 
-                clippedPolyObject << pointRight;
+                m_clippedPoints << pointRight;
         }
         else if ( m_previousSector == 7 ) {
             QPointF pointBottom = clipBottom( m, m_previousPoint );
@@ -675,14 +737,14 @@ void ClipPainterPrivate::clipMultiple( QPolygonF & clippedPolyObject,
             QPointF pointRight = clipRight( m, m_currentPoint );
 
             if ( pointBottom.x() < m_right ) {
-                clippedPolyObject << pointBottom;
+                m_clippedPoints << pointBottom;
             } else {
-                clippedPolyObject << QPointF( m_right, m_bottom );
+                m_clippedPoints << QPointF( m_right, m_bottom );
             }
             if ( pointRight.y() >= m_top && pointRight.y() < m_bottom ) 
-                clippedPolyObject << pointRight;
+                m_clippedPoints << pointRight;
             if ( pointTop.x() < m_right )
-                clippedPolyObject << pointTop;
+                m_clippedPoints << pointTop;
         }
         else if ( m_previousSector == 6 ) {
             QPointF pointBottom = clipBottom( m, m_previousPoint );
@@ -691,21 +753,21 @@ void ClipPainterPrivate::clipMultiple( QPolygonF & clippedPolyObject,
             QPointF pointRight = clipRight( m, m_previousPoint );
 
             if ( pointBottom.x() > m_left && pointBottom.x() < m_right )
-                clippedPolyObject << pointBottom;
+                m_clippedPoints << pointBottom;
             if ( pointLeft.y() > m_top && pointLeft.y() < m_bottom ) 
-                clippedPolyObject << pointLeft;
+                m_clippedPoints << pointLeft;
             if ( pointTop.x() > m_left && pointTop.x() < m_right ) 
-                clippedPolyObject << pointTop;
+                m_clippedPoints << pointTop;
             if ( pointRight.y() > m_top && pointRight.y() < m_bottom ) 
-                clippedPolyObject << pointRight;
+                m_clippedPoints << pointRight;
    
             if ( pointBottom.x() >= m_right && pointRight.y() >= m_bottom )
-                clippedPolyObject << QPointF( m_right, m_bottom );
+                m_clippedPoints << QPointF( m_right, m_bottom );
             if ( pointTop.x() <= m_left && pointLeft.y() <= m_top )
-                clippedPolyObject << QPointF( m_left, m_top );
+                m_clippedPoints << QPointF( m_left, m_top );
         }
 
-        clippedPolyObject << QPointF( m_right, m_top );
+        m_clippedPoints << QPointF( m_right, m_top );
         break;
 
     case 3:
@@ -714,11 +776,11 @@ void ClipPainterPrivate::clipMultiple( QPolygonF & clippedPolyObject,
             QPointF pointLeft = clipLeft( m, m_currentPoint );
 
             if ( pointBottom.x() > m_left )
-                clippedPolyObject << pointBottom;
+                m_clippedPoints << pointBottom;
             if ( pointLeft.y() < m_bottom ) {
-                clippedPolyObject << pointLeft;
+                m_clippedPoints << pointLeft;
             } else {
-                clippedPolyObject << QPointF( m_left, m_bottom );
+                m_clippedPoints << QPointF( m_left, m_bottom );
             }
         }
         else if ( m_previousSector == 1 ) {
@@ -726,11 +788,11 @@ void ClipPainterPrivate::clipMultiple( QPolygonF & clippedPolyObject,
             QPointF pointLeft = clipLeft( m, m_currentPoint );
 
             if ( pointTop.x() > m_left )
-                clippedPolyObject << pointTop;
+                m_clippedPoints << pointTop;
             if ( pointLeft.y() > m_top ) {
-                clippedPolyObject << pointLeft;
+                m_clippedPoints << pointLeft;
             } else {
-                clippedPolyObject << QPointF( m_left, m_top );
+                m_clippedPoints << QPointF( m_left, m_top );
             }
         }
         else if ( m_previousSector == 8 ) {
@@ -739,18 +801,18 @@ void ClipPainterPrivate::clipMultiple( QPolygonF & clippedPolyObject,
             QPointF pointLeft = clipLeft( m, m_currentPoint );
 
             if ( pointRight.y() < m_bottom ) 
-                clippedPolyObject << pointRight;
+                m_clippedPoints << pointRight;
             if ( pointBottom.x() > m_left && pointBottom.x() <= m_right )
-                clippedPolyObject << pointBottom;
+                m_clippedPoints << pointBottom;
             if ( pointLeft.y() < m_bottom ) {
-                clippedPolyObject << pointLeft;
+                m_clippedPoints << pointLeft;
             } else {
-                clippedPolyObject << QPointF( m_left, m_bottom );
+                m_clippedPoints << QPointF( m_left, m_bottom );
             }
         }
         else if ( m_previousSector == 5 ) {
-            clippedPolyObject << clipRight( m, m_previousPoint );
-            clippedPolyObject << clipLeft( m, m_currentPoint );
+            m_clippedPoints << clipRight( m, m_previousPoint );
+            m_clippedPoints << clipLeft( m, m_currentPoint );
         }
         else if ( m_previousSector == 2 ) {
             QPointF pointRight = clipRight( m, m_previousPoint );
@@ -758,13 +820,13 @@ void ClipPainterPrivate::clipMultiple( QPolygonF & clippedPolyObject,
             QPointF pointLeft = clipLeft( m, m_currentPoint );
 
             if ( pointRight.y() > m_top ) 
-                clippedPolyObject << pointRight;
+                m_clippedPoints << pointRight;
             if ( pointTop.x() > m_left && pointTop.x() <= m_right )
-                clippedPolyObject << pointTop;
+                m_clippedPoints << pointTop;
             if ( pointLeft.y() > m_top ) {
-                clippedPolyObject << pointLeft;
+                m_clippedPoints << pointLeft;
             } else {
-                clippedPolyObject << QPointF( m_left, m_top );
+                m_clippedPoints << QPointF( m_left, m_top );
             }
         }
         break;
@@ -775,11 +837,11 @@ void ClipPainterPrivate::clipMultiple( QPolygonF & clippedPolyObject,
             QPointF pointRight = clipRight( m, m_currentPoint );
 
             if ( pointBottom.x() < m_right )
-                clippedPolyObject << pointBottom;
+                m_clippedPoints << pointBottom;
             if ( pointRight.y() < m_bottom ) {
-                clippedPolyObject << pointRight;
+                m_clippedPoints << pointRight;
             } else {
-                clippedPolyObject << QPointF( m_right, m_bottom );
+                m_clippedPoints << QPointF( m_right, m_bottom );
             }
         }
         else if ( m_previousSector == 1 ) {
@@ -787,11 +849,11 @@ void ClipPainterPrivate::clipMultiple( QPolygonF & clippedPolyObject,
             QPointF pointRight = clipRight( m, m_currentPoint );
 
             if ( pointTop.x() < m_right )
-                clippedPolyObject << pointTop;
+                m_clippedPoints << pointTop;
             if ( pointRight.y() > m_top ) {
-                clippedPolyObject << pointRight;
+                m_clippedPoints << pointRight;
             } else {
-                clippedPolyObject << QPointF( m_right, m_top );
+                m_clippedPoints << QPointF( m_right, m_top );
             }
         }
         else if ( m_previousSector == 6 ) {
@@ -800,18 +862,18 @@ void ClipPainterPrivate::clipMultiple( QPolygonF & clippedPolyObject,
             QPointF pointRight = clipRight( m, m_currentPoint );
 
             if ( pointLeft.y() < m_bottom ) 
-                clippedPolyObject << pointLeft;
+                m_clippedPoints << pointLeft;
             if ( pointBottom.x() >= m_left && pointBottom.x() < m_right )
-                clippedPolyObject << pointBottom;
+                m_clippedPoints << pointBottom;
             if ( pointRight.y() < m_bottom ) {
-                clippedPolyObject << pointRight;
+                m_clippedPoints << pointRight;
             } else {
-                clippedPolyObject << QPointF( m_right, m_bottom );
+                m_clippedPoints << QPointF( m_right, m_bottom );
             }
         }
         else if ( m_previousSector == 3 ) {
-            clippedPolyObject << clipLeft( m, m_previousPoint );
-            clippedPolyObject << clipRight( m, m_currentPoint );
+            m_clippedPoints << clipLeft( m, m_previousPoint );
+            m_clippedPoints << clipRight( m, m_currentPoint );
         }
         else if ( m_previousSector == 0 ) {
             QPointF pointLeft = clipLeft( m, m_previousPoint );
@@ -819,13 +881,13 @@ void ClipPainterPrivate::clipMultiple( QPolygonF & clippedPolyObject,
             QPointF pointRight = clipRight( m, m_currentPoint );
 
             if ( pointLeft.y() > m_top ) 
-                clippedPolyObject << pointLeft;
+                m_clippedPoints << pointLeft;
             if ( pointTop.x() >= m_left && pointTop.x() < m_right )
-                clippedPolyObject << pointTop;
+                m_clippedPoints << pointTop;
             if ( pointRight.y() > m_top ) {
-                clippedPolyObject << pointRight;
+                m_clippedPoints << pointRight;
             } else {
-                clippedPolyObject << QPointF( m_right, m_top );
+                m_clippedPoints << QPointF( m_right, m_top );
             }
         }
         break;
@@ -837,14 +899,14 @@ void ClipPainterPrivate::clipMultiple( QPolygonF & clippedPolyObject,
             QPointF pointLeft = clipLeft( m, m_currentPoint );
 
             if ( pointRight.y() < m_bottom ) {
-                clippedPolyObject << pointRight;
+                m_clippedPoints << pointRight;
             } else {
-                clippedPolyObject << QPointF( m_right, m_bottom );
+                m_clippedPoints << QPointF( m_right, m_bottom );
             }
             if ( pointBottom.x() >= m_left && pointBottom.x() < m_right )
-                clippedPolyObject << pointBottom;
+                m_clippedPoints << pointBottom;
             if ( pointLeft.y() < m_bottom ) 
-                clippedPolyObject << pointLeft;
+                m_clippedPoints << pointLeft;
         }
         else if ( m_previousSector == 1 ) {
             QPointF pointTop = clipTop( m, m_previousPoint );
@@ -852,14 +914,14 @@ void ClipPainterPrivate::clipMultiple( QPolygonF & clippedPolyObject,
             QPointF pointBottom = clipBottom( m, m_currentPoint );
 
             if ( pointTop.x() > m_left ) {
-                clippedPolyObject << pointTop;
+                m_clippedPoints << pointTop;
             } else {
-                clippedPolyObject << QPointF( m_left, m_top );
+                m_clippedPoints << QPointF( m_left, m_top );
             }
             if ( pointLeft.y() > m_top && pointLeft.y() <= m_bottom ) 
-                clippedPolyObject << pointLeft;
+                m_clippedPoints << pointLeft;
             if ( pointBottom.x() > m_left )
-                clippedPolyObject << pointBottom;
+                m_clippedPoints << pointBottom;
         }
         else if ( m_previousSector == 2 ) {
             QPointF pointTop = clipTop( m, m_currentPoint );
@@ -868,21 +930,21 @@ void ClipPainterPrivate::clipMultiple( QPolygonF & clippedPolyObject,
             QPointF pointLeft = clipLeft( m, m_currentPoint );
 
             if ( pointTop.x() > m_left && pointTop.x() < m_right ) 
-                clippedPolyObject << pointTop;
+                m_clippedPoints << pointTop;
             if ( pointRight.y() > m_top && pointRight.y() < m_bottom ) 
-                clippedPolyObject << pointRight;
+                m_clippedPoints << pointRight;
             if ( pointBottom.x() > m_left && pointBottom.x() < m_right )
-                clippedPolyObject << pointBottom;
+                m_clippedPoints << pointBottom;
             if ( pointLeft.y() > m_top && pointLeft.y() < m_bottom ) 
-                clippedPolyObject << pointLeft;
+                m_clippedPoints << pointLeft;
    
             if ( pointBottom.x() >= m_right && pointRight.y() >= m_bottom )
-                clippedPolyObject << QPointF( m_right, m_bottom );
+                m_clippedPoints << QPointF( m_right, m_bottom );
             if ( pointTop.x() <= m_left && pointLeft.y() <= m_top )
-                clippedPolyObject << QPointF( m_left, m_top );
+                m_clippedPoints << QPointF( m_left, m_top );
         }
 
-        clippedPolyObject << QPointF( m_left, m_bottom );
+        m_clippedPoints << QPointF( m_left, m_bottom );
         break;
 
     case 7:
@@ -891,24 +953,24 @@ void ClipPainterPrivate::clipMultiple( QPolygonF & clippedPolyObject,
             QPointF pointBottom = clipBottom( m, m_currentPoint );
 
             if ( pointLeft.y() < m_bottom ) {
-                clippedPolyObject << pointLeft;
+                m_clippedPoints << pointLeft;
             } else {
-                clippedPolyObject << QPointF( m_left, m_bottom );
+                m_clippedPoints << QPointF( m_left, m_bottom );
             }
             if ( pointBottom.x() > m_left )
-                clippedPolyObject << pointBottom;
+                m_clippedPoints << pointBottom;
         }
         else if ( m_previousSector == 5 ) {
             QPointF pointRight = clipRight( m, m_previousPoint );
             QPointF pointBottom = clipBottom( m, m_currentPoint );
 
             if ( pointRight.y() < m_bottom ) {
-                clippedPolyObject << pointRight;
+                m_clippedPoints << pointRight;
             } else {
-                clippedPolyObject << QPointF( m_right, m_bottom );
+                m_clippedPoints << QPointF( m_right, m_bottom );
             }
             if ( pointBottom.x() < m_right )
-                clippedPolyObject << pointBottom;
+                m_clippedPoints << pointBottom;
         }
         else if ( m_previousSector == 0 ) {
             QPointF pointTop = clipTop( m, m_previousPoint );
@@ -916,18 +978,18 @@ void ClipPainterPrivate::clipMultiple( QPolygonF & clippedPolyObject,
             QPointF pointBottom = clipBottom( m, m_currentPoint );
 
             if ( pointTop.x() > m_left )
-                clippedPolyObject << pointTop;
+                m_clippedPoints << pointTop;
             if ( pointLeft.y() >= m_top && pointLeft.y() < m_bottom ) 
-                clippedPolyObject << pointLeft;
+                m_clippedPoints << pointLeft;
             if ( pointBottom.x() > m_left ) {
-                clippedPolyObject << pointBottom;
+                m_clippedPoints << pointBottom;
             } else {
-                clippedPolyObject << QPointF( m_left, m_bottom );
+                m_clippedPoints << QPointF( m_left, m_bottom );
             }
         }
         else if ( m_previousSector == 1 ) {
-            clippedPolyObject << clipTop( m, m_previousPoint );
-            clippedPolyObject << clipBottom( m, m_currentPoint );
+            m_clippedPoints << clipTop( m, m_previousPoint );
+            m_clippedPoints << clipBottom( m, m_currentPoint );
         }
         else if ( m_previousSector == 2 ) {
             QPointF pointTop = clipTop( m, m_previousPoint );
@@ -935,13 +997,13 @@ void ClipPainterPrivate::clipMultiple( QPolygonF & clippedPolyObject,
             QPointF pointBottom = clipBottom( m, m_currentPoint );
 
             if ( pointTop.x() < m_right )
-                clippedPolyObject << pointTop;
+                m_clippedPoints << pointTop;
             if ( pointRight.y() >= m_top && pointRight.y() < m_bottom ) 
-                clippedPolyObject << pointRight;
+                m_clippedPoints << pointRight;
             if ( pointBottom.x() < m_right ) {
-                clippedPolyObject << pointBottom;
+                m_clippedPoints << pointBottom;
             } else {
-                clippedPolyObject << QPointF( m_right, m_bottom );
+                m_clippedPoints << QPointF( m_right, m_bottom );
             }
         }
         break;
@@ -953,14 +1015,14 @@ void ClipPainterPrivate::clipMultiple( QPolygonF & clippedPolyObject,
             QPointF pointRight = clipRight( m, m_currentPoint );
 
             if ( pointLeft.y() < m_bottom ) {
-                clippedPolyObject << pointLeft;
+                m_clippedPoints << pointLeft;
             } else {
-                clippedPolyObject << QPointF( m_left, m_bottom );
+                m_clippedPoints << QPointF( m_left, m_bottom );
             }
             if ( pointBottom.x() > m_left && pointBottom.x() <= m_right )
-                clippedPolyObject << pointBottom;
+                m_clippedPoints << pointBottom;
             if ( pointRight.y() < m_bottom ) 
-                clippedPolyObject << pointRight;
+                m_clippedPoints << pointRight;
         }
         else if ( m_previousSector == 1 ) {
             QPointF pointTop = clipTop( m, m_previousPoint );
@@ -968,14 +1030,14 @@ void ClipPainterPrivate::clipMultiple( QPolygonF & clippedPolyObject,
             QPointF pointBottom = clipBottom( m, m_currentPoint );
 
             if ( pointTop.x() < m_right ) {
-                clippedPolyObject << pointTop;
+                m_clippedPoints << pointTop;
             } else {
-                clippedPolyObject << QPointF( m_right, m_top );
+                m_clippedPoints << QPointF( m_right, m_top );
             }
             if ( pointRight.y() > m_top && pointRight.y() <= m_bottom ) 
-                clippedPolyObject << pointRight;
+                m_clippedPoints << pointRight;
             if ( pointBottom.x() < m_right )
-                clippedPolyObject << pointBottom;
+                m_clippedPoints << pointBottom;
         }
         else if ( m_previousSector == 0 ) {
             QPointF pointTop = clipTop( m, m_currentPoint );
@@ -984,21 +1046,21 @@ void ClipPainterPrivate::clipMultiple( QPolygonF & clippedPolyObject,
             QPointF pointRight = clipRight( m, m_previousPoint );
 
             if ( pointTop.x() > m_left && pointTop.x() < m_right ) 
-                clippedPolyObject << pointTop;
+                m_clippedPoints << pointTop;
             if ( pointLeft.y() > m_top && pointLeft.y() < m_bottom ) 
-                clippedPolyObject << pointLeft;
+                m_clippedPoints << pointLeft;
             if ( pointBottom.x() > m_left && pointBottom.x() < m_right )
-                clippedPolyObject << pointBottom;
+                m_clippedPoints << pointBottom;
             if ( pointRight.y() > m_top && pointRight.y() < m_bottom ) 
-                clippedPolyObject << pointRight;
+                m_clippedPoints << pointRight;
    
             if ( pointBottom.x() <= m_left && pointLeft.y() >= m_bottom )
-                clippedPolyObject << QPointF( m_left, m_bottom );
+                m_clippedPoints << QPointF( m_left, m_bottom );
             if ( pointTop.x() >= m_right && pointRight.y() <= m_top )
-                clippedPolyObject << QPointF( m_right, m_top );
+                m_clippedPoints << QPointF( m_right, m_top );
         }
 
-        clippedPolyObject << QPointF( m_right, m_bottom );
+        m_clippedPoints << QPointF( m_right, m_bottom );
         break;
 
     default:
@@ -1006,50 +1068,40 @@ void ClipPainterPrivate::clipMultiple( QPolygonF & clippedPolyObject,
     }
 }
 
-void ClipPainterPrivate::clipOnceCorner( QPolygonF & clippedPolyObject,
-                                         QVector<QPolygonF> & clippedPolyObjects,
-                                         const QPointF& corner,
-                                         const QPointF& point, 
-                                         bool isClosed )
+void ClipPainterPrivate::clipOnceCorner( const QPointF& corner,
+                                         const QPointF& point )
 {
-    Q_UNUSED( clippedPolyObjects )
-    Q_UNUSED( isClosed )
-
     if ( m_currentSector == 4) {
         // Appearing
-        clippedPolyObject << corner;
-        clippedPolyObject << point;
+        m_clippedPoints << corner;
+        m_clippedPoints << point;
     } else {
         // Disappearing
-        clippedPolyObject << point;
-        clippedPolyObject << corner;
+        m_clippedPoints << point;
+        m_clippedPoints << corner;
     }
 }
 
-void ClipPainterPrivate::clipOnceEdge( QPolygonF & clippedPolyObject,
-                                       QVector<QPolygonF> & clippedPolyObjects,
-                                       const QPointF& point,
+void ClipPainterPrivate::clipOnceEdge( const QPointF& point,
                                        bool isClosed )
 {
     if ( m_currentSector == 4) {
         // Appearing
         if ( !isClosed ) {
-            clippedPolyObject = QPolygonF();
+            m_clippedPolyObjectStart = m_clippedPoints.size();
         }
-        clippedPolyObject << point;
+        m_clippedPoints << point;
     }
     else {
         // Disappearing
-        clippedPolyObject << point;
+        m_clippedPoints << point;
         if ( !isClosed ) {
-            clippedPolyObjects << clippedPolyObject;           
+            finishPolyObject();
         }
     }
 }
 
-void ClipPainterPrivate::clipOnce( QPolygonF & clippedPolyObject,
-                                   QVector<QPolygonF> & clippedPolyObjects,
-                                   bool isClosed )
+void ClipPainterPrivate::clipOnce( bool isClosed )
 {
     //	Interpolate border points (linear interpolation)
     QPointF point;
@@ -1067,44 +1119,44 @@ void ClipPainterPrivate::clipOnce( QPolygonF & clippedPolyObject,
         if ( point.x() < m_left ) {
             point = clipLeft( m, point );
         }
-        clipOnceCorner( clippedPolyObject, clippedPolyObjects, QPointF( m_left, m_top ), point, isClosed );
+        clipOnceCorner( QPointF( m_left, m_top ), point );
         break;
     case 1: // top
         point = clipTop( m, m_previousPoint );
-        clipOnceEdge( clippedPolyObject, clippedPolyObjects, point, isClosed );
+        clipOnceEdge( point, isClosed );
         break;
     case 2: // topright
         point = clipTop( m, m_previousPoint );
         if ( point.x() > m_right ) {
             point = clipRight( m, point );
         }
-        clipOnceCorner( clippedPolyObject, clippedPolyObjects, QPointF( m_right, m_top ), point, isClosed );
+        clipOnceCorner( QPointF( m_right, m_top ), point );
         break;
     case 3: // left
         point = clipLeft( m, m_previousPoint );
-        clipOnceEdge( clippedPolyObject, clippedPolyObjects, point, isClosed );
+        clipOnceEdge( point, isClosed );
         break;
     case 5: // right
         point = clipRight( m, m_previousPoint );
-        clipOnceEdge( clippedPolyObject, clippedPolyObjects, point, isClosed );
+        clipOnceEdge( point, isClosed );
         break;
     case 6: // bottomleft
         point = clipBottom( m, m_previousPoint );
         if ( point.x() < m_left ) {
             point = clipLeft( m, point );
         }
-        clipOnceCorner( clippedPolyObject, clippedPolyObjects, QPointF( m_left, m_bottom ), point, isClosed );
+        clipOnceCorner( QPointF( m_left, m_bottom ), point );
         break;
     case 7: // bottom
         point = clipBottom( m, m_previousPoint );
-        clipOnceEdge( clippedPolyObject, clippedPolyObjects, point, isClosed );
+        clipOnceEdge( point, isClosed );
         break;
     case 8: // bottomright
         point = clipBottom( m, m_previousPoint );
         if ( point.x() > m_right ) {
             point = clipRight( m, point );
         }
-        clipOnceCorner( clippedPolyObject, clippedPolyObjects, QPointF( m_right, m_bottom ), point, isClosed );
+        clipOnceCorner( QPointF( m_right, m_bottom ), point );
         break;
     default:
         break;			
@@ -1114,7 +1166,7 @@ void ClipPainterPrivate::clipOnce( QPolygonF & clippedPolyObject,
 
 #ifdef DEBUG_DRAW_NODES
 
-void ClipPainterPrivate::debugDrawNodes( const QPolygonF & polygon )
+void ClipPainterPrivate::debugDrawNodes( const QPointF * points, int size )
 {
 
     q->save();
@@ -1123,9 +1175,9 @@ void ClipPainterPrivate::debugDrawNodes( const QPolygonF & polygon )
     q->setPen( Qt::red );
     q->setBrush( Qt::transparent );
 
-    const QVector<QPointF>::const_iterator  itStartPoint = polygon.constBegin();
-    const QVector<QPointF>::const_iterator  itEndPoint   = polygon.constEnd();
-    QVector<QPointF>::const_iterator        itPoint      = itStartPoint;
+    const QPointF * const itStartPoint = points;
+    const QPointF * const itEndPoint   = points + size;
+    const QPointF *       itPoint      = itStartPoint;
 
     for (; itPoint != itEndPoint; ++itPoint ) {
         
@@ -11,38 +11,59 @@
 #include "FileLoader.h"
 
 #include <QtCore/QBuffer>
+#include <QtCore/QCryptographicHash>
 #include <QtCore/QDataStream>
 #include <QtCore/QDateTime>
+#include <QtCore/QDir>
 #include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QSemaphore>
 #include <QtCore/QThread>
+#include <QtCore/QTime>
 
 #include "GeoDataParser.h"
 #include "GeoDataDocument.h"
 #include "GeoDataFolder.h"
+#include "GeoDataLineString.h"
+#include "GeoDataMultiGeometry.h"
 #include "GeoDataPlacemark.h"
+#include "GeoDataPolygon.h"
 #include "GeoDataData.h"
 #include "GeoDataExtendedData.h"
+#include "GeoDataStyle.h"
 #include "GeoDataStyleMap.h"
+#include "GeoDataTrack.h"
 #include "GeoDataTypes.h"
 #include "MarbleClock.h"
 #include "MarbleDirs.h"
 #include "MarbleDebug.h"
 #include "MarbleModel.h"
 #include "MarbleRunnerManager.h"
+#include "PlacemarkCache.h"
 
 namespace Marble
 {
 
+// Snapshots of documents parsed from source files at least this large are
+// kept to skip parsing the next time
+static const qint64 snapshotMinimumSize = 1024 * 1024;
+static const quint32 snapshotMagic = 0x4d534e50;
+static const qint32 snapshotVersion = 2;
+
 class FileLoaderPrivate
 {
 public:
     FileLoaderPrivate( FileLoader* parent, MarbleModel *model,
-                       const QString& file, DocumentRole role )
+                       const QString& file, DocumentRole role, const GeoDataLatLonBox &latLonBox )
         : q( parent),
           m_runner( new MarbleRunnerManager( model->pluginManager(), q ) ),
           m_filepath ( file ),
+          m_latLonBox( latLonBox ),
           m_documentRole ( role ),
           m_document( 0 ),
+          m_placemarkCache( 0 ),
+          m_memoryUsage( 0 ),
+          m_canceled( false ),
           m_clock( model->clock() )
     {
         m_runner->setModel( model );
@@ -56,6 +77,9 @@ public:
           m_contents ( contents ),
           m_documentRole ( role ),
           m_document( 0 ),
+          m_placemarkCache( 0 ),
+          m_memoryUsage( 0 ),
+          m_canceled( false ),
           m_clock( model->clock() )
     {
         m_runner->setModel( model );
@@ -64,10 +88,15 @@ public:
     ~FileLoaderPrivate()
     {
         delete m_runner;
+        delete m_placemarkCache;
     }
 
+    bool openPlacemarkCache( const QString &fileName );
     void saveFile(const QString& filename );
-    void savePlacemarks(QDataStream &out, const GeoDataContainer *container);
+    static void collectPlacemarks( QVector<const GeoDataPlacemark*> &placemarks, const GeoDataContainer *container );
+    static QString snapshotFileName( const QString &sourceFile );
+    bool loadSnapshot( const QString &sourceFile );
+    void saveSnapshot();
 
     void createFilterProperties( GeoDataContainer *container );
     int cityPopIdx( qint64 population ) const;
@@ -75,23 +104,38 @@ public:
     int areaPopIdx( qreal area ) const;
 
     void documentParsed( GeoDataDocument *doc, const QString& error);
+    void featuresParsed( GeoDataDocument *features, qreal progress );
+    void parsingFinished();
+    void addFeatures( GeoDataDocument *features );
+    void resolveStyles( GeoDataFeature *feature );
+    static qint64 memoryUsage( const GeoDataFeature *feature );
+    static qint64 memoryUsage( const GeoDataGeometry *geometry );
 
     FileLoader *q;
     MarbleRunnerManager *m_runner;
     QString m_filepath;
+    GeoDataLatLonBox m_latLonBox;
     QString m_contents;
-    QString m_nonExistentLocalCacheFile;
+    QString m_localCacheFile;
+    QString m_snapshotSourceFile;
     DocumentRole m_documentRole;
     GeoDataDocument *m_document;
+    PlacemarkCache *m_placemarkCache;
     QString m_error;
+    qint64 m_memoryUsage;
+    bool m_canceled;
+
+    // Released once the runners are done with the file, or on cancel()
+    QSemaphore m_parsed;
 
     const MarbleClock *m_clock;
 };
 
 FileLoader::FileLoader( QObject* parent, MarbleModel *model,
-                       const QString& file, DocumentRole role = UnknownDocument )
+                       const QString& file, DocumentRole role = UnknownDocument,
+                       const GeoDataLatLonBox &latLonBox )
     : QThread( parent ),
-      d( new FileLoaderPrivate( this, model, file, role ) )
+      d( new FileLoaderPrivate( this, model, file, role, latLonBox ) )
 {
 }
 
@@ -122,6 +166,20 @@ QString FileLoader::error() const
     return d->m_error;
 }
 
+PlacemarkCache *FileLoader::takePlacemarkCache()
+{
+    PlacemarkCache *cache = d->m_placemarkCache;
+    d->m_placemarkCache = 0;
+    return cache;
+}
+
+void FileLoader::cancel()
+{
+    d->m_canceled = true;
+    d->m_runner->cancelParsing();
+    d->m_parsed.release();
+}
+
 void FileLoader::run()
 {
     if ( d->m_contents.isEmpty() ) {
@@ -153,11 +211,17 @@ void FileLoader::run()
             if ( cacheFile.isEmpty()) {
                 cacheFile = MarbleDirs::localPath() + "/placemarks/" + path + name + ".cache";
                 if ( !QFileInfo( cacheFile ).exists() ) {
-                    d->m_nonExistentLocalCacheFile = cacheFile;
+                    d->m_localCacheFile = cacheFile;
                 }
             }
         }
 
+        // Caches and snapshots hold whole files, not parts of them
+        if ( !d->m_latLonBox.isEmpty() ) {
+            cacheFile.clear();
+            d->m_localCacheFile.clear();
+        }
+
         // if cache file more recent that source file, load cache file
         if ( QFile::exists( cacheFile ) ) {
             mDebug() << "Loading Cache File:" + cacheFile;
@@ -171,23 +235,59 @@ void FileLoader::run()
             const QDateTime cacheLastModified  = QFileInfo( cacheFile ).lastModified();
 
             if ( sourceLastModified < cacheLastModified ) {
-                connect( d->m_runner, SIGNAL( parsingFinished( GeoDataDocument*, QString ) ),
-                         this, SLOT( documentParsed( GeoDataDocument*, QString ) ) );
-                d->m_runner->parseFile( cacheFile, d->m_documentRole );
+                const qint32 version = PlacemarkCache::fileVersion( cacheFile );
+                if ( version != PlacemarkCache::version || !d->openPlacemarkCache( cacheFile ) ) {
+                    // Older caches, like the ones coming with Marble, are read
+                    // in full once and converted into a local mapped one
+                    if ( version == PlacemarkCache::streamVersion ) {
+                        d->m_localCacheFile = MarbleDirs::localPath() + "/placemarks/" + path + name + ".cache";
+                    }
+
+                    connect( d->m_runner, SIGNAL( parsingFinished( GeoDataDocument*, QString ) ),
+                             this, SLOT( documentParsed( GeoDataDocument*, QString ) ) );
+                    connect( d->m_runner, SIGNAL( parsingFinished() ),
+                             this, SLOT( parsingFinished() ) );
+                    d->m_runner->parseFile( cacheFile, d->m_documentRole );
+                    d->m_parsed.acquire();
+                }
             }
         }
         // we load source file, multiple cases
         else if ( QFile::exists( defaultSourceName ) ) {
             mDebug() << "No recent Default Placemark Cache File available!";
 
-            // use runners: pnt, gpx, osm
-            connect( d->m_runner, SIGNAL( parsingFinished(GeoDataDocument*,QString) ),
-                    this, SLOT( documentParsed( GeoDataDocument*, QString ) ) );
-            d->m_runner->parseFile( defaultSourceName, d->m_documentRole );
+            const bool wholeFile = d->m_latLonBox.isEmpty();
+            if ( !wholeFile || !d->loadSnapshot( defaultSourceName ) ) {
+                if ( wholeFile && QFileInfo( defaultSourceName ).size() >= snapshotMinimumSize ) {
+                    d->m_snapshotSourceFile = defaultSourceName;
+                }
+
+                // use runners: pnt, gpx, osm
+                connect( d->m_runner, SIGNAL( parsingFinished(GeoDataDocument*,QString) ),
+                        this, SLOT( documentParsed( GeoDataDocument*, QString ) ) );
+                connect( d->m_runner, SIGNAL( featuresParsed( GeoDataDocument*, qreal ) ),
+                         this, SLOT( featuresParsed( GeoDataDocument*, qreal ) ) );
+                connect( d->m_runner, SIGNAL( parsingFinished() ),
+                         this, SLOT( parsingFinished() ) );
+                d->m_runner->parseFile( defaultSourceName, d->m_documentRole, true, d->m_latLonBox );
+                d->m_parsed.acquire();
+            }
         }
         else {
             mDebug() << "No Default Placemark Source File for " << name;
         }
+
+        // The runners hand over the document in the GUI thread while it is
+        // parsed. Files made of the whole document are written here instead,
+        // so that they don't block it.
+        if ( d->m_document && !d->m_canceled && d->m_error.isEmpty() ) {
+            if ( !d->m_snapshotSourceFile.isEmpty() ) {
+                d->saveSnapshot();
+            }
+            if ( !d->m_localCacheFile.isEmpty() ) {
+                d->saveFile( d->m_localCacheFile );
+            }
+        }
     // content is not empty, we load from data
     } else {
         // Read the KML Data
@@ -199,28 +299,45 @@ void FileLoader::run()
 
         if ( !parser.read( &buffer ) ) {
             qWarning( "Could not import kml buffer!" );
-            emit loaderFinished( this );
-            return;
-        }
-
-        GeoDocument* document = parser.releaseDocument();
-        Q_ASSERT( document );
+        } else {
+            GeoDocument* document = parser.releaseDocument();
+            Q_ASSERT( document );
 
-        d->m_document = static_cast<GeoDataDocument*>( document );
-        d->m_document->setDocumentRole( d->m_documentRole );
-        d->m_document->setFileName( d->m_filepath );
-        d->createFilterProperties( d->m_document );
-        buffer.close();
+            d->m_document = static_cast<GeoDataDocument*>( document );
+            d->m_document->setDocumentRole( d->m_documentRole );
+            d->m_document->setFileName( d->m_filepath );
+            d->createFilterProperties( d->m_document );
+            buffer.close();
 
-        mDebug() << "newGeoDataDocumentAdded" << d->m_filepath;
+            mDebug() << "newGeoDataDocumentAdded" << d->m_filepath;
 
-        emit newGeoDataDocumentAdded( d->m_document );
-        emit loaderFinished( this );
+            emit newGeoDataDocumentAdded( d->m_document );
+        }
     }
 
+    emit loaderFinished( this );
 }
 
-const quint32 MarbleMagicNumber = 0x31415926;
+/**
+ * Hands over an empty document for a mapped placemark cache, its
+ * placemarks get created once they are shown or searched for.
+ */
+bool FileLoaderPrivate::openPlacemarkCache( const QString &fileName )
+{
+    PlacemarkCache *cache = new PlacemarkCache;
+    if ( !cache->open( fileName ) ) {
+        delete cache;
+        return false;
+    }
+
+    mDebug() << "Mapped" << cache->size() << "placemarks of" << fileName;
+    m_placemarkCache = cache;
+
+    GeoDataDocument *document = new GeoDataDocument;
+    document->setDocumentRole( m_documentRole );
+    documentParsed( document, QString() );
+    return true;
+}
 
 void FileLoaderPrivate::saveFile( const QString& filename )
 {
@@ -230,70 +347,246 @@ void FileLoaderPrivate::saveFile( const QString& filename )
    
     mDebug() << "Creating cache at " << filename ;
 
-    QFile file( filename );
-    if ( !file.open( QIODevice::WriteOnly ) ) {
-        mDebug() << Q_FUNC_INFO << "Can't open" << filename << "for writing";
-        return;
+    QVector<const GeoDataPlacemark*> placemarks;
+    collectPlacemarks( placemarks, m_document );
+    PlacemarkCache::write( filename, placemarks, m_clock->dateTime() );
+}
+
+void FileLoaderPrivate::collectPlacemarks( QVector<const GeoDataPlacemark*> &placemarks, const GeoDataContainer *container )
+{
+    foreach ( const GeoDataPlacemark *placemark, container->placemarkList() ) {
+        placemarks << placemark;
     }
-    QDataStream out( &file );
 
-    // Write a header with a "magic number" and a version
-    // out << (quint32)0xA0B0C0D0;
-    out << (quint32)MarbleMagicNumber;
-    out << (qint32)015;
+    foreach ( const GeoDataFolder *folder, container->folderList() ) {
+        collectPlacemarks( placemarks, folder );
+    }
+}
 
-    out.setVersion( QDataStream::Qt_4_2 );
+QString FileLoaderPrivate::snapshotFileName( const QString &sourceFile )
+{
+    const QByteArray path = QFileInfo( sourceFile ).absoluteFilePath().toUtf8();
+    const QString hash = QCryptographicHash::hash( path, QCryptographicHash::Md5 ).toHex();
+    return MarbleDirs::localPath() + "/cache/documents/" + hash + ".snapshot";
+}
 
-    savePlacemarks(out, m_document);
+/**
+ * Snapshots are GeoDataDocument::pack() streams, preceded by a header with
+ * the size and modification time of the source file they were made of.
+ */
+bool FileLoaderPrivate::loadSnapshot( const QString &sourceFile )
+{
+    QFile file( snapshotFileName( sourceFile ) );
+    if ( !file.open( QIODevice::ReadOnly ) ) {
+        return false;
+    }
+
+    QTime timer;
+    timer.start();
+
+    QDataStream in( &file );
+    in.setVersion( QDataStream::Qt_4_2 );
+
+    quint32 magic;
+    qint32 version;
+    qint64 sourceSize;
+    QDateTime sourceLastModified;
+    in >> magic >> version >> sourceSize >> sourceLastModified;
+
+    const QFileInfo sourceInfo( sourceFile );
+    if ( in.status() != QDataStream::Ok || magic != snapshotMagic || version != snapshotVersion
+         || sourceSize != sourceInfo.size() || sourceLastModified != sourceInfo.lastModified() ) {
+        mDebug() << "Outdated snapshot" << file.fileName() << "of" << sourceFile;
+        return false;
+    }
+
+    GeoDataDocument *document = new GeoDataDocument;
+    document->unpack( in );
+    if ( in.status() != QDataStream::Ok ) {
+        mDebug() << "Corrupt snapshot" << file.fileName() << "of" << sourceFile;
+        delete document;
+        return false;
+    }
+
+    document->setDocumentRole( m_documentRole );
+    foreach ( GeoDataFeature *feature, document->featureList() ) {
+        resolveStyles( feature );
+    }
+
+    mDebug() << "Read snapshot of" << sourceFile << "in" << timer.elapsed() << "ms";
+    documentParsed( document, QString() );
+    return true;
 }
 
-void FileLoaderPrivate::savePlacemarks(QDataStream &out, const GeoDataContainer *container)
+void FileLoaderPrivate::saveSnapshot()
 {
+    const QString fileName = snapshotFileName( m_snapshotSourceFile );
+    QDir().mkpath( QFileInfo( fileName ).path() );
 
-    qreal lon;
-    qreal lat;
-    qreal alt;
-
-    const QVector<GeoDataPlacemark*> placemarks = container->placemarkList();
-    QVector<GeoDataPlacemark*>::const_iterator it = placemarks.constBegin();
-    QVector<GeoDataPlacemark*>::const_iterator const end = placemarks.constEnd();
-    for (; it != end; ++it ) {
-        out << (*it)->name();
-        (*it)->coordinate( m_clock->dateTime() ).geoCoordinates( lon, lat, alt );
-
-        // Use double to provide a single cache file format across architectures
-        out << (double)(lon) << (double)(lat) << (double)(alt);
-        out << QString( (*it)->role() );
-        out << QString( (*it)->description() );
-        out << QString( (*it)->countryCode() );
-        out << QString( (*it)->state() );
-        out << (double) (*it)->area();
-        out << (qint64) (*it)->population();
-        out << ( qint16 ) ( (*it)->extendedData().value("gmt").value().toInt() );
-        out << ( qint8 ) ( (*it)->extendedData().value("dst").value().toInt() );
+    QFile file( fileName );
+    if ( !file.open( QIODevice::WriteOnly ) ) {
+        mDebug() << Q_FUNC_INFO << "Can't open" << fileName << "for writing";
+        return;
     }
 
-    const QVector<GeoDataFolder*> folders = container->folderList();
-    QVector<GeoDataFolder*>::const_iterator cont = folders.constBegin();
-    QVector<GeoDataFolder*>::const_iterator endcont = folders.constEnd();
-    for (; cont != endcont; ++cont ) {
-            savePlacemarks(out, *cont);
+    QTime timer;
+    timer.start();
+
+    QDataStream out( &file );
+    out.setVersion( QDataStream::Qt_4_2 );
+
+    const QFileInfo sourceInfo( m_snapshotSourceFile );
+    out << snapshotMagic << snapshotVersion << sourceInfo.size() << sourceInfo.lastModified();
+    m_document->pack( out );
+
+    if ( out.status() != QDataStream::Ok ) {
+        mDebug() << "Can't write" << fileName;
+        file.remove();
+        return;
     }
+
+    mDebug() << "Wrote snapshot of" << m_snapshotSourceFile << "in" << timer.elapsed() << "ms";
 }
 
 void FileLoaderPrivate::documentParsed( GeoDataDocument* doc, const QString& error )
 {
     m_error = error;
-    if ( doc ) {
-        m_document = doc;
-        doc->setFileName( m_filepath );
-        createFilterProperties( doc );
+    if ( doc && m_canceled ) {
+        delete doc;
+    } else if ( doc ) {
+        if ( m_document ) {
+            // The file was handed over in batches, this is the rest of it
+            addFeatures( doc );
+        } else {
+            m_document = doc;
+            doc->setFileName( m_filepath );
+            createFilterProperties( doc );
+            emit q->newGeoDataDocumentAdded( m_document );
+        }
+    }
+}
+
+void FileLoaderPrivate::featuresParsed( GeoDataDocument *features, qreal progress )
+{
+    if ( m_canceled ) {
+        delete features;
+        return;
+    }
+
+    if ( m_document ) {
+        addFeatures( features );
+    } else {
+        m_document = features;
+        m_document->setDocumentRole( m_documentRole );
+        m_document->setFileName( m_filepath );
+        createFilterProperties( m_document );
+        foreach ( GeoDataFeature *feature, m_document->featureList() ) {
+            resolveStyles( feature );
+            m_memoryUsage += memoryUsage( feature );
+        }
         emit q->newGeoDataDocumentAdded( m_document );
-        if ( !m_nonExistentLocalCacheFile.isEmpty() ) {
-            saveFile( m_nonExistentLocalCacheFile );
+    }
+
+    mDebug() << "loaded" << qRound( 100 * progress ) << "% of" << m_filepath
+             << "taking about" << m_memoryUsage / 1024 << "kB";
+    emit q->loaderProgress( q, progress, m_memoryUsage );
+}
+
+void FileLoaderPrivate::parsingFinished()
+{
+    // Results of the runners arrive before they report to be finished
+    m_parsed.release();
+}
+
+void FileLoaderPrivate::addFeatures( GeoDataDocument *features )
+{
+    createFilterProperties( features );
+
+    foreach ( const GeoDataStyle &style, features->styles() ) {
+        m_document->addStyle( style );
+    }
+    foreach ( const GeoDataStyleMap &styleMap, features->styleMaps() ) {
+        m_document->addStyleMap( styleMap );
+    }
+
+    const QVector<GeoDataFeature*> featureList = features->featureList();
+    while ( features->size() > 0 ) {
+        features->remove( features->size() - 1 );
+    }
+    delete features;
+
+    foreach ( GeoDataFeature *feature, featureList ) {
+        feature->setParent( m_document );
+        resolveStyles( feature );
+        m_memoryUsage += memoryUsage( feature );
+    }
+
+    emit q->newGeoDataFeaturesAdded( m_document, featureList );
+}
+
+void FileLoaderPrivate::resolveStyles( GeoDataFeature *feature )
+{
+    // Shared styles of batches point into the document of the parser, which
+    // goes away once parsing is done. Look them up in m_document instead.
+    if ( !feature->styleUrl().isEmpty() ) {
+        feature->setStyleUrl( feature->styleUrl() );
+    }
+
+    // Nested documents bring their own styles
+    if ( feature->nodeType() == GeoDataTypes::GeoDataFolderType ) {
+        GeoDataContainer *container = static_cast<GeoDataContainer*>( feature );
+        QVector<GeoDataFeature*>::Iterator i = container->begin();
+        QVector<GeoDataFeature*>::Iterator const end = container->end();
+        for (; i != end; ++i ) {
+            resolveStyles( *i );
         }
     }
-    emit q->loaderFinished( q );
+}
+
+qint64 FileLoaderPrivate::memoryUsage( const GeoDataFeature *feature )
+{
+    // Rough numbers, good enough to tell how much a file takes
+    qint64 result = 512;
+
+    if ( const GeoDataContainer *container = dynamic_cast<const GeoDataContainer*>( feature ) ) {
+        foreach ( const GeoDataFeature *child, container->featureList() ) {
+            result += memoryUsage( child );
+        }
+    } else if ( feature->nodeType() == GeoDataTypes::GeoDataPlacemarkType ) {
+        result += memoryUsage( static_cast<const GeoDataPlacemark*>( feature )->geometry() );
+    }
+
+    return result;
+}
+
+qint64 FileLoaderPrivate::memoryUsage( const GeoDataGeometry *geometry )
+{
+    const int coordinateSize = 64;
+
+    if ( !geometry ) {
+        return 0;
+    }
+
+    if ( const GeoDataLineString *lineString = dynamic_cast<const GeoDataLineString*>( geometry ) ) {
+        return lineString->size() * coordinateSize;
+    } else if ( const GeoDataPolygon *polygon = dynamic_cast<const GeoDataPolygon*>( geometry ) ) {
+        qint64 result = polygon->outerBoundary().size() * coordinateSize;
+        foreach ( const GeoDataLinearRing &ring, polygon->innerBoundaries() ) {
+            result += ring.size() * coordinateSize;
+        }
+        return result;
+    } else if ( const GeoDataMultiGeometry *multiGeometry = dynamic_cast<const GeoDataMultiGeometry*>( geometry ) ) {
+        qint64 result = 0;
+        for ( int i = 0; i < multiGeometry->size(); ++i ) {
+            result += memoryUsage( multiGeometry->child( i ) );
+        }
+        return result;
+    } else if ( const GeoDataTrack *track = dynamic_cast<const GeoDataTrack*>( geometry ) ) {
+        // Each point has a time stamp as well
+        return track->size() * ( coordinateSize + 16 );
+    }
+
+    return coordinateSize;
 }
 
 void FileLoaderPrivate::createFilterProperties( GeoDataContainer *container )
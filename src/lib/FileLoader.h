@@ -11,22 +11,30 @@
 #define MARBLE_FILELOADER_H
 
 #include "GeoDataDocument.h"
+#include "GeoDataLatLonBox.h"
 
 #include <QtCore/QThread>
 #include <QtCore/QString>
+#include <QtCore/QVector>
 
 namespace Marble
 {
 class GeoDataContainer;
 class FileLoaderPrivate;
 class MarbleModel;
+class PlacemarkCache;
 
 class FileLoader : public QThread
 {
     Q_OBJECT
     public:
+        /**
+         * Loads @p file. A non-empty @p latLonBox limits the document to
+         * the features within it, for file formats that can be read in parts.
+         */
         FileLoader( QObject* parent, MarbleModel *model,
-                    const QString& file, DocumentRole role );
+                    const QString& file, DocumentRole role,
+                    const GeoDataLatLonBox &latLonBox = GeoDataLatLonBox() );
         FileLoader( QObject* parent, MarbleModel *model,
                     const QString& contents, const QString& name, DocumentRole role );
         virtual ~FileLoader();
@@ -36,12 +44,40 @@ class FileLoader : public QThread
         GeoDataDocument *document();
         QString error() const;
 
+        /**
+         * Returns the mapped placemark cache the document was opened from,
+         * if any. Its placemarks are only added to the document on request.
+         * The caller takes ownership.
+         */
+        PlacemarkCache *takePlacemarkCache();
+
+        /**
+         * Stops loading. Features that were already handed over with
+         * newGeoDataDocumentAdded or newGeoDataFeaturesAdded stay in place.
+         */
+        void cancel();
+
     Q_SIGNALS:
         void loaderFinished( FileLoader* );
         void newGeoDataDocumentAdded( GeoDataDocument* );
 
+        /**
+         * Large files are loaded in batches: the first one is handed over
+         * with newGeoDataDocumentAdded, the following ones with this signal.
+         * @p features still need to be appended to @p document.
+         */
+        void newGeoDataFeaturesAdded( GeoDataDocument *document, const QVector<GeoDataFeature*> &features );
+
+        /**
+         * Reports the fraction of a large file loaded so far and a rough
+         * estimate of the memory in bytes taken by its features.
+         */
+        void loaderProgress( FileLoader*, qreal progress, qint64 memoryUsage );
+
 private:
         Q_PRIVATE_SLOT ( d, void documentParsed( GeoDataDocument *, QString) )
+        Q_PRIVATE_SLOT ( d, void featuresParsed( GeoDataDocument *, qreal ) )
+        Q_PRIVATE_SLOT ( d, void parsingFinished() )
 
         friend class FileLoaderPrivate;
 
@@ -13,6 +13,7 @@
 
 #include <QtCore/QDir>
 #include <QtCore/QFileInfo>
+#include <QtCore/QHash>
 #include <QtCore/QTime>
 #include <QtGui/QMessageBox>
 
@@ -20,6 +21,7 @@
 #include "MarbleDebug.h"
 #include "MarbleModel.h"
 #include "GeoDataTreeModel.h"
+#include "PlacemarkCache.h"
 
 #include "GeoDataDocument.h"
 #include "GeoDataLatLonAltBox.h"
@@ -34,7 +36,8 @@ class FileManagerPrivate
 public:
     FileManagerPrivate( MarbleModel* model )
         : m_model( model ),
-          m_recenter( false )
+          m_recenter( false ),
+          m_zoomLevel( -1 )
     {
     }
 
@@ -42,19 +45,37 @@ public:
     {
         foreach ( FileLoader *loader, m_loaderList ) {
             if ( loader ) {
+                loader->cancel();
                 loader->wait();
             }
         }
+        qDeleteAll( m_placemarkCaches );
     }
 
+    void addPlacemarks( GeoDataDocument *document, PlacemarkCache *cache, const QVector<int> &records );
+
     MarbleModel* const m_model;
     QList<FileLoader*> m_loaderList;
     QList < GeoDataDocument* > m_fileItemList;
     bool m_recenter;
     QTime m_timer;
+
+    // Documents of mapped placemark caches get the placemarks of the
+    // region shown and of searches added
+    QHash<GeoDataDocument*, PlacemarkCache*> m_placemarkCaches;
+    GeoDataLatLonBox m_latLonBox;
+    int m_zoomLevel;
 };
 }
 
+void FileManagerPrivate::addPlacemarks( GeoDataDocument *document, PlacemarkCache *cache, const QVector<int> &records )
+{
+    const QVector<GeoDataFeature*> placemarks = cache->materialize( records );
+    if ( !placemarks.isEmpty() ) {
+        m_model->treeModel()->addFeatures( document, placemarks );
+    }
+}
+
 FileManager::FileManager( MarbleModel *model, QObject *parent )
     : QObject( parent )
     , d( new FileManagerPrivate( model ) )
@@ -67,7 +88,8 @@ FileManager::~FileManager()
     delete d;
 }
 
-void FileManager::addFile( const QString& filepath, DocumentRole role, bool recenter )
+void FileManager::addFile( const QString& filepath, DocumentRole role, bool recenter,
+                           const GeoDataLatLonBox &latLonBox )
 {
     foreach ( const GeoDataDocument *document, d->m_fileItemList ) {
         if ( document->fileName() == filepath )
@@ -83,7 +105,7 @@ void FileManager::addFile( const QString& filepath, DocumentRole role, bool rece
     mDebug() << "Starting placemark loading timer";
     d->m_timer.start();
     d->m_recenter = recenter;
-    FileLoader* loader = new FileLoader( this, d->m_model, filepath, role );
+    FileLoader* loader = new FileLoader( this, d->m_model, filepath, role, latLonBox );
     appendLoader( loader );
 }
 
@@ -108,6 +130,12 @@ void FileManager::appendLoader( FileLoader *loader )
     connect( loader, SIGNAL( newGeoDataDocumentAdded( GeoDataDocument* ) ),
              this, SLOT( addGeoDataDocument( GeoDataDocument* ) ) );
 
+    connect( loader, SIGNAL( newGeoDataFeaturesAdded( GeoDataDocument*, QVector<GeoDataFeature*> ) ),
+             this, SLOT( addGeoDataFeatures( GeoDataDocument*, QVector<GeoDataFeature*> ) ) );
+
+    connect( loader, SIGNAL( loaderProgress( FileLoader*, qreal, qint64 ) ),
+             this, SLOT( reportProgress( FileLoader*, qreal, qint64 ) ) );
+
     d->m_loaderList.append( loader );
     loader->start();
 }
@@ -117,9 +145,16 @@ void FileManager::removeFile( const QString& key )
     foreach ( FileLoader *loader, d->m_loaderList ) {
         if ( loader->path() == key ) {
             disconnect( loader, 0, this, 0 );
+            loader->cancel();
             loader->wait();
             d->m_loaderList.removeAll( loader );
-            delete loader->document();
+            // Large files are already shown while they are loaded
+            const int index = d->m_fileItemList.indexOf( loader->document() );
+            if ( index >= 0 ) {
+                closeFile( index );
+            } else {
+                delete loader->document();
+            }
             return;
         }
     }
@@ -144,6 +179,7 @@ void FileManager::closeFile( int index )
     mDebug() << "FileManager::closeFile " << d->m_fileItemList.at( index )->fileName();
     if ( index < d->m_fileItemList.size() ) {
         d->m_model->treeModel()->removeDocument( d->m_fileItemList.at( index ) );
+        delete d->m_placemarkCaches.take( d->m_fileItemList.at( index ) );
         emit fileRemoved( index );
         delete d->m_fileItemList.at( index );
         d->m_fileItemList.removeAt( index );
@@ -176,25 +212,62 @@ void FileManager::addGeoDataDocument( GeoDataDocument* document )
     emit fileAdded( d->m_fileItemList.indexOf( document ) );
 }
 
+void FileManager::addGeoDataFeatures( GeoDataDocument *document, const QVector<GeoDataFeature*> &features )
+{
+    d->m_model->treeModel()->addFeatures( document, features );
+}
+
+void FileManager::setViewport( const GeoDataLatLonBox &latLonBox, int zoomLevel )
+{
+    d->m_latLonBox = latLonBox;
+    d->m_zoomLevel = zoomLevel;
+
+    QHash<GeoDataDocument*, PlacemarkCache*>::const_iterator it = d->m_placemarkCaches.constBegin();
+    for (; it != d->m_placemarkCaches.constEnd(); ++it ) {
+        d->addPlacemarks( it.key(), it.value(), it.value()->records( latLonBox, zoomLevel ) );
+    }
+}
+
+void FileManager::addMatchingPlacemarks( const QString &namePrefix )
+{
+    QHash<GeoDataDocument*, PlacemarkCache*>::const_iterator it = d->m_placemarkCaches.constBegin();
+    for (; it != d->m_placemarkCaches.constEnd(); ++it ) {
+        d->addPlacemarks( it.key(), it.value(), it.value()->records( namePrefix ) );
+    }
+}
+
+void FileManager::reportProgress( FileLoader *loader, qreal progress, qint64 memoryUsage )
+{
+    emit fileLoadingProgress( loader->path(), progress, memoryUsage );
+}
+
 void FileManager::cleanupLoader( FileLoader* loader )
 {
     GeoDataDocument *doc = loader->document();
     d->m_loaderList.removeAll( loader );
-    if ( loader->isFinished() ) {
-        if ( doc && d->m_recenter ) {
-            emit centeredDocument( doc->latLonAltBox() );
-            d->m_recenter = false;
+    if ( PlacemarkCache *cache = loader->takePlacemarkCache() ) {
+        if ( d->m_fileItemList.contains( doc ) ) {
+            d->m_placemarkCaches.insert( doc, cache );
+            d->addPlacemarks( doc, cache, cache->records( d->m_latLonBox, d->m_zoomLevel ) );
+        } else {
+            delete cache;
         }
-        if ( !loader->error().isEmpty() ) {
-            QMessageBox errorBox;
-            errorBox.setWindowTitle( QObject::tr("File Parsing Error"));
-            errorBox.setText( loader->error() );
-            errorBox.setIcon( QMessageBox::Warning );
-            errorBox.exec();
-            qWarning() << "File Parsing error " << loader->error();
-        }
-        delete loader;
     }
+    // loaderFinished is the last thing the loader thread does
+    loader->wait();
+    if ( doc && d->m_recenter ) {
+        emit centeredDocument( doc->latLonAltBox() );
+        d->m_recenter = false;
+    }
+    if ( !loader->error().isEmpty() ) {
+        QMessageBox errorBox;
+        errorBox.setWindowTitle( QObject::tr("File Parsing Error"));
+        errorBox.setText( loader->error() );
+        errorBox.setIcon( QMessageBox::Warning );
+        errorBox.exec();
+        qWarning() << "File Parsing error " << loader->error();
+    }
+    delete loader;
     if ( d->m_loaderList.isEmpty()  )
     {
         mDebug() << "Finished loading all placemarks " << d->m_timer.elapsed();
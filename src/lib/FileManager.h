@@ -13,6 +13,7 @@
 #define MARBLE_FILEMANAGER_H
 
 #include "GeoDataDocument.h"
+#include "GeoDataLatLonBox.h"
 
 #include <QtCore/QObject>
 #include <QtCore/QString>
@@ -24,7 +25,6 @@ namespace Marble
 class MarbleModel;
 class FileManagerPrivate;
 class FileLoader;
-class GeoDataLatLonBox;
 
 /**
  * This class is responsible for loading the
@@ -51,9 +51,12 @@ class FileManager : public QObject
     ~FileManager();
 
     /**
-     * Loads a new file into the manager.
+     * Loads a new file into the manager. A non-empty @p latLonBox limits
+     * the loaded features to those within it, for file formats that can be
+     * read in parts, like shapefiles.
      */
-    void addFile( const QString &fileName, DocumentRole role, bool recenter = false );
+    void addFile( const QString &fileName, DocumentRole role, bool recenter = false,
+                  const GeoDataLatLonBox &latLonBox = GeoDataLatLonBox() );
 
 
     /**
@@ -63,7 +66,8 @@ class FileManager : public QObject
 
 
     /**
-    * removes an existing file from the manager
+    * removes an existing file from the manager, files still being loaded
+    * stop loading
     */
     void removeFile( const QString &fileName );
 
@@ -78,18 +82,43 @@ class FileManager : public QObject
     int size() const;
     GeoDataDocument *at( int index );
 
+    /**
+     * Adds the placemarks of mapped placemark caches whose name starts with
+     * @p namePrefix to their documents, so that they can be found.
+     */
+    void addMatchingPlacemarks( const QString &namePrefix );
+
 
  Q_SIGNALS:
     void fileAdded( int index );
     void fileRemoved( int index );
     void centeredDocument( const GeoDataLatLonBox& );
 
+    /**
+     * Large files show up while they are still being loaded. This reports
+     * the fraction of @p fileName loaded so far and a rough estimate of the
+     * memory in bytes taken by its features.
+     */
+    void fileLoadingProgress( const QString &fileName, qreal progress, qint64 memoryUsage );
+
  public Q_SLOTS:
     void addGeoDataDocument( GeoDataDocument *document );
 
+    /**
+     * Placemarks of mapped placemark caches are only added to their
+     * documents once they are shown: those within @p latLonBox, or anywhere
+     * if it is empty, up to @p zoomLevel. They stay until the file is
+     * removed.
+     */
+    void setViewport( const GeoDataLatLonBox &latLonBox, int zoomLevel );
+
  private Q_SLOTS:
     void cleanupLoader( FileLoader *loader );
 
+    void addGeoDataFeatures( GeoDataDocument *document, const QVector<GeoDataFeature*> &features );
+
+    void reportProgress( FileLoader *loader, qreal progress, qint64 memoryUsage );
+
  private:
 
     void appendLoader( FileLoader *loader );
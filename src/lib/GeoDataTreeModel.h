@@ -14,6 +14,7 @@
 #include "marble_export.h"
 
 #include <QtCore/QAbstractItemModel>
+#include <QtCore/QVector>
 
 namespace Marble
 {
@@ -84,6 +85,13 @@ public Q_SLOTS:
 
     int addFeature( GeoDataContainer *parent, GeoDataFeature *feature );
 
+    /**
+     * Appends @p features to @p parent in one go, which is much cheaper for
+     * views than adding them one by one.
+     * @return the row of the first feature, or -1 if @p parent is not in the model
+     */
+    int addFeatures( GeoDataContainer *parent, const QVector<GeoDataFeature*> &features );
+
     bool removeFeature( GeoDataContainer *parent, int index );
 
     bool removeFeature( GeoDataFeature *feature );
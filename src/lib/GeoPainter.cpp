@@ -24,6 +24,7 @@
 #include "GeoDataPolygon.h"
 
 #include "MarbleGlobal.h"
+#include "ProjectedGeometryCache.h"
 #include "ViewportParams.h"
 
 // #define MARBLE_DEBUG
@@ -33,7 +34,8 @@ using namespace Marble;
 GeoPainterPrivate::GeoPainterPrivate( const ViewportParams *viewport, MapQuality mapQuality )
         : m_viewport( viewport ),
         m_mapQuality( mapQuality ),
-        m_x( new qreal[100] )
+        m_x( new qreal[100] ),
+        m_projectionCache( 0 )
 {
 }
 
@@ -43,15 +45,25 @@ GeoPainterPrivate::~GeoPainterPrivate()
 }
 
 void GeoPainterPrivate::createPolygonsFromLineString( const GeoDataLineString & lineString,
-                                                      QVector<QPolygonF *> &polygons )
+                                                      QVector<QPolygonF> &polygons )
 {
-    m_viewport->screenCoordinates( lineString, polygons );
+    if ( m_projectionCache ) {
+        m_projectionCache->screenCoordinates( lineString, polygons );
+    }
+    else {
+        QVector<QPolygonF*> projected;
+        m_viewport->screenCoordinates( lineString, projected );
+        foreach( QPolygonF* polygon, projected ) {
+            polygons << *polygon;
+        }
+        qDeleteAll( projected );
+    }
 }
 
 void GeoPainterPrivate::createPolygonsFromLinearRing( const GeoDataLinearRing & linearRing,
-                                                      QVector<QPolygonF *> &polygons )
+                                                      QVector<QPolygonF> &polygons )
 {
-    m_viewport->screenCoordinates( linearRing, polygons );
+    createPolygonsFromLineString( linearRing, polygons );
 }
 
 void GeoPainterPrivate::createAnnotationLayout (  qreal x, qreal y,
@@ -204,6 +216,18 @@ MapQuality GeoPainter::mapQuality() const
 }
 
 
+void GeoPainter::setProjectionCache( ProjectedGeometryCache *cache )
+{
+    d->m_projectionCache = cache;
+}
+
+
+ProjectedGeometryCache *GeoPainter::projectionCache() const
+{
+    return d->m_projectionCache;
+}
+
+
 void GeoPainter::drawAnnotation( const GeoDataCoordinates & position,
                                  const QString & text, QSizeF bubbleSize,
                                  qreal bubbleOffsetX, qreal bubbleOffsetY,
@@ -556,12 +580,12 @@ void GeoPainter::drawPolyline ( const GeoDataLineString & lineString,
         return;
     }
 
-    QVector<QPolygonF*> polygons;
+    QVector<QPolygonF> polygons;
     d->createPolygonsFromLineString( lineString, polygons );
 
     if ( labelText.isEmpty() ) {
-        foreach( QPolygonF* itPolygon, polygons ) {
-            ClipPainter::drawPolyline( *itPolygon );
+        foreach( const QPolygonF& itPolygon, polygons ) {
+            ClipPainter::drawPolyline( itPolygon );
         }
     }
     else {
@@ -569,9 +593,9 @@ void GeoPainter::drawPolyline ( const GeoDataLineString & lineString,
         int labelAscent = fontMetrics().ascent();
 
         QVector<QPointF> labelNodes;
-        foreach( QPolygonF* itPolygon, polygons ) {
+        foreach( const QPolygonF& itPolygon, polygons ) {
             labelNodes.clear();
-            ClipPainter::drawPolyline( *itPolygon, labelNodes, labelPositionFlags );
+            ClipPainter::drawPolyline( itPolygon, labelNodes, labelPositionFlags );
             if ( !labelNodes.isEmpty() ) {
                 foreach ( const QPointF& labelNode, labelNodes ) {
                     QPointF labelPosition = labelNode + QPointF( 3.0, -2.0 );
@@ -589,7 +613,6 @@ void GeoPainter::drawPolyline ( const GeoDataLineString & lineString,
             }
         }
     }
-    qDeleteAll( polygons );
 }
 
 
@@ -610,15 +633,13 @@ QRegion GeoPainter::regionFromPolyline ( const GeoDataLineString & lineString,
     QList<QRegion> regions;
     QPainterPath painterPath;
 
-    QVector<QPolygonF*> polygons;
+    QVector<QPolygonF> polygons;
     d->createPolygonsFromLineString( lineString, polygons );
 
-    foreach( QPolygonF* itPolygon, polygons ) {
-        painterPath.addPolygon( *itPolygon );
+    foreach( const QPolygonF& itPolygon, polygons ) {
+        painterPath.addPolygon( itPolygon );
     }
 
-    qDeleteAll( polygons );
-
     QPainterPathStroker stroker;
     stroker.setWidth( strokeWidth );
     QPainterPath strokePath = stroker.createStroke( painterPath );
@@ -642,35 +663,32 @@ void GeoPainter::drawPolygon ( const GeoDataLinearRing & linearRing,
     }
 
     if ( !linearRing.latLonAltBox().crossesDateLine() ) {
-        QVector<QPolygonF*> polygons;
+        QVector<QPolygonF> polygons;
         d->createPolygonsFromLinearRing( linearRing, polygons );
 
-        foreach( QPolygonF* itPolygon, polygons ) {
-            ClipPainter::drawPolygon( *itPolygon, fillRule );
+        foreach( const QPolygonF& itPolygon, polygons ) {
+            ClipPainter::drawPolygon( itPolygon, fillRule );
         }
-
-        qDeleteAll( polygons );
     }
     else {
         QPen polygonPen = pen();
         setPen( Qt::NoPen );
 
-        QVector<QPolygonF*> polygons;
+        QVector<QPolygonF> polygons;
         d->createPolygonsFromLinearRing( linearRing, polygons );
 
-        foreach( QPolygonF* itPolygon, polygons ) {
-            ClipPainter::drawPolygon( *itPolygon, fillRule );
+        foreach( const QPolygonF& itPolygon, polygons ) {
+            ClipPainter::drawPolygon( itPolygon, fillRule );
         }
 
-        qDeleteAll( polygons );
-
         setPen( polygonPen );
         GeoDataLineString lineString( linearRing );
 
         lineString << lineString.first();
 
+        // lineString is a temporary, so don't pass it through the projection cache
         QVector<QPolygonF*> polylines;
-        d->createPolygonsFromLineString( lineString, polylines );
+        d->m_viewport->screenCoordinates( lineString, polylines );
 
         foreach( QPolygonF* itPolygon, polylines ) {
             ClipPainter::drawPolyline( *itPolygon );
@@ -696,19 +714,19 @@ QRegion GeoPainter::regionFromPolygon ( const GeoDataLinearRing & linearRing,
 
     QRegion regions;
 
-    QVector<QPolygonF*> polygons;
+    QVector<QPolygonF> polygons;
     d->createPolygonsFromLinearRing( linearRing, polygons );
 
     if ( strokeWidth == 0 ) {
         // This is the faster way
-        foreach( QPolygonF* itPolygon, polygons ) {
-            regions += QRegion ( (*itPolygon).toPolygon(), fillRule );
+        foreach( const QPolygonF& itPolygon, polygons ) {
+            regions += QRegion ( itPolygon.toPolygon(), fillRule );
         }
     }
     else {
         QPainterPath painterPath;
-        foreach( QPolygonF* itPolygon, polygons ) {
-            painterPath.addPolygon( *itPolygon );
+        foreach( const QPolygonF& itPolygon, polygons ) {
+            painterPath.addPolygon( itPolygon );
         }
 
         QPainterPathStroker stroker;
@@ -718,8 +736,6 @@ QRegion GeoPainter::regionFromPolygon ( const GeoDataLinearRing & linearRing,
         regions = QRegion( painterPath.toFillPolygon().toPolygon() );
     }
 
-    qDeleteAll( polygons );
-
     return regions;
 }
 
@@ -739,7 +755,7 @@ void GeoPainter::drawPolygon ( const GeoDataPolygon & polygon,
     // mDebug() << "Drawing Polygon";
 
     // Creating the outer screen polygons first
-    QVector<QPolygonF*> outerPolygons;
+    QVector<QPolygonF> outerPolygons;
     d->createPolygonsFromLinearRing( polygon.outerBoundary(), outerPolygons );
 
     // Now creating the "holes" by cutting away the inner boundaries:
@@ -755,34 +771,31 @@ void GeoPainter::drawPolygon ( const GeoDataPolygon & polygon,
     // it's really needed. See review 105019 for details.
     bool const needOutlineWorkaround = !polygon.innerBoundaries().isEmpty();
     if ( needOutlineWorkaround ) {
-        foreach( QPolygonF* polygon, outerPolygons ) {
-            outline << *polygon;
-        }
+        outline << outerPolygons;
         setPen( QPen( Qt::NoPen ) );
     }
 
 
     QVector<GeoDataLinearRing> innerBoundaries = polygon.innerBoundaries(); 
     foreach( const GeoDataLinearRing& itInnerBoundary, innerBoundaries ) {
-        QVector<QPolygonF*> innerPolygons;
+        QVector<QPolygonF> innerPolygons;
         d->createPolygonsFromLinearRing( itInnerBoundary, innerPolygons );
 
         if ( needOutlineWorkaround ) {
-            foreach( QPolygonF* polygon, innerPolygons ) {
-                outline << *polygon;
-            }
+            outline << innerPolygons;
         }
 
-        foreach( QPolygonF* itOuterPolygon, outerPolygons ) {
-            foreach( QPolygonF* itInnerPolygon, innerPolygons ) {
-                *itOuterPolygon = itOuterPolygon->subtracted( *itInnerPolygon );
+        // The screen polygons may be shared with the projection cache,
+        // subtracting replaces them rather than modifying them
+        for ( int i = 0; i < outerPolygons.size(); ++i ) {
+            foreach( const QPolygonF& itInnerPolygon, innerPolygons ) {
+                outerPolygons[i] = outerPolygons.at( i ).subtracted( itInnerPolygon );
             }
         }
-        qDeleteAll( innerPolygons );    
     }
 
-    foreach( QPolygonF* itOuterPolygon, outerPolygons ) {
-        ClipPainter::drawPolygon( *itOuterPolygon, fillRule );
+    foreach( const QPolygonF& itOuterPolygon, outerPolygons ) {
+        ClipPainter::drawPolygon( itOuterPolygon, fillRule );
     }
 
     if ( needOutlineWorkaround ) {
@@ -791,8 +804,6 @@ void GeoPainter::drawPolygon ( const GeoDataPolygon & polygon,
             ClipPainter::drawPolyline( polygon );
         }
     }
-
-    qDeleteAll( outerPolygons );    
 }
 
 
@@ -40,6 +40,7 @@ class GeoDataLineString;
 class GeoDataLinearRing;
 class GeoDataPoint;
 class GeoDataPolygon;
+class ProjectedGeometryCache;
 
 
 /*!
@@ -137,6 +138,22 @@ class MARBLE_EXPORT GeoPainter : public ClipPainter
     MapQuality mapQuality() const;
 
 
+/*!
+    \brief Sets a cache for the screen polygons of line strings and linear rings.
+
+    While a cache is set, drawPolyline() and drawPolygon() reuse the screen
+    polygons of geometries that were already projected for the same viewport
+    instead of projecting them again. Only set a cache while drawing
+    geometries that outlive it. Passing 0 disables caching again.
+*/
+    void setProjectionCache( ProjectedGeometryCache *cache );
+
+/*!
+    \brief Returns the cache set by setProjectionCache(), or 0.
+*/
+    ProjectedGeometryCache *projectionCache() const;
+
+
 /*!
     \brief Draws a text annotation that points to a geodesic position.
 
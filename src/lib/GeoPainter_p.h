@@ -25,6 +25,7 @@ namespace Marble
 
 class ViewportParams;
 class GeoDataCoordinates;
+class ProjectedGeometryCache;
 
 class GeoPainterPrivate
 {
@@ -35,11 +36,11 @@ class GeoPainterPrivate
 
 
     void createPolygonsFromLineString( const GeoDataLineString & lineString,
-                                       QVector<QPolygonF *> &polygons );
+                                       QVector<QPolygonF> &polygons );
 
 
     void createPolygonsFromLinearRing( const GeoDataLinearRing & linearRing,
-                                       QVector<QPolygonF *> &polygons );
+                                       QVector<QPolygonF> &polygons );
 
 
     void createAnnotationLayout ( qreal x, qreal y,
@@ -54,6 +55,7 @@ class GeoPainterPrivate
     const ViewportParams *const m_viewport;
     const MapQuality       m_mapQuality;
     qreal             *const m_x;
+    ProjectedGeometryCache *m_projectionCache;
 };
 
 } // namespace Marble
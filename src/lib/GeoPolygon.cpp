@@ -12,22 +12,16 @@
 
 #include "GeoPolygon.h"
 
-#include <cstdlib>
-#include <fcntl.h>
 #include <cmath>
 using std::fabs;
 
 #include <QtCore/QFile>
-#include <QtCore/QDataStream> 
 #include <QtCore/QTime>
-#ifdef Q_OS_UNIX
-# include <unistd.h>
-# include <sys/types.h>
-# include <sys/stat.h>
-# include <sys/mman.h> /* mmap() is defined in this header */
-#endif
+#include <QtCore/QtAlgorithms>
+#include <QtCore/QtConcurrentMap>
 
 #include "MarbleDebug.h"
+#include "GeoDataLatLonBox.h"
 #include "Quaternion.h"
 
 using namespace Marble;
@@ -35,6 +29,10 @@ using namespace Marble;
 const qreal ARCMINUTE = 10800; // distance of 180deg in arcminutes
 const qreal INT2RAD = M_PI / 10800.0;
 
+// The polyline index divides the globe into cells of 5 x 5 degrees.
+const int INDEX_COLUMNS = 72;
+const int INDEX_ROWS = 36;
+
 GeoPolygon::GeoPolygon()
     : m_dateLineCrossing( false ),
       m_closed( false ),
@@ -122,6 +120,7 @@ PntMap::~PntMap()
 {   
     if ( m_loader ) {
         m_loader->wait();
+        delete m_loader;
     }
     qDeleteAll( begin(), end() );
 }
@@ -134,8 +133,102 @@ void PntMap::load(const QString &filename)
     m_loader->start();
 }
 
+int PntMap::column( qreal lon )
+{
+    const int column = (int)( ( lon + M_PI ) / ( 2.0 * M_PI ) * INDEX_COLUMNS );
+    return qBound( 0, column, INDEX_COLUMNS - 1 );
+}
+
+int PntMap::row( qreal lat )
+{
+    const int row = (int)( ( M_PI / 2.0 - lat ) / M_PI * INDEX_ROWS );
+    return qBound( 0, row, INDEX_ROWS - 1 );
+}
+
+void PntMap::addToIndex( int polyline, qreal lonLeft, qreal latTop, qreal lonRight, qreal latBottom )
+{
+    const int lastRow = row( latBottom );
+    const int lastColumn = column( lonRight );
+
+    for ( int y = row( latTop ); y <= lastRow; ++y ) {
+        for ( int x = column( lonLeft ); x <= lastColumn; ++x ) {
+            m_cells[ y * INDEX_COLUMNS + x ].append( polyline );
+        }
+    }
+}
+
+void PntMap::buildIndex()
+{
+    m_cells.clear();
+    m_cells.resize( INDEX_ROWS * INDEX_COLUMNS );
+
+    for ( int i = 0; i < size(); ++i ) {
+        const GeoPolygon *polyline = at( i );
+
+        if ( polyline->getDateLine() == GeoPolygon::Even ) {
+            // the bounding box wraps around the dateline
+            addToIndex( i, polyline->getLonLeft(), polyline->getLatTop(), M_PI, polyline->getLatBottom() );
+            addToIndex( i, -M_PI, polyline->getLatTop(), polyline->getLonRight(), polyline->getLatBottom() );
+        }
+        else {
+            addToIndex( i, polyline->getLonLeft(), polyline->getLatTop(),
+                        polyline->getLonRight(), polyline->getLatBottom() );
+        }
+    }
+}
+
+void PntMap::intersecting( const GeoDataLatLonBox &box, GeoPolygon::PtrVector &polylines ) const
+{
+    if ( !m_isInitialized || m_cells.isEmpty() || box.isEmpty() ) {
+        polylines = *this;
+        return;
+    }
+
+    // Grow the query by one cell in each direction to account for
+    // segments bulging out of the bounding box of their points.
+    const int firstRow = qMax( 0, row( box.north() ) - 1 );
+    const int lastRow = qMin( INDEX_ROWS - 1, row( box.south() ) + 1 );
+
+    const int firstColumn = column( box.west() ) - 1;
+    int lastColumn = column( box.east() ) + 1;
+    if ( box.crossesDateLine() ) {
+        lastColumn += INDEX_COLUMNS;
+    }
+    if ( lastColumn - firstColumn >= INDEX_COLUMNS ) {
+        lastColumn = firstColumn + INDEX_COLUMNS - 1;
+    }
+
+    QVector<int> indices;
+    for ( int y = firstRow; y <= lastRow; ++y ) {
+        for ( int x = firstColumn; x <= lastColumn; ++x ) {
+            const int wrappedColumn = ( x + INDEX_COLUMNS ) % INDEX_COLUMNS;
+            indices += m_cells.at( y * INDEX_COLUMNS + wrappedColumn );
+        }
+    }
+
+    // restore the order of the file and drop polylines covering several cells
+    qSort( indices );
+
+    polylines.clear();
+    polylines.reserve( indices.size() );
+    int last = -1;
+    foreach ( int index, indices ) {
+        if ( index != last ) {
+            polylines.append( at( index ) );
+            last = index;
+        }
+    }
+}
+
 void PntMap::setInitialized( bool isInitialized )
 {
+    if ( isInitialized ) {
+        // The loader has finished writing the polylines before it emitted
+        // pntMapLoaded(), so they can be taken over in this thread.
+        GeoPolygon::PtrVector::operator=( m_loader->takePolylines() );
+        buildIndex();
+    }
+
     if ( m_loader->isFinished() ) {
         delete m_loader;
         m_loader = 0;
@@ -145,252 +238,220 @@ void PntMap::setInitialized( bool isInitialized )
     emit initialized();
 }
 
-PntMapLoader::PntMapLoader( PntMap* parent, const QString& filename )
-    : m_parent( parent ),
-      m_filename( filename )
+namespace
 {
+
+// A polyline of a PNT file: the header record and all following
+// point records up to the next header.
+struct PntPolylineRecords
+{
+    GeoPolygon  *polyline;
+    const uchar *begin;
+    int          count;
+};
+
+inline short pntShort( const uchar *data )
+{
+    return (short)( data[0] | ( data[1] << 8 ) );
 }
 
-void PntMapLoader::run()
+// To optimize performance we compute the boundaries of the
+// polygons.  To detect inside/outside we need to detect the
+// dateline first We probably won't need this for spherical
+// projection but for flat projection
+void computeBoundary( GeoPolygon *polyline )
 {
-//    qDebug("PntMap::load trying to load: " + m_filename.toLocal8Bit());
-    QTime timer;
-    timer.restart();
+    qreal  lon     = 0.0;
+    qreal  lastLon = 0.0;
+    qreal  lat     = 0.0;
 
-#ifdef Q_OS_UNIX
-    // MMAP Start
-    int          fd;
-    unsigned char* src; 
-    struct stat  statbuf;
-
-    if ( (fd = open (m_filename.toLatin1(), O_RDONLY) ) < 0)  // krazy:exclude=syscalls
-        mDebug() << "cannot open" << m_filename << " for reading";
-
-    if ( fstat (fd,&statbuf) < 0 ) // krazy:exclude=syscalls
-        mDebug() << "fstat error";
-
-    int  filelength = statbuf.st_size;
-	
-    if ((src = (unsigned char*) mmap (0, filelength, PROT_READ, MAP_SHARED, fd, 0))
-        == (unsigned char*) (caddr_t) -1)
-        mDebug() << "mmap error for input";
-		
-    short  header;
-    short  iLat;
-    short  iLon;
-    int    count = 0;
-
-    //const int halfFileLength = filelength / 2;
-
-    for (int i=0; i < filelength; i+=6){
-        header = src[i] | (src[i+1] << 8);
-        iLat = src[i+2] | (src[i+3] << 8);
-        iLon = src[i+4] | (src[i+5] << 8);   
-
-        // Transforming Range of Coordinates to iLat [0,ARCMINUTE] ,
-        // iLon [0,2 * ARCMINUTE]
-						
-        //
-        // 90 00N =   -ARCMINUTE / 2
-        // 90 00S =   ARCMINUTE / 2
-        // 180 00W =  -ARCMINUTE
-        // 180 00E =   ARCMINUTE
-        //
-        if ( header > 5 ) {
-			
-            // qDebug(QString("header: %1 iLat: %2 iLon: %3").arg(header).arg(iLat).arg(iLon).toLatin1());
+    qreal  lonLeft       =  +M_PI;
+    qreal  lonRight      =  -M_PI;
+    qreal  otherLonLeft  =  +M_PI;
+    qreal  otherLonRight =  -M_PI;
+    qreal  latTop        =  -M_PI / 2.0;
+    qreal  latBottom     =  +M_PI / 2.0;
 
-            GeoPolygon  *polyline = new GeoPolygon();
-            m_parent->append( polyline );
+    bool isCrossingDateLine = false;
+    bool isOriginalSide = true;
+    int  lastSign     = 0;
 
-//            polyline->m_sourceFileName=filename;
-            polyline->setIndex( header );
+    GeoDataCoordinates::Vector::ConstIterator  itPoint = polyline->constBegin();
+    GeoDataCoordinates::Vector::ConstIterator  itEndPoint = polyline->constEnd();
 
-            // Find out whether the Polyline is a river or a closed polygon
-            if ( ( header >= 7000 && header < 8000 )
-                 || ( header >= 9000 && header < 20000 ) )
-                polyline->setClosed( false );
-            else 
-                polyline->setClosed( true );
+    for ( ; itPoint != itEndPoint; ++itPoint ) {
+        itPoint->geoCoordinates( lon, lat );
+
+        int currentSign = ( lon > 0.0 ) ? 1 : -1 ;
 
-            polyline->append( GeoDataCoordinates( (qreal)(iLon) * INT2RAD, (qreal)(iLat) * INT2RAD,
-                                                  0.0, GeoDataCoordinates::Radian, 5 ) );
+        if( itPoint == polyline->constBegin() ) {
+            lastSign = currentSign;
+            lastLon  = lon;
         }
-        else {
-            // qDebug(QString("header: %1 iLat: %2 iLon: %3").arg(header).arg(iLat).arg(iLon).toLatin1());
-            m_parent->last()->append( GeoDataCoordinates( (qreal)(iLon) * INT2RAD,
-                                                          (qreal)(iLat) * INT2RAD, 0.0,
-                                                          GeoDataCoordinates::Radian,
-                                                          (int)(header) ) ); 
+
+        if ( lastSign != currentSign && fabs(lastLon) + fabs(lon) > M_PI ) {
+            isOriginalSide = !isOriginalSide;
+            isCrossingDateLine = true;
         }
-        ++count;
+
+        if ( isOriginalSide ) {
+            if ( lon < lonLeft  ) lonLeft = lon;
+            if ( lon > lonRight ) lonRight = lon;
+        } else {
+            if ( lon < otherLonLeft  ) otherLonLeft = lon;
+            if ( lon > otherLonRight ) otherLonRight = lon;
+        }
+
+        if ( lat > latTop )    latTop = lat;
+        if ( lat < latBottom ) latBottom = lat;
+
+        lastSign = currentSign;
+        lastLon  = lon;
     }
-    munmap(src,filelength);
-    close(fd);
-
-    // qDebug(QString("Opened %1 with %2 Polylines and %3 Points").arg(filename).arg(this->count()).arg(count).toLatin1());
-    // MMAP End
-#else
-#  ifdef Q_OS_WIN
-
-    // qDebug("Loading PntMap ...");
-    int    count = 0;
-    QFile  file( m_filename );
-
-    file.open( QIODevice::ReadOnly );
-    QDataStream stream( &file );  // read the data serialized from the file
-    stream.setByteOrder( QDataStream::LittleEndian );
-
-    short  header;
-    short  iLat;
-    short  iLon;
-
-    // Iterator that points to current PolyLine in PntMap
-    //	QList<GeoPolygon*>::iterator it = begin();
-    //	int count = 0;
-
-    while( !stream.atEnd() ){	
-        stream >> header >> iLat >> iLon;		
-        // Transforming Range of Coordinates to iLat [0,ARCMINUTE] , iLon [0,2 * ARCMINUTE] 
-						
-        if ( header > 5 ) {
-			
-            // qDebug(QString("header: %1 iLat: %2 iLon: %3").arg(header).arg(iLat).arg(iLon).toLatin1());
-            GeoPolygon  *polyline = new GeoPolygon();
-            m_parent->append( polyline );
 
-            polyline->setIndex(header);
+    if ( !isOriginalSide ) {
+        polyline->setDateLine( GeoPolygon::Odd );
+        polyline->setBoundary( -M_PI, latTop, M_PI, -M_PI / 2.0 );
+    }
 
-            // Find out whether the Polyline is a river or a closed polygon
-            if ( ( header >= 7000 && header < 8000 )
-                 || ( header >= 9000 && header < 20000 ) )
-                polyline->setClosed( false );
-            else 
-                polyline->setClosed( true );
+    if ( isOriginalSide && isCrossingDateLine ) {
+        polyline->setDateLine( GeoPolygon::Even );
 
-            polyline->append( GeoDataCoordinates( (qreal)(iLon) * INT2RAD, (qreal)(iLat) * INT2RAD,
-                                                  0.0, GeoDataCoordinates::Radian, 5 ) );
-        }
-        else {
-            // qDebug(QString("header: %1 iLat: %2 iLon: %3").arg(header).arg(iLat).arg(iLon).toLatin1());
-            m_parent->last()->append( GeoDataCoordinates( (qreal)(iLon) * INT2RAD,
-                                                          (qreal)(iLat) * INT2RAD, 0.0,
-                                                          GeoDataCoordinates::Radian,
-                                                          (int)(header) ) );
+        qreal leftLonRight, rightLonLeft;
+
+        if ( fabs( M_PI * lonRight/fabs(lonRight) - lonRight ) >
+             fabs( M_PI * otherLonRight/fabs(otherLonRight) - otherLonRight ) ) {
+            rightLonLeft = otherLonLeft;
+            leftLonRight = lonRight;
+        } else {
+            rightLonLeft = lonLeft;
+            leftLonRight = otherLonRight;
         }
-        ++count;
+
+        polyline->setBoundary( rightLonLeft, latTop, leftLonRight, latBottom );
     }
-	
-    file.close();
-    // qDebug(QString("Opened %1 with %2 Polylines and %3 Points").arg(filename).arg(this->count()).arg(count).toLatin1());
 
-#  else
-#  warning Your OS is not supported!
-#  endif
-#endif
+    if ( !isCrossingDateLine ) {
+        polyline->setDateLine( GeoPolygon::None );
+        polyline->setBoundary( lonLeft, latTop, lonRight, latBottom );
+    }
+}
 
+// Decodes the points of a single polyline. Each polyline only touches
+// its own GeoPolygon, so polylines can be decoded concurrently.
+void decodePolyline( PntPolylineRecords &records )
+{
+    GeoPolygon *const polyline = records.polyline;
+    polyline->reserve( records.count );
 
-    // To optimize performance we compute the boundaries of the
-    // polygons.  To detect inside/outside we need to detect the
-    // dateline first We probably won't need this for spherical
-    // projection but for flat projection
+    // Transforming Range of Coordinates to iLat [0,ARCMINUTE] ,
+    // iLon [0,2 * ARCMINUTE]
     //
-    // FIXME: Break this out into its own function.
-		
-    qreal  lon     = 0.0;
-    qreal  lastLon = 0.0;
-    qreal  lat     = 0.0;
+    // 90 00N =   -ARCMINUTE / 2
+    // 90 00S =   ARCMINUTE / 2
+    // 180 00W =  -ARCMINUTE
+    // 180 00E =   ARCMINUTE
+    //
+    const uchar *record = records.begin;
+    for ( int i = 0; i < records.count; ++i, record += 6 ) {
+        const short header = pntShort( record );
+        const short iLat = pntShort( record + 2 );
+        const short iLon = pntShort( record + 4 );
 
-    GeoPolygon::PtrVector::ConstIterator       itPolyLine;
-    GeoPolygon::PtrVector::ConstIterator  itEndPolyLine = m_parent->constEnd();
-    GeoDataCoordinates::Vector::ConstIterator   itPoint;
-
-    // Now we calculate the boundaries
-	
-    for ( itPolyLine = m_parent->constBegin(); itPolyLine != itEndPolyLine; ++itPolyLine ) {
-		
-        qreal  lonLeft       =  +M_PI;
-        qreal  lonRight      =  -M_PI;
-        qreal  otherLonLeft  =  +M_PI;
-        qreal  otherLonRight =  -M_PI;
-        qreal  latTop        =  -M_PI / 2.0;
-        qreal  latBottom     =  +M_PI / 2.0;		
-
-        bool isCrossingDateLine = false;
-        bool isOriginalSide = true;
-        int  lastSign     = 0;
-
-        GeoDataCoordinates::Vector::ConstIterator  itEndPoint = (*itPolyLine)->constEnd();
-					
-        for ( itPoint = (*itPolyLine)->constBegin();
-                itPoint != itEndPoint;
-                ++itPoint )
-        {
-            itPoint->geoCoordinates( lon, lat );
-
-            int currentSign = ( lon > 0.0 ) ? 1 : -1 ;
-
-            if( itPoint == (*itPolyLine)->constBegin() ) {
-                lastSign = currentSign;
-                lastLon  = lon;
-            }
-
-            if ( lastSign != currentSign && fabs(lastLon) + fabs(lon) > M_PI ) {
-                isOriginalSide = !isOriginalSide;
-                isCrossingDateLine = true;
-            }
-
-            if ( isOriginalSide ) {
-                if ( lon < lonLeft  ) lonLeft = lon;
-                if ( lon > lonRight ) lonRight = lon;
-            } else {
-                if ( lon < otherLonLeft  ) otherLonLeft = lon;
-                if ( lon > otherLonRight ) otherLonRight = lon;
-            }
-
-            if ( lat > latTop )    latTop = lat;
-            if ( lat < latBottom ) latBottom = lat;
+        // the header record of a polyline carries the most sparse level of detail
+        const int detail = ( i == 0 ) ? 5 : (int)( header );
 
-            lastSign = currentSign;
-            lastLon  = lon;
-        }
+        polyline->append( GeoDataCoordinates( (qreal)(iLon) * INT2RAD, (qreal)(iLat) * INT2RAD,
+                                              0.0, GeoDataCoordinates::Radian, detail ) );
+    }
 
-        if ( !isOriginalSide ) {
-            (*itPolyLine)->setDateLine( GeoPolygon::Odd );
-//            mDebug() << "Odd  >> File: " << (*itPolyLine)->m_sourceFileName;
-            (*itPolyLine)->setBoundary( -M_PI, latTop, M_PI, -M_PI / 2.0 );
-//            mDebug() << " lonLeft: " << lonLeft << " lonRight: " << lonRight << " otherLonLeft: " << otherLonLeft << " otherlonRight: " << otherLonRight;
-        }
+    computeBoundary( polyline );
+}
+
+}
 
-        if ( isOriginalSide && isCrossingDateLine ) {
-            (*itPolyLine)->setDateLine( GeoPolygon::Even );
-//            mDebug() << "Even >> File: " << (*itPolyLine)->m_sourceFileName << " Size: " << (*itPolyLine)->size();
+PntMapLoader::PntMapLoader( PntMap* parent, const QString& filename )
+    : m_parent( parent ),
+      m_filename( filename )
+{
+}
 
-//            mDebug() << " lonLeft: " << lonLeft << " lonRight: " << lonRight << " otherLonLeft: " << otherLonLeft << " otherlonRight: " << otherLonRight;
+PntMapLoader::~PntMapLoader()
+{
+    // polylines that were not taken over by the PntMap
+    qDeleteAll( m_polylines );
+}
 
-            qreal leftLonRight, rightLonLeft;
+GeoPolygon::PtrVector PntMapLoader::takePolylines()
+{
+    const GeoPolygon::PtrVector polylines = m_polylines;
+    m_polylines.clear();
 
-            if ( fabs( M_PI * lonRight/fabs(lonRight) - lonRight ) >  
-                 fabs( M_PI * otherLonRight/fabs(otherLonRight) - otherLonRight ) ) {
-                rightLonLeft = otherLonLeft; 
-                leftLonRight = lonRight; 
-            } else {
-                rightLonLeft = lonLeft;
-                leftLonRight = otherLonRight;
-            }
+    return polylines;
+}
 
-            (*itPolyLine)->setBoundary( rightLonLeft, latTop, leftLonRight, latBottom );
+void PntMapLoader::run()
+{
+    QTime timer;
+    timer.restart();
+
+    QFile file( m_filename );
+    if ( !file.open( QIODevice::ReadOnly ) ) {
+        mDebug() << "cannot open" << m_filename << "for reading";
+        emit pntMapLoaded( false );
+        return;
+    }
+
+    const qint64 filelength = file.size();
+    const uchar *const src = file.map( 0, filelength );
+    if ( !src ) {
+        mDebug() << "cannot map" << m_filename;
+        emit pntMapLoaded( false );
+        return;
+    }
 
-//            mDebug() << "Crosses: lonLeft: " << rightLonLeft << " is right from: lonRight: " << leftLonRight;
+    // First pass: find the records that start a polyline, i.e. that have
+    // a header greater than 5. The remaining records are points whose
+    // header holds the level of detail.
+    const int recordCount = filelength / 6;
+    QVector<PntPolylineRecords> polylines;
 
+    for ( int i = 0; i < recordCount; ++i ) {
+        const uchar *const record = src + 6 * i;
+        const short header = pntShort( record );
+
+        if ( header > 5 ) {
+            GeoPolygon  *polyline = new GeoPolygon();
+            m_polylines.append( polyline );
+
+            polyline->setIndex( header );
+
+            // Find out whether the Polyline is a river or a closed polygon
+            if ( ( header >= 7000 && header < 8000 )
+                 || ( header >= 9000 && header < 20000 ) )
+                polyline->setClosed( false );
+            else 
+                polyline->setClosed( true );
+
+            PntPolylineRecords records;
+            records.polyline = polyline;
+            records.begin = record;
+            records.count = 1;
+            polylines.append( records );
         }
-        if ( !isCrossingDateLine ) {
-            (*itPolyLine)->setDateLine( GeoPolygon::None );
-            (*itPolyLine)->setBoundary( lonLeft, latTop, lonRight, latBottom );
+        else if ( !polylines.isEmpty() ) {
+            ++polylines.last().count;
         }
     }
 
-    mDebug() << Q_FUNC_INFO << "Loaded" << m_filename << "in" << timer.elapsed() << "ms";
+    // Second pass: decode the points and compute the boundaries.
+    QtConcurrent::blockingMap( polylines, decodePolyline );
+
+    file.unmap( const_cast<uchar *>( src ) );
+    file.close();
+
+    mDebug() << Q_FUNC_INFO << "Loaded" << m_filename << "with" << m_polylines.size() << "polylines and"
+             << recordCount << "points in" << timer.elapsed() << "ms";
 
     emit pntMapLoaded( true );
 }
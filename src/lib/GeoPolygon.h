@@ -67,6 +67,11 @@ class MARBLE_EXPORT GeoPolygon : public GeoDataCoordinates::Vector
     void setBoundary( qreal, qreal, qreal, qreal );
     GeoDataCoordinates::PtrVector getBoundary() const { return m_boundary; }
 
+    qreal getLonLeft() const { return m_lonLeft; }
+    qreal getLatTop() const { return m_latTop; }
+    qreal getLonRight() const { return m_lonRight; }
+    qreal getLatBottom() const { return m_latBottom; }
+
     void displayBoundary();
 
     // Type definitions
@@ -94,6 +99,7 @@ class MARBLE_EXPORT GeoPolygon : public GeoDataCoordinates::Vector
  * FIXME: Rename it (into GeoPolygonMap?)
  */
 
+class GeoDataLatLonBox;
 class PntMapLoader;
 
 class MARBLE_EXPORT PntMap : public QObject,
@@ -108,6 +114,16 @@ class MARBLE_EXPORT PntMap : public QObject,
 
     void load( const QString & );
 
+    /**
+     * @brief Collects the polylines whose bounding box intersects @p box.
+     *
+     * The polylines are returned in the order of the file so that painting
+     * order is preserved. The lookup uses a grid index over longitude and
+     * latitude that is built when loading has finished; before that all
+     * polylines are returned.
+     */
+    void intersecting( const GeoDataLatLonBox &box, GeoPolygon::PtrVector &polylines ) const;
+
  Q_SIGNALS:
     void initialized();
 
@@ -115,9 +131,17 @@ class MARBLE_EXPORT PntMap : public QObject,
     void setInitialized( bool );
 
  private:
+    void buildIndex();
+    void addToIndex( int polyline, qreal lonLeft, qreal latTop, qreal lonRight, qreal latBottom );
+    static int column( qreal lon );
+    static int row( qreal lat );
+
     bool m_isInitialized;
     PntMapLoader* m_loader;
 
+    // polyline indices per grid cell, row-major
+    QVector< QVector<int> > m_cells;
+
     Q_DISABLE_COPY( PntMap )
 };
 
@@ -126,6 +150,14 @@ class MARBLE_EXPORT PntMapLoader : public QThread
     Q_OBJECT
     public:
         PntMapLoader( PntMap* parent, const QString& filename );
+        ~PntMapLoader();
+
+        /**
+         * @brief Hands the loaded polylines over to the caller.
+         *
+         * Only call this after pntMapLoaded( true ) has been emitted.
+         */
+        GeoPolygon::PtrVector takePolylines();
 
         void run();
     Q_SIGNALS:
@@ -134,6 +166,7 @@ class MARBLE_EXPORT PntMapLoader : public QThread
     private:
         PntMap *m_parent;
         QString m_filename;
+        GeoPolygon::PtrVector m_polylines;
 };
 
 }
@@ -9,15 +9,24 @@
 
 #include "MarbleAbstractRunner.h"
 
+#include "GeoDataStyle.h"
+#include "GeoDataStyleMap.h"
+
+#include <QtCore/QIODevice>
 #include <QtCore/QThread>
 #include <QtCore/QString>
 
 namespace Marble
 {
 
+// Amount of a file to read before its features are handed over
+static const qint64 streamingBatchSize = 4 * 1024 * 1024;
+
 MarbleAbstractRunner::MarbleAbstractRunner( QObject *parent )
     : QObject( parent ),
-      m_model( 0 )
+      m_model( 0 ),
+      m_streamedPosition( 0 ),
+      m_streamedStyles( 0 )
 {
     // nothing to do
 }
@@ -61,6 +70,69 @@ void MarbleAbstractRunner::parseFile( const QString &, DocumentRole )
     emit parsingFinished( 0, "Not Implemented" );
 }
 
+void MarbleAbstractRunner::setStreaming( const QSharedPointer<QAtomicInt> &canceled )
+{
+    m_canceled = canceled;
+    m_streamedPosition = 0;
+    m_streamedStyles = 0;
+}
+
+void MarbleAbstractRunner::setLatLonBox( const GeoDataLatLonBox &latLonBox )
+{
+    m_latLonBox = latLonBox;
+}
+
+const GeoDataLatLonBox &MarbleAbstractRunner::latLonBox() const
+{
+    return m_latLonBox;
+}
+
+bool MarbleAbstractRunner::streamFeatures( GeoDataDocument *document, const QIODevice *device )
+{
+    if ( !m_canceled ) {
+        return true;
+    }
+
+    if ( *m_canceled ) {
+        return false;
+    }
+
+    const qint64 position = device->pos();
+    if ( document->size() == 0 || position - m_streamedPosition < streamingBatchSize ) {
+        return true;
+    }
+    m_streamedPosition = position;
+
+    GeoDataDocument *const features = new GeoDataDocument;
+    features->setName( document->name() );
+
+    // Styles are few and usually come first, only pass them on when there are new ones
+    const QList<GeoDataStyle> styles = document->styles();
+    const QList<GeoDataStyleMap> styleMaps = document->styleMaps();
+    if ( styles.size() + styleMaps.size() != m_streamedStyles ) {
+        m_streamedStyles = styles.size() + styleMaps.size();
+        foreach ( const GeoDataStyle &style, styles ) {
+            features->addStyle( style );
+        }
+        foreach ( const GeoDataStyleMap &styleMap, styleMaps ) {
+            features->addStyleMap( styleMap );
+        }
+    }
+
+    // The features still refer to the styles of document, the receiver has to look them up again
+    features->reserve( document->size() );
+    foreach ( GeoDataFeature *feature, document->featureList() ) {
+        features->append( feature );
+    }
+    while ( document->size() > 0 ) {
+        document->remove( document->size() - 1 );
+    }
+
+    emit featuresParsed( features, device->size() > 0 ? qreal( position ) / device->size() : 0.0 );
+
+    return true;
+}
+
 }
 
 #include "MarbleAbstractRunner.moc"
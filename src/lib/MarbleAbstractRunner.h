@@ -16,10 +16,15 @@
 #include "GeoDataFeature.h"
 #include "GeoDataPlacemark.h"
 #include "GeoDataDocument.h"
+#include "GeoDataLatLonBox.h"
 
+#include <QtCore/QAtomicInt>
+#include <QtCore/QSharedPointer>
 #include <QtCore/QThread>
 #include <QtCore/QVector>
 
+class QIODevice;
+
 namespace Marble
 {
 
@@ -83,6 +88,23 @@ public:
       */
     virtual void parseFile( const QString &fileName, DocumentRole role );
 
+    /**
+      * Makes parseFile hand over the top-level features of large files in
+      * batches via the featuresParsed signal while parsing is still going on,
+      * parsingFinished then only carries the rest of the document. Parsing
+      * stops early once @p canceled becomes non-zero, which may happen in any
+      * thread. Runners that cannot parse incrementally ignore this.
+      * Pass a null pointer to parse files in one go again.
+      */
+    void setStreaming( const QSharedPointer<QAtomicInt> &canceled );
+
+    /**
+      * Limits parseFile to the features intersecting @p latLonBox. Runners
+      * that cannot read parts of a file ignore this, an empty box stands
+      * for the whole file.
+      */
+    void setLatLonBox( const GeoDataLatLonBox &latLonBox );
+
 Q_SIGNALS:
 
     /**
@@ -110,14 +132,39 @@ Q_SIGNALS:
       */
     void parsingFinished( GeoDataDocument* document, const QString& error = QString() );
 
+    /**
+      * A batch of top-level features of the file being parsed, along with the
+      * styles of the file known so far. @p progress is the fraction of the
+      * file read. Only emitted if streaming was enabled with @see setStreaming.
+      */
+    void featuresParsed( GeoDataDocument* features, qreal progress );
+
 protected:
     /**
       * Access to the currently used map, or null if no was set with @see setMap
       */
     MarbleModel * model();
 
+    /**
+      * For runners parsing @p document incrementally from @p device: moves the
+      * top-level features parsed so far into a new document and emits it via
+      * featuresParsed, once enough of the device was read since the last batch.
+      * Does nothing if streaming is disabled.
+      * @return false if parsing was canceled and should stop
+      */
+    bool streamFeatures( GeoDataDocument *document, const QIODevice *device );
+
+    /**
+      * The region parseFile is limited to, @see setLatLonBox
+      */
+    const GeoDataLatLonBox &latLonBox() const;
+
 private:
     MarbleModel *m_model;
+    QSharedPointer<QAtomicInt> m_canceled;
+    qint64 m_streamedPosition;
+    int m_streamedStyles;
+    GeoDataLatLonBox m_latLonBox;
 };
 
 }
@@ -21,6 +21,7 @@
 
 // Qt
 #include <QtCore/QAbstractItemModel>
+#include <QtCore/qmath.h>
 #include <QtCore/QTime>
 #include <QtCore/QTimer>
 #include <QtGui/QItemSelectionModel>
@@ -43,6 +44,7 @@
 #include "layers/VectorMapLayer.h"
 #include "layers/VectorTileLayer.h"
 #include "AbstractFloatItem.h"
+#include "FileManager.h"
 #include "GeoDataTreeModel.h"
 #include "GeoPainter.h"
 #include "GeoSceneDocument.h"
@@ -113,6 +115,10 @@ public:
 
     void updateProperty( const QString &, bool );
 
+    void updateTessellationTolerance();
+
+    void updatePlacemarkCaches();
+
     MarbleMap *const q;
 
     // The model we are showing.
@@ -169,6 +175,9 @@ MarbleMapPrivate::MarbleMapPrivate( MarbleMap *parent, MarbleModel *model )
 
     QObject::connect( &m_placemarkLayer, SIGNAL( repaintNeeded()),
                       parent, SIGNAL( repaintNeeded() ));
+    // Features get shown and hidden through the tree model.
+    QObject::connect( model->treeModel(), SIGNAL( dataChanged( QModelIndex, QModelIndex ) ),
+                      &m_placemarkLayer, SLOT( requestVisibilityUpdate() ) );
 
     QObject::connect ( &m_layerManager, SIGNAL( pluginSettingsChanged() ),
                        parent,        SIGNAL( pluginSettingsChanged() ) );
@@ -186,9 +195,43 @@ MarbleMapPrivate::MarbleMapPrivate( MarbleMap *parent, MarbleModel *model )
                       parent, SIGNAL( tileLevelChanged( int ) ) );
     QObject::connect( &m_textureLayer, SIGNAL( repaintNeeded() ),
                       parent, SIGNAL( repaintNeeded() ) );
+    QObject::connect( &m_vectorTileLayer, SIGNAL( repaintNeeded() ),
+                      parent, SIGNAL( repaintNeeded() ) );
 
     QObject::connect( parent, SIGNAL( visibleLatLonAltBoxChanged( const GeoDataLatLonAltBox & ) ),
                       parent, SIGNAL( repaintNeeded() ) );
+    QObject::connect( parent, SIGNAL( visibleLatLonAltBoxChanged( const GeoDataLatLonAltBox & ) ),
+                      parent, SLOT( updatePlacemarkCaches() ) );
+
+    updateTessellationTolerance();
+}
+
+void MarbleMapPrivate::updatePlacemarkCaches()
+{
+    // The zoom level the placemark layout shows placemarks up to
+    const int zoomLevel = qLn( m_viewport.radius() * 4 / 256 ) / qLn( 2.0 );
+    m_model->fileManager()->setViewport( m_viewport.viewLatLonAltBox(), zoomLevel );
+}
+
+void MarbleMapPrivate::updateTessellationTolerance()
+{
+    // Lines may deviate further from the exact great circles while the
+    // map is moving, but should be exact when printed.
+    switch ( m_viewParams.mapQuality() ) {
+    case OutlineQuality:
+    case LowQuality:
+        m_viewport.setTessellationTolerance( 2.0 );
+        break;
+    case NormalQuality:
+        m_viewport.setTessellationTolerance( 1.0 );
+        break;
+    case HighQuality:
+        m_viewport.setTessellationTolerance( 0.5 );
+        break;
+    case PrintQuality:
+        m_viewport.setTessellationTolerance( 0.25 );
+        break;
+    }
 }
 
 void MarbleMapPrivate::updateProperty( const QString &name, bool show )
@@ -297,6 +340,7 @@ const ViewportParams *MarbleMap::viewport() const
 void MarbleMap::setMapQualityForViewContext( MapQuality quality, ViewContext viewContext )
 {
     d->m_viewParams.setMapQualityForViewContext( quality, viewContext );
+    d->updateTessellationTolerance();
 
     // Update texture map during the repaint that follows:
     d->m_textureLayer.setNeedsUpdate();
@@ -317,6 +361,7 @@ void MarbleMap::setViewContext( ViewContext viewContext )
     const MapQuality oldQuality = d->m_viewParams.mapQuality();
 
     d->m_viewParams.setViewContext( viewContext );
+    d->updateTessellationTolerance();
 
     if ( d->m_viewParams.mapQuality() != oldQuality ) {
         // Update texture map during the repaint that follows:
@@ -640,6 +640,11 @@ void MarbleModel::addGeoDataFile( const QString& filename )
     d->m_fileManager->addFile( filename, UserDocument, true );
 }
 
+void MarbleModel::addGeoDataFile( const QString& filename, const GeoDataLatLonBox &latLonBox )
+{
+    d->m_fileManager->addFile( filename, UserDocument, true, latLonBox );
+}
+
 void MarbleModel::addGeoDataString( const QString& data, const QString& key )
 {
     d->m_fileManager->addData( key, data, UserDocument );
@@ -60,6 +60,7 @@ class TileCreator;
 class PluginManager;
 class GeoDataCoordinates;
 class GeoDataDocument;
+class GeoDataLatLonBox;
 class GeoDataTreeModel;
 class GeoSceneDocument;
 class Planet;
@@ -204,6 +205,13 @@ class MARBLE_EXPORT MarbleModel : public QObject
     MARBLE_DEPRECATED( void removePlacemarkKey( const QString& key ) );
 
     void addGeoDataFile( const QString& filename );
+
+    /**
+      * Loads the features of @p filename within @p latLonBox only, like
+      * the visible region of a large shapefile. File formats that cannot
+      * be read in parts are loaded completely.
+      */
+    void addGeoDataFile( const QString& filename, const GeoDataLatLonBox &latLonBox );
     void addGeoDataString( const QString& data, const QString& key = "data" );
     void removeGeoData( const QString& key );
     FileManager       *fileManager();
@@ -119,9 +119,11 @@ QVariant MarblePlacemarkModel::data( const QModelIndex &index, int role ) const
     } else if ( role == StyleRole ) {
         return qVariantFromValue( d->m_placemarkContainer->at( index.row() )->style() );
     } else if ( role == GmtRole ) {
-        return qVariantFromValue( d->m_placemarkContainer->at( index.row() )->extendedData().value("gmt").value() );
+        const GeoDataPlacemark *placemark = d->m_placemarkContainer->at( index.row() );
+        return placemark->hasExtendedData() ? placemark->extendedData().value("gmt").value() : QVariant();
     } else if ( role == DstRole ) {
-        return qVariantFromValue( d->m_placemarkContainer->at( index.row() )->extendedData().value("dst").value() );
+        const GeoDataPlacemark *placemark = d->m_placemarkContainer->at( index.row() );
+        return placemark->hasExtendedData() ? placemark->extendedData().value("dst").value() : QVariant();
     } else if ( role == GeometryRole ) {
         return qVariantFromValue( d->m_placemarkContainer->at( index.row() )->geometry() );
     } else if ( role == ObjectPointerRole ) {
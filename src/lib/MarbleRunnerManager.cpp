@@ -11,6 +11,7 @@
 
 #include "MarbleRunnerManager.h"
 
+#include "FileManager.h"
 #include "MarblePlacemarkModel.h"
 #include "MarbleDebug.h"
 #include "MarbleModel.h"
@@ -20,6 +21,7 @@
 #include "GeoDataPlacemark.h"
 #include "PluginManager.h"
 #include "ParseRunnerPlugin.h"
+#include "ParseRunnerSelection.h"
 #include "ReverseGeocodingRunnerPlugin.h"
 #include "RoutingRunnerPlugin.h"
 #include "SearchRunnerPlugin.h"
@@ -27,13 +29,16 @@
 #include "routing/RouteRequest.h"
 #include "routing/RoutingProfilesModel.h"
 
+#include <QtCore/QAtomicInt>
 #include <QtCore/QObject>
+#include <QtCore/QSharedPointer>
 #include <QtCore/QString>
 #include <QtCore/QVector>
 #include <QtCore/QThreadPool>
 #include <QtCore/QTimer>
 #include <QtCore/QFileInfo>
 
+
 namespace Marble
 {
 
@@ -66,8 +71,12 @@ public:
     QList<RunnerTask*> m_reverseTasks;
     QList<RunnerTask*> m_routingTasks;
     QList<RunnerTask*> m_parsingTasks;
+    QSharedPointer<QAtomicInt> m_parsingCanceled;
     int m_watchdogTimer;
 
+    // Built on the first parseFile()
+    ParseRunnerSelection *m_parseRunnerSelection;
+
     void addSearchResult( QVector<GeoDataPlacemark*> result );
     void addReverseGeocodingResult( const GeoDataCoordinates &coordinates, const GeoDataPlacemark &placemark );
     void addRoutingResult( GeoDataDocument* route );
@@ -86,10 +95,12 @@ MarbleRunnerManagerPrivate::MarbleRunnerManagerPrivate( MarbleRunnerManager* par
         m_fileResult( 0 ),
         m_marbleModel( 0 ),
         m_pluginManager( pluginManager ),
-        m_watchdogTimer( 30000 )
+        m_watchdogTimer( 30000 ),
+        m_parseRunnerSelection( 0 )
 {
     m_model->setPlacemarkContainer( &m_placemarkContainer );
     qRegisterMetaType<GeoDataDocument*>( "GeoDataDocument*" );
+    qRegisterMetaType<qreal>( "qreal" );
     qRegisterMetaType<GeoDataPlacemark>( "GeoDataPlacemark" );
     qRegisterMetaType<GeoDataCoordinates>( "GeoDataCoordinates" );
     qRegisterMetaType<QVector<GeoDataPlacemark*> >( "QVector<GeoDataPlacemark*>" );
@@ -97,7 +108,7 @@ MarbleRunnerManagerPrivate::MarbleRunnerManagerPrivate( MarbleRunnerManager* par
 
 MarbleRunnerManagerPrivate::~MarbleRunnerManagerPrivate()
 {
-    // nothing to do
+    delete m_parseRunnerSelection;
 }
 
 template<typename T>
@@ -210,6 +221,11 @@ void MarbleRunnerManager::findPlacemarks( const QString &searchTerm, const GeoDa
         return;
     }
 
+    // Placemarks of mapped caches need to exist to be found
+    if ( d->m_marbleModel ) {
+        d->m_marbleModel->fileManager()->addMatchingPlacemarks( searchTerm );
+    }
+
     QList<const SearchRunnerPlugin*> plugins = d->plugins( d->m_pluginManager->searchRunnerPlugins() );
     foreach( const SearchRunnerPlugin* plugin, plugins ) {
         SearchTask* task = new SearchTask( plugin, this, d->m_marbleModel, searchTerm, preferred );
@@ -372,26 +388,39 @@ QVector<GeoDataDocument*> MarbleRunnerManager::searchRoute( const RouteRequest *
     return d->m_routingResult;
 }
 
-void MarbleRunnerManager::parseFile( const QString &fileName, DocumentRole role )
+void MarbleRunnerManager::parseFile( const QString &fileName, DocumentRole role, bool streaming,
+                                     const GeoDataLatLonBox &latLonBox )
 {
-    QList<const ParseRunnerPlugin*> plugins = d->m_pluginManager->parsingRunnerPlugins();
-    QFileInfo const fileInfo( fileName );
-    QString const suffix = fileInfo.suffix();
-    QString const completeSuffix = fileInfo.completeSuffix();
-    foreach( const ParseRunnerPlugin *plugin, plugins ) {
-        QStringList const extensions = plugin->fileExtensions();
-        if ( extensions.isEmpty() || extensions.contains( suffix ) || extensions.contains( completeSuffix ) ) {
-            ParsingTask *task = new ParsingTask( plugin, this, fileName, role );
-            connect( task, SIGNAL( finished( RunnerTask* ) ), this, SLOT( cleanupParsingTask(RunnerTask*) ) );
-            mDebug() << "parse task " << plugin->nameId() << " " << (long)task;
-            d->m_parsingTasks << task;
-            QThreadPool::globalInstance()->start( task );
-        }
+    // Running tasks keep their own reference, so a new flag won't affect them
+    if ( streaming && ( !d->m_parsingCanceled || *d->m_parsingCanceled ) ) {
+        d->m_parsingCanceled = QSharedPointer<QAtomicInt>( new QAtomicInt( 0 ) );
     }
 
+    // A single task tries the runners in turn instead of all of them
+    // parsing the same file at once
+    if ( !d->m_parseRunnerSelection ) {
+        d->m_parseRunnerSelection = new ParseRunnerSelection( d->m_pluginManager->parsingRunnerPlugins() );
+    }
+    QList<const ParseRunnerPlugin*> const plugins = d->m_parseRunnerSelection->plugins( fileName );
     if ( plugins.isEmpty() ) {
         emit parsingFinished( 0 );
         d->cleanupParsingTask( 0 );
+        return;
+    }
+
+    ParsingTask *task = new ParsingTask( plugins, this, fileName, role,
+                                         streaming ? d->m_parsingCanceled : QSharedPointer<QAtomicInt>(),
+                                         latLonBox );
+    connect( task, SIGNAL( finished( RunnerTask* ) ), this, SLOT( cleanupParsingTask(RunnerTask*) ) );
+    mDebug() << "parse task " << plugins.first()->nameId() << " " << (long)task;
+    d->m_parsingTasks << task;
+    QThreadPool::globalInstance()->start( task );
+}
+
+void MarbleRunnerManager::cancelParsing()
+{
+    if ( d->m_parsingCanceled ) {
+        d->m_parsingCanceled->fetchAndStoreOrdered( 1 );
     }
 }
 
@@ -405,7 +434,8 @@ void MarbleRunnerManagerPrivate::addParsingResult( GeoDataDocument *document, co
     }
 }
 
-GeoDataDocument* MarbleRunnerManager::openFile( const QString &fileName, DocumentRole role ) {
+GeoDataDocument* MarbleRunnerManager::openFile( const QString &fileName, DocumentRole role,
+                                                const GeoDataLatLonBox &latLonBox ) {
     QEventLoop localEventLoop;
     QTimer watchdog;
     watchdog.setSingleShot(true);
@@ -415,7 +445,7 @@ GeoDataDocument* MarbleRunnerManager::openFile( const QString &fileName, Documen
             &localEventLoop, SLOT(quit()), Qt::QueuedConnection );
 
     watchdog.start( d->m_watchdogTimer );
-    parseFile( fileName, role);
+    parseFile( fileName, role, false, latLonBox );
     localEventLoop.exec();
     return d->m_fileResult;
 }
@@ -86,13 +86,30 @@ public:
 
     /**
       * Parse the file using the runners for various formats
+      * The runner is chosen by the extension of the file, or by its content
+      * if no runner handles the extension, see ParseRunnerSelection. Further
+      * runners that might read it are only tried if that one fails.
       * @see parseFile is asynchronous with results returned using the
       * @see parsingFinished signal.
       * @see openFile is blocking.
       * @see parsingFinished signal indicates all runners are finished.
+      * With @p streaming, runners that support it hand over the features of
+      * large files in batches with the @see featuresParsed signal while parsing,
+      * and @see cancelParsing can stop them.
+      * A non-empty @p latLonBox limits the result to the features within it,
+      * for runners that can read parts of a file.
       */
-    void parseFile( const QString& fileName, DocumentRole role = UserDocument );
-    GeoDataDocument* openFile( const QString& fileName, DocumentRole role = UserDocument );
+    void parseFile( const QString& fileName, DocumentRole role = UserDocument, bool streaming = false,
+                    const GeoDataLatLonBox &latLonBox = GeoDataLatLonBox() );
+    GeoDataDocument* openFile( const QString& fileName, DocumentRole role = UserDocument,
+                               const GeoDataLatLonBox &latLonBox = GeoDataLatLonBox() );
+
+    /**
+      * Stops the streaming parseFile requests that are still running. Runners
+      * finish with a null document then; batches already handed over with
+      * @see featuresParsed may still arrive.
+      */
+    void cancelParsing();
 
 Q_SIGNALS:
     /**
@@ -140,6 +157,12 @@ Q_SIGNALS:
       */
     void parsingFinished( GeoDataDocument* document, const QString& error = QString() );
 
+    /**
+      * A batch of features of a file parsed with streaming enabled, see
+      * MarbleAbstractRunner::featuresParsed. Ownership passes to the receiver.
+      */
+    void featuresParsed( GeoDataDocument* features, qreal progress );
+
     /** signal emitted whenever all runners are finished for the query
       */
     void parsingFinished();
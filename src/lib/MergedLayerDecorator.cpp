@@ -103,8 +103,9 @@ StackedTile *MergedLayerDecorator::Private::createTile( const QVector<QSharedPoi
     // Image for blending all the texture tiles on it
     QImage resultImage;
 
-    // GeoDataDocument for appending all the vector data features to it
-    GeoDataDocument * resultVector = new GeoDataDocument;
+    // GeoDataDocument for appending all the vector data features to it.
+    // It is owned by the VectorTile it comes from, so there is none without one.
+    GeoDataDocument * resultVector = 0;
 
     // if there are more than one active texture layers, we have to convert the
     // result tile into QImage::Format_ARGB32_Premultiplied to make blending possible
@@ -147,8 +148,6 @@ StackedTile *MergedLayerDecorator::Private::createTile( const QVector<QSharedPoi
         // main GeoDataDocument
         if ( tile->nodeType() == QString("VectorTile") ){
 
-            Q_ASSERT( resultVector );
-
             // FIXME
             // IF IN THE FUTURE MORE THAN ONE VECTORTILE LAYER ARE POSSIBLE,
             // HERE ALL THE GEOMETRIES FROM THE DIFFERENT LAYERS SHOULD BE
@@ -189,29 +188,14 @@ StackedTile *MergedLayerDecorator::loadTile( const TileId &stackedTileId, const
             mDebug() << Q_FUNC_INFO << "could not find blending" << textureLayer->blending();
         }
 
-        /*
-        Here is where the TileLoader chooses between ImageTile and VectorTile
-        Format from VectorTile is available if it is needed to specify the parser
-        that should parse that tile file
-        */
-
-        // ImageTile
+        // ImageTile. The data of vector tiles is loaded and kept by the
+        // VectorTileLayer itself, see TileLoader::loadTileVectorData().
         if ( textureLayer->nodeType() == GeoSceneTypes::GeoSceneTextureTileType ){
             const QImage tileImage = d->m_tileLoader->loadTileImage( textureLayer, tileId, DownloadBrowse );
 
             QSharedPointer<Tile> tile(new TextureTile( tileId, tileImage, blending ) );
             tiles.append( tile );
         }
-
-        // VectorTile
-        if ( textureLayer->nodeType() == GeoSceneTypes::GeoSceneVectorTileType ){
-
-            GeoDataDocument* tileVectordata = d->m_tileLoader->loadTileVectorData( textureLayer, tileId, DownloadBrowse, textureLayer->fileFormat() );
-
-            QSharedPointer<Tile> tile( new VectorTile( tileId, tileVectordata ) );
-
-            tiles.append( tile );
-        }
     }
 
     ( !tiles.isEmpty() );
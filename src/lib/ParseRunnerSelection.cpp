@@ -0,0 +1,126 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "ParseRunnerSelection.h"
+
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QStringList>
+#include <QtCore/QtEndian>
+
+#include <cctype>
+
+#include "ParseRunnerPlugin.h"
+
+namespace Marble
+{
+
+ParseRunnerSelection::ParseRunnerSelection( const QList<const ParseRunnerPlugin*> &plugins )
+{
+    foreach( const ParseRunnerPlugin *plugin, plugins ) {
+        QStringList const extensions = plugin->fileExtensions();
+        if ( extensions.isEmpty() ) {
+            m_genericPlugins << plugin;
+        }
+        foreach( const QString &extension, extensions ) {
+            if ( !m_extensions.contains( extension.toLower() ) ) {
+                m_extensions.insert( extension.toLower(), plugin );
+            }
+        }
+    }
+}
+
+QList<const ParseRunnerPlugin*> ParseRunnerSelection::plugins( const QString &fileName ) const
+{
+    QList<const ParseRunnerPlugin*> result;
+
+    // Only files of unknown extensions are opened to look at their content
+    const ParseRunnerPlugin *plugin = extensionPlugin( fileName );
+    if ( !plugin ) {
+        plugin = m_extensions.value( sniffFileFormat( fileName ) );
+    }
+    if ( plugin ) {
+        result << plugin;
+    }
+
+    foreach( const ParseRunnerPlugin *generic, m_genericPlugins ) {
+        if ( !result.contains( generic ) ) {
+            result << generic;
+        }
+    }
+
+    return result;
+}
+
+const ParseRunnerPlugin *ParseRunnerSelection::extensionPlugin( const QString &fileName ) const
+{
+    QString suffix = QFileInfo( fileName ).completeSuffix().toLower();
+    while ( !suffix.isEmpty() ) {
+        const ParseRunnerPlugin *plugin = m_extensions.value( suffix );
+        if ( plugin ) {
+            return plugin;
+        }
+        const int dot = suffix.indexOf( '.' );
+        suffix = dot < 0 ? QString() : suffix.mid( dot + 1 );
+    }
+
+    return 0;
+}
+
+QString ParseRunnerSelection::sniffFileFormat( const QString &fileName )
+{
+    QFile file( fileName );
+    if ( !file.open( QIODevice::ReadOnly ) ) {
+        return QString();
+    }
+
+    const QByteArray head = file.read( 1024 );
+    const uchar *const data = reinterpret_cast<const uchar *>( head.constData() );
+
+    // Binary formats by their magic numbers
+    if ( head.startsWith( "MVB" ) ) {
+        return "mvb";
+    }
+    if ( head.size() >= 4 && qFromBigEndian<quint32>( data ) == 0x31415926 ) {
+        return "cache";
+    }
+    if ( head.size() >= 4 && qFromBigEndian<qint32>( data ) == 9994 ) {
+        return "shp";
+    }
+    if ( head.mid( 4, 11 ) == QByteArray( "\x0a\x09OSMHeader", 11 ) ) {
+        return "pbf";
+    }
+    if ( head.startsWith( "onKothicDataResponse" ) ) {
+        return "js";
+    }
+
+    // XML formats by their root element
+    int position = head.indexOf( '<' );
+    while ( position >= 0 && position + 1 < head.size() ) {
+        if ( head.mid( position, 4 ) == "<!--" ) {
+            position = head.indexOf( "-->", position );
+        } else if ( head.at( position + 1 ) == '?' || head.at( position + 1 ) == '!' ) {
+            ++position;
+        } else {
+            int end = position + 1;
+            while ( end < head.size() && ( isalnum( uchar( head.at( end ) ) ) || head.at( end ) == ':' ) ) {
+                ++end;
+            }
+            const QByteArray root = head.mid( position + 1, end - position - 1 );
+            return QString::fromLatin1( root.mid( root.lastIndexOf( ':' ) + 1 ).toLower() );
+        }
+
+        if ( position >= 0 ) {
+            position = head.indexOf( '<', position );
+        }
+    }
+
+    return QString();
+}
+
+}
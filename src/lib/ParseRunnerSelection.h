@@ -0,0 +1,60 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_PARSERUNNERSELECTION_H
+#define MARBLE_PARSERUNNERSELECTION_H
+
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QString>
+
+#include "marble_export.h"
+
+namespace Marble
+{
+
+class ParseRunnerPlugin;
+
+/**
+ * @short Picks the parse runners that are tried for a file.
+ *
+ * The runners come in the order they are tried: the one registered for the
+ * extension of the file, or if there is none, the one for the format
+ * recognized from the start of the file, followed by those for any file.
+ *
+ * The map of extensions is built once from the plugins. A selection does
+ * not change afterwards, so plugins() may be called from any thread.
+ */
+class MARBLE_EXPORT ParseRunnerSelection
+{
+ public:
+    explicit ParseRunnerSelection( const QList<const ParseRunnerPlugin*> &plugins );
+
+    QList<const ParseRunnerPlugin*> plugins( const QString &fileName ) const;
+
+ private:
+    /**
+     * Returns the runner for the longest extension of @p fileName, so that
+     * osm.pbf wins over pbf, or 0 if there is none.
+     */
+    const ParseRunnerPlugin *extensionPlugin( const QString &fileName ) const;
+
+    /**
+     * Returns the extension of the format of @p fileName recognized by
+     * magic numbers or the xml root element, or an empty string.
+     */
+    static QString sniffFileFormat( const QString &fileName );
+
+    // Parse runner plugins by lower case file extension
+    QHash<QString, const ParseRunnerPlugin*> m_extensions;
+    QList<const ParseRunnerPlugin*> m_genericPlugins;
+};
+
+}
+
+#endif
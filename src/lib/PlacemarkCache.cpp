@@ -0,0 +1,541 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "PlacemarkCache.h"
+
+#include <QtCore/QBitArray>
+#include <QtCore/QFile>
+#include <QtCore/QHash>
+#include <QtCore/QtAlgorithms>
+#include <QtCore/QtEndian>
+
+#include <cstring>
+
+#include "GeoDataData.h"
+#include "GeoDataExtendedData.h"
+#include "GeoDataLatLonBox.h"
+#include "GeoDataPlacemark.h"
+#include "MarbleDebug.h"
+
+namespace Marble
+{
+
+// Bits of the column and the row in a tile code
+static const int tileCodeBits = 16;
+
+// Regions are looked up in at most this many grid cells
+static const int maximumQueryCells = 64;
+
+class PlacemarkCachePrivate
+{
+ public:
+    PlacemarkCachePrivate();
+
+    const uchar *record( int index ) const;
+    quint32 tileCode( int index ) const;
+    QString string( quint32 reference ) const;
+
+    /**
+     * Adds the records of the levels up to @p levels within the given range
+     * of tile codes and @p latLonBox to @p result.
+     */
+    void addRecords( QVector<int> &result, int levels, quint64 begin, quint64 end,
+                     const GeoDataLatLonBox &latLonBox ) const;
+
+    static bool contains( const GeoDataLatLonBox &latLonBox, qreal lon, qreal lat );
+
+    QFile m_file;
+    QByteArray m_content;
+    const uchar *m_records;
+    const uchar *m_offsets;
+    const uchar *m_stringData;
+    int m_size;
+    quint32 m_stringCount;
+    quint32 m_stringSize;
+    QVector<int> m_levelStarts;
+
+    // Every distinct string is decoded once and shared by all placemarks using it
+    mutable QVector<QString> m_strings;
+    mutable QBitArray m_decoded;
+
+    QBitArray m_materialized;
+};
+
+static double readDouble( const uchar *data )
+{
+    const quint64 bits = qFromLittleEndian<quint64>( data );
+    double value;
+    memcpy( &value, &bits, sizeof( value ) );
+    return value;
+}
+
+static void writeDouble( double value, uchar *data )
+{
+    quint64 bits;
+    memcpy( &bits, &value, sizeof( bits ) );
+    qToLittleEndian( bits, data );
+}
+
+static int column( qreal lon )
+{
+    return qBound( 0, int( ( lon + M_PI ) / ( 2 * M_PI ) * ( 1 << tileCodeBits ) ), ( 1 << tileCodeBits ) - 1 );
+}
+
+static int row( qreal lat )
+{
+    return qBound( 0, int( ( M_PI / 2 - lat ) / M_PI * ( 1 << tileCodeBits ) ), ( 1 << tileCodeBits ) - 1 );
+}
+
+/**
+ * Puts the bits of @p value into the even bits of the result.
+ */
+static quint32 spreadBits( quint32 value )
+{
+    value &= 0xffff;
+    value = ( value | ( value << 8 ) ) & 0x00ff00ff;
+    value = ( value | ( value << 4 ) ) & 0x0f0f0f0f;
+    value = ( value | ( value << 2 ) ) & 0x33333333;
+    value = ( value | ( value << 1 ) ) & 0x55555555;
+    return value;
+}
+
+static quint32 tileCode( int column, int row )
+{
+    return spreadBits( column ) | ( spreadBits( row ) << 1 );
+}
+
+/**
+ * Returns the index of @p string in the string table of a cache file and
+ * adds it to the table if it is new.
+ */
+static quint32 cacheString( const QString &string, QHash<QString, quint32> &references,
+                            QByteArray &stringData, QVector<quint32> &offsets )
+{
+    const QHash<QString, quint32>::const_iterator it = references.constFind( string );
+    if ( it != references.constEnd() ) {
+        return it.value();
+    }
+
+    const quint32 reference = offsets.size() - 1;
+    references.insert( string, reference );
+    stringData += string.toUtf8();
+    offsets << stringData.size();
+    return reference;
+}
+
+namespace
+{
+
+struct RecordOrder
+{
+    int level;
+    quint32 tileCode;
+    int placemark;
+
+    bool operator<( const RecordOrder &other ) const
+    {
+        return level < other.level || ( level == other.level && tileCode < other.tileCode );
+    }
+};
+
+}
+
+PlacemarkCachePrivate::PlacemarkCachePrivate()
+    : m_records( 0 ),
+      m_offsets( 0 ),
+      m_stringData( 0 ),
+      m_size( 0 ),
+      m_stringCount( 0 ),
+      m_stringSize( 0 )
+{
+}
+
+const uchar *PlacemarkCachePrivate::record( int index ) const
+{
+    return m_records + qint64( index ) * PlacemarkCache::recordSize;
+}
+
+quint32 PlacemarkCachePrivate::tileCode( int index ) const
+{
+    return qFromLittleEndian<quint32>( record( index ) + PlacemarkCache::TileCode );
+}
+
+QString PlacemarkCachePrivate::string( quint32 reference ) const
+{
+    if ( reference >= m_stringCount ) {
+        mDebug() << "Bad Cache file - invalid string reference" << reference << "in" << m_file.fileName();
+        return QString();
+    }
+
+    if ( !m_decoded.testBit( reference ) ) {
+        const quint32 begin = qFromLittleEndian<quint32>( m_offsets + reference * sizeof( quint32 ) );
+        const quint32 end = qFromLittleEndian<quint32>( m_offsets + ( reference + 1 ) * sizeof( quint32 ) );
+        if ( begin <= end && end <= m_stringSize ) {
+            m_strings[reference] = QString::fromUtf8( reinterpret_cast<const char *>( m_stringData ) + begin, end - begin );
+        } else {
+            mDebug() << "Bad Cache file - invalid string table in" << m_file.fileName();
+        }
+        m_decoded.setBit( reference );
+    }
+
+    return m_strings.at( reference );
+}
+
+bool PlacemarkCachePrivate::contains( const GeoDataLatLonBox &latLonBox, qreal lon, qreal lat )
+{
+    if ( lat < latLonBox.south() || lat > latLonBox.north() ) {
+        return false;
+    }
+
+    if ( latLonBox.crossesDateLine() ) {
+        return lon >= latLonBox.west() || lon <= latLonBox.east();
+    }
+
+    return lon >= latLonBox.west() && lon <= latLonBox.east();
+}
+
+void PlacemarkCachePrivate::addRecords( QVector<int> &result, int levels, quint64 begin, quint64 end,
+                                        const GeoDataLatLonBox &latLonBox ) const
+{
+    for ( int level = 0; level < levels; ++level ) {
+        // Binary search for the first record of the range within the level
+        int first = m_levelStarts.at( level );
+        int last = m_levelStarts.at( level + 1 );
+        while ( first < last ) {
+            const int middle = first + ( last - first ) / 2;
+            if ( tileCode( middle ) < begin ) {
+                first = middle + 1;
+            } else {
+                last = middle;
+            }
+        }
+
+        for ( int i = first; i < m_levelStarts.at( level + 1 ) && tileCode( i ) < end; ++i ) {
+            const uchar *const data = record( i );
+            if ( contains( latLonBox, readDouble( data + PlacemarkCache::Longitude ),
+                           readDouble( data + PlacemarkCache::Latitude ) ) ) {
+                result << i;
+            }
+        }
+    }
+}
+
+const quint32 PlacemarkCache::magic;
+const qint32 PlacemarkCache::streamVersion;
+const qint32 PlacemarkCache::version;
+const int PlacemarkCache::headerSize;
+const int PlacemarkCache::recordSize;
+const int PlacemarkCache::levelCount;
+
+PlacemarkCache::PlacemarkCache()
+    : d( new PlacemarkCachePrivate )
+{
+}
+
+PlacemarkCache::~PlacemarkCache()
+{
+    delete d;
+}
+
+qint32 PlacemarkCache::fileVersion( const QString &fileName )
+{
+    QFile file( fileName );
+    if ( !file.open( QIODevice::ReadOnly ) ) {
+        return 0;
+    }
+
+    const QByteArray header = file.read( 8 );
+    if ( header.size() < 8
+         || qFromBigEndian<quint32>( reinterpret_cast<const uchar *>( header.constData() ) ) != magic ) {
+        return 0;
+    }
+
+    return qFromBigEndian<qint32>( reinterpret_cast<const uchar *>( header.constData() ) + 4 );
+}
+
+bool PlacemarkCache::write( const QString &fileName, const QVector<const GeoDataPlacemark*> &placemarks,
+                            const QDateTime &dateTime )
+{
+    QFile file( fileName );
+    if ( !file.open( QIODevice::WriteOnly ) ) {
+        mDebug() << Q_FUNC_INFO << "Can't open" << fileName << "for writing";
+        return false;
+    }
+
+    qreal lon;
+    qreal lat;
+    qreal alt;
+
+    // Records are sorted by zoom level and tile code, placemarks of the
+    // same tile keep their order
+    QVector<RecordOrder> order( placemarks.size() );
+    for ( int i = 0; i < placemarks.size(); ++i ) {
+        placemarks.at( i )->coordinate( dateTime ).geoCoordinates( lon, lat, alt );
+        order[i].level = qBound( 0, placemarks.at( i )->zoomLevel(), levelCount - 1 );
+        order[i].tileCode = tileCode( column( lon ), row( lat ) );
+        order[i].placemark = i;
+    }
+    qStableSort( order.begin(), order.end() );
+
+    QVector<quint32> levelStarts( levelCount + 1, 0 );
+    for ( int i = 0; i < order.size(); ++i ) {
+        levelStarts[order.at( i ).level + 1] = i + 1;
+    }
+    for ( int level = 1; level <= levelCount; ++level ) {
+        levelStarts[level] = qMax( levelStarts.at( level ), levelStarts.at( level - 1 ) );
+    }
+
+    // String zero is the empty string
+    QHash<QString, quint32> references;
+    references.insert( QString(), 0 );
+    QByteArray stringData;
+    QVector<quint32> offsets;
+    offsets << 0 << 0;
+
+    QByteArray records( placemarks.size() * recordSize, 0 );
+    uchar *record = reinterpret_cast<uchar *>( records.data() );
+    foreach ( const RecordOrder &entry, order ) {
+        const GeoDataPlacemark *placemark = placemarks.at( entry.placemark );
+        placemark->coordinate( dateTime ).geoCoordinates( lon, lat, alt );
+
+        // Use double to provide a single cache file format across architectures
+        writeDouble( lon, record + Longitude );
+        writeDouble( lat, record + Latitude );
+        writeDouble( alt, record + Altitude );
+        writeDouble( placemark->area(), record + Area );
+        qToLittleEndian<qint64>( placemark->population(), record + Population );
+        qToLittleEndian<qint64>( placemark->popularity(), record + Popularity );
+        qToLittleEndian<quint32>( cacheString( placemark->name(), references, stringData, offsets ),
+                                  record + Name );
+        qToLittleEndian<quint32>( cacheString( placemark->role(), references, stringData, offsets ),
+                                  record + Role );
+        qToLittleEndian<quint32>( cacheString( placemark->description(), references, stringData, offsets ),
+                                  record + Description );
+        qToLittleEndian<quint32>( cacheString( placemark->countryCode(), references, stringData, offsets ),
+                                  record + CountryCode );
+        qToLittleEndian<quint32>( cacheString( placemark->state(), references, stringData, offsets ),
+                                  record + State );
+        qToLittleEndian<quint32>( entry.tileCode, record + TileCode );
+        // Placemarks are shown while their cache is written, so reading
+        // must not create their extended data
+        const bool hasExtendedData = placemark->hasExtendedData();
+        const int gmt = hasExtendedData ? placemark->extendedData().value( "gmt" ).value().toInt() : 0;
+        const int dst = hasExtendedData ? placemark->extendedData().value( "dst" ).value().toInt() : 0;
+        qToLittleEndian<qint16>( gmt, record + Gmt );
+        qToLittleEndian<quint16>( placemark->visualCategory(), record + VisualCategory );
+        record[Dst] = quint8( dst );
+        record[ZoomLevel] = quint8( entry.level );
+        record += recordSize;
+    }
+
+    QByteArray header( headerSize + ( levelCount + 1 ) * sizeof( quint32 ), 0 );
+    uchar *const headerData = reinterpret_cast<uchar *>( header.data() );
+    qToBigEndian<quint32>( magic, headerData );
+    qToBigEndian<qint32>( version, headerData + 4 );
+    qToLittleEndian<quint32>( placemarks.size(), headerData + 8 );
+    qToLittleEndian<quint32>( offsets.size() - 1, headerData + 12 );
+    qToLittleEndian<quint32>( stringData.size(), headerData + 16 );
+    qToLittleEndian<quint32>( levelCount, headerData + 20 );
+    for ( int level = 0; level <= levelCount; ++level ) {
+        qToLittleEndian<quint32>( levelStarts.at( level ), headerData + headerSize + level * sizeof( quint32 ) );
+    }
+
+    QByteArray offsetData( offsets.size() * sizeof( quint32 ), 0 );
+    for ( int i = 0; i < offsets.size(); ++i ) {
+        qToLittleEndian<quint32>( offsets.at( i ), reinterpret_cast<uchar *>( offsetData.data() ) + i * sizeof( quint32 ) );
+    }
+
+    if ( file.write( header ) != header.size() || file.write( records ) != records.size()
+         || file.write( offsetData ) != offsetData.size() || file.write( stringData ) != stringData.size() ) {
+        mDebug() << "Can't write" << fileName;
+        file.remove();
+        return false;
+    }
+
+    return true;
+}
+
+bool PlacemarkCache::open( const QString &fileName )
+{
+    d->m_file.setFileName( fileName );
+    if ( !d->m_file.open( QIODevice::ReadOnly ) ) {
+        return false;
+    }
+
+    // Files that cannot be mapped are read into memory instead
+    const qint64 size = d->m_file.size();
+    const uchar *data = d->m_file.map( 0, size );
+    if ( !data ) {
+        d->m_content = d->m_file.readAll();
+        data = reinterpret_cast<const uchar *>( d->m_content.constData() );
+    }
+
+    if ( size < headerSize || qFromBigEndian<quint32>( data ) != magic
+         || qFromBigEndian<qint32>( data + 4 ) != version ) {
+        mDebug() << "Bad Cache file - not of version" << version << ":" << fileName;
+        return false;
+    }
+
+    const quint32 placemarkCount = qFromLittleEndian<quint32>( data + 8 );
+    const quint32 stringCount = qFromLittleEndian<quint32>( data + 12 );
+    const quint32 stringSize = qFromLittleEndian<quint32>( data + 16 );
+    const quint32 levels = qFromLittleEndian<quint32>( data + 20 );
+
+    const qint64 recordsPosition = headerSize + ( qint64( levels ) + 1 ) * sizeof( quint32 );
+    const qint64 offsetsPosition = recordsPosition + qint64( placemarkCount ) * recordSize;
+    const qint64 stringsPosition = offsetsPosition + ( qint64( stringCount ) + 1 ) * sizeof( quint32 );
+    if ( levels > 256 || stringCount == 0 || stringsPosition + stringSize != size ) {
+        mDebug() << "Bad Cache file - truncated:" << fileName;
+        return false;
+    }
+
+    d->m_levelStarts.resize( levels + 1 );
+    for ( quint32 level = 0; level <= levels; ++level ) {
+        d->m_levelStarts[level] = qFromLittleEndian<quint32>( data + headerSize + level * sizeof( quint32 ) );
+        if ( d->m_levelStarts.at( level ) > int( placemarkCount )
+             || ( level > 0 && d->m_levelStarts.at( level ) < d->m_levelStarts.at( level - 1 ) ) ) {
+            mDebug() << "Bad Cache file - invalid level index:" << fileName;
+            d->m_levelStarts.clear();
+            return false;
+        }
+    }
+    if ( d->m_levelStarts.first() != 0 || d->m_levelStarts.last() != int( placemarkCount ) ) {
+        mDebug() << "Bad Cache file - invalid level index:" << fileName;
+        d->m_levelStarts.clear();
+        return false;
+    }
+
+    d->m_records = data + recordsPosition;
+    d->m_offsets = data + offsetsPosition;
+    d->m_stringData = data + stringsPosition;
+    d->m_size = placemarkCount;
+    d->m_stringCount = stringCount;
+    d->m_stringSize = stringSize;
+    d->m_strings.resize( stringCount );
+    d->m_decoded.resize( stringCount );
+    d->m_materialized.resize( placemarkCount );
+
+    return true;
+}
+
+int PlacemarkCache::size() const
+{
+    return d->m_size;
+}
+
+QVector<int> PlacemarkCache::records( const GeoDataLatLonBox &latLonBox, int zoomLevel ) const
+{
+    QVector<int> result;
+    const int levels = qMin( zoomLevel + 1, d->m_levelStarts.size() - 1 );
+    if ( levels <= 0 ) {
+        return result;
+    }
+
+    if ( latLonBox.isEmpty() ) {
+        for ( int i = 0; i < d->m_levelStarts.at( levels ); ++i ) {
+            result << i;
+        }
+        return result;
+    }
+
+    const int west = column( latLonBox.west() );
+    const int east = column( latLonBox.east() );
+    const int north = row( latLonBox.north() );
+    const int south = row( latLonBox.south() );
+
+    // Look up the region in the finest grid that covers it with few cells,
+    // the records of a cell are a range of tile codes
+    for ( int level = tileCodeBits; level >= 0; --level ) {
+        const int shift = tileCodeBits - level;
+        const int cells = 1 << level;
+        const int firstColumn = west >> shift;
+        const int lastColumn = east >> shift;
+        const int columns = latLonBox.crossesDateLine() ? qMin( cells, cells - firstColumn + lastColumn + 1 )
+                                                        : lastColumn - firstColumn + 1;
+        const int rows = ( south >> shift ) - ( north >> shift ) + 1;
+        if ( qint64( columns ) * rows > maximumQueryCells && level > 0 ) {
+            continue;
+        }
+
+        for ( int i = 0; i < columns; ++i ) {
+            const int x = ( firstColumn + i ) % cells;
+            for ( int y = north >> shift; y <= south >> shift; ++y ) {
+                const quint64 code = tileCode( x, y );
+                d->addRecords( result, levels, code << 2 * shift, ( code + 1 ) << 2 * shift, latLonBox );
+            }
+        }
+        break;
+    }
+
+    qSort( result );
+    return result;
+}
+
+QVector<int> PlacemarkCache::records( const QString &prefix ) const
+{
+    QVector<int> result;
+    if ( d->m_size == 0 ) {
+        return result;
+    }
+
+    QBitArray matches( d->m_stringCount );
+    for ( quint32 i = 0; i < d->m_stringCount; ++i ) {
+        if ( d->string( i ).startsWith( prefix, Qt::CaseInsensitive ) ) {
+            matches.setBit( i );
+        }
+    }
+
+    for ( int i = 0; i < d->m_size; ++i ) {
+        const quint32 name = qFromLittleEndian<quint32>( d->record( i ) + Name );
+        if ( name < d->m_stringCount && matches.testBit( name ) ) {
+            result << i;
+        }
+    }
+
+    return result;
+}
+
+GeoDataPlacemark *PlacemarkCache::placemark( int record ) const
+{
+    Q_ASSERT( record >= 0 && record < d->m_size );
+
+    const uchar *const data = d->record( record );
+
+    GeoDataPlacemark *placemark = new GeoDataPlacemark;
+    placemark->setName( d->string( qFromLittleEndian<quint32>( data + Name ) ) );
+    placemark->setCoordinate( readDouble( data + Longitude ), readDouble( data + Latitude ),
+                              readDouble( data + Altitude ) );
+    placemark->setRole( d->string( qFromLittleEndian<quint32>( data + Role ) ) );
+    placemark->setDescription( d->string( qFromLittleEndian<quint32>( data + Description ) ) );
+    placemark->setCountryCode( d->string( qFromLittleEndian<quint32>( data + CountryCode ) ) );
+    placemark->setState( d->string( qFromLittleEndian<quint32>( data + State ) ) );
+    placemark->setArea( readDouble( data + Area ) );
+    placemark->setPopulation( qFromLittleEndian<qint64>( data + Population ) );
+    placemark->setPopularity( qFromLittleEndian<qint64>( data + Popularity ) );
+    placemark->setZoomLevel( data[ZoomLevel] );
+    placemark->setVisualCategory( GeoDataFeature::GeoDataVisualCategory( qFromLittleEndian<quint16>( data + VisualCategory ) ) );
+    placemark->extendedData().addValue( GeoDataData( "gmt", int( qFromLittleEndian<qint16>( data + Gmt ) ) ) );
+    placemark->extendedData().addValue( GeoDataData( "dst", int( qint8( data[Dst] ) ) ) );
+
+    return placemark;
+}
+
+QVector<GeoDataFeature*> PlacemarkCache::materialize( const QVector<int> &records )
+{
+    QVector<GeoDataFeature*> result;
+    foreach ( int record, records ) {
+        if ( !d->m_materialized.testBit( record ) ) {
+            d->m_materialized.setBit( record );
+            result << placemark( record );
+        }
+    }
+
+    return result;
+}
+
+}
@@ -0,0 +1,139 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_PLACEMARKCACHE_H
+#define MARBLE_PLACEMARKCACHE_H
+
+#include <QtCore/QDateTime>
+#include <QtCore/QString>
+#include <QtCore/QVector>
+
+#include "marble_export.h"
+
+namespace Marble
+{
+
+class GeoDataFeature;
+class GeoDataLatLonBox;
+class GeoDataPlacemark;
+class PlacemarkCachePrivate;
+
+/**
+ * @short The .cache files of the standard placemarks.
+ *
+ * FileLoader writes them, the cache runner and FileLoader read them.
+ * Version 1 (015) was a QDataStream of all placemark fields. Version 2 is
+ * meant to be memory mapped, so that placemarks are only created once they
+ * are shown or searched for:
+ *
+ *   magic            quint32, big endian as in version 1
+ *   version          qint32, big endian as in version 1
+ *   placemark count  quint32, little endian like everything that follows
+ *   string count     quint32
+ *   string size      quint32, the size of the string data in bytes
+ *   level count      quint32
+ *   level starts     level count plus one quint32 record indexes, the
+ *                    records of zoom level i span from start i to start i + 1
+ *   records          one of recordSize bytes per placemark, sorted by zoom
+ *                    level and by tile code within a level
+ *   string offsets   string count plus one quint32 offsets into the string
+ *                    data, string i spans from offset i to offset i + 1
+ *   string data      UTF-8
+ *
+ * String references in records are indexes into the string table, string
+ * zero is always the empty string. Coordinates are in radians. The tile
+ * code interleaves the bits of the column and the row of a placemark in a
+ * grid of 2^16 x 2^16 cells, so that the placemarks of a grid cell at any
+ * coarser level are adjacent within a zoom level.
+ */
+class MARBLE_EXPORT PlacemarkCache
+{
+ public:
+    static const quint32 magic = 0x31415926;
+    static const qint32 streamVersion = 015;
+    static const qint32 version = 016;
+
+    static const int headerSize = 24;
+    static const int recordSize = 80;
+    static const int levelCount = 20;
+
+    // Byte offsets of the fields within a record
+    enum RecordField {
+        Longitude = 0,      // double
+        Latitude = 8,       // double
+        Altitude = 16,      // double
+        Area = 24,          // double
+        Population = 32,    // qint64
+        Popularity = 40,    // qint64
+        Name = 48,          // quint32 string reference
+        Role = 52,          // quint32 string reference
+        Description = 56,   // quint32 string reference
+        CountryCode = 60,   // quint32 string reference
+        State = 64,         // quint32 string reference
+        TileCode = 68,      // quint32
+        Gmt = 72,           // qint16
+        VisualCategory = 74,// quint16
+        Dst = 76,           // qint8
+        ZoomLevel = 77      // quint8, followed by two bytes of padding
+    };
+
+    PlacemarkCache();
+    ~PlacemarkCache();
+
+    /**
+     * Returns the format version of @p fileName, or 0 if it is no
+     * placemark cache.
+     */
+    static qint32 fileVersion( const QString &fileName );
+
+    /**
+     * Writes @p placemarks to @p fileName in the current version. Their
+     * zoom level, popularity and visual category are stored as they are,
+     * coordinates are taken at @p dateTime.
+     */
+    static bool write( const QString &fileName, const QVector<const GeoDataPlacemark*> &placemarks,
+                       const QDateTime &dateTime );
+
+    /**
+     * Maps @p fileName, which must be of the current version.
+     */
+    bool open( const QString &fileName );
+
+    int size() const;
+
+    /**
+     * Returns the records of a zoom level of at most @p zoomLevel within
+     * @p latLonBox, or anywhere if the box is empty, ordered as in the file.
+     */
+    QVector<int> records( const GeoDataLatLonBox &latLonBox, int zoomLevel ) const;
+
+    /**
+     * Returns the records whose name starts with @p prefix, ignoring case.
+     */
+    QVector<int> records( const QString &prefix ) const;
+
+    /**
+     * Creates a placemark for @p record.
+     */
+    GeoDataPlacemark *placemark( int record ) const;
+
+    /**
+     * Creates placemarks for those of @p records that no placemark was
+     * created for by an earlier call. The caller takes ownership of them.
+     */
+    QVector<GeoDataFeature*> materialize( const QVector<int> &records );
+
+ private:
+    Q_DISABLE_COPY( PlacemarkCache )
+
+    PlacemarkCachePrivate *const d;
+};
+
+}
+
+#endif
@@ -137,8 +137,14 @@ void PlacemarkInfoDialog::showContent()
 
     coordinates_val_lbl->setText( coordinates.toString() );
     country_val_lbl->setText( m_placemark->countryCode() );
-    QString gmt = QString( "%1" ).arg( m_placemark->extendedData().value("gmt").value().toInt()/( double ) 100, 0, 'f', 1 );
-    QString dst = QString( "%1" ).arg( ( m_placemark->extendedData().value("gmt").value().toInt() + m_placemark->extendedData().value("dst").value().toInt() )/( double ) 100, 0, 'f', 1 );
+    int gmtOffset = 0;
+    int dstOffset = 0;
+    if ( m_placemark->hasExtendedData() ) {
+        gmtOffset = m_placemark->extendedData().value("gmt").value().toInt();
+        dstOffset = m_placemark->extendedData().value("dst").value().toInt();
+    }
+    QString gmt = QString( "%1" ).arg( gmtOffset/( double ) 100, 0, 'f', 1 );
+    QString dst = QString( "%1" ).arg( ( gmtOffset + dstOffset )/( double ) 100, 0, 'f', 1 );
     gmtdst_val_lbl->setText( gmt + " / " + dst );
     state_val_lbl->setText( m_placemark->state() );
 
@@ -14,7 +14,9 @@
 
 #include <QtCore/QAbstractItemModel>
 #include <QtCore/QList>
+#include <QtCore/QtAlgorithms>
 #include <QtCore/QPoint>
+#include <QtCore/QSet>
 #include <QtCore/QVector>
 #include <QtCore/QVectorIterator>
 #include <QtGui/QFont>
@@ -22,6 +24,8 @@
 #include <QtGui/QItemSelectionModel>
 #include <QtCore/qmath.h>
 
+#include <algorithm>
+
 #include "GeoDataPlacemark.h"
 #include "GeoDataStyle.h"
 #include "GeoDataTypes.h"
@@ -29,18 +33,48 @@
 #include "MarbleDebug.h"
 #include "MarbleGlobal.h"
 #include "PlacemarkLayer.h"
+#include "PlacemarkPixmapCache.h"
 #include "MarbleClock.h"
 #include "MarblePlacemarkModel.h"
 #include "MarbleDirs.h"
 #include "ViewportParams.h"
 #include "TileId.h"
-#include "TileCoordsPyramid.h"
 #include "VisiblePlacemark.h"
 #include "MathHelper.h"
 
 namespace Marble
 {
 
+// The tile level at which the positions of placemarks are cached. Tiles at
+// this level are a few meters wide.
+static const int cacheTileLevel = 24;
+
+// Placemarks are clustered in cells two levels below the tiles of the
+// current zoom level, which are about 100 pixels wide, ...
+static const int clusterLevelOffset = 2;
+
+// ... unless that results in more cells than this ...
+static const int maxClusterCells = 4096;
+
+// ... if a cell holds more placemarks than its labels could fill.
+static const int clusterThreshold = 12;
+
+/// interleaves the bits of @p x and @p y, with the lowest bit from @p x
+static quint64 mortonCode( quint32 x, quint32 y )
+{
+    quint64 bits[2] = { x, y };
+    for ( int i = 0; i < 2; ++i ) {
+        quint64 &b = bits[i];
+        b = ( b | ( b << 16 ) ) & Q_UINT64_C( 0x0000FFFF0000FFFF );
+        b = ( b | ( b << 8 ) ) & Q_UINT64_C( 0x00FF00FF00FF00FF );
+        b = ( b | ( b << 4 ) ) & Q_UINT64_C( 0x0F0F0F0F0F0F0F0F );
+        b = ( b | ( b << 2 ) ) & Q_UINT64_C( 0x3333333333333333 );
+        b = ( b | ( b << 1 ) ) & Q_UINT64_C( 0x5555555555555555 );
+    }
+
+    return bits[0] | ( bits[1] << 1 );
+}
+
 QVector<GeoDataFeature::GeoDataVisualCategory> sortedVisualCategories()
 {
     QVector<GeoDataFeature::GeoDataVisualCategory> visualCategories;
@@ -148,8 +182,15 @@ PlacemarkLayout::PlacemarkLayout( QAbstractItemModel  *placemarkModel,
       m_showLandingSites( false ),
       m_showCraters( false ),
       m_showMaria( false ),
+      m_labelGridColumns( 0 ),
+      m_labelGridRows( 0 ),
+      m_labelGridCellSize( 1 ),
+      m_shownCountsValid( false ),
       m_maxLabelHeight( 0 ),
-      m_styleResetRequested( true )
+      m_styleResetRequested( true ),
+      m_coherentLayout( false ),
+      m_layoutRadius( 0 ),
+      m_clustering( false )
 {
     m_placemarkModel.setSourceModel( placemarkModel );
     m_placemarkModel.setDynamicSortFilter( true );
@@ -163,9 +204,9 @@ PlacemarkLayout::PlacemarkLayout( QAbstractItemModel  *placemarkModel,
     connect( &m_placemarkModel, SIGNAL( dataChanged( QModelIndex, QModelIndex ) ),
              this, SLOT( setCacheData() ) );
     connect( &m_placemarkModel, SIGNAL( rowsInserted(const QModelIndex&, int, int) ),
-             this, SLOT( setCacheData() ) );
-    connect( &m_placemarkModel, SIGNAL( rowsRemoved(const QModelIndex&, int, int) ),
-             this, SLOT( setCacheData() ) );
+             this, SLOT( addPlacemarks(const QModelIndex&, int, int) ) );
+    connect( &m_placemarkModel, SIGNAL( rowsAboutToBeRemoved(const QModelIndex&, int, int) ),
+             this, SLOT( removePlacemarks(const QModelIndex&, int, int) ) );
     connect( &m_placemarkModel, SIGNAL( modelReset() ),
              this, SLOT( setCacheData() ) );
 }
@@ -173,6 +214,8 @@ PlacemarkLayout::PlacemarkLayout( QAbstractItemModel  *placemarkModel,
 PlacemarkLayout::~PlacemarkLayout()
 {
     styleReset();
+    qDeleteAll( m_clusterPlacemarks );
+    qDeleteAll( m_unusedClusterPlacemarks );
 }
 
 void PlacemarkLayout::setShowPlaces( bool show )
@@ -210,12 +253,37 @@ void PlacemarkLayout::setShowMaria( bool show )
     m_showMaria = show;
 }
 
+void PlacemarkLayout::setCoherentLayout( bool coherent )
+{
+    m_coherentLayout = coherent;
+}
+
+bool PlacemarkLayout::coherentLayout() const
+{
+    return m_coherentLayout;
+}
+
+void PlacemarkLayout::setClustering( bool clustering )
+{
+    m_clustering = clustering;
+}
+
+bool PlacemarkLayout::clustering() const
+{
+    return m_clustering;
+}
+
 void PlacemarkLayout::requestStyleReset()
 {
     mDebug() << "Style reset requested.";
     m_styleResetRequested = true;
 }
 
+void PlacemarkLayout::requestVisibilityUpdate()
+{
+    m_shownCountsValid = false;
+}
+
 void PlacemarkLayout::styleReset()
 {
     m_paintOrder.clear();
@@ -235,8 +303,12 @@ QVector<const GeoDataPlacemark*> PlacemarkLayout::whichPlacemarkAt( const QPoint
     QVector<const GeoDataPlacemark*> ret;
 
     foreach( VisiblePlacemark* mark, m_paintOrder ) {
+        if ( m_clusterMarkers.contains( mark->placemark() ) ) {
+            continue;
+        }
+
         if ( mark->labelRect().contains( curpos )
-             || QRect( mark->symbolPosition(), mark->symbolPixmap().size() ).contains( curpos ) ) {
+             || QRect( mark->symbolPosition(), mark->symbolRect().size() ).contains( curpos ) ) {
             ret.append( mark->placemark() );
         }
     }
@@ -264,7 +336,30 @@ int PlacemarkLayout::maxLabelHeight() const
     return maxLabelHeight;
 }
 
-/// feed an internal QMap of placemarks with TileId as key when model changes
+bool PlacemarkLayout::tileLessThan( const CacheEntry &entry1, const CacheEntry &entry2 )
+{
+    return entry1.tile < entry2.tile;
+}
+
+bool PlacemarkLayout::cacheEntry( const GeoDataPlacemark *placemark, CacheEntry &entry, int &level ) const
+{
+    level = placemark->zoomLevel();
+    if ( level < 0 || level > 31 ) {
+        return false;
+    }
+
+    const GeoDataCoordinates coordinates = placemarkIconCoordinates( placemark );
+    if ( !coordinates.isValid() ) {
+        return false;
+    }
+
+    const TileId key = TileId::fromCoordinates( coordinates, cacheTileLevel );
+    entry.tile = mortonCode( key.x(), key.y() );
+    entry.placemark = placemark;
+    return true;
+}
+
+/// feed the per level arrays of placemarks sorted by tile when the model is reset or its data changes
 /// FIXME this method is too expensive on minor data change, e.g. when adding a point to a track (see bug 305195)
 void PlacemarkLayout::setCacheData()
 {
@@ -282,21 +377,210 @@ void PlacemarkLayout::setCacheData()
 
         const GeoDataPlacemark *placemark = static_cast<GeoDataPlacemark*>(qvariant_cast<GeoDataObject*>(index.data( MarblePlacemarkModel::ObjectPointerRole ) ));
 
-        const GeoDataCoordinates coordinates = placemarkIconCoordinates( placemark );
+        CacheEntry entry;
+        int level;
+        if ( !cacheEntry( placemark, entry, level ) ) {
+            continue;
+        }
 
-        if ( !coordinates.isValid() ) {
+        if ( level >= m_placemarkCache.size() ) {
+            m_placemarkCache.resize( level + 1 );
+        }
+        m_placemarkCache[level].append( entry );
+    }
+
+    // A stable sort keeps the model order within each tile.
+    for ( int level = 0; level < m_placemarkCache.size(); ++level ) {
+        QVector<CacheEntry> &entries = m_placemarkCache[level];
+        qStableSort( entries.begin(), entries.end(), tileLessThan );
+        entries.squeeze();
+    }
+    m_shownCountsValid = false;
+
+    emit repaintNeeded();
+}
+
+void PlacemarkLayout::addPlacemarks( const QModelIndex &parent, int first, int last )
+{
+    QVector< QVector<CacheEntry> > added( m_placemarkCache.size() );
+    for ( int i = first; i <= last; ++i ) {
+        const QModelIndex index = m_placemarkModel.index( i, 0, parent );
+        const GeoDataPlacemark *placemark = dynamic_cast<GeoDataPlacemark*>(qvariant_cast<GeoDataObject*>(index.data( MarblePlacemarkModel::ObjectPointerRole ) ));
+        if ( !placemark ) {
             continue;
         }
 
-        int zoomLevel = placemark->zoomLevel();
-        TileId key = TileId::fromCoordinates( coordinates, zoomLevel );
-        m_placemarkCache[key].append( placemark );
+        // The label grid must be able to hold the new labels as well.
+        const int textHeight = QFontMetrics( placemark->style()->labelStyle().font() ).height();
+        m_maxLabelHeight = qMax( m_maxLabelHeight, textHeight );
+
+        CacheEntry entry;
+        int level;
+        if ( !cacheEntry( placemark, entry, level ) ) {
+            continue;
+        }
+
+        if ( level >= added.size() ) {
+            added.resize( level + 1 );
+        }
+        added[level].append( entry );
+    }
+
+    if ( added.size() > m_placemarkCache.size() ) {
+        m_placemarkCache.resize( added.size() );
+    }
+
+    // Merge the new placemarks behind the existing ones of the same tile.
+    for ( int level = 0; level < added.size(); ++level ) {
+        QVector<CacheEntry> &newEntries = added[level];
+        if ( newEntries.isEmpty() ) {
+            continue;
+        }
+
+        qStableSort( newEntries.begin(), newEntries.end(), tileLessThan );
+
+        const QVector<CacheEntry> &entries = m_placemarkCache.at( level );
+        QVector<CacheEntry> merged( entries.size() + newEntries.size() );
+        std::merge( entries.constBegin(), entries.constEnd(),
+                    newEntries.constBegin(), newEntries.constEnd(),
+                    merged.begin(), tileLessThan );
+        m_placemarkCache[level] = merged;
     }
+    m_shownCountsValid = false;
+
     emit repaintNeeded();
 }
 
-/// determine the set of placemarks that fit the viewport based on a pyramid of TileIds
-QList<const GeoDataPlacemark*> PlacemarkLayout::visiblePlacemarks( const ViewportParams *viewport ) const
+void PlacemarkLayout::removePlacemarks( const QModelIndex &parent, int first, int last )
+{
+    QVector< QSet<const GeoDataPlacemark*> > removed( m_placemarkCache.size() );
+    for ( int i = first; i <= last; ++i ) {
+        const QModelIndex index = m_placemarkModel.index( i, 0, parent );
+        const GeoDataPlacemark *placemark = dynamic_cast<GeoDataPlacemark*>(qvariant_cast<GeoDataObject*>(index.data( MarblePlacemarkModel::ObjectPointerRole ) ));
+        if ( !placemark ) {
+            continue;
+        }
+
+        // The placemark goes away, so must its visible placemark.
+        VisiblePlacemark *const mark = m_visiblePlacemarks.take( placemark );
+        if ( mark ) {
+            const int paintIndex = m_paintOrder.indexOf( mark );
+            if ( paintIndex >= 0 ) {
+                m_paintOrder.remove( paintIndex );
+            }
+            delete mark;
+        }
+
+        const int level = placemark->zoomLevel();
+        if ( 0 <= level && level < removed.size() ) {
+            removed[level].insert( placemark );
+        }
+    }
+
+    // The maximum label height stays an upper bound, so there is no need
+    // for a style reset here.
+    for ( int level = 0; level < removed.size(); ++level ) {
+        const QSet<const GeoDataPlacemark*> &placemarks = removed.at( level );
+        if ( placemarks.isEmpty() ) {
+            continue;
+        }
+
+        QVector<CacheEntry> &entries = m_placemarkCache[level];
+        int size = 0;
+        for ( int i = 0; i < entries.size(); ++i ) {
+            if ( !placemarks.contains( entries.at( i ).placemark ) ) {
+                entries[size++] = entries.at( i );
+            }
+        }
+        entries.resize( size );
+    }
+    m_shownCountsValid = false;
+
+    emit repaintNeeded();
+}
+
+bool PlacemarkLayout::isShown( const GeoDataPlacemark *placemark, const QVector<bool> &visibleCategories )
+{
+    const int visualCategory = placemark->visualCategory();
+    return placemark->isGloballyVisible()
+        && visualCategory >= 0 && visualCategory < visibleCategories.size()
+        && visibleCategories.at( visualCategory );
+}
+
+void PlacemarkLayout::updateShownCounts( const QVector<bool> &visibleCategories )
+{
+    m_shownCounts.resize( m_placemarkCache.size() );
+    for ( int level = 0; level < m_placemarkCache.size(); ++level ) {
+        const QVector<CacheEntry> &entries = m_placemarkCache.at( level );
+        QVector<int> &counts = m_shownCounts[level];
+        counts.resize( entries.size() + 1 );
+
+        int count = 0;
+        for ( int i = 0; i < entries.size(); ++i ) {
+            counts[i] = count;
+            if ( isShown( entries.at( i ).placemark, visibleCategories ) ) {
+                ++count;
+            }
+        }
+        counts[entries.size()] = count;
+    }
+
+    m_shownCountsCategories = visibleCategories;
+    m_shownCountsValid = true;
+}
+
+int PlacemarkLayout::clusterCount( const QPair<int, int> *ranges, int levelCount, int selectedCount,
+                                   const QSet<const GeoDataPlacemark*> &selectedPlacemarks,
+                                   const GeoDataPlacemark *&representative ) const
+{
+    int count = -selectedCount;
+    for ( int level = 0; level < levelCount; ++level ) {
+        const QVector<int> &counts = m_shownCounts.at( level );
+        count += counts.at( ranges[level].second ) - counts.at( ranges[level].first );
+    }
+
+    // The representative is taken from the most popular level, as close to
+    // the middle of the cell's shown placemarks as possible. The entry with
+    // a given rank is where the count before it gets passed.
+    representative = 0;
+    for ( int level = 0; level < levelCount && !representative; ++level ) {
+        const QVector<CacheEntry> &entries = m_placemarkCache.at( level );
+        const QVector<int> &counts = m_shownCounts.at( level );
+        const int first = ranges[level].first;
+        const int second = ranges[level].second;
+        if ( counts.at( second ) == counts.at( first ) ) {
+            continue;
+        }
+
+        const int middleRank = ( counts.at( first ) + counts.at( second ) - 1 ) / 2;
+        const int middle = qUpperBound( counts.constBegin() + first, counts.constBegin() + second,
+                                        middleRank ) - counts.constBegin() - 1;
+
+        // Selected placemarks are few, so just look for a neighbour then.
+        for ( int i = middle; i < second && !representative; ++i ) {
+            const GeoDataPlacemark *placemark = entries.at( i ).placemark;
+            if ( counts.at( i + 1 ) > counts.at( i ) && !selectedPlacemarks.contains( placemark ) ) {
+                representative = placemark;
+            }
+        }
+        for ( int i = middle - 1; i >= first && !representative; --i ) {
+            const GeoDataPlacemark *placemark = entries.at( i ).placemark;
+            if ( counts.at( i + 1 ) > counts.at( i ) && !selectedPlacemarks.contains( placemark ) ) {
+                representative = placemark;
+            }
+        }
+    }
+
+    return count;
+}
+
+/// determine the set of placemarks that fit the viewport based on a grid of tiles
+QList<const GeoDataPlacemark*> PlacemarkLayout::visiblePlacemarks( const ViewportParams *viewport,
+                                                                    const QVector<bool> &visibleCategories,
+                                                                    const QSet<const GeoDataPlacemark*> &selectedPlacemarks,
+                                                                    QVector<Cluster> &clusters,
+                                                                    QVector<quint64> &clusteredCells,
+                                                                    int &clusterLevel ) const
 {
     int zoomLevel = qLn( viewport->radius() *4 / 256 ) / qLn( 2.0 );
 
@@ -306,66 +590,179 @@ QList<const GeoDataPlacemark*> PlacemarkLayout::visiblePlacemarks( const Viewpor
      * the bottom level tiles have the smaller ones, and we only get the ones
      * matching our latLonAltBox.
      */
+    const int levelCount = qBound( 0, zoomLevel + 1, m_placemarkCache.size() );
 
-    QRect rect;
     qreal north, south, east, west;
     viewport->viewLatLonAltBox().boundaries(north, south, east, west);
-    TileId key;
+    const bool crossesDateLine = viewport->viewLatLonAltBox().crossesDateLine();
+
+    // Collect the cells covering the viewport, coarser ones if there are
+    // too many of them.
+    QVector<quint64> cells;
+    for ( clusterLevel = qBound( 0, zoomLevel + clusterLevelOffset, cacheTileLevel ); clusterLevel >= 0; --clusterLevel ) {
+        const TileId topLeft = TileId::fromCoordinates( GeoDataCoordinates( west, north, 0 ), clusterLevel );
+        const TileId bottomRight = TileId::fromCoordinates( GeoDataCoordinates( east, south, 0 ), clusterLevel );
+        const int maxX = ( 1 << clusterLevel ) - 1;
+
+        int x1 = topLeft.x();
+        int x2 = bottomRight.x();
+        if ( crossesDateLine && x1 <= x2 ) { // both parts overlap at this level
+            x1 = 0;
+            x2 = maxX;
+        }
 
-    key = TileId::fromCoordinates( GeoDataCoordinates(west, north, 0), zoomLevel);
-    rect.setLeft( key.x() );
-    rect.setTop( key.y() );
+        // as we cross dateline, we first get west part, then east part
+        const int columns = x1 <= x2 ? x2 - x1 + 1 : maxX - x1 + 1 + x2 + 1;
+        const int rows = bottomRight.y() - topLeft.y() + 1;
+        if ( clusterLevel > 0 && qint64( columns ) * rows > maxClusterCells ) {
+            continue;
+        }
 
-    key = TileId::fromCoordinates( GeoDataCoordinates(east, south, 0), zoomLevel);
-    rect.setRight( key.x() );
-    rect.setBottom( key.y() );
+        cells.reserve( columns * rows );
+        for ( int y = topLeft.y(); y <= bottomRight.y(); ++y ) {
+            for ( int i = 0; i < columns; ++i ) {
+                cells.append( mortonCode( ( x1 + i ) & maxX, y ) );
+            }
+        }
+        break;
+    }
 
-    TileCoordsPyramid pyramid(0, zoomLevel );
-    pyramid.setBottomLevelCoords( rect );
+    // Look up the range of placemarks of each level in each cell. The
+    // cells with too many of them become clusters.
+    const int shift = 2 * ( cacheTileLevel - clusterLevel );
+    QVector< QPair<int, int> > ranges( cells.size() * levelCount );
+
+    // Selected placemarks are not part of clusters, so count them per cell.
+    QHash<quint64, int> selectedCounts;
+    if ( m_clustering ) {
+        foreach ( const GeoDataPlacemark *placemark, selectedPlacemarks ) {
+            CacheEntry entry;
+            int level;
+            if ( cacheEntry( placemark, entry, level ) && level < levelCount
+                 && isShown( placemark, visibleCategories ) ) {
+                ++selectedCounts[entry.tile >> shift];
+            }
+        }
+    }
+    for ( int i = 0; i < cells.size(); ++i ) {
+        CacheEntry first;
+        first.tile = cells.at( i ) << shift;
+        first.placemark = 0;
+        CacheEntry next;
+        next.tile = ( cells.at( i ) + 1 ) << shift;
+        next.placemark = 0;
+
+        QPair<int, int> *const cellRanges = ranges.data() + i * levelCount;
+        int count = 0;
+        for ( int level = 0; level < levelCount; ++level ) {
+            const QVector<CacheEntry> &entries = m_placemarkCache.at( level );
+            QVector<CacheEntry>::const_iterator begin = qLowerBound( entries.constBegin(), entries.constEnd(),
+                                                                     first, tileLessThan );
+            QVector<CacheEntry>::const_iterator end = qLowerBound( begin, entries.constEnd(),
+                                                                   next, tileLessThan );
+            cellRanges[level] = qMakePair( int( begin - entries.constBegin() ), int( end - entries.constBegin() ) );
+            count += int( end - begin );
+        }
+
+        // Hidden and selected placemarks only need to be filtered out
+        // of cells that could be crowded at all.
+        if ( !m_clustering || count <= clusterThreshold ) {
+            continue;
+        }
+
+        Cluster cluster;
+        cluster.cell = cells.at( i );
+        cluster.count = clusterCount( cellRanges, levelCount, selectedCounts.value( cells.at( i ) ),
+                                      selectedPlacemarks, cluster.representative );
+        if ( cluster.count <= clusterThreshold ) {
+            continue;
+        }
+        clusters.append( cluster );
+
+        clusteredCells.append( cells.at( i ) );
+        for ( int level = 0; level < levelCount; ++level ) {
+            cellRanges[level] = qMakePair( 0, 0 );
+        }
+    }
+    qSort( clusteredCells );
 
-    QSet<TileId> tileIdSet;
     QList<const GeoDataPlacemark*> placemarkList;
-    bool crossesDateLine = viewport->viewLatLonAltBox().crossesDateLine();
-    for ( int level = pyramid.topLevel(); level <= pyramid.bottomLevel(); ++level ) {
-        QRect const coords = pyramid.coords( level );
-        int x1, y1, x2, y2;
-        coords.getCoords( &x1, &y1, &x2, &y2 );
-        if ( !crossesDateLine ) { // normal case, rect does not cross dateline
-            for ( int x = x1; x <= x2; ++x ) {
-                for ( int y = y1; y <= y2; ++y ) {
-                    TileId const tileId( 0, level, x, y );
-                    if ( !tileIdSet.contains( tileId ) ) {
-                        tileIdSet.insert(tileId);
-                        placemarkList += m_placemarkCache.value(tileId);
-                    }
-                }
-            }
-        } else { // as we cross dateline, we first get west part, then east part
-            // go till max tile
-            for ( int x = x1; x <= ((2 << (level-1))-1); ++x ) {
-                for ( int y = y1; y <= y2; ++y ) {
-                    TileId const tileId( 0, level, x, y );
-                    if ( !tileIdSet.contains( tileId ) ) {
-                        tileIdSet.insert(tileId);
-                        placemarkList += m_placemarkCache.value(tileId);
-                    }
-                }
-            }
-            // start from min tile
-            for ( int x = 0; x <= x2; ++x ) {
-                for ( int y = y1; y <= y2; ++y ) {
-                    TileId const tileId( 0, level, x, y );
-                    if ( !tileIdSet.contains( tileId ) ) {
-                        tileIdSet.insert(tileId);
-                        placemarkList += m_placemarkCache.value(tileId);
-                    }
-                }
+    for ( int level = 0; level < levelCount; ++level ) {
+        const QVector<CacheEntry> &entries = m_placemarkCache.at( level );
+        for ( int i = 0; i < cells.size(); ++i ) {
+            const QPair<int, int> &range = ranges.at( i * levelCount + level );
+            for ( int j = range.first; j < range.second; ++j ) {
+                placemarkList.append( entries.at( j ).placemark );
             }
         }
     }
     return placemarkList;
 }
 
+void PlacemarkLayout::layoutClusters( const QVector<Cluster> &clusters, int clusterLevel,
+                                      const ViewportParams *viewport )
+{
+    // Cluster markers are kept as long as their cell stays a cluster, so
+    // that they do not get in the way of coherent layouts.
+    QHash<quint64, GeoDataPlacemark*> previousClusters = m_clusterPlacemarks;
+    m_clusterPlacemarks.clear();
+    m_clusterMarkers.clear();
+
+    foreach ( const Cluster &cluster, clusters ) {
+        const GeoDataCoordinates coordinates = placemarkIconCoordinates( cluster.representative );
+
+        qreal x = 0;
+        qreal y = 0;
+
+        if ( !coordinates.isValid() ||
+             !viewport->viewLatLonAltBox().contains( coordinates ) ||
+             ! viewport->screenCoordinates( coordinates, x, y )) {
+            continue;
+        }
+
+        const quint64 key = ( quint64( clusterLevel ) << 56 ) | cluster.cell;
+        const QString name = QString::number( cluster.count );
+        GeoDataPlacemark *placemark = previousClusters.take( key );
+        if ( !placemark ) {
+            if ( !m_unusedClusterPlacemarks.isEmpty() ) {
+                placemark = m_unusedClusterPlacemarks.last();
+                m_unusedClusterPlacemarks.removeLast();
+                placemark->setName( name );
+            } else {
+                placemark = new GeoDataPlacemark( name );
+            }
+        } else if ( placemark->name() != name ) {
+            placemark->setName( name );
+            delete m_visiblePlacemarks.take( placemark );
+        }
+
+        // Only touch the marker if its representative changed, so that
+        // it keeps its label.
+        if ( !( placemark->coordinate() == coordinates ) ) {
+            placemark->setCoordinate( coordinates.longitude(), coordinates.latitude(), coordinates.altitude() );
+        }
+        if ( placemark->visualCategory() != cluster.representative->visualCategory() ) {
+            placemark->setVisualCategory( cluster.representative->visualCategory() );
+            delete m_visiblePlacemarks.take( placemark );
+        }
+
+        m_clusterPlacemarks.insert( key, placemark );
+        m_clusterMarkers.insert( placemark );
+
+        if( layoutPlacemark( placemark, x, y, false ) ) {
+            // Make sure not to draw more placemarks on the screen than
+            // specified by placemarksOnScreenLimit().
+            if ( placemarksOnScreenLimit( viewport->size() ) )
+                break;
+        }
+    }
+
+    foreach ( GeoDataPlacemark *placemark, previousClusters ) {
+        delete m_visiblePlacemarks.take( placemark );
+        m_unusedClusterPlacemarks.append( placemark );
+    }
+}
+
 QVector<VisiblePlacemark *> PlacemarkLayout::generateLayout( const ViewportParams *viewport )
 {
     m_runtimeTrace.clear();
@@ -384,12 +781,27 @@ QVector<VisiblePlacemark *> PlacemarkLayout::generateLayout( const ViewportParam
         return QVector<VisiblePlacemark *>();
     }
 
-    const int secnumber = viewport->height() / m_maxLabelHeight + 1;
-    m_rowsection.clear();
-    m_rowsection.resize(secnumber);
+    // Labels are a lot wider than high, so cells twice the label height
+    // keep the number of cells touched per label small.
+    m_labelGridCellSize = 2 * m_maxLabelHeight;
+    m_labelGridColumns = viewport->width() / m_labelGridCellSize + 1;
+    m_labelGridRows = viewport->height() / m_labelGridCellSize + 1;
+    m_labelGrid.fill( QVector<VisiblePlacemark*>(), m_labelGridColumns * m_labelGridRows );
+
+    // The placemarks drawn in the previous frame, most important first.
+    // After zooming other places compete for room, so start from scratch.
+    QVector<const GeoDataPlacemark*> previousPlacemarks;
+    if ( m_coherentLayout && viewport->radius() == m_layoutRadius ) {
+        previousPlacemarks.reserve( m_paintOrder.size() );
+        foreach ( const VisiblePlacemark *mark, m_paintOrder ) {
+            previousPlacemarks.append( mark->placemark() );
+        }
+    }
 
+    m_layoutRadius = viewport->radius();
     m_paintOrder.clear();
     m_labelArea = 0;
+    PlacemarkPixmapCache::instance()->resetStatistics();
 
     /**
      * First handle the selected placemarks, as they have the highest priority.
@@ -397,10 +809,22 @@ QVector<VisiblePlacemark *> PlacemarkLayout::generateLayout( const ViewportParam
 
     const QModelIndexList selectedIndexes = m_selectionModel->selection().indexes();
 
+    // Remember the selected placemarks so that they can be skipped
+    // in constant time below.
+    QVector<const GeoDataPlacemark*> selectedPlacemarkList;
+    selectedPlacemarkList.reserve( selectedIndexes.count() );
+    QSet<const GeoDataPlacemark*> selectedPlacemarks;
+    selectedPlacemarks.reserve( selectedIndexes.count() );
+
     for ( int i = 0; i < selectedIndexes.count(); ++i ) {
         const QModelIndex index = selectedIndexes.at( i );
         const GeoDataPlacemark *placemark = dynamic_cast<GeoDataPlacemark*>(qvariant_cast<GeoDataObject*>(index.data( MarblePlacemarkModel::ObjectPointerRole ) ));
         Q_ASSERT(placemark);
+        selectedPlacemarkList.append( placemark );
+        selectedPlacemarks.insert( placemark );
+    }
+
+    foreach ( const GeoDataPlacemark *placemark, selectedPlacemarkList ) {
         const GeoDataCoordinates coordinates = placemarkIconCoordinates( placemark );
 
         if ( !coordinates.isValid() ) {
@@ -429,18 +853,49 @@ QVector<VisiblePlacemark *> PlacemarkLayout::generateLayout( const ViewportParam
     /**
      * Now handle all other placemarks...
      */
-    const QItemSelection selection = m_selectionModel->selection();
+    QVector<bool> visibleCategories( GeoDataFeature::LastIndex );
+    for ( int i = 0; i < visibleCategories.size(); ++i ) {
+        visibleCategories[i] = isCategoryShown( GeoDataFeature::GeoDataVisualCategory( i ) );
+    }
 
-    const QList<const GeoDataPlacemark*> placemarkList = visiblePlacemarks( viewport );
-    foreach ( const GeoDataPlacemark *placemark, placemarkList ) {
-        const GeoDataCoordinates coordinates = placemarkIconCoordinates( placemark );
-        if ( !coordinates.isValid() ) {
+    /**
+     * In coherent mode the labels of the previous frame stay where they
+     * were relative to their placemarks, as long as they still fit. Only
+     * the remaining placemarks have to search for room below. This avoids
+     * labels jumping around and shuffling while the map is panned.
+     */
+    if ( m_clustering && ( !m_shownCountsValid || visibleCategories != m_shownCountsCategories ) ) {
+        updateShownCounts( visibleCategories );
+    }
+
+    QVector<Cluster> clusters;
+    QVector<quint64> clusteredCells;
+    int clusterLevel = 0;
+    const QList<const GeoDataPlacemark*> placemarkList = visiblePlacemarks( viewport, visibleCategories, selectedPlacemarks,
+                                                                            clusters, clusteredCells, clusterLevel );
+
+    const int viewportZoomLevel = qLn( viewport->radius() *4 / 256 ) / qLn( 2.0 );
+    QSet<const GeoDataPlacemark*> keptPlacemarks;
+    keptPlacemarks.reserve( previousPlacemarks.size() );
+
+    foreach ( const GeoDataPlacemark *placemark, previousPlacemarks ) {
+        // Selected placemarks have been handled already and offscreen ones
+        // may have been deleted meanwhile. Cluster markers are placed below.
+        VisiblePlacemark *const mark = m_visiblePlacemarks.value( placemark );
+        if ( !mark || selectedPlacemarks.contains( placemark ) || m_clusterMarkers.contains( placemark ) ) {
             continue;
         }
 
-        int zoomLevel = placemark->zoomLevel();
-        if ( zoomLevel > 18 ) {
-            break;
+        const int visualCategory = placemark->visualCategory();
+        if ( placemark->zoomLevel() > viewportZoomLevel || !placemark->isGloballyVisible()
+             || visualCategory < 0 || visualCategory >= visibleCategories.size()
+             || !visibleCategories.at( visualCategory ) ) {
+            continue;
+        }
+
+        const GeoDataCoordinates coordinates = placemarkIconCoordinates( placemark );
+        if ( !coordinates.isValid() ) {
+            continue;
         }
 
         qreal x = 0;
@@ -448,72 +903,75 @@ QVector<VisiblePlacemark *> PlacemarkLayout::generateLayout( const ViewportParam
 
         if ( !viewport->viewLatLonAltBox().contains( coordinates ) ||
              ! viewport->screenCoordinates( coordinates, x, y )) {
-                delete m_visiblePlacemarks.take( placemark );
-                continue;
-            }
+            continue;
+        }
 
-        if ( !placemark->isGloballyVisible() ) {
+        // Placemarks in crowded cells are part of a cluster now.
+        const TileId key = TileId::fromCoordinates( coordinates, cacheTileLevel );
+        const quint64 cell = mortonCode( key.x(), key.y() ) >> ( 2 * ( cacheTileLevel - clusterLevel ) );
+        if ( qBinaryFind( clusteredCells, cell ) != clusteredCells.constEnd() ) {
             continue;
         }
 
-        const GeoDataFeature::GeoDataVisualCategory visualCategory = placemark->visualCategory();
+        // Move the label along with its placemark.
+        const QPointF hotSpot = placemark->style()->iconStyle().hotSpot();
+        const QPointF previousAnchor = QPointF( mark->symbolPosition() )
+                                     + QPointF( qRound( hotSpot.x() ), qRound( hotSpot.y() ) );
+        QRectF labelRect = mark->labelRect();
+        labelRect.moveTopLeft( QPointF( x, y ) + labelRect.topLeft() - previousAnchor );
 
-        // Skip city marks if we're not showing cities.
-        if ( !m_showCities
-             && visualCategory >= GeoDataFeature::SmallCity
-             && visualCategory <= GeoDataFeature::Nation )
+        if ( labelRect.isNull() || !hasRoomForLabel( labelRect ) ) {
             continue;
+        }
 
-        // Skip terrain marks if we're not showing terrain.
-        if ( !m_showTerrain
-             && visualCategory >= GeoDataFeature::Mountain
-             && visualCategory <= GeoDataFeature::OtherTerrain )
-            continue;
+        placeLabel( placemark, x, y, labelRect, false );
+        keptPlacemarks.insert( placemark );
 
-        // Skip other places if we're not showing other places.
-        if ( !m_showOtherPlaces
-             && visualCategory >= GeoDataFeature::GeographicPole
-             && visualCategory <= GeoDataFeature::Observatory )
-            continue;
+        // Make sure not to draw more placemarks on the screen than
+        // specified by placemarksOnScreenLimit().
+        if ( placemarksOnScreenLimit( viewport->size() ) )
+            break;
+    }
 
-        // Skip landing sites if we're not showing landing sites.
-        if ( !m_showLandingSites
-             && visualCategory >= GeoDataFeature::MannedLandingSite
-             && visualCategory <= GeoDataFeature::UnmannedHardLandingSite )
-            continue;
+    layoutClusters( clusters, clusterLevel, viewport );
 
-        // Skip craters if we're not showing craters.
-        if ( !m_showCraters
-             && visualCategory == GeoDataFeature::Crater )
+    foreach ( const GeoDataPlacemark *placemark, placemarkList ) {
+        const GeoDataCoordinates coordinates = placemarkIconCoordinates( placemark );
+        if ( !coordinates.isValid() ) {
             continue;
+        }
 
-        // Skip maria if we're not showing maria.
-        if ( !m_showMaria
-             && visualCategory == GeoDataFeature::Mare )
+        int zoomLevel = placemark->zoomLevel();
+        if ( zoomLevel > 18 ) {
+            break;
+        }
+
+        qreal x = 0;
+        qreal y = 0;
+
+        if ( !viewport->viewLatLonAltBox().contains( coordinates ) ||
+             ! viewport->screenCoordinates( coordinates, x, y )) {
+                delete m_visiblePlacemarks.take( placemark );
+                continue;
+            }
+
+        if ( !placemark->isGloballyVisible() ) {
             continue;
+        }
 
-        if ( !m_showPlaces
-             && visualCategory >= GeoDataFeature::GeographicPole
-             && visualCategory <= GeoDataFeature::Observatory )
+        // Skip placemarks whose category is hidden.
+        const int visualCategory = placemark->visualCategory();
+        if ( visualCategory < 0 || visualCategory >= visibleCategories.size()
+             || !visibleCategories.at( visualCategory ) )
             continue;
 
         /**
          * We handled selected placemarks already, so we skip them here...
-         * Assuming that only a small amount of places is selected
-         * we check for the selected state after all other filters
          */
-        bool isSelected = false;
-        foreach ( const QModelIndex &index, selection.indexes() ) {
-            const GeoDataPlacemark *mark = dynamic_cast<GeoDataPlacemark*>(qvariant_cast<GeoDataObject*>(index.data( MarblePlacemarkModel::ObjectPointerRole ) ));
-            if (mark == placemark ) {
-                isSelected = true;
-                break;
-            }
-        }
-        if ( isSelected )
+        if ( selectedPlacemarks.contains( placemark ) || keptPlacemarks.contains( placemark ) )
             continue;
 
-        if( layoutPlacemark( placemark, x, y, isSelected ) ) {
+        if( layoutPlacemark( placemark, x, y, false ) ) {
             // Make sure not to draw more placemarks on the screen than
             // specified by placemarksOnScreenLimit().
             if ( placemarksOnScreenLimit( viewport->size() ) )
@@ -521,10 +979,58 @@ QVector<VisiblePlacemark *> PlacemarkLayout::generateLayout( const ViewportParam
         }
     }
 
-    m_runtimeTrace = QString("Visible: %1 Drawn: %2").arg( placemarkList.count() ).arg( m_paintOrder.size() );
+    m_runtimeTrace = QString("Visible: %1 Clusters: %2 Drawn: %3 Kept: %4 %5").arg( placemarkList.count() )
+                                                                               .arg( clusters.size() )
+                                                                               .arg( m_paintOrder.size() )
+                                                                               .arg( keptPlacemarks.size() )
+                                                                               .arg( PlacemarkPixmapCache::instance()->runtimeTrace() );
     return m_paintOrder;
 }
 
+bool PlacemarkLayout::isCategoryShown( GeoDataFeature::GeoDataVisualCategory visualCategory ) const
+{
+    // Skip city marks if we're not showing cities.
+    if ( !m_showCities
+         && visualCategory >= GeoDataFeature::SmallCity
+         && visualCategory <= GeoDataFeature::Nation )
+        return false;
+
+    // Skip terrain marks if we're not showing terrain.
+    if ( !m_showTerrain
+         && visualCategory >= GeoDataFeature::Mountain
+         && visualCategory <= GeoDataFeature::OtherTerrain )
+        return false;
+
+    // Skip other places if we're not showing other places.
+    if ( !m_showOtherPlaces
+         && visualCategory >= GeoDataFeature::GeographicPole
+         && visualCategory <= GeoDataFeature::Observatory )
+        return false;
+
+    // Skip landing sites if we're not showing landing sites.
+    if ( !m_showLandingSites
+         && visualCategory >= GeoDataFeature::MannedLandingSite
+         && visualCategory <= GeoDataFeature::UnmannedHardLandingSite )
+        return false;
+
+    // Skip craters if we're not showing craters.
+    if ( !m_showCraters
+         && visualCategory == GeoDataFeature::Crater )
+        return false;
+
+    // Skip maria if we're not showing maria.
+    if ( !m_showMaria
+         && visualCategory == GeoDataFeature::Mare )
+        return false;
+
+    if ( !m_showPlaces
+         && visualCategory >= GeoDataFeature::GeographicPole
+         && visualCategory <= GeoDataFeature::Observatory )
+        return false;
+
+    return true;
+}
+
 QString PlacemarkLayout::runtimeTrace() const
 {
     return m_runtimeTrace;
@@ -543,6 +1049,15 @@ bool PlacemarkLayout::layoutPlacemark( const GeoDataPlacemark *placemark, qreal
     if ( labelRect.isNull() )
         return false;
 
+    placeLabel( placemark, x, y, labelRect, selected );
+    return true;
+}
+
+void PlacemarkLayout::placeLabel( const GeoDataPlacemark *placemark, qreal x, qreal y,
+                                  const QRectF &labelRect, bool selected )
+{
+    const GeoDataStyle* style = placemark->style();
+
     // Find the corresponding visible placemark
     VisiblePlacemark *mark = m_visiblePlacemarks.value( placemark );
     if ( !mark ) {
@@ -562,18 +1077,10 @@ bool PlacemarkLayout::layoutPlacemark( const GeoDataPlacemark *placemark, qreal
                                      y - qRound( hotSpot.y() ) ) );
     mark->setLabelRect( labelRect );
 
-    // Add the current placemark to the matching row and its
-    // direct neighbors.
-    int idx = y / m_maxLabelHeight;
-    if ( idx - 1 >= 0 )
-        m_rowsection[ idx - 1 ].append( mark );
-    m_rowsection[ idx ].append( mark );
-    if ( idx + 1 < m_rowsection.size() )
-        m_rowsection[ idx + 1 ].append( mark );
+    addToLabelGrid( mark );
 
     m_paintOrder.append( mark );
     m_labelArea += labelRect.width() * labelRect.height();
-    return true;
 }
 
 GeoDataCoordinates PlacemarkLayout::placemarkIconCoordinates( const GeoDataPlacemark *placemark ) const
@@ -612,8 +1119,6 @@ QRectF PlacemarkLayout::roomForLabel( const GeoDataStyle * style,
         textWidth = ( QFontMetrics( labelFont ).width( labelText ) );
     }
 
-    const QVector<VisiblePlacemark*> currentsec = m_rowsection.at( y / m_maxLabelHeight );
-
     if ( style->labelStyle().alignment() == GeoDataLabelStyle::Corner ) {
         qreal  xpos = x + symbolwidth / 2 + 1;
         qreal  ypos = y;
@@ -632,19 +1137,10 @@ QRectF PlacemarkLayout::roomForLabel( const GeoDataStyle * style,
                 ypos = y;
             }
 
-            isRoom = true;
             labelRect.moveTo( xpos, ypos );
 
             // Check if there is another label or symbol that overlaps.
-            QVector<VisiblePlacemark*>::const_iterator beforeItEnd = m_paintOrder.constEnd();
-            for ( QVector<VisiblePlacemark*>::ConstIterator beforeIt = m_paintOrder.constBegin();
-                  beforeIt != beforeItEnd;
-                  ++beforeIt ) {
-                if ( labelRect.intersects( (*beforeIt)->labelRect()) ) {
-                    isRoom = false;
-                    break;
-                }
-            }
+            isRoom = hasRoomForLabel( labelRect );
 
             if ( isRoom ) {
                 // claim the place immediately if it hasn't been used yet
@@ -653,20 +1149,11 @@ QRectF PlacemarkLayout::roomForLabel( const GeoDataStyle * style,
         }
     }
     else if ( style->labelStyle().alignment() == GeoDataLabelStyle::Center ) {
-        isRoom = true;
         QRectF  labelRect( x - textWidth / 2, y - textHeight / 2,
                           textWidth, textHeight );
 
         // Check if there is another label or symbol that overlaps.
-        QVector<VisiblePlacemark*>::const_iterator beforeItEnd = currentsec.constEnd();
-        for ( QVector<VisiblePlacemark*>::ConstIterator beforeIt = currentsec.constBegin();
-              beforeIt != beforeItEnd; ++beforeIt )
-        {
-            if ( labelRect.intersects( (*beforeIt)->labelRect() ) ) {
-                isRoom = false;
-                break;
-            }
-        }
+        isRoom = hasRoomForLabel( labelRect );
 
         if ( isRoom ) {
             // claim the place immediately if it hasn't been used yet 
@@ -678,6 +1165,51 @@ QRectF PlacemarkLayout::roomForLabel( const GeoDataStyle * style,
                      // for the rectangle anymore.
 }
 
+QRect PlacemarkLayout::labelGridCells( const QRectF &rect ) const
+{
+    // Labels partially outside of the viewport go to the border cells.
+    // Clamping keeps the cell ranges of overlapping rects overlapping.
+    const int left   = qBound( 0, qFloor( rect.left()   / m_labelGridCellSize ), m_labelGridColumns - 1 );
+    const int right  = qBound( 0, qFloor( rect.right()  / m_labelGridCellSize ), m_labelGridColumns - 1 );
+    const int top    = qBound( 0, qFloor( rect.top()    / m_labelGridCellSize ), m_labelGridRows - 1 );
+    const int bottom = qBound( 0, qFloor( rect.bottom() / m_labelGridCellSize ), m_labelGridRows - 1 );
+
+    return QRect( QPoint( left, top ), QPoint( right, bottom ) );
+}
+
+bool PlacemarkLayout::hasRoomForLabel( const QRectF &labelRect ) const
+{
+    const QRect cells = labelGridCells( labelRect );
+
+    for ( int row = cells.top(); row <= cells.bottom(); ++row ) {
+        for ( int column = cells.left(); column <= cells.right(); ++column ) {
+            const QVector<VisiblePlacemark*> &cell = m_labelGrid.at( row * m_labelGridColumns + column );
+
+            QVector<VisiblePlacemark*>::const_iterator beforeItEnd = cell.constEnd();
+            for ( QVector<VisiblePlacemark*>::ConstIterator beforeIt = cell.constBegin();
+                  beforeIt != beforeItEnd; ++beforeIt )
+            {
+                if ( labelRect.intersects( (*beforeIt)->labelRect() ) ) {
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+void PlacemarkLayout::addToLabelGrid( VisiblePlacemark *mark )
+{
+    const QRect cells = labelGridCells( mark->labelRect() );
+
+    for ( int row = cells.top(); row <= cells.bottom(); ++row ) {
+        for ( int column = cells.left(); column <= cells.right(); ++column ) {
+            m_labelGrid[ row * m_labelGridColumns + column ].append( mark );
+        }
+    }
+}
+
 bool PlacemarkLayout::placemarksOnScreenLimit( const QSize &screenSize ) const
 {
     int ratio = ( m_labelArea * 100 ) / ( screenSize.width() * screenSize.height() );
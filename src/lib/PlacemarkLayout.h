@@ -20,11 +20,14 @@
 
 #include <QtCore/QHash>
 #include <QtCore/QModelIndex>
+#include <QtCore/QPair>
 #include <QtCore/QRect>
+#include <QtCore/QSet>
 #include <QtCore/QVector>
 #include <QtGui/QSortFilterProxyModel>
 
 #include "GeoDataFeature.h"
+#include "marble_export.h"
 
 class QAbstractItemModel;
 class QItemSelectionModel;
@@ -40,7 +43,6 @@ class GeoDataStyle;
 class GeoPainter;
 class MarbleClock;
 class PlacemarkPainter;
-class TileId;
 class VisiblePlacemark;
 class ViewportParams;
 
@@ -50,7 +52,7 @@ class ViewportParams;
 
 
 
-class PlacemarkLayout : public QObject
+class MARBLE_EXPORT PlacemarkLayout : public QObject
 {
     Q_OBJECT
 
@@ -80,6 +82,31 @@ class PlacemarkLayout : public QObject
 
     QString runtimeTrace() const;
 
+    /**
+     * Sets whether each layout starts from the labels of the previous one.
+     *
+     * In coherent mode labels that still fit keep their position relative
+     * to their placemark from frame to frame. Only placemarks that were not
+     * shown before search for room for their label. Labels are laid out
+     * from scratch again whenever the zoom changes, so that labels of less
+     * important places do not keep more important ones from showing up.
+     * Disabled by default.
+     */
+    void setCoherentLayout( bool coherent );
+    bool coherentLayout() const;
+
+    /**
+     * Sets whether crowded areas are shown as cluster markers.
+     *
+     * A cell of about 100 pixels holding more placemarks than there is room
+     * for is drawn as one marker labelled with the number of placemarks in
+     * it. Only placemarks that would be shown otherwise are counted.
+     * Clusters split up into smaller ones and finally into single
+     * placemarks when zooming in. Disabled by default.
+     */
+    void setClustering( bool clustering );
+    bool clustering() const;
+
  public Q_SLOTS:
     // earth
     void setShowPlaces( bool show );
@@ -93,12 +120,78 @@ class PlacemarkLayout : public QObject
     void setShowMaria( bool show );
 
     void requestStyleReset();
+
+    /**
+     * Tells the layout that placemarks may have been shown or hidden
+     * through the visibility of themselves or of their containers.
+     */
+    void requestVisibilityUpdate();
+
     void setCacheData();
 
  Q_SIGNALS:
     void repaintNeeded();
 
+ private Q_SLOTS:
+    void addPlacemarks( const QModelIndex &parent, int first, int last );
+    void removePlacemarks( const QModelIndex &parent, int first, int last );
+
  private:
+    /**
+     * A placemark together with the tile it falls into at a fixed, fine
+     * tile level. The tile is encoded as the Morton code of its x and y
+     * coordinates, so that the placemarks of any tile at any coarser level
+     * form a contiguous range.
+     */
+    struct CacheEntry
+    {
+        quint64 tile;
+        const GeoDataPlacemark *placemark;
+    };
+
+    /**
+     * A cell of the viewport holding too many placemarks to show each one.
+     */
+    struct Cluster
+    {
+        quint64 cell;
+        int count;
+        const GeoDataPlacemark *representative;
+    };
+
+    static bool tileLessThan( const CacheEntry &entry1, const CacheEntry &entry2 );
+
+    /**
+     * Fills in @p entry and @p level for @p placemark. Returns false if the
+     * placemark cannot be shown at any zoom level.
+     */
+    bool cacheEntry( const GeoDataPlacemark *placemark, CacheEntry &entry, int &level ) const;
+
+    /**
+     * Returns the number of placemarks shown with the current settings out
+     * of the @p ranges of m_placemarkCache, one for each of the first
+     * @p levelCount levels. Selected placemarks are not counted, as they
+     * are shown on their own; @p selectedCount of them fall into the ranges.
+     * One of the most popular of the counted placemarks is returned as
+     * @p representative.
+     *
+     * Only takes a binary search per level, see m_shownCounts.
+     */
+    int clusterCount( const QPair<int, int> *ranges, int levelCount, int selectedCount,
+                      const QSet<const GeoDataPlacemark*> &selectedPlacemarks,
+                      const GeoDataPlacemark *&representative ) const;
+
+    /**
+     * Returns whether @p placemark is shown with @p visibleCategories,
+     * regardless of whether it is selected.
+     */
+    static bool isShown( const GeoDataPlacemark *placemark, const QVector<bool> &visibleCategories );
+
+    /**
+     * Recounts m_shownCounts for @p visibleCategories.
+     */
+    void updateShownCounts( const QVector<bool> &visibleCategories );
+
     /**
      * Returns a the maximum height of all possible labels.
      * WARNING: This is a really slow method as it traverses all placemarks
@@ -110,8 +203,32 @@ class PlacemarkLayout : public QObject
 
     void styleReset();
 
-    QList<const GeoDataPlacemark*> visiblePlacemarks( const ViewportParams *viewport ) const;
+    /**
+     * Returns the placemarks in the viewport, most popular first. Cells at
+     * @p clusterLevel holding too many of them are returned as @p clusters
+     * instead, and their tile codes are returned sorted in @p clusteredCells.
+     */
+    QList<const GeoDataPlacemark*> visiblePlacemarks( const ViewportParams *viewport,
+                                                      const QVector<bool> &visibleCategories,
+                                                      const QSet<const GeoDataPlacemark*> &selectedPlacemarks,
+                                                      QVector<Cluster> &clusters,
+                                                      QVector<quint64> &clusteredCells,
+                                                      int &clusterLevel ) const;
+
+    /**
+     * Turns @p clusters into cluster markers and places them.
+     */
+    void layoutClusters( const QVector<Cluster> &clusters, int clusterLevel,
+                         const ViewportParams *viewport );
+
+    /**
+     * Returns whether placemarks of @p visualCategory are shown with the
+     * current settings. Evaluated once per category for each layout.
+     */
+    bool isCategoryShown( GeoDataFeature::GeoDataVisualCategory visualCategory ) const;
     bool layoutPlacemark( const GeoDataPlacemark *placemark, qreal x, qreal y, bool selected );
+    void placeLabel( const GeoDataPlacemark *placemark, qreal x, qreal y,
+                     const QRectF &labelRect, bool selected );
 
     /**
      * Returns the coordinates at which an icon should be drawn for the @p placemark.
@@ -124,6 +241,21 @@ class PlacemarkLayout : public QObject
                          const qreal x, const qreal y,
                          const QString &labelText ) const;
 
+    /**
+     * Returns whether @p labelRect overlaps none of the labels placed so far.
+     */
+    bool    hasRoomForLabel( const QRectF &labelRect ) const;
+
+    /**
+     * Registers the label of @p mark in all grid cells its label rect covers.
+     */
+    void    addToLabelGrid( VisiblePlacemark *mark );
+
+    /**
+     * Returns the range of grid cells covered by @p rect.
+     */
+    QRect   labelGridCells( const QRectF &rect ) const;
+
     bool    placemarksOnScreenLimit( const QSize &screenSize ) const;
 
  private:
@@ -136,10 +268,27 @@ class PlacemarkLayout : public QObject
     QString m_runtimeTrace;
     int m_labelArea;
     QHash<const GeoDataPlacemark*, VisiblePlacemark*> m_visiblePlacemarks;
-    QVector< QVector< VisiblePlacemark* > >  m_rowsection;
 
-    /// map providing the list of placemark belonging in TileId as key
-    QMap<TileId, QList<const GeoDataPlacemark*> > m_placemarkCache;
+    /// labels placed so far, bucketed by the screen cells their rects cover
+    QVector< QVector< VisiblePlacemark* > >  m_labelGrid;
+    int m_labelGridColumns;
+    int m_labelGridRows;
+    int m_labelGridCellSize;
+
+    /// placemarks per zoom level, sorted by tile and in model order within a tile
+    QVector< QVector<CacheEntry> > m_placemarkCache;
+
+    /// for each level of m_placemarkCache the number of shown placemarks
+    /// before each entry, with one more element holding the total
+    QVector< QVector<int> > m_shownCounts;
+    QVector<bool> m_shownCountsCategories;   // categories m_shownCounts are valid for
+    bool m_shownCountsValid;
+
+    /// cluster markers of the last layout by level and tile code of their cell
+    QHash<quint64, GeoDataPlacemark*> m_clusterPlacemarks;
+    QSet<const GeoDataPlacemark*> m_clusterMarkers;
+    /// cluster markers no longer in use, to be reused for other cells
+    QVector<GeoDataPlacemark*> m_unusedClusterPlacemarks;
 
     const QVector< GeoDataFeature::GeoDataVisualCategory > m_acceptedVisualCategories;
 
@@ -156,6 +305,9 @@ class PlacemarkLayout : public QObject
 
     int     m_maxLabelHeight;
     bool    m_styleResetRequested;
+    bool    m_coherentLayout;
+    int     m_layoutRadius;   // radius of the previous layout
+    bool    m_clustering;
 };
 
 }
@@ -0,0 +1,203 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "PlacemarkPixmapCache.h"
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QCryptographicHash>
+#include <QtGui/QPainter>
+
+namespace Marble
+{
+
+// Labels are kept until they take up more than 8 MB (the cost is in KB).
+static const int maxLabelCost = 8 * 1024;
+
+// Initial width of the icon atlas. It only gets wider for wider icons.
+static const int atlasWidth = 256;
+
+// The atlas gets cleared rather than growing higher than this. Icons of
+// places that are long gone get dropped that way.
+static const int maxAtlasHeight = 2048;
+
+bool PlacemarkPixmapCache::LabelKey::operator==( const LabelKey &other ) const
+{
+    return text == other.text
+        && font == other.font
+        && color == other.color
+        && glow == other.glow
+        && selected == other.selected;
+}
+
+uint qHash( const PlacemarkPixmapCache::LabelKey &key )
+{
+    return qHash( key.text ) ^ qHash( key.font ) ^ key.color
+         ^ ( uint( key.glow ) << 24 ) ^ ( uint( key.selected ) << 25 );
+}
+
+PlacemarkPixmapCache::PlacemarkPixmapCache()
+    : m_labels( maxLabelCost ),
+      m_labelHits( 0 ),
+      m_labelMisses( 0 ),
+      m_atlasDirty( false ),
+      m_shelfPosition( 0, 0 ),
+      m_shelfHeight( 0 ),
+      m_generation( 0 )
+{
+}
+
+static PlacemarkPixmapCache *s_instance = 0;
+
+// Pixmaps must not outlive the application object, so the cache
+// gets deleted together with it rather than at static destruction.
+static void deleteInstance()
+{
+    delete s_instance;
+    s_instance = 0;
+}
+
+PlacemarkPixmapCache *PlacemarkPixmapCache::instance()
+{
+    if ( !s_instance ) {
+        s_instance = new PlacemarkPixmapCache;
+        qAddPostRoutine( deleteInstance );
+    }
+
+    return s_instance;
+}
+
+QPixmap PlacemarkPixmapCache::label( const LabelKey &key )
+{
+    const QPixmap *const pixmap = m_labels.object( key );
+    if ( pixmap ) {
+        ++m_labelHits;
+        return *pixmap;
+    }
+
+    ++m_labelMisses;
+    return QPixmap();
+}
+
+void PlacemarkPixmapCache::insertLabel( const LabelKey &key, const QPixmap &pixmap )
+{
+    const int cost = qMax( 1, pixmap.width() * pixmap.height() * 4 / 1024 );
+    m_labels.insert( key, new QPixmap( pixmap ), cost );
+}
+
+QByteArray PlacemarkPixmapCache::contentKey( const QImage &icon )
+{
+    QCryptographicHash hash( QCryptographicHash::Md5 );
+    hash.addData( reinterpret_cast<const char *>( icon.bits() ), icon.byteCount() );
+
+    QByteArray key = hash.result();
+    key += QByteArray::number( icon.width() ) + 'x' + QByteArray::number( icon.height() )
+         + ':' + QByteArray::number( int( icon.format() ) );
+
+    return key;
+}
+
+QRect PlacemarkPixmapCache::iconRect( const QImage &icon )
+{
+    if ( icon.isNull() ) {
+        return QRect();
+    }
+
+    // Hashing the content is only needed once per image instance.
+    QHash<qint64, QByteArray>::const_iterator keyIt = m_iconKeys.constFind( icon.cacheKey() );
+    if ( keyIt == m_iconKeys.constEnd() ) {
+        keyIt = m_iconKeys.insert( icon.cacheKey(), contentKey( icon ) );
+    }
+    const QByteArray key = keyIt.value();
+
+    const QHash<QByteArray, QRect>::const_iterator it = m_iconRects.constFind( key );
+    if ( it != m_iconRects.constEnd() ) {
+        return it.value();
+    }
+
+    // Fill the atlas shelf by shelf, each shelf as high as its tallest icon.
+    const int width = qMax( atlasWidth, m_atlasImage.width() );
+    if ( m_shelfPosition.x() + icon.width() > width ) {
+        m_shelfPosition = QPoint( 0, m_shelfPosition.y() + m_shelfHeight );
+        m_shelfHeight = 0;
+    }
+
+    // Start over with an empty atlas once it is full.
+    if ( m_shelfPosition.y() + icon.height() > maxAtlasHeight && !m_iconRects.isEmpty() ) {
+        m_iconRects.clear();
+        m_iconKeys.clear();
+        m_iconKeys.insert( icon.cacheKey(), key );
+        m_atlasImage.fill( 0 );
+        m_shelfPosition = QPoint( 0, 0 );
+        m_shelfHeight = 0;
+        ++m_generation;
+    }
+
+    // Growing keeps the existing icons in place, so handed out rects stay valid.
+    const QSize requiredSize( qMax( width, icon.width() ), m_shelfPosition.y() + icon.height() );
+    if ( requiredSize.width() > m_atlasImage.width() || requiredSize.height() > m_atlasImage.height() ) {
+        const int height = qMax( requiredSize.height(), qMin( 2 * m_atlasImage.height(), maxAtlasHeight ) );
+        QImage atlasImage( QSize( requiredSize.width(), height ),
+                           QImage::Format_ARGB32_Premultiplied );
+        atlasImage.fill( 0 );
+
+        QPainter painter( &atlasImage );
+        painter.setCompositionMode( QPainter::CompositionMode_Source );
+        painter.drawImage( 0, 0, m_atlasImage );
+        painter.end();
+
+        m_atlasImage = atlasImage;
+    }
+
+    QPainter painter( &m_atlasImage );
+    painter.setCompositionMode( QPainter::CompositionMode_Source );
+    painter.drawImage( m_shelfPosition, icon );
+    painter.end();
+
+    const QRect rect( m_shelfPosition, icon.size() );
+    m_iconRects.insert( key, rect );
+
+    m_shelfPosition.rx() += icon.width() + 1;
+    m_shelfHeight = qMax( m_shelfHeight, icon.height() + 1 );
+    m_atlasDirty = true;
+
+    return rect;
+}
+
+int PlacemarkPixmapCache::generation() const
+{
+    return m_generation;
+}
+
+const QPixmap &PlacemarkPixmapCache::atlas()
+{
+    if ( m_atlasDirty ) {
+        m_atlas = QPixmap::fromImage( m_atlasImage );
+        m_atlasDirty = false;
+    }
+
+    return m_atlas;
+}
+
+QString PlacemarkPixmapCache::runtimeTrace() const
+{
+    return QString( "Labels: %1 (%2 KB, %3/%4 hits) Icons: %5 (%6 KB)" )
+            .arg( m_labels.count() )
+            .arg( m_labels.totalCost() )
+            .arg( m_labelHits )
+            .arg( m_labelHits + m_labelMisses )
+            .arg( m_iconRects.count() )
+            .arg( m_atlasImage.byteCount() / 1024 );
+}
+
+void PlacemarkPixmapCache::resetStatistics()
+{
+    m_labelHits = 0;
+    m_labelMisses = 0;
+}
+
+}
@@ -0,0 +1,121 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_PLACEMARKPIXMAPCACHE_H
+#define MARBLE_PLACEMARKPIXMAPCACHE_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QCache>
+#include <QtCore/QHash>
+#include <QtCore/QRect>
+#include <QtCore/QString>
+#include <QtGui/QColor>
+#include <QtGui/QFont>
+#include <QtGui/QImage>
+#include <QtGui/QPixmap>
+
+namespace Marble
+{
+
+/**
+ * @short Shares the rendered labels and symbols of visible placemarks.
+ *
+ * Visible placemarks get created and destroyed a lot while panning. Instead
+ * of rendering the same label text and converting the same icon again for
+ * each of them, labels are kept in a least recently used cache of bounded
+ * size, and icons are copied once into a single atlas pixmap.
+ *
+ * There is one instance per process, see instance(). It must only be used
+ * from the GUI thread.
+ */
+class PlacemarkPixmapCache
+{
+ public:
+    /**
+     * The look of a rendered label.
+     */
+    struct LabelKey
+    {
+        QString text;
+        QString font;
+        QRgb color;
+        bool glow;
+        bool selected;
+
+        bool operator==( const LabelKey &other ) const;
+    };
+
+    static PlacemarkPixmapCache *instance();
+
+    /**
+     * Returns the cached label for @p key, or a null pixmap if there is none.
+     */
+    QPixmap label( const LabelKey &key );
+
+    void insertLabel( const LabelKey &key, const QPixmap &pixmap );
+
+    /**
+     * Copies @p icon into the atlas unless an icon with the same content is
+     * there already and returns the area it covers in atlas(). Returns an
+     * empty rect for null icons.
+     *
+     * Styles load their own copy of an icon even if they share the file, so
+     * icons are told apart by content rather than by QImage::cacheKey().
+     *
+     * Once the atlas is full it gets cleared and refilled with the icons
+     * requested from then on, see generation().
+     */
+    QRect iconRect( const QImage &icon );
+
+    /**
+     * Returns a number that changes whenever the atlas gets cleared. Rects
+     * returned by iconRect() stay valid as long as it doesn't change.
+     */
+    int generation() const;
+
+    /**
+     * Returns the pixmap holding all icons passed to iconRect() so far.
+     *
+     * The atlas gets converted to a pixmap lazily, so callers should resolve
+     * all icon rects of a frame before asking for it.
+     */
+    const QPixmap &atlas();
+
+    /**
+     * Returns a summary of the memory used and of the hit rate since the
+     * last call of resetStatistics(), suitable for runtime traces.
+     */
+    QString runtimeTrace() const;
+
+    void resetStatistics();
+
+ private:
+    PlacemarkPixmapCache();
+    Q_DISABLE_COPY( PlacemarkPixmapCache )
+
+    QCache<LabelKey, QPixmap> m_labels;
+    int m_labelHits;
+    int m_labelMisses;
+
+    static QByteArray contentKey( const QImage &icon );
+
+    QHash<qint64, QByteArray> m_iconKeys;   // QImage::cacheKey() to contentKey()
+    QHash<QByteArray, QRect>  m_iconRects;
+    QImage  m_atlasImage;
+    QPixmap m_atlas;
+    bool    m_atlasDirty;
+    QPoint  m_shelfPosition;  // where the next icon goes in the current shelf
+    int     m_shelfHeight;    // height of the tallest icon in the current shelf
+    int     m_generation;
+};
+
+uint qHash( const PlacemarkPixmapCache::LabelKey &key );
+
+}
+
+#endif
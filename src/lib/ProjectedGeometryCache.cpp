@@ -0,0 +1,137 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "ProjectedGeometryCache.h"
+
+#include "GeoDataLineString.h"
+#include "ViewportParams.h"
+
+namespace Marble
+{
+
+ProjectedGeometryCache::Fingerprint::Fingerprint()
+    : projection( Spherical ),
+      radius( -1 ),
+      centerLon( 0.0 ),
+      centerLat( 0.0 ),
+      width( -1 ),
+      height( -1 ),
+      tessellationTolerance( 0.0 ),
+      smallScreen( false )
+{
+}
+
+bool ProjectedGeometryCache::Fingerprint::operator==( const Fingerprint &other ) const
+{
+    return projection == other.projection
+        && radius == other.radius
+        && centerLon == other.centerLon
+        && centerLat == other.centerLat
+        && width == other.width
+        && height == other.height
+        && tessellationTolerance == other.tessellationTolerance
+        && smallScreen == other.smallScreen;
+}
+
+ProjectedGeometryCache::ProjectedGeometryCache( int maxPoints )
+    : m_viewport( 0 ),
+      m_entries( maxPoints ),
+      m_hits( 0 ),
+      m_misses( 0 )
+{
+}
+
+ProjectedGeometryCache::~ProjectedGeometryCache()
+{
+}
+
+void ProjectedGeometryCache::setViewport( const ViewportParams *viewport )
+{
+    m_viewport = viewport;
+
+    m_fingerprint.projection = viewport->projection();
+    m_fingerprint.radius = viewport->radius();
+    m_fingerprint.centerLon = viewport->centerLongitude();
+    m_fingerprint.centerLat = viewport->centerLatitude();
+    m_fingerprint.width = viewport->width();
+    m_fingerprint.height = viewport->height();
+    m_fingerprint.tessellationTolerance = viewport->tessellationTolerance();
+    m_fingerprint.smallScreen = MarbleGlobal::getInstance()->profiles() & MarbleGlobal::SmallScreen;
+}
+
+bool ProjectedGeometryCache::screenCoordinates( const GeoDataLineString &lineString,
+                                                QVector<QPolygonF> &polygons )
+{
+    Q_ASSERT( m_viewport );
+
+    const Entry *const cached = m_entries.object( &lineString );
+    if ( cached
+         && cached->fingerprint == m_fingerprint
+         && cached->revision == lineString.revision() ) {
+        ++m_hits;
+        polygons += cached->polygons;
+        return cached->visible;
+    }
+
+    ++m_misses;
+
+    QVector<QPolygonF*> projected;
+    const bool visible = m_viewport->screenCoordinates( lineString, projected );
+
+    Entry *entry = new Entry;
+    entry->fingerprint = m_fingerprint;
+    entry->revision = lineString.revision();
+    entry->visible = visible;
+
+    int cost = 1;
+    entry->polygons.reserve( projected.size() );
+    foreach ( const QPolygonF *polygon, projected ) {
+        entry->polygons << *polygon;
+        cost += polygon->size();
+    }
+    qDeleteAll( projected );
+    polygons += entry->polygons;
+
+    // QCache deletes the entry right away if it exceeds the maximum cost
+    m_entries.insert( &lineString, entry, cost );
+
+    return visible;
+}
+
+void ProjectedGeometryCache::clear()
+{
+    m_entries.clear();
+}
+
+int ProjectedGeometryCache::hits() const
+{
+    return m_hits;
+}
+
+int ProjectedGeometryCache::misses() const
+{
+    return m_misses;
+}
+
+int ProjectedGeometryCache::count() const
+{
+    return m_entries.count();
+}
+
+int ProjectedGeometryCache::totalPoints() const
+{
+    return m_entries.totalCost();
+}
+
+void ProjectedGeometryCache::resetStatistics()
+{
+    m_hits = 0;
+    m_misses = 0;
+}
+
+}
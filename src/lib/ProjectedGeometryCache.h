@@ -0,0 +1,109 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_PROJECTEDGEOMETRYCACHE_H
+#define MARBLE_PROJECTEDGEOMETRYCACHE_H
+
+#include <QtCore/QCache>
+#include <QtCore/QVector>
+#include <QtGui/QPolygonF>
+
+#include "MarbleGlobal.h"
+#include "marble_export.h"
+
+namespace Marble
+{
+
+class GeoDataLineString;
+class ViewportParams;
+
+/**
+ * @short Keeps screen polygons of line strings across repaints.
+ *
+ * Projecting, tessellating and splitting a line string into screen polygons
+ * only depends on the line string and the viewport. As long as neither
+ * changes, repaints (e.g. triggered by float items or the position marker)
+ * can reuse the polygons of the previous frame.
+ *
+ * Entries are keyed by the address of the line string and only returned
+ * while its revision matches, so modified line strings and new ones that
+ * reuse the memory of deleted ones get projected again. The memory used is
+ * bounded by the total number of screen points, least recently used entries
+ * are evicted first.
+ */
+class MARBLE_EXPORT ProjectedGeometryCache
+{
+ public:
+    explicit ProjectedGeometryCache( int maxPoints = 1000000 );
+    ~ProjectedGeometryCache();
+
+    /**
+     * @brief Sets the viewport the following lookups refer to.
+     *
+     * Entries that were projected for a different viewport are not
+     * returned anymore.
+     */
+    void setViewport( const ViewportParams *viewport );
+
+    /**
+     * @brief Returns the screen polygons of @p lineString for the current viewport.
+     *
+     * The polygons are appended to @p polygons. They share their points with
+     * the cache until either side modifies them.
+     */
+    bool screenCoordinates( const GeoDataLineString &lineString,
+                            QVector<QPolygonF> &polygons );
+
+    void clear();
+
+    int hits() const;
+    int misses() const;
+    int count() const;
+    int totalPoints() const;
+
+    /**
+     * @brief Resets the hit and miss counters, e.g. at the start of a frame.
+     */
+    void resetStatistics();
+
+ private:
+    Q_DISABLE_COPY( ProjectedGeometryCache )
+
+    struct Fingerprint
+    {
+        Fingerprint();
+        bool operator==( const Fingerprint &other ) const;
+
+        Projection projection;
+        int radius;
+        qreal centerLon;
+        qreal centerLat;
+        int width;
+        int height;
+        qreal tessellationTolerance;
+        bool smallScreen;
+    };
+
+    struct Entry
+    {
+        Fingerprint fingerprint;
+        int revision;
+        bool visible;
+        QVector<QPolygonF> polygons;
+    };
+
+    const ViewportParams *m_viewport;
+    Fingerprint m_fingerprint;
+    QCache<const GeoDataLineString *, Entry> m_entries;
+    int m_hits;
+    int m_misses;
+};
+
+}
+
+#endif
@@ -25,8 +25,75 @@
 
 using namespace Marble;
 
-// Maximum amount of nodes that are created automatically between actual nodes.
-static const int maxTessellationNodes = 200;
+// Maximum depth of the adaptive subdivision of a line segment. This limits
+// the amount of nodes that are created automatically between actual nodes to 256.
+static const int maxTessellationDepth = 8;
+
+namespace
+{
+
+// A piece of a line segment that is about to be tessellated: t is the
+// interpolation parameter along the whole segment, point the screen position
+// and hidden whether the globe hides the node at that position.
+struct TessellationPiece
+{
+    TessellationPiece()
+        : t0( 0.0 ), t1( 0.0 ), hidden0( false ), hidden1( false ), depth( 0 )
+    {}
+
+    TessellationPiece( qreal t0_, const QPointF &point0_, bool hidden0_,
+                       qreal t1_, const QPointF &point1_, bool hidden1_,
+                       const GeoDataCoordinates &coords1_,
+                       int depth_ )
+        : t0( t0_ ), t1( t1_ ), point0( point0_ ), point1( point1_ ),
+          hidden0( hidden0_ ), hidden1( hidden1_ ), coords1( coords1_ ), depth( depth_ )
+    {}
+
+    qreal t0;
+    qreal t1;
+    QPointF point0;
+    QPointF point1;
+    bool hidden0;
+    bool hidden1;
+    GeoDataCoordinates coords1;
+    int depth;
+};
+
+// Distance of point from the line segment that connects a and b.
+qreal distanceToChord( const QPointF &point, const QPointF &a, const QPointF &b )
+{
+    const qreal dx = b.x() - a.x();
+    const qreal dy = b.y() - a.y();
+    const qreal lengthSquared = dx * dx + dy * dy;
+
+    qreal t = 0.0;
+    if ( lengthSquared > 0.0 ) {
+        t = ( ( point.x() - a.x() ) * dx + ( point.y() - a.y() ) * dy ) / lengthSquared;
+        t = qBound( qreal( 0.0 ), t, qreal( 1.0 ) );
+    }
+
+    const qreal ex = point.x() - ( a.x() + t * dx );
+    const qreal ey = point.y() - ( a.y() + t * dy );
+
+    return sqrt( ex * ex + ey * ey );
+}
+
+// Moves x by multiples of worldWidth so that it ends up next to reference.
+qreal unwrapX( qreal x, qreal reference, qreal worldWidth )
+{
+    if ( worldWidth > 0.0 ) {
+        while ( x - reference > 0.5 * worldWidth ) {
+            x -= worldWidth;
+        }
+        while ( reference - x > 0.5 * worldWidth ) {
+            x += worldWidth;
+        }
+    }
+
+    return x;
+}
+
+}
 
 AbstractProjection::AbstractProjection()
     : d_ptr( new AbstractProjectionPrivate( this ) )
@@ -294,18 +361,13 @@ void AbstractProjectionPrivate::tessellateLineSegment( const GeoDataCoordinates
     )
     {
 #endif
-        bool const smallScreen = MarbleGlobal::getInstance()->profiles() & MarbleGlobal::SmallScreen;
-        int const finalTessellationPrecision = smallScreen ? 3 * tessellationPrecision : tessellationPrecision;
-
-        int tessellatedNodes = (int)( distance / finalTessellationPrecision );
-
         // Let the line segment follow the spherical surface
-        // if the distance between the previous point and the current point
-        // on screen is too big
-        if ( distance > finalTessellationPrecision ) {
+        // unless the previous point and the current point are so close
+        // on screen that the line in between can't deviate visibly
+        if ( distance > tessellationTolerance( viewport ) ) {
 
-            processTessellation( aCoords, bCoords,
-                                 tessellatedNodes,
+            processTessellation( aCoords, ax, ay,
+                                 bCoords, bx, by,
                                  polygons,
                                  viewport,
                                  f );
@@ -320,19 +382,18 @@ void AbstractProjectionPrivate::tessellateLineSegment( const GeoDataCoordinates
 
 
 void AbstractProjectionPrivate::processTessellation(  const GeoDataCoordinates &previousCoords,
+                                                    qreal previousX, qreal previousY,
                                                     const GeoDataCoordinates &currentCoords,
-                                                    int tessellatedNodes,
+                                                    qreal currentX, qreal currentY,
                                                     QVector<QPolygonF*> &polygons,
                                                     const ViewportParams *viewport,
                                                     TessellationFlags f ) const
 {
+    Q_Q( const AbstractProjection );
 
     const bool clampToGround = f.testFlag( FollowGround );
     bool followLatitudeCircle = false;     
 
-    // Maximum amount of tessellation nodes.
-    if ( tessellatedNodes > maxTessellationNodes ) tessellatedNodes = maxTessellationNodes;
-
     qreal previousAltitude = previousCoords.altitude();
 
     // Calculate steps for tessellation: lonDiff and altDiff 
@@ -371,42 +432,94 @@ void AbstractProjectionPrivate::processTessellation(  const GeoDataCoordinates &
 
     qreal altDiff = currentCoords.altitude() - previousAltitude;
 
-    int startNode = 1;
-    const int endNode = tessellatedNodes - 2;
+    // For the clampToGround case add the "current" coordinate after adding all other nodes. 
+    GeoDataCoordinates currentModifiedCoords( currentCoords );
+    if ( clampToGround ) {
+        currentModifiedCoords.setAltitude( 0.0 );
+    }
 
-    // Create the tessellation nodes.
-    for ( int i = startNode; i <= endNode; ++i ) {
-        qreal  t = (qreal)(i) / (qreal)( tessellatedNodes ) ;
+    const qreal tolerance = tessellationTolerance( viewport );
 
-        // interpolate the altitude, too
-        qreal altitude = clampToGround ? 0 : altDiff * t + previousAltitude;
+    // Screen positions of segments crossing the date line get compared
+    // as if the map continued beyond it.
+    const qreal worldWidth = q->repeatX() ? mirrorPoint( viewport ) : 0.0;
 
-        if ( followLatitudeCircle ) {
-            // To tessellate along latitude circles use the 
-            // linear interpolation of the longitude.
-            lon = lonDiff * t + previousCoords.longitude();
-            lat = previousLatitude;
-        }
-        else {
-            // To tessellate along great circles use the 
-            // normalized linear interpolation ("NLERP") for latitude and longitude.
-            const Quaternion itpos = Quaternion::nlerp( previousCoords.quaternion(), currentCoords.quaternion(), t );
-            itpos. getSpherical( lon, lat );
+    // Subdivide the segment until the projection of the midpoint of each piece
+    // is closer to the straight line between its ends than the tolerance.
+    // The pieces are processed from start to end using an explicit stack
+    // which never holds more than maxTessellationDepth + 1 pieces.
+    TessellationPiece pieces[ maxTessellationDepth + 1 ];
+    int pieceCount = 0;
+
+    qreal x, y;
+    bool previousHidden;
+    bool currentHidden;
+    q->screenCoordinates( previousCoords, viewport, x, y, previousHidden );
+    q->screenCoordinates( currentCoords, viewport, x, y, currentHidden );
+
+    pieces[ pieceCount++ ] = TessellationPiece( 0.0, QPointF( previousX, previousY ), previousHidden,
+                                                1.0, QPointF( unwrapX( currentX, previousX, worldWidth ), currentY ), currentHidden,
+                                                currentModifiedCoords, 0 );
+
+    while ( pieceCount > 0 ) {
+        const TessellationPiece piece = pieces[ --pieceCount ];
+
+        if ( piece.depth < maxTessellationDepth ) {
+            const qreal t = 0.5 * ( piece.t0 + piece.t1 );
+
+            // interpolate the altitude, too
+            qreal altitude = clampToGround ? 0 : altDiff * t + previousAltitude;
+
+            if ( followLatitudeCircle ) {
+                // To tessellate along latitude circles use the 
+                // linear interpolation of the longitude.
+                lon = lonDiff * t + previousCoords.longitude();
+                lat = previousLatitude;
+            }
+            else {
+                // To tessellate along great circles use the 
+                // normalized linear interpolation ("NLERP") for latitude and longitude.
+                const Quaternion itpos = Quaternion::nlerp( previousCoords.quaternion(), currentCoords.quaternion(), t );
+                itpos. getSpherical( lon, lat );
+            }
+
+            const GeoDataCoordinates midCoords( lon, lat, altitude );
+
+            bool globeHidesPoint;
+            q->screenCoordinates( midCoords, viewport, x, y, globeHidesPoint );
+            const QPointF midPoint( unwrapX( x, piece.point0.x(), worldWidth ), y );
+
+            // Pieces that are hidden entirely don't need any precision. Pieces
+            // that are hidden partially get refined to find the horizon.
+            const bool split = globeHidesPoint
+                ? !( piece.hidden0 && piece.hidden1 )
+                : piece.hidden0 || piece.hidden1
+                  || distanceToChord( midPoint, piece.point0, piece.point1 ) > tolerance;
+
+            if ( split ) {
+                // Push the second half first so that the first half gets processed first.
+                pieces[ pieceCount++ ] = TessellationPiece( t, midPoint, globeHidesPoint,
+                                                            piece.t1, piece.point1, piece.hidden1,
+                                                            piece.coords1, piece.depth + 1 );
+                pieces[ pieceCount++ ] = TessellationPiece( piece.t0, piece.point0, piece.hidden0,
+                                                            t, midPoint, globeHidesPoint,
+                                                            midCoords, piece.depth + 1 );
+                continue;
+            }
         }
 
-        crossDateLine( GeoDataCoordinates( previousLongitude, previousLatitude, previousAltitude),
-                       GeoDataCoordinates( lon, lat, altitude ), polygons, viewport );
-        previousLongitude = lon;
+        crossDateLine( GeoDataCoordinates( previousLongitude, previousLatitude, previousAltitude ),
+                       piece.coords1, polygons, viewport );
+        previousLongitude = piece.coords1.longitude();
     }
+}
 
+qreal AbstractProjectionPrivate::tessellationTolerance( const ViewportParams *viewport ) const
+{
+    bool const smallScreen = MarbleGlobal::getInstance()->profiles() & MarbleGlobal::SmallScreen;
 
-    // For the clampToGround case add the "current" coordinate after adding all other nodes. 
-    GeoDataCoordinates currentModifiedCoords( currentCoords );
-    if ( clampToGround ) {
-        currentModifiedCoords.setAltitude( 0.0 );
-    }
-    crossDateLine( GeoDataCoordinates( previousLongitude, previousLatitude, previousAltitude ),
-                   currentModifiedCoords, polygons, viewport );
+    return smallScreen ? 3 * viewport->tessellationTolerance()
+                       : viewport->tessellationTolerance();
 }
 
 void AbstractProjectionPrivate::crossDateLine( const GeoDataCoordinates & aCoord,
@@ -33,8 +33,6 @@
 namespace Marble
 {
 
-// The manhattan distance in pixels at which extra nodes get created for tessellation.
-static const int tessellationPrecision = 10;
 static const int latLonAltBoxSamplingRate = 4;
 
 class GeoDataLineString;
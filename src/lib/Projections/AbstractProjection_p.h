@@ -31,10 +31,9 @@ class AbstractProjectionPrivate
     qreal  m_minLat;
 
     // This method tessellates a line segment in a way that the line segment
-    // follows great circles. The count parameter specifies the
-    // number of nodes generated for the polygon. If the
-    // clampToGround flag is added the polygon contains count + 2
-    // nodes as the clamped down start and end node get added.
+    // follows great circles. The segment gets subdivided until the
+    // tessellated line deviates less than ViewportParams::tessellationTolerance()
+    // pixels from the projected great circle (or latitude circle).
 
     void tessellateLineSegment( const GeoDataCoordinates &aCoords,
                                 qreal ax, qreal ay,
@@ -45,14 +44,18 @@ class AbstractProjectionPrivate
                                 TessellationFlags f = 0 ) const;
 
     void processTessellation(  const GeoDataCoordinates &previousCoords,
+                               qreal previousX, qreal previousY,
                                const GeoDataCoordinates &currentCoords,
-                               int count,
+                               qreal currentX, qreal currentY,
                                QVector<QPolygonF*> &polygons,
                                const ViewportParams *viewport,
                                TessellationFlags f = 0 ) const;
 
     qreal mirrorPoint( const ViewportParams *viewport ) const;
 
+    // The tessellation tolerance of the viewport, adjusted for the small screen profile.
+    qreal tessellationTolerance( const ViewportParams *viewport ) const;
+
 
     void translatePolygons( const QVector<QPolygonF *> &polygons,
                             QVector<QPolygonF *> &translatedPolygons,
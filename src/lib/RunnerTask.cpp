@@ -100,22 +100,53 @@ void RoutingTask::runTask()
     runner->deleteLater();
 }
 
-ParsingTask::ParsingTask( const ParseRunnerPlugin *factory, MarbleRunnerManager *manager, const QString& fileName, DocumentRole role ) :
+ParsingTask::ParsingTask( const QList<const ParseRunnerPlugin*> &factories, MarbleRunnerManager *manager,
+                          const QString& fileName, DocumentRole role,
+                          const QSharedPointer<QAtomicInt> &canceled, const GeoDataLatLonBox &latLonBox ) :
     RunnerTask( manager ),
-    m_factory( factory ),
+    m_factories( factories ),
+    m_document( 0 ),
     m_fileName( fileName ),
-    m_role( role )
+    m_role( role ),
+    m_canceled( canceled ),
+    m_latLonBox( latLonBox )
 {
-    // nothing to do
+    connect( this, SIGNAL( parsed( GeoDataDocument*, QString ) ),
+             manager, SLOT( addParsingResult( GeoDataDocument*, QString ) ) );
 }
 
 void ParsingTask::runTask()
 {
-    MarbleAbstractRunner *runner = m_factory->newRunner();
-    connect( runner, SIGNAL( parsingFinished( GeoDataDocument*, QString ) ),
-             manager(), SLOT( addParsingResult( GeoDataDocument*, QString ) ) );
-    runner->parseFile( m_fileName, m_role );
-    runner->deleteLater();
+    QString firstError;
+    foreach( const ParseRunnerPlugin *factory, m_factories ) {
+        m_error.clear();
+        MarbleAbstractRunner *runner = factory->newRunner();
+        connect( runner, SIGNAL( parsingFinished( GeoDataDocument*, QString ) ),
+                 this, SLOT( setResult( GeoDataDocument*, QString ) ), Qt::DirectConnection );
+        connect( runner, SIGNAL( featuresParsed( GeoDataDocument*, qreal ) ),
+                 manager(), SIGNAL( featuresParsed( GeoDataDocument*, qreal ) ) );
+        runner->setStreaming( m_canceled );
+        runner->setLatLonBox( m_latLonBox );
+        runner->parseFile( m_fileName, m_role );
+        runner->deleteLater();
+
+        if ( m_document || ( m_canceled && *m_canceled ) ) {
+            break;
+        }
+        mDebug() << factory->nameId() << "runner could not read" << m_fileName << m_error;
+
+        if ( firstError.isEmpty() ) {
+            firstError = m_error;
+        }
+    }
+
+    emit parsed( m_document, m_document ? m_error : firstError );
+}
+
+void ParsingTask::setResult( GeoDataDocument *document, const QString &error )
+{
+    m_document = document;
+    m_error = error;
 }
 
 }
@@ -15,7 +15,10 @@
 #include "GeoDataDocument.h"
 #include "GeoDataLatLonAltBox.h"
 
+#include <QtCore/QAtomicInt>
+#include <QtCore/QList>
 #include <QtCore/QRunnable>
+#include <QtCore/QSharedPointer>
 #include <QtCore/QString>
 
 namespace Marble
@@ -115,14 +118,34 @@ class ParsingTask : public RunnerTask
     Q_OBJECT
 
 public:
-    ParsingTask( const ParseRunnerPlugin* factory, MarbleRunnerManager *manager, const QString& fileName, DocumentRole role );
+    /**
+      * Tries the runners of @p factories in turn until one of them returns a
+      * document. If none does, the first error a runner returned is reported.
+      * Parses the file in batches as described in MarbleAbstractRunner::setStreaming
+      * unless @p canceled is a null pointer. Only the features intersecting
+      * @p latLonBox are read if it is not empty and the runner supports it.
+      */
+    ParsingTask( const QList<const ParseRunnerPlugin*> &factories, MarbleRunnerManager *manager,
+                 const QString& fileName, DocumentRole role,
+                 const QSharedPointer<QAtomicInt> &canceled = QSharedPointer<QAtomicInt>(),
+                 const GeoDataLatLonBox &latLonBox = GeoDataLatLonBox() );
 
     virtual void runTask();
 
+Q_SIGNALS:
+    void parsed( GeoDataDocument *document, const QString &error );
+
+private Q_SLOTS:
+    void setResult( GeoDataDocument *document, const QString &error );
+
 private:
-    const ParseRunnerPlugin *const m_factory;
+    const QList<const ParseRunnerPlugin*> m_factories;
+    GeoDataDocument *m_document;
+    QString m_error;
     QString m_fileName;
     DocumentRole m_role;
+    QSharedPointer<QAtomicInt> m_canceled;
+    GeoDataLatLonBox m_latLonBox;
 };
 
 }
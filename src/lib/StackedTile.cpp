@@ -231,7 +231,7 @@ StackedTile::StackedTile( TileId const &id, QImage const &resultImage, GeoDataDo
 {
     Q_ASSERT( !tiles.isEmpty() );
 
-    if ( d->m_resultImage.isNull() && d->m_resultVector->size() == 0 ) {
+    if ( d->m_resultImage.isNull() && !d->m_resultVector ) {
         qWarning() << "A tile has no image and no vector data. Please rerun the application.";
         return;
     }
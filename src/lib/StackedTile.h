@@ -91,7 +91,8 @@ class StackedTile
 
 /*!
     \brief Returns the GeoDataDocument that describes the merged stack of Tiles
-    \return A non-zero pointer to the resulting GeoDataDocument
+    \return A pointer to the resulting GeoDataDocument, which is empty while
+            the vector data is still being parsed, or 0 if there are no VectorTiles
 */
     GeoDataDocument *resultVectorData() const;
 
@@ -25,14 +25,13 @@
 #include <QtCore/QMetaType>
 #include <QtGui/QImage>
 
-#include "MarbleRunnerManager.h"
-
 #include "GeoSceneTiled.h"
 #include "GeoDataContainer.h"
 #include "HttpDownloadManager.h"
 #include "MarbleDebug.h"
 #include "MarbleDirs.h"
 #include "TileLoaderHelper.h"
+#include "VectorTileParsePool.h"
 
 Q_DECLARE_METATYPE( Marble::DownloadUsage )
 
@@ -40,9 +39,11 @@ namespace Marble
 {
 
 TileLoader::TileLoader(HttpDownloadManager * const downloadManager, const PluginManager *pluginManager) :
-      m_pluginManager( pluginManager )
+      m_vectorTileParsePool( new VectorTileParsePool( pluginManager, this ) )
 {
     qRegisterMetaType<DownloadUsage>( "DownloadUsage" );
+    connect( m_vectorTileParsePool, SIGNAL( tileParsed( TileId, GeoDataDocument*, QString ) ),
+             this, SIGNAL( tileCompleted( TileId, GeoDataDocument*, QString ) ) );
     connect( this, SIGNAL( downloadTile( QUrl, QString, QString, DownloadUsage )),
              downloadManager, SLOT( addJob( QUrl, QString, QString, DownloadUsage )));
     connect( downloadManager, SIGNAL( downloadComplete( QByteArray, QString )),
@@ -86,11 +87,8 @@ QImage TileLoader::loadTileImage( GeoSceneTiled const *textureLayer, TileId cons
 }
 
 
-GeoDataDocument *TileLoader::loadTileVectorData( GeoSceneTiled const *textureLayer, TileId const & tileId, DownloadUsage const usage, QString const &format )
+void TileLoader::loadTileVectorData( GeoSceneTiled const *textureLayer, TileId const & tileId, DownloadUsage const usage, QString const &format )
 {
-    // Format could be used in the future for use just that parser, instead of all available parsers
-    Q_UNUSED( format );
-
     QString const fileName = tileFileName( textureLayer, tileId );
 
     TileStatus status = tileStatus( textureLayer, tileId );
@@ -105,23 +103,15 @@ GeoDataDocument *TileLoader::loadTileVectorData( GeoSceneTiled const *textureLay
             triggerDownload( textureLayer, tileId, usage );
         }
 
-        QFile file ( fileName );
-        if ( file.exists() ) {
-
-            // File is ready, so parse and return the vector data in any case
-            MarbleRunnerManager* man = new MarbleRunnerManager( m_pluginManager );
-            GeoDataDocument* document = man->openFile( fileName );
-
-            if (document){
-                return document;
-            }
+        if ( QFile::exists( fileName ) ) {
+            // File is ready, so parse it without blocking
+            m_vectorTileParsePool->parseTile( tileId, fileName, format );
+            return;
         }
     }
 
     // tile was not locally available => trigger download
     triggerDownload( textureLayer, tileId, usage );
-
-    return new GeoDataDocument;
 }
 
 // This method triggers a download of the given tile (without checking
@@ -38,6 +38,7 @@ namespace Marble
 class HttpDownloadManager;
 class GeoSceneTiled;
 class GeoSceneTexture;
+class VectorTileParsePool;
 
 class TileLoader: public QObject
 {
@@ -53,7 +54,12 @@ class TileLoader: public QObject
     explicit TileLoader(HttpDownloadManager * const, const PluginManager * );
 
     QImage loadTileImage( GeoSceneTiled const *textureLayer, TileId const & tileId, DownloadUsage const );
-    GeoDataDocument* loadTileVectorData( GeoSceneTiled const *textureLayer, TileId const & tileId, DownloadUsage const usage, QString const &format );
+
+    /**
+     * Returns right away. If the tile file is available, it gets parsed in
+     * the background and the result is delivered through tileCompleted().
+     */
+    void loadTileVectorData( GeoSceneTiled const *textureLayer, TileId const & tileId, DownloadUsage const usage, QString const &format );
     void downloadTile( GeoSceneTiled const *textureLayer, TileId const &, DownloadUsage const );
 
     static int maximumTileLevel( GeoSceneTiled const & texture );
@@ -89,7 +95,7 @@ class TileLoader: public QObject
     QImage scaledLowerLevelTile( GeoSceneTiled const * textureLayer, TileId const & ) const;
 
     // For vectorTile parsing
-    const PluginManager * m_pluginManager;
+    VectorTileParsePool *const m_vectorTileParsePool;
 };
 
 }
@@ -105,6 +105,28 @@ VectorComposer::~VectorComposer()
     }
 }
 
+bool VectorComposer::isLoaded() const
+{
+    if ( !s_coastLinesLoaded && !s_overlaysLoaded ) {
+        return false;
+    }
+
+    if ( s_coastLinesLoaded
+         && !( s_coastLines->isInitialized() && s_islands->isInitialized()
+               && s_lakeislands->isInitialized() && s_lakes->isInitialized()
+               && s_glaciers->isInitialized() ) ) {
+        return false;
+    }
+
+    if ( s_overlaysLoaded
+         && !( s_rivers->isInitialized() && s_countries->isInitialized()
+               && s_usaStates->isInitialized() && s_dateLine->isInitialized() ) ) {
+        return false;
+    }
+
+    return true;
+}
+
 void VectorComposer::loadCoastlines()
 {
     if ( s_coastLinesLoaded ) {
@@ -26,6 +26,8 @@
 #include <QtGui/QBrush>
 #include <QtGui/QPen>
 
+#include "marble_export.h"
+
 class QColor;
 
 namespace Marble
@@ -37,13 +39,21 @@ class VectorMap;
 class ViewportParams;
 
 
-class VectorComposer : public QObject
+class MARBLE_EXPORT VectorComposer : public QObject
 {
     Q_OBJECT
  public:
     VectorComposer( QObject * parent = 0 );
     virtual ~VectorComposer();
 
+    /**
+     * @brief  Returns whether all datasets requested so far are loaded
+     *
+     * The datasets are shared by all instances and are requested by the
+     * first paint that needs them. Returns false before that.
+     */
+    bool isLoaded() const;
+
     void  drawTextureMap( GeoPainter *painter, const ViewportParams *viewport );
     void  paintBaseVectorMap( GeoPainter *, const ViewportParams * );
     void  paintVectorMap( GeoPainter *, const ViewportParams * );
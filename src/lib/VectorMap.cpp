@@ -45,20 +45,23 @@ VectorMap::~VectorMap()
 void VectorMap::createFromPntMap( const PntMap* pntmap, 
                                   const ViewportParams* viewport )
 {
+    // Only visit the polylines whose bounding box intersects the view.
+    pntmap->intersecting( viewport->viewLatLonAltBox(), m_visiblePolylines );
+
     switch( viewport->projection() ) {
         case Spherical:
-            sphericalCreateFromPntMap( pntmap, viewport );
+            sphericalCreateFromPntMap( m_visiblePolylines, viewport );
             break;
         case Equirectangular:
-            rectangularCreateFromPntMap( pntmap, viewport );
+            rectangularCreateFromPntMap( m_visiblePolylines, viewport );
             break;
         case Mercator:
-            mercatorCreateFromPntMap( pntmap, viewport );
+            mercatorCreateFromPntMap( m_visiblePolylines, viewport );
             break;
     }
 }
 
-void VectorMap::sphericalCreateFromPntMap( const PntMap* pntmap, 
+void VectorMap::sphericalCreateFromPntMap( const GeoPolygon::PtrVector &polylines,
                                            const ViewportParams* viewport )
 {
     m_polygons.clear();
@@ -86,8 +89,8 @@ void VectorMap::sphericalCreateFromPntMap( const PntMap* pntmap,
                      ? zlimit : m_zPointLimit;
 
     viewport->planetAxis().inverse().toMatrix( m_rotMatrix );
-    GeoPolygon::PtrVector::ConstIterator  itPolyLine = pntmap->constBegin();
-    GeoPolygon::PtrVector::ConstIterator  itEndPolyLine = pntmap->constEnd();
+    GeoPolygon::PtrVector::ConstIterator  itPolyLine = polylines.constBegin();
+    GeoPolygon::PtrVector::ConstIterator  itEndPolyLine = polylines.constEnd();
 
     //	const int detail = 0;
     const int  detail = getDetailLevel( viewport->radius() );
@@ -121,7 +124,7 @@ void VectorMap::sphericalCreateFromPntMap( const PntMap* pntmap,
     }
 }
 
-void VectorMap::rectangularCreateFromPntMap( const PntMap* pntmap, 
+void VectorMap::rectangularCreateFromPntMap( const GeoPolygon::PtrVector &polylines,
                                              const ViewportParams* viewport )
 {
     m_polygons.clear();
@@ -134,8 +137,8 @@ void VectorMap::rectangularCreateFromPntMap( const PntMap* pntmap,
     const qreal rad2Pixel = (float)( 2 * radius ) / M_PI;
 
     viewport->planetAxis().inverse().toMatrix( m_rotMatrix );
-    GeoPolygon::PtrVector::ConstIterator  itPolyLine = pntmap->constBegin();
-    GeoPolygon::PtrVector::ConstIterator  itEndPolyLine = pntmap->constEnd();
+    GeoPolygon::PtrVector::ConstIterator  itPolyLine = polylines.constBegin();
+    GeoPolygon::PtrVector::ConstIterator  itEndPolyLine = polylines.constEnd();
 
     const QRectF visibleArea ( 0, 0, viewport->width(), viewport->height() );
     const int      detail = getDetailLevel( radius );
@@ -224,7 +227,7 @@ void VectorMap::rectangularCreateFromPntMap( const PntMap* pntmap,
     }
 }
 
-void VectorMap::mercatorCreateFromPntMap( const PntMap* pntmap,
+void VectorMap::mercatorCreateFromPntMap( const GeoPolygon::PtrVector &polylines,
                                           const ViewportParams* viewport )
 {
     m_polygons.clear();
@@ -237,8 +240,8 @@ void VectorMap::mercatorCreateFromPntMap( const PntMap* pntmap,
     const qreal rad2Pixel = (float)( 2 * radius ) / M_PI;
 
     viewport->planetAxis().inverse().toMatrix( m_rotMatrix );
-    GeoPolygon::PtrVector::ConstIterator  itPolyLine = pntmap->constBegin();
-    GeoPolygon::PtrVector::ConstIterator  itEndPolyLine = pntmap->constEnd();
+    GeoPolygon::PtrVector::ConstIterator  itPolyLine = polylines.constBegin();
+    GeoPolygon::PtrVector::ConstIterator  itEndPolyLine = polylines.constEnd();
 
     const QRectF visibleArea ( 0, 0, viewport->width(), viewport->height() );
     const int      detail = getDetailLevel( radius );
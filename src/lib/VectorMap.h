@@ -19,6 +19,7 @@
 #include "MarbleGlobal.h"
 #include "Quaternion.h"
 #include "GeoDataCoordinates.h"
+#include "GeoPolygon.h"
 #include "ScreenPolygon.h"
 
 class QPaintDevice;
@@ -51,9 +52,9 @@ class VectorMap
     //	int nodeCount(){ return m_debugNodeCount; }
 
  private:
-    void sphericalCreateFromPntMap( const PntMap*, const ViewportParams *viewport );
-    void rectangularCreateFromPntMap( const PntMap*, const ViewportParams *viewport );
-    void mercatorCreateFromPntMap( const PntMap*, const ViewportParams *viewport );
+    void sphericalCreateFromPntMap( const GeoPolygon::PtrVector &polylines, const ViewportParams *viewport );
+    void rectangularCreateFromPntMap( const GeoPolygon::PtrVector &polylines, const ViewportParams *viewport );
+    void mercatorCreateFromPntMap( const GeoPolygon::PtrVector &polylines, const ViewportParams *viewport );
 
     void sphericalCreatePolyLine( GeoDataCoordinates::Vector::ConstIterator const &,
 				  GeoDataCoordinates::Vector::ConstIterator const &,
@@ -82,6 +83,9 @@ class VectorMap
     //	int m_debugNodeCount;
 
     ScreenPolygon     m_polygon;
+
+    // polylines of the current PntMap that intersect the viewport
+    GeoPolygon::PtrVector m_visiblePolylines;
 };
 
 }
@@ -12,16 +12,12 @@
 
 #include <cmath>
 
-#include <QtCore/QRunnable>
-
 #include "MarbleGlobal.h"
 #include "MarbleDebug.h"
 #include "GeoPainter.h"
 #include "GeoDataPolygon.h"
 #include "Quaternion.h"
 #include "ScanlineTextureMapperContext.h"
-#include "StackedTileLoader.h"
-#include "StackedTile.h"
 #include "TextureColorizer.h"
 
 #include "ViewportParams.h"
@@ -34,12 +30,10 @@ VectorTileMapper::~VectorTileMapper()
 {
 }
 
-VectorTileMapper::VectorTileMapper( StackedTileLoader *tileLoader )
+VectorTileMapper::VectorTileMapper()
     : TextureMapperInterface()
-    , m_tileLoader( tileLoader )
     , m_repaintNeeded( true )
     , m_radius( 0 )
-    , m_threadPool()
 {
     m_minTileX = 0;
     m_minTileY = 0;
@@ -52,6 +46,7 @@ void VectorTileMapper::mapTexture( GeoPainter *painter,
                                    const QRect &dirtyRect,
                                    TextureColorizer *texColorizer )
 {
+    Q_UNUSED( painter );
     Q_UNUSED( texColorizer );
 
     /** LOGIC FOR DOWNLOADING ALL THE TILES THAT ARE INSIDE THE SCREEN AT THE CURRENT ZOOM LEVEL **/
@@ -81,27 +76,12 @@ void VectorTileMapper::mapTexture( GeoPainter *painter,
     bool up    = minY < m_minTileY;
     bool down  = maxY > m_maxTileY ;
 
-    // Download tiles and send them to VectorTileLayer
-    // When changing zoom, download everything inside the screen
-    if ( left && right && up && down )
-
-                mapTexture( viewport, painter->mapQuality(), minX, minY, maxX, maxY );
-
-    // When only moving screen, just download the new tiles
-    else if ( left || right || up || down ){
-
-        if ( left )
-            mapTexture( viewport, painter->mapQuality(), minX, m_minTileY, m_minTileX, m_maxTileY );
-        if ( right )
-            mapTexture( viewport, painter->mapQuality(), m_maxTileX, m_minTileY, maxX, m_maxTileY );
-        if ( up )
-            mapTexture( viewport, painter->mapQuality(), m_minTileX, minY, m_maxTileX, m_minTileY );
-        if ( down )
-            mapTexture( viewport, painter->mapQuality(), m_minTileX, m_maxTileY, m_maxTileX, maxY );
-
-        // During testing discovered that this code above does not request the "corner" tiles
-
-    }
+    // Ask VectorTileLayer for the tiles
+    // Loading does not block on parsing any more, and tiles already on display
+    // are just looked up, so all tiles inside the screen are requested whenever
+    // new ones came into view. This also takes care of the "corner" tiles.
+    if ( left || right || up || down )
+        loadTiles( minX, minY, maxX, maxY );
 
     // Update tiles X and Y for screen coordinates
     m_minTileX = minX;
@@ -125,37 +105,14 @@ void VectorTileMapper::initTileRangeCoords(){
     m_maxTileY = 0;
 }
 
-void VectorTileMapper::mapTexture( const ViewportParams *viewport, MapQuality mapQuality,
-                                   unsigned int minTileX, unsigned int minTileY, unsigned int maxTileX, unsigned int maxTileY )
-{
-    Q_UNUSED( mapQuality);
-
-    // Reset backend
-    m_tileLoader->resetTilehash();
-
-    // Create render thread
-    RenderJob *const job = new RenderJob( m_tileLoader, tileZoomLevel(), viewport,
-                                          minTileX, minTileY, maxTileX, maxTileY);
-
-    // Connect the parser thread to the VectorTileMapper for recieving tiles
-    connect( job, SIGNAL( tileCompleted( TileId, GeoDataDocument*, QString ) ),
-             this, SLOT( updateTile( TileId, GeoDataDocument*, QString ) ) );
-
-    // Start thread
-    m_threadPool.start( job );
-
-    // Aparently there is not needed to wait for it to finish but
-    // waiting prevents having crashes with TileLoader's cache
-    // when cleaning tile hash (duplicated node errors and double free errors)
-    m_threadPool.waitForDone();
-
-    m_tileLoader->cleanupTilehash();
-}
-
-void VectorTileMapper::updateTile(TileId const & tileId, GeoDataDocument * document, QString const &format )
+void VectorTileMapper::loadTiles( unsigned int minTileX, unsigned int minTileY, unsigned int maxTileX, unsigned int maxTileY )
 {
-    // We recieved a vector tile, send it to the VectorTileLayer
-    emit tileCompleted( tileId, document, format );
+    // Tiles that are not parsed yet are delivered to the VectorTileLayer later on
+    for ( unsigned int x = minTileX; x <= maxTileX; ++x ) {
+        for ( unsigned int y = minTileY; y <= maxTileY; ++y ) {
+            emit tileNeeded( TileId( 0, tileZoomLevel(), x, y ) );
+        }
+    }
 }
 
 unsigned int VectorTileMapper::lon2tilex(double lon, int z)
@@ -168,33 +125,4 @@ unsigned int VectorTileMapper::lat2tiley(double lat, int z)
     return (unsigned int)(floor((1.0 - log( tan(lat * M_PI/180.0) + 1.0 / cos(lat * M_PI/180.0)) / M_PI) / 2.0 * pow(2.0, z)));
 }
 
-VectorTileMapper::RenderJob::RenderJob( StackedTileLoader *tileLoader, int tileLevel, const ViewportParams *viewport,
-                                        unsigned int minTileX, unsigned int minTileY, unsigned int maxTileX, unsigned int maxTileY )
-    : m_tileLoader( tileLoader ),
-      m_tileLevel( tileLevel ),
-      m_viewport( viewport ),
-      m_minTileX( minTileX ),
-      m_minTileY( minTileY ),
-      m_maxTileX( maxTileX ),
-      m_maxTileY( maxTileY )
-
-{
-}
-
-void VectorTileMapper::RenderJob::run()
-{
-    // Download all the tiles inside the given indexes
-    for (unsigned int x = m_minTileX; x <= m_maxTileX; x++)
-        for (unsigned int y = m_minTileY; y <= m_maxTileY; y++)
-        {
-           const TileId tileId = TileId( 0, m_tileLevel, x, y );
-           const StackedTile * tile = m_tileLoader->loadTile( tileId );
-
-           // When tile has vectorData send it to the VectorTileLayer for it to insert
-           // it in the treeModel
-           if ( tile->resultVectorData()->size() > 0 )
-                emit tileCompleted( tileId, tile->resultVectorData(), "JS" );
-        }
-}
-
 #include "VectorTileMapper.moc"
@@ -15,23 +15,19 @@
 
 #include "MarbleGlobal.h"
 #include "TileId.h"
-#include "GeoDataDocument.h"
 
-#include <QtCore/QThreadPool>
 #include <QtGui/QImage>
 
 
 namespace Marble
 {
 
-class StackedTileLoader;
-
 class VectorTileMapper : public QObject, public TextureMapperInterface
 {
     Q_OBJECT
 
 public:
-    explicit VectorTileMapper( StackedTileLoader *tileLoader );
+    VectorTileMapper();
     ~VectorTileMapper();
 
     virtual void mapTexture( GeoPainter *painter,
@@ -43,59 +39,29 @@ public:
 
     void initTileRangeCoords();
 
-public Q_SLOTS:
-    void updateTile(TileId const & tileId, GeoDataDocument *document, QString const & format );
-
 Q_SIGNALS:
-    void tileCompleted( TileId const & tileId, GeoDataDocument * document, QString const & format );
+    /**
+     * Emitted for every tile inside the screen whenever new tiles came
+     * into view. @p stackedTileId has no map theme.
+     */
+    void tileNeeded( TileId const & stackedTileId );
 
 private:
-    void mapTexture( const ViewportParams *viewport, MapQuality mapQuality, unsigned int minX, unsigned int minY, unsigned int maxX, unsigned int maxY );
+    void loadTiles( unsigned int minTileX, unsigned int minTileY, unsigned int maxTileX, unsigned int maxTileY );
 
     unsigned int lon2tilex(double lon, int z);
 
     unsigned int lat2tiley(double lat, int z);
 
 private:
-    class RenderJob;
-    StackedTileLoader *const m_tileLoader;
     bool m_repaintNeeded;
     int m_radius;
-    QThreadPool m_threadPool;
     unsigned int m_minTileX;
     unsigned int m_minTileY;
     unsigned int m_maxTileX;
     unsigned int m_maxTileY;
 };
 
-
-class VectorTileMapper::RenderJob : public QObject, public QRunnable
-{
-    Q_OBJECT
-
-public:
-
-    RenderJob(StackedTileLoader *tileLoader, int tileLevel, const ViewportParams *viewport,
-              unsigned int minTileX, unsigned int minTileY, unsigned int maxTileX, unsigned int maxTileY );
-
-    virtual void run();
-
-Q_SIGNALS:
-    void tileCompleted( TileId const & tileId, GeoDataDocument * document, QString const & format );
-
-private:
-    StackedTileLoader *const m_tileLoader;
-    const int m_tileLevel;
-    const ViewportParams *const m_viewport;
-
-    // Variables for storing current screen tiles
-    unsigned int m_minTileX;
-    unsigned int m_minTileY;
-    unsigned int m_maxTileX;
-    unsigned int m_maxTileY;
-};
-
-
 }
 
 #endif // MARBLE_VECTORTILEMAPPER_H
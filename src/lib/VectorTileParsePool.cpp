@@ -0,0 +1,177 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "VectorTileParsePool.h"
+
+#include <QtCore/QHash>
+#include <QtCore/QMetaObject>
+#include <QtCore/QThreadStorage>
+
+#include "GeoDataDocument.h"
+#include "MarbleAbstractRunner.h"
+#include "MarbleDebug.h"
+#include "ParseRunnerPlugin.h"
+#include "PluginManager.h"
+
+namespace Marble
+{
+
+namespace
+{
+
+/**
+ * The parse runners of one thread, created on first use.
+ */
+class ParseRunners
+{
+ public:
+    ~ParseRunners()
+    {
+        qDeleteAll( m_runners );
+    }
+
+    MarbleAbstractRunner *runner( const ParseRunnerPlugin *plugin )
+    {
+        MarbleAbstractRunner *&runner = m_runners[plugin];
+        if ( !runner ) {
+            runner = plugin->newRunner();
+        }
+
+        return runner;
+    }
+
+ private:
+    QHash<const ParseRunnerPlugin *, MarbleAbstractRunner *> m_runners;
+};
+
+}
+
+static QThreadStorage<ParseRunners *> s_parseRunners;
+
+VectorTileParsePool::VectorTileParsePool( const PluginManager *pluginManager, QObject *parent )
+    : QObject( parent ),
+      m_pluginManager( pluginManager ),
+      m_runnerSelection( 0 )
+{
+}
+
+VectorTileParsePool::~VectorTileParsePool()
+{
+    m_threadPool.waitForDone();
+    delete m_runnerSelection;
+
+    foreach ( const Result &result, m_results ) {
+        delete result.document;
+    }
+}
+
+void VectorTileParsePool::parseTile( const TileId &tileId, const QString &fileName, const QString &format )
+{
+    if ( m_pendingTiles.contains( tileId ) ) {
+        return;
+    }
+
+    if ( !m_runnerSelection ) {
+        m_runnerSelection = new ParseRunnerSelection( m_pluginManager->parsingRunnerPlugins() );
+    }
+
+    // The runners for the file are chosen by the job, in case it needs to
+    // read the file to recognize it
+    m_pendingTiles.insert( tileId );
+    m_threadPool.start( new ParseJob( this, *m_runnerSelection, tileId, fileName, format ) );
+}
+
+void VectorTileParsePool::addResult( const TileId &tileId, GeoDataDocument *document, const QString &format )
+{
+    Result result;
+    result.tileId = tileId;
+    result.document = document;
+    result.format = format;
+
+    QMutexLocker locker( &m_resultMutex );
+    m_results << result;
+
+    // One delivery for all results that finish before the event loop gets to it
+    if ( m_results.size() == 1 ) {
+        QMetaObject::invokeMethod( this, "deliverTiles", Qt::QueuedConnection );
+    }
+}
+
+void VectorTileParsePool::deliverTiles()
+{
+    m_resultMutex.lock();
+    const QList<Result> results = m_results;
+    m_results.clear();
+    m_resultMutex.unlock();
+
+    foreach ( const Result &result, results ) {
+        m_pendingTiles.remove( result.tileId );
+
+        if ( result.document ) {
+            emit tileParsed( result.tileId, result.document, result.format );
+        }
+    }
+}
+
+VectorTileParsePool::ParseJob::ParseJob( VectorTileParsePool *pool, const ParseRunnerSelection &runnerSelection,
+                                         const TileId &tileId, const QString &fileName, const QString &format )
+    : m_pool( pool ),
+      m_runnerSelection( runnerSelection ),
+      m_tileId( tileId ),
+      m_fileName( fileName ),
+      m_format( format ),
+      m_document( 0 )
+{
+}
+
+void VectorTileParsePool::ParseJob::run()
+{
+    if ( !s_parseRunners.hasLocalData() ) {
+        s_parseRunners.setLocalData( new ParseRunners );
+    }
+
+    ParseRunners *const runners = s_parseRunners.localData();
+
+    // Same choice of parsers as in MarbleRunnerManager::parseFile()
+    const QList<const ParseRunnerPlugin *> plugins = m_runnerSelection.plugins( m_fileName );
+    if ( plugins.isEmpty() ) {
+        mDebug() << Q_FUNC_INFO << "no parser for" << m_fileName;
+    }
+
+    // Parse runners report synchronously, so the first parser that succeeds wins
+    foreach ( const ParseRunnerPlugin *plugin, plugins ) {
+        MarbleAbstractRunner *const runner = runners->runner( plugin );
+        connect( runner, SIGNAL( parsingFinished( GeoDataDocument*, QString ) ),
+                 this, SLOT( setDocument( GeoDataDocument*, QString ) ), Qt::DirectConnection );
+        runner->parseFile( m_fileName, UserDocument );
+        disconnect( runner, 0, this, 0 );
+
+        if ( m_document ) {
+            break;
+        }
+    }
+
+    m_pool->addResult( m_tileId, m_document, m_format );
+}
+
+void VectorTileParsePool::ParseJob::setDocument( GeoDataDocument *document, const QString &error )
+{
+    if ( !error.isEmpty() ) {
+        mDebug() << Q_FUNC_INFO << m_fileName << error;
+    }
+
+    if ( document && !m_document ) {
+        m_document = document;
+    } else {
+        delete document;
+    }
+}
+
+}
+
+#include "VectorTileParsePool.moc"
@@ -0,0 +1,116 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_VECTORTILEPARSEPOOL_H
+#define MARBLE_VECTORTILEPARSEPOOL_H
+
+#include <QtCore/QList>
+#include <QtCore/QMutex>
+#include <QtCore/QObject>
+#include <QtCore/QRunnable>
+#include <QtCore/QSet>
+#include <QtCore/QString>
+#include <QtCore/QThreadPool>
+
+#include "ParseRunnerSelection.h"
+#include "TileId.h"
+
+namespace Marble
+{
+
+class GeoDataDocument;
+class ParseRunnerPlugin;
+class PluginManager;
+
+/**
+ * @short Parses vector tile files in the background.
+ *
+ * Several tiles are parsed at the same time, each in a thread of its own.
+ * The parse runners are created once per thread and reused for all tiles
+ * parsed in that thread. Results are delivered in the thread of the pool
+ * through tileParsed(), the receiver takes ownership of the document.
+ */
+class VectorTileParsePool : public QObject
+{
+    Q_OBJECT
+
+ public:
+    explicit VectorTileParsePool( const PluginManager *pluginManager, QObject *parent = 0 );
+
+    /**
+     * Waits for running jobs and deletes the documents not delivered yet.
+     */
+    ~VectorTileParsePool();
+
+    /**
+     * Starts parsing @p fileName unless @p tileId is being parsed already.
+     * @p format is passed back in tileParsed().
+     */
+    void parseTile( const TileId &tileId, const QString &fileName, const QString &format );
+
+ Q_SIGNALS:
+    /**
+     * Emitted for each tile that was parsed successfully.
+     */
+    void tileParsed( TileId const &tileId, GeoDataDocument *document, QString const &format );
+
+ private Q_SLOTS:
+    void deliverTiles();
+
+ private:
+    class ParseJob;
+
+    struct Result
+    {
+        TileId tileId;
+        GeoDataDocument *document;
+        QString format;
+    };
+
+    /**
+     * Called by the jobs from their thread, @p document may be 0.
+     */
+    void addResult( const TileId &tileId, GeoDataDocument *document, const QString &format );
+
+    const PluginManager *const m_pluginManager;
+
+    // Built on the first parseTile(), as the plugin manager is not thread safe
+    ParseRunnerSelection *m_runnerSelection;
+
+    QThreadPool m_threadPool;
+    QSet<TileId> m_pendingTiles;
+
+    QMutex m_resultMutex;
+    QList<Result> m_results;
+};
+
+class VectorTileParsePool::ParseJob : public QObject, public QRunnable
+{
+    Q_OBJECT
+
+ public:
+    ParseJob( VectorTileParsePool *pool, const ParseRunnerSelection &runnerSelection,
+              const TileId &tileId, const QString &fileName, const QString &format );
+
+    virtual void run();
+
+ private Q_SLOTS:
+    void setDocument( GeoDataDocument *document, const QString &error );
+
+ private:
+    VectorTileParsePool *const m_pool;
+    const ParseRunnerSelection m_runnerSelection;
+    const TileId m_tileId;
+    const QString m_fileName;
+    const QString m_format;
+    GeoDataDocument *m_document;
+};
+
+}
+
+#endif
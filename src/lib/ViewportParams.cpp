@@ -46,6 +46,7 @@ public:
     mutable matrix       m_planetAxisMatrix;
     int                  m_radius;       // Zoom level (pixels / globe radius)
     qreal                m_angularResolution;
+    qreal                m_tessellationTolerance;
 
     QSize                m_size;         // width, height
 
@@ -71,6 +72,7 @@ ViewportParamsPrivate::ViewportParamsPrivate()
       m_planetAxisMatrix(),
       m_radius( 2000 ),
       m_angularResolution( 0.25 * M_PI / fabs( (qreal)( m_radius ) ) ),
+      m_tessellationTolerance( 0.5 ),
       m_size( 100, 100 ),
       m_dirtyBox( true ),
       m_viewLatLonAltBox(),
@@ -351,6 +353,18 @@ bool ViewportParams::resolves ( const GeoDataCoordinates &coord1,
     return ( fabs( lon2 - lon1 ) + fabs( lat2 - lat1 ) < angularResolution() );
 }
 
+qreal ViewportParams::tessellationTolerance() const
+{
+    return d->m_tessellationTolerance;
+}
+
+void ViewportParams::setTessellationTolerance( qreal tolerance )
+{
+    if ( tolerance > 0.0 ) {
+        d->m_tessellationTolerance = tolerance;
+    }
+}
+
 
 bool ViewportParams::screenCoordinates( const qreal lon, const qreal lat,
                         qreal &x, qreal &y ) const
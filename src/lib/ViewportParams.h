@@ -83,6 +83,15 @@ class MARBLE_EXPORT ViewportParams
     
     bool resolves ( const GeoDataCoordinates &coord1, const GeoDataCoordinates &coord2 ) const;
 
+    /**
+     * @brief Maximum distance in pixels a tessellated line may deviate from its exact projection.
+     *
+     * Great circles and latitude circles get subdivided until their straight
+     * screen pieces are closer than this to the projected curve.
+     */
+    qreal tessellationTolerance() const;
+    void setTessellationTolerance( qreal tolerance );
+
     int  radius() const;
 
     /**
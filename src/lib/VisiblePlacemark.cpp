@@ -15,6 +15,7 @@
 
 #include "GeoDataStyle.h"
 #include "PlacemarkLayer.h"
+#include "PlacemarkPixmapCache.h"
 
 #include <QtGui/QApplication>
 #include <QtGui/QPainter>
@@ -25,7 +26,9 @@ using namespace Marble;
 
 VisiblePlacemark::VisiblePlacemark( const GeoDataPlacemark *placemark )
     : m_placemark( placemark ),
-      m_selected( false )
+      m_selected( false ),
+      m_symbolStyle( 0 ),
+      m_symbolGeneration( -1 )
 {
     drawLabelPixmap();
 }
@@ -36,14 +39,29 @@ const GeoDataPlacemark* VisiblePlacemark::placemark() const
 }
 
 const QPixmap& VisiblePlacemark::symbolPixmap() const
-{    
+{
+    return PlacemarkPixmapCache::instance()->atlas();
+}
+
+QRect VisiblePlacemark::symbolRect() const
+{
     const GeoDataStyle* style = m_placemark->style();
-    if ( style ) {
-        m_symbolPixmap = QPixmap::fromImage( style->iconStyle().icon() );
-    } else {
+    if ( !style ) {
         mDebug() << "Style pointer null";
+        return QRect();
+    }
+
+    PlacemarkPixmapCache *const cache = PlacemarkPixmapCache::instance();
+    if ( style == m_symbolStyle && m_symbolGeneration == cache->generation() ) {
+        return m_symbolRect;
     }
-    return  m_symbolPixmap;
+
+    m_symbolRect = cache->iconRect( style->iconStyle().icon() );
+    m_symbolStyle = style;
+    // Inserting the icon may have cleared the atlas.
+    m_symbolGeneration = cache->generation();
+
+    return m_symbolRect;
 }
 
 bool VisiblePlacemark::selected() const
@@ -102,6 +120,18 @@ void VisiblePlacemark::drawLabelPixmap()
         labelStyle = Glow;
     }
 
+    PlacemarkPixmapCache::LabelKey key;
+    key.text = labelName;
+    key.font = labelFont.key();
+    key.color = labelColor.rgba();
+    key.glow = style->labelStyle().glow();
+    key.selected = m_selected;
+
+    m_labelPixmap = PlacemarkPixmapCache::instance()->label( key );
+    if ( !m_labelPixmap.isNull() ) {
+        return;
+    }
+
     int textHeight = QFontMetrics( labelFont ).height();
 
     int textWidth;
@@ -136,6 +166,8 @@ void VisiblePlacemark::drawLabelPixmap()
 
         m_labelPixmap = QPixmap::fromImage( image );
     }
+
+    PlacemarkPixmapCache::instance()->insertLabel( key, m_labelPixmap );
 }
 
 void VisiblePlacemark::drawLabelText(QPainter &labelPainter, const QString &text,
@@ -47,10 +47,19 @@ class VisiblePlacemark
     const GeoDataPlacemark* placemark() const;
 
     /**
-     * Returns the pixmap of the place mark symbol.
+     * Returns the pixmap that holds the place mark symbol.
+     *
+     * Symbols are shared between all place marks in one atlas pixmap,
+     * only the area symbolRect() of it belongs to this place mark.
      */
     const QPixmap& symbolPixmap() const;
 
+    /**
+     * Returns the area of symbolPixmap() covered by the place mark symbol.
+     * The rect is empty if the place mark has no symbol.
+     */
+    QRect symbolRect() const;
+
     /**
      * Returns the state of the place mark.
      */
@@ -104,7 +113,11 @@ class VisiblePlacemark
     QPixmap     m_labelPixmap;    // the text label (most often name)
     QRectF      m_labelRect;      // bounding box of label
 
-    mutable QPixmap     m_symbolPixmap; // cached value
+    // Area of the symbol in the icon atlas, for the style and the atlas
+    // generation it was looked up for
+    mutable QRect               m_symbolRect;
+    mutable const GeoDataStyle *m_symbolStyle;
+    mutable int                 m_symbolGeneration;
 };
 
 }
@@ -19,6 +19,7 @@
 
 // Marble
 #include "MarbleDebug.h"
+#include "GeoDataDocument.h"
 #include "GeoDataFeature.h"
 #include "GeoDataFolder.h"
 #include "GeoDataPlacemark.h"
@@ -163,6 +164,12 @@ void GeoDataContainer::append( GeoDataFeature *other )
 }
 
 
+void GeoDataContainer::reserve( int size )
+{
+    detach();
+    p()->m_vector.reserve( size );
+}
+
 void GeoDataContainer::remove( int index )
 {
     detach();
@@ -238,13 +245,21 @@ void GeoDataContainer::pack( QDataStream& stream ) const
 {
     GeoDataFeature::pack( stream );
 
-    stream << p()->m_vector.count();
-
+    // Only the features unpack() can create are stored
+    QVector<const GeoDataFeature*> features;
     for ( QVector <GeoDataFeature*>::const_iterator iterator = p()->m_vector.constBegin();
           iterator != p()->m_vector.constEnd();
           ++iterator )
     {
-        const GeoDataFeature *feature = *iterator;
+        const EnumFeatureId featureId = (*iterator)->featureId();
+        if ( featureId == GeoDataDocumentId || featureId == GeoDataFolderId || featureId == GeoDataPlacemarkId ) {
+            features.append( *iterator );
+        }
+    }
+
+    stream << features.count();
+
+    foreach ( const GeoDataFeature *feature, features ) {
         stream << feature->featureId();
         feature->pack( stream );
     }
@@ -263,11 +278,18 @@ void GeoDataContainer::unpack( QDataStream& stream )
         stream >> featureId;
         switch( featureId ) {
             case GeoDataDocumentId:
-                /* not usable!!!! */ break;
+                {
+                GeoDataDocument *document = new GeoDataDocument;
+                document->unpack( stream );
+                document->setParent( this );
+                p()->m_vector.append( document );
+                }
+                break;
             case GeoDataFolderId:
                 {
                 GeoDataFolder *folder = new GeoDataFolder;
                 folder->unpack( stream );
+                folder->setParent( this );
                 p()->m_vector.append( folder );
                 }
                 break;
@@ -275,6 +297,7 @@ void GeoDataContainer::unpack( QDataStream& stream )
                 {
                 GeoDataPlacemark *placemark = new GeoDataPlacemark;
                 placemark->unpack( stream );
+                placemark->setParent( this );
                 p()->m_vector.append( placemark );
                 }
                 break;
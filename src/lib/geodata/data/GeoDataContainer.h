@@ -108,6 +108,11 @@ class GEODATA_EXPORT GeoDataContainer : public GeoDataFeature
     */
     void append( GeoDataFeature *other );
 
+    /**
+    * @brief reserve space for @p size features to avoid reallocations when appending them
+    */
+    void reserve( int size );
+
     void remove( int index );
 
     /**
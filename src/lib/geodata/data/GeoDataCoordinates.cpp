@@ -14,7 +14,6 @@
 
 
 #include "GeoDataCoordinates.h"
-#include "GeoDataCoordinates_p.h"
 
 #include <QtCore/qmath.h>
 #include <QtCore/QRegExp>
@@ -22,7 +21,6 @@
 #include <QtCore/QString>
 #include <QtCore/QStringList>
 #include <QtCore/QCoreApplication>
-#include <QtCore/QAtomicInt>
 
 #include "MarbleGlobal.h"
 #include "MarbleDebug.h"
@@ -582,40 +580,52 @@ bool LonLatParser::isCorrectDirections(const QString& dir1, const QString& dir2,
 
 GeoDataCoordinates::Notation GeoDataCoordinates::s_notation = GeoDataCoordinates::DMS;
 
-const GeoDataCoordinates GeoDataCoordinates::null = GeoDataCoordinates( 0, 0, 0 ); // don't use default constructor!
-
 GeoDataCoordinates::GeoDataCoordinates( qreal _lon, qreal _lat, qreal _alt, GeoDataCoordinates::Unit unit, int _detail )
-  : d( new GeoDataCoordinatesPrivate( _lon, _lat, _alt, unit, _detail ) )
+  : m_altitude( _alt ),
+    m_detail( _detail ),
+    m_valid( true )
 {
-    d->ref.ref();
+    switch( unit ){
+    default:
+    case Radian:
+        m_q = Quaternion::fromSpherical( _lon, _lat );
+        m_lon = _lon;
+        m_lat = _lat;
+        break;
+    case Degree:
+        m_q = Quaternion::fromSpherical( _lon * DEG2RAD , _lat * DEG2RAD  );
+        m_lon = _lon * DEG2RAD;
+        m_lat = _lat * DEG2RAD;
+        break;
+    }
 }
 
-/* simply copy the d pointer
-* it will be replaced in the detach function instead
-*/
 GeoDataCoordinates::GeoDataCoordinates( const GeoDataCoordinates& other )
-  : d( other.d )
+  : m_q( other.m_q ),
+    m_lon( other.m_lon ),
+    m_lat( other.m_lat ),
+    m_altitude( other.m_altitude ),
+    m_detail( other.m_detail ),
+    m_valid( other.m_valid )
 {
-    d->ref.ref();
 }
 
-/* simply copy null's d pointer
- * it will be replaced in the detach function
+/*
+ * an invalid instance still carries the coordinates 0, 0, 0 so that
+ * it compares equal to GeoDataCoordinates( 0, 0, 0 )
  */
 GeoDataCoordinates::GeoDataCoordinates()
-  : d( null.d )
+  : m_q( Quaternion::fromSpherical( 0, 0 ) ),
+    m_lon( 0 ),
+    m_lat( 0 ),
+    m_altitude( 0 ),
+    m_detail( 0 ),
+    m_valid( false )
 {
-    d->ref.ref();
 }
 
-/*
- * only delete the private d pointer if the number of references is 0
- * remember that all copies share the same d pointer!
- */
 GeoDataCoordinates::~GeoDataCoordinates()
 {
-    if (!d->ref.deref())
-        delete d;
 #ifdef DEBUG_GEODATA
 //    mDebug() << "delete coordinates";
 #endif
@@ -623,86 +633,60 @@ GeoDataCoordinates::~GeoDataCoordinates()
 
 bool GeoDataCoordinates::isValid() const
 {
-    return d != null.d;
+    return m_valid;
 }
 
-/*
- * if only one copy exists, return
- * else make a new private d pointer object and assign the values of the current
- * one to it
- * at the end, if the number of references thus reaches 0 delete it
- * this state shouldn't happen, but if it does, we have to clean up behind us.
- */
 void GeoDataCoordinates::detach()
 {
-    if(d->ref == 1)
-        return;
-
-    GeoDataCoordinatesPrivate *new_d = new GeoDataCoordinatesPrivate( *d );
-
-    if (!d->ref.deref())
-        delete d;
-
-    d = new_d;
-    d->ref.ref();
 }
 
-/*
- * call detach() at the start of all non-static, non-const functions
- */
 void GeoDataCoordinates::set( qreal _lon, qreal _lat, qreal _alt, GeoDataCoordinates::Unit unit )
 {
-    detach();
-    d->m_altitude = _alt;
+    m_valid = true;
+    m_altitude = _alt;
     switch( unit ){
     default:
     case Radian:
-        d->m_q = Quaternion::fromSpherical( _lon, _lat );
-        d->m_lon = _lon;
-        d->m_lat = _lat;
+        m_q = Quaternion::fromSpherical( _lon, _lat );
+        m_lon = _lon;
+        m_lat = _lat;
         break;
     case Degree:
-        d->m_q = Quaternion::fromSpherical( _lon * DEG2RAD , _lat * DEG2RAD  );
-        d->m_lon = _lon * DEG2RAD;
-        d->m_lat = _lat * DEG2RAD;
+        m_q = Quaternion::fromSpherical( _lon * DEG2RAD , _lat * DEG2RAD  );
+        m_lon = _lon * DEG2RAD;
+        m_lat = _lat * DEG2RAD;
         break;
     }
 }
 
-/*
- * call detach() at the start of all non-static, non-const functions
- */
 void GeoDataCoordinates::setLongitude( qreal _lon, GeoDataCoordinates::Unit unit )
 {
-    detach();
+    m_valid = true;
     switch( unit ){
     default:
     case Radian:
-        d->m_q = Quaternion::fromSpherical( _lon, d->m_lat );
-        d->m_lon = _lon;
+        m_q = Quaternion::fromSpherical( _lon, m_lat );
+        m_lon = _lon;
         break;
     case Degree:
-        d->m_q = Quaternion::fromSpherical( _lon * DEG2RAD , d->m_lat  );
-        d->m_lon = _lon * DEG2RAD;
+        m_q = Quaternion::fromSpherical( _lon * DEG2RAD , m_lat  );
+        m_lon = _lon * DEG2RAD;
         break;
     }
 }
 
 
-/*
- * call detach() at the start of all non-static, non-const functions
- */
 void GeoDataCoordinates::setLatitude( qreal _lat, GeoDataCoordinates::Unit unit )
 {
-    detach();
+    m_valid = true;
     switch( unit ){
     case Radian:
-        d->m_q = Quaternion::fromSpherical( d->m_lon, _lat );
-        d->m_lat = _lat;
+        m_q = Quaternion::fromSpherical( m_lon, _lat );
+        m_lat = _lat;
         break;
     case Degree:
-        d->m_q = Quaternion::fromSpherical( d->m_lon, _lat * DEG2RAD   );
-        d->m_lat = _lat * DEG2RAD;
+        m_q = Quaternion::fromSpherical( m_lon, _lat * DEG2RAD   );
+        m_lat = _lat * DEG2RAD;
         break;
     }
 }
@@ -715,12 +699,12 @@ void GeoDataCoordinates::geoCoordinates( qreal& lon, qreal& lat,
     {
     default:
     case Radian:
-            lon = d->m_lon;
-            lat = d->m_lat;
+            lon = m_lon;
+            lat = m_lat;
         break;
     case Degree:
-            lon = d->m_lon * RAD2DEG;
-            lat = d->m_lat * RAD2DEG;
+            lon = m_lon * RAD2DEG;
+            lat = m_lat * RAD2DEG;
         break;
     }
 }
@@ -729,7 +713,7 @@ void GeoDataCoordinates::geoCoordinates( qreal& lon, qreal& lat, qreal& alt,
                                          GeoDataCoordinates::Unit unit ) const
 {
     geoCoordinates( lon, lat, unit );
-    alt = d->m_altitude;
+    alt = m_altitude;
 }
 
 qreal GeoDataCoordinates::longitude( GeoDataCoordinates::Unit unit ) const
@@ -738,9 +722,9 @@ qreal GeoDataCoordinates::longitude( GeoDataCoordinates::Unit unit ) const
     {
     default:
     case Radian:
-        return d->m_lon;
+        return m_lon;
     case Degree:
-        return d->m_lon * RAD2DEG;
+        return m_lon * RAD2DEG;
     }
 }
 
@@ -750,9 +734,9 @@ qreal GeoDataCoordinates::latitude( GeoDataCoordinates::Unit unit ) const
     {
     default:
     case Radian:
-        return d->m_lat;
+        return m_lat;
     case Degree:
-        return d->m_lat * RAD2DEG;
+        return m_lat * RAD2DEG;
     }
 }
 
@@ -921,9 +905,9 @@ QString GeoDataCoordinates::toString() const
 
 QString GeoDataCoordinates::toString( GeoDataCoordinates::Notation notation, int precision ) const
 {
-        return  lonToString( d->m_lon, notation, Radian, precision )
+        return  lonToString( m_lon, notation, Radian, precision )
                 + QString(", ")
-                + latToString( d->m_lat, notation, Radian, precision );
+                + latToString( m_lat, notation, Radian, precision );
 }
 
 QString GeoDataCoordinates::lonToString( qreal lon, GeoDataCoordinates::Notation notation,  
@@ -1010,7 +994,7 @@ QString GeoDataCoordinates::lonToString( qreal lon, GeoDataCoordinates::Notation
 
 QString GeoDataCoordinates::lonToString() const
 {
-    return GeoDataCoordinates::lonToString( d->m_lon , s_notation );
+    return GeoDataCoordinates::lonToString( m_lon , s_notation );
 }
 
 QString GeoDataCoordinates::latToString( qreal lat, GeoDataCoordinates::Notation notation,
@@ -1098,39 +1082,41 @@ QString GeoDataCoordinates::latToString( qreal lat, GeoDataCoordinates::Notation
 
 QString GeoDataCoordinates::latToString() const
 {
-    return GeoDataCoordinates::latToString( d->m_lat, s_notation );
+    return GeoDataCoordinates::latToString( m_lat, s_notation );
 }
 
 bool GeoDataCoordinates::operator==( const GeoDataCoordinates &rhs ) const
 {
-    return *d == *rhs.d;
+    // do not compare the m_detail member as it does not really belong to
+    // GeoDataCoordinates and should be removed
+    return m_lon == rhs.m_lon && m_lat == rhs.m_lat && m_altitude == rhs.m_altitude;
 }
 
 bool GeoDataCoordinates::operator!=( const GeoDataCoordinates &rhs ) const
 {
-    return *d != *rhs.d;
+    return ! ( *this == rhs );
 }
 
 void GeoDataCoordinates::setAltitude( const qreal altitude )
 {
-    detach();
-    d->m_altitude = altitude;
+    m_valid = true;
+    m_altitude = altitude;
 }
 
 qreal GeoDataCoordinates::altitude() const
 {
-    return d->m_altitude;
+    return m_altitude;
 }
 
 int GeoDataCoordinates::detail() const
 {
-    return d->m_detail;
+    return m_detail;
 }
 
 void GeoDataCoordinates::setDetail( const int det )
 {
-    detach();
-    d->m_detail = det;
+    m_valid = true;
+    m_detail = det;
 }
 
 qreal GeoDataCoordinates::bearing( const GeoDataCoordinates &other, Unit unit, BearingType type ) const
@@ -1140,15 +1126,15 @@ qreal GeoDataCoordinates::bearing( const GeoDataCoordinates &other, Unit unit, B
         return offset + other.bearing( *this, unit, InitialBearing );
     }
 
-    qreal const delta = other.d->m_lon - d->m_lon;
-    double const bearing = atan2( sin ( delta ) * cos ( other.d->m_lat ),
-                 cos( d->m_lat ) * sin( other.d->m_lat ) - sin( d->m_lat ) * cos( other.d->m_lat ) * cos ( delta ) );
+    qreal const delta = other.m_lon - m_lon;
+    double const bearing = atan2( sin ( delta ) * cos ( other.m_lat ),
+                 cos( m_lat ) * sin( other.m_lat ) - sin( m_lat ) * cos( other.m_lat ) * cos ( delta ) );
     return unit == Radian ? bearing : bearing * RAD2DEG;
 }
 
 const Quaternion& GeoDataCoordinates::quaternion() const
 {
-    return d->m_q;
+    return m_q;
 }
 
 bool GeoDataCoordinates::isPole( Pole pole ) const
@@ -1156,20 +1142,20 @@ bool GeoDataCoordinates::isPole( Pole pole ) const
     // Evaluate the most likely case first:
     // The case where we haven't hit the pole and where our latitude is normalized
     // to the range of 90 deg S ... 90 deg N
-    if ( fabs( (qreal) 2.0 * d->m_lat ) < M_PI ) {
+    if ( fabs( (qreal) 2.0 * m_lat ) < M_PI ) {
         return false;
     }
     else {
-        if ( fabs( (qreal) 2.0 * d->m_lat ) == M_PI ) {
+        if ( fabs( (qreal) 2.0 * m_lat ) == M_PI ) {
             // Ok, we have hit a pole. Now let's check whether it's the one we've asked for:
             if ( pole == AnyPole ){
                 return true;
             }
             else {
-                if ( pole == NorthPole && 2.0 * d->m_lat == +M_PI ) {
+                if ( pole == NorthPole && 2.0 * m_lat == +M_PI ) {
                     return true;
                 }
-                if ( pole == SouthPole && 2.0 * d->m_lat == -M_PI ) {
+                if ( pole == SouthPole && 2.0 * m_lat == -M_PI ) {
                     return true;
                 }
                 return false;
@@ -1185,7 +1171,7 @@ bool GeoDataCoordinates::isPole( Pole pole ) const
             // Only as a last resort we cover the unlikely case where
             // the latitude is not normalized to the range of 
             // 90 deg S ... 90 deg N
-            if ( fabs( (qreal) 2.0 * normalizeLat( d->m_lat ) ) < M_PI  ) {
+            if ( fabs( (qreal) 2.0 * normalizeLat( m_lat ) ) < M_PI  ) {
                 return false;
             }
             else {
@@ -1194,10 +1180,10 @@ bool GeoDataCoordinates::isPole( Pole pole ) const
                     return true;
                 }
                 else {
-                    if ( pole == NorthPole && 2.0 * d->m_lat == +M_PI ) {
+                    if ( pole == NorthPole && 2.0 * m_lat == +M_PI ) {
                         return true;
                     }
-                    if ( pole == SouthPole && 2.0 * d->m_lat == -M_PI ) {
+                    if ( pole == SouthPole && 2.0 * m_lat == -M_PI ) {
                         return true;
                     }
                     return false;
@@ -1209,26 +1195,30 @@ bool GeoDataCoordinates::isPole( Pole pole ) const
 
 GeoDataCoordinates& GeoDataCoordinates::operator=( const GeoDataCoordinates &other )
 {
-    qAtomicAssign(d, other.d);
+    m_q = other.m_q;
+    m_lon = other.m_lon;
+    m_lat = other.m_lat;
+    m_altitude = other.m_altitude;
+    m_detail = other.m_detail;
+    m_valid = other.m_valid;
     return *this;
 }
 
 void GeoDataCoordinates::pack( QDataStream& stream ) const
 {
-    stream << d->m_lon;
-    stream << d->m_lat;
-    stream << d->m_altitude;
+    stream << m_lon;
+    stream << m_lat;
+    stream << m_altitude;
 }
 
 void GeoDataCoordinates::unpack( QDataStream& stream )
 {
-    // call detach even though it shouldn't be needed - one never knows
-    detach();
-    stream >> d->m_lon;
-    stream >> d->m_lat;
-    stream >> d->m_altitude;
+    m_valid = true;
+    stream >> m_lon;
+    stream >> m_lat;
+    stream >> m_altitude;
 
-    d->m_q = Quaternion::fromSpherical( d->m_lon, d->m_lat );
+    m_q = Quaternion::fromSpherical( m_lon, m_lat );
 }
 
 }
@@ -28,15 +28,13 @@
 
 #include "geodata_export.h"
 #include "MarbleGlobal.h"
+#include "Quaternion.h"
 
 namespace Marble
 {
 
 const qreal TWOPI = 2 * M_PI;
 
-class GeoDataCoordinatesPrivate;
-class Quaternion;
-
 /**
  * @short A 3d point representation
  *
@@ -46,6 +44,10 @@ class Quaternion;
  * This class was introduced to reflect the difference between a simple 3d point
  * and the GeoDataGeometry object containing such a point. The latter is a 
  * GeoDataPoint and is simply derived from GeoDataCoordinates.
+ *
+ * GeoDataCoordinates is a plain value type: the coordinates are stored
+ * inline, so creating, copying and destroying temporaries does not touch
+ * the heap.
  * @see GeoDataPoint
 */
 
@@ -348,17 +350,28 @@ class GEODATA_EXPORT GeoDataCoordinates
     /** Unserialize the contents of the feature from @p stream. */
     virtual void unpack( QDataStream& stream );
 
+    /**
+     * @brief kept for source compatibility
+     *
+     * The coordinates are stored by value, so there is nothing to detach.
+     */
     virtual void detach();
+
  protected:
-    GeoDataCoordinatesPrivate* d;
+    Quaternion m_q;
+    qreal      m_lon;
+    qreal      m_lat;
+    qreal      m_altitude;     // in meters above sea level
+    int        m_detail;
+    bool       m_valid;
 
  private:
     static GeoDataCoordinates::Notation s_notation;
-    static const GeoDataCoordinates null;
 };
 
 }
 
+Q_DECLARE_TYPEINFO( Marble::GeoDataCoordinates, Q_MOVABLE_TYPE );
 Q_DECLARE_METATYPE( Marble::GeoDataCoordinates )
 
 #endif
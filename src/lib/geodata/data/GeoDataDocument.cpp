@@ -135,6 +135,14 @@ void GeoDataDocument::pack( QDataStream& stream ) const
         ++iterator ) {
         iterator.value().pack( stream );
     }
+
+    stream << p()->m_styleMapHash.size();
+    for( QMap<QString, GeoDataStyleMap>::const_iterator iterator
+          = p()->m_styleMapHash.constBegin();
+        iterator != p()->m_styleMapHash.constEnd();
+        ++iterator ) {
+        iterator.value().pack( stream );
+    }
 }
 
 
@@ -151,6 +159,13 @@ void GeoDataDocument::unpack( QDataStream& stream )
         style.unpack( stream );
         p()->m_styleHash.insert( style.styleId(), style );
     }
+
+    stream >> size;
+    for( int i = 0; i < size; i++ ) {
+        GeoDataStyleMap styleMap;
+        styleMap.unpack( stream );
+        p()->m_styleMapHash.insert( styleMap.styleId(), styleMap );
+    }
 }
 
 }
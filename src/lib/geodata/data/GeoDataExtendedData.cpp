@@ -100,11 +100,45 @@ GeoDataSimpleArrayData* GeoDataExtendedData::simpleArrayData( const QString& key
 void GeoDataExtendedData::pack( QDataStream& stream ) const
 {
     GeoDataObject::pack( stream );
+
+    stream << d->hash.size();
+    QHash< QString, GeoDataData >::const_iterator data = d->hash.constBegin();
+    for (; data != d->hash.constEnd(); ++data ) {
+        stream << data.key();
+        data.value().pack( stream );
+    }
+
+    stream << d->arrayHash.size();
+    QHash< QString, GeoDataSimpleArrayData* >::const_iterator array = d->arrayHash.constBegin();
+    for (; array != d->arrayHash.constEnd(); ++array ) {
+        stream << array.key();
+        array.value()->pack( stream );
+    }
 }
 
 void GeoDataExtendedData::unpack( QDataStream& stream )
 {
     GeoDataObject::unpack( stream );
+
+    int size = 0;
+    stream >> size;
+    for ( int i = 0; i < size; ++i ) {
+        QString key;
+        GeoDataData data;
+        stream >> key;
+        data.unpack( stream );
+        d->hash.insert( key, data );
+    }
+
+    stream >> size;
+    for ( int i = 0; i < size; ++i ) {
+        QString key;
+        GeoDataSimpleArrayData *array = new GeoDataSimpleArrayData;
+        stream >> key;
+        array->unpack( stream );
+        delete d->arrayHash.value( key );
+        d->arrayHash.insert( key, array );
+    }
 }
 
 }
@@ -594,24 +594,34 @@ bool GeoDataFeature::isGloballyVisible() const
 
 GeoDataTimeSpan& GeoDataFeature::timeSpan() const
 {
-    return d->m_timeSpan;
+    return GeoDataFeaturePrivate::lazy( d->m_timeSpan );
+}
+
+bool GeoDataFeature::hasTimeSpan() const
+{
+    return d->m_timeSpan != 0;
 }
 
 void GeoDataFeature::setTimeSpan( GeoDataTimeSpan timeSpan )
 {
     detach();
-    d->m_timeSpan = timeSpan;
+    GeoDataFeaturePrivate::lazy( d->m_timeSpan ) = timeSpan;
 }
 
 GeoDataTimeStamp&  GeoDataFeature::timeStamp() const
 {
-    return d->m_timeStamp;
+    return GeoDataFeaturePrivate::lazy( d->m_timeStamp );
+}
+
+bool GeoDataFeature::hasTimeStamp() const
+{
+    return d->m_timeStamp != 0;
 }
 
 void GeoDataFeature::setTimeStamp( GeoDataTimeStamp timeStamp )
 {
     detach();
-    d->m_timeStamp = timeStamp;
+    GeoDataFeaturePrivate::lazy( d->m_timeStamp ) = timeStamp;
 }
 
 const GeoDataStyle* GeoDataFeature::style() const
@@ -639,28 +649,41 @@ void GeoDataFeature::setStyle( const GeoDataStyle* style )
 {
     detach();
     d->m_style = style;
+    if ( style != d->m_ownStyle.data() ) {
+        d->m_ownStyle.clear();
+    }
 }
 
 GeoDataExtendedData& GeoDataFeature::extendedData() const
 {
-    return d->m_extendedData;
+    return GeoDataFeaturePrivate::lazy( d->m_extendedData );
+}
+
+bool GeoDataFeature::hasExtendedData() const
+{
+    return d->m_extendedData != 0;
 }
 
 void GeoDataFeature::setExtendedData( const GeoDataExtendedData& extendedData )
 {
     detach();
-    d->m_extendedData = extendedData;
+    GeoDataFeaturePrivate::lazy( d->m_extendedData ) = extendedData;
 }
 
 GeoDataRegion& GeoDataFeature::region() const
 {
-    return d->m_region;
+    return GeoDataFeaturePrivate::lazy( d->m_region );
+}
+
+bool GeoDataFeature::hasRegion() const
+{
+    return d->m_region != 0;
 }
 
 void GeoDataFeature::setRegion( const GeoDataRegion& region )
 {
     detach();
-    d->m_region = region;
+    GeoDataFeaturePrivate::lazy( d->m_region ) = region;
 }
 
 GeoDataFeature::GeoDataVisualCategory GeoDataFeature::visualCategory() const
@@ -754,6 +777,28 @@ void GeoDataFeature::detach()
     d->ref.ref();
 }
 
+template<class T>
+static void packOptional( QDataStream& stream, const T *object )
+{
+    stream << ( object != 0 );
+    if ( object ) {
+        object->pack( stream );
+    }
+}
+
+template<class T>
+static void unpackOptional( QDataStream& stream, T *&object )
+{
+    bool hasObject;
+    stream >> hasObject;
+    delete object;
+    object = 0;
+    if ( hasObject ) {
+        object = new T;
+        object->unpack( stream );
+    }
+}
+
 void GeoDataFeature::pack( QDataStream& stream ) const
 {
     GeoDataObject::pack( stream );
@@ -763,10 +808,23 @@ void GeoDataFeature::pack( QDataStream& stream ) const
     stream << d->m_phoneNumber;
     stream << d->m_description;
     stream << d->m_visible;
-//    stream << d->m_visualCategory;
+    stream << (int)d->m_visualCategory;
     stream << d->m_role;
     stream << d->m_popularity;
     stream << d->m_zoomLevel;
+    stream << d->m_descriptionCDATA;
+    stream << d->m_styleUrl;
+    packOptional( stream, d->m_extendedData );
+    packOptional( stream, d->m_timeSpan );
+    packOptional( stream, d->m_timeStamp );
+
+    // Shared styles are found again through the style url, inline ones
+    // are stored with the feature
+    const bool hasInlineStyle = d->m_style && d->m_styleUrl.isEmpty();
+    stream << hasInlineStyle;
+    if ( hasInlineStyle ) {
+        d->m_style->pack( stream );
+    }
 }
 
 void GeoDataFeature::unpack( QDataStream& stream )
@@ -779,10 +837,26 @@ void GeoDataFeature::unpack( QDataStream& stream )
     stream >> d->m_phoneNumber;
     stream >> d->m_description;
     stream >> d->m_visible;
-//    stream >> (int)d->m_visualCategory;
+    int visualCategory;
+    stream >> visualCategory;
+    d->m_visualCategory = (GeoDataVisualCategory)visualCategory;
     stream >> d->m_role;
     stream >> d->m_popularity;
     stream >> d->m_zoomLevel;
+    stream >> d->m_descriptionCDATA;
+    stream >> d->m_styleUrl;
+    unpackOptional( stream, d->m_extendedData );
+    unpackOptional( stream, d->m_timeSpan );
+    unpackOptional( stream, d->m_timeStamp );
+
+    bool hasInlineStyle;
+    stream >> hasInlineStyle;
+    if ( hasInlineStyle ) {
+        GeoDataStyle *style = new GeoDataStyle;
+        style->unpack( stream );
+        d->m_ownStyle = QSharedPointer<const GeoDataStyle>( style );
+        d->m_style = style;
+    }
 }
 
 GeoDataFeature::GeoDataVisualCategory GeoDataFeature::OsmVisualCategory(const QString &keyValue )
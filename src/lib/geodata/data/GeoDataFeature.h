@@ -359,6 +359,12 @@ class GEODATA_EXPORT GeoDataFeature : public GeoDataObject
      */
     GeoDataTimeSpan& timeSpan() const;
 
+    /**
+     * Return whether the feature has a timespan. Unlike timeSpan(), this
+     * does not create an empty one.
+     */
+    bool hasTimeSpan() const;
+
     /**
      * Set the timespan of the feature.
      * @param timeSpan new of timespan.	
@@ -370,6 +376,12 @@ class GEODATA_EXPORT GeoDataFeature : public GeoDataObject
      */
     GeoDataTimeStamp& timeStamp() const;
 
+    /**
+     * Return whether the feature has a timestamp. Unlike timeStamp(), this
+     * does not create an empty one.
+     */
+    bool hasTimeStamp() const;
+
     /**
      * Set the timestamp of the feature.
      * @param timeStamp new of the timestamp.
@@ -391,6 +403,13 @@ class GEODATA_EXPORT GeoDataFeature : public GeoDataObject
      */
     GeoDataExtendedData& extendedData() const;
 
+    /**
+     * Return whether the feature has ExtendedData. Unlike extendedData(),
+     * this does not create an empty one, so check it before reading
+     * features that other threads may read at the same time.
+     */
+    bool hasExtendedData() const;
+
     /**
      * Sets the ExtendedData of the feature.
      * @param  extendedData  the new ExtendedData to be used.
@@ -401,6 +420,12 @@ class GEODATA_EXPORT GeoDataFeature : public GeoDataObject
      * Return the region assigned to the placemark.
      */
     GeoDataRegion& region() const;
+
+    /**
+     * Return whether the placemark has a region. Unlike region(), this
+     * does not create an empty one.
+     */
+    bool hasRegion() const;
     /**
      * @brief Sets the region of the placemark.
      * @param region new value for the region
@@ -13,6 +13,7 @@
 
 #include <QtCore/QString>
 #include <QtCore/QAtomicInt>
+#include <QtCore/QSharedPointer>
 
 #include "GeoDataExtendedData.h"
 #include "GeoDataAbstractView.h"
@@ -42,13 +43,13 @@ class GeoDataFeaturePrivate
         m_zoomLevel( 1 ),
         m_visible( true ),
         m_visualCategory( GeoDataFeature::Default ),
-        m_role(" "),
+        m_role( defaultRole() ),
         m_style( 0 ),
         m_styleMap( 0 ),
-        m_extendedData(),
-        m_timeSpan(),
-        m_timeStamp(),
-        m_region(),
+        m_extendedData( 0 ),
+        m_timeSpan( 0 ),
+        m_timeStamp( 0 ),
+        m_region( 0 ),
         ref( 0 )
     {
     }
@@ -66,11 +67,12 @@ class GeoDataFeaturePrivate
         m_visualCategory( other.m_visualCategory ),
         m_role( other.m_role ),
         m_style( other.m_style ),               //FIXME: both style and stylemap need to be reworked internally!!!!
+        m_ownStyle( other.m_ownStyle ),
         m_styleMap( other.m_styleMap ),
-        m_extendedData( other.m_extendedData ),
-        m_timeSpan( other.m_timeSpan ),
-        m_timeStamp( other.m_timeStamp ),
-        m_region( other.m_region ),
+        m_extendedData( copyOf( other.m_extendedData ) ),
+        m_timeSpan( copyOf( other.m_timeSpan ) ),
+        m_timeStamp( copyOf( other.m_timeStamp ) ),
+        m_region( copyOf( other.m_region ) ),
         ref( 0 )
     {
     }
@@ -88,12 +90,13 @@ class GeoDataFeaturePrivate
         m_visible = other.m_visible;
         m_role = other.m_role;
         m_style = other.m_style;
+        m_ownStyle = other.m_ownStyle;
         m_styleMap = other.m_styleMap;
-        m_timeSpan = other.m_timeSpan;
-        m_timeStamp = other.m_timeStamp;
+        assign( m_timeSpan, other.m_timeSpan );
+        assign( m_timeStamp, other.m_timeStamp );
         m_visualCategory = other.m_visualCategory;
-        m_extendedData = other.m_extendedData;
-        m_region = other.m_region;
+        assign( m_extendedData, other.m_extendedData );
+        assign( m_region, other.m_region );
     }
     
     virtual GeoDataFeaturePrivate* copy()
@@ -110,6 +113,43 @@ class GeoDataFeaturePrivate
 
     virtual ~GeoDataFeaturePrivate()
     {
+        delete m_extendedData;
+        delete m_timeSpan;
+        delete m_timeStamp;
+        delete m_region;
+    }
+
+    template<class T>
+    static T* copyOf( const T *other )
+    {
+        return other ? new T( *other ) : 0;
+    }
+
+    template<class T>
+    static void assign( T *&member, const T *other )
+    {
+        T *const copy = copyOf( other );
+        delete member;
+        member = copy;
+    }
+
+    /**
+     * Returns the member, creating it first if the feature has none yet.
+     */
+    template<class T>
+    static T& lazy( T *&member )
+    {
+        if ( !member ) {
+            member = new T;
+        }
+        return *member;
+    }
+
+    static const QString& defaultRole()
+    {
+        // Shared by all features instead of allocated for each of them
+        static const QString role( " " );
+        return role;
     }
 
     virtual const char* nodeType() const
@@ -191,14 +231,17 @@ class GeoDataFeaturePrivate
     QString       m_role;
 
     const GeoDataStyle* m_style;
+    // The inline style created by unpack(), shared with copies of the feature
+    QSharedPointer<const GeoDataStyle> m_ownStyle;
     const GeoDataStyleMap* m_styleMap;
 
-    GeoDataExtendedData m_extendedData;
+    // Few features have any of these, so they are only created on demand
+    GeoDataExtendedData* m_extendedData;
 
-    GeoDataTimeSpan  m_timeSpan;
-    GeoDataTimeStamp m_timeStamp;
+    GeoDataTimeSpan*  m_timeSpan;
+    GeoDataTimeStamp* m_timeStamp;
 
-    GeoDataRegion m_region;
+    GeoDataRegion* m_region;
     
     QAtomicInt  ref;
 
@@ -166,7 +166,11 @@ void GeoDataIconStyle::pack( QDataStream& stream ) const
     GeoDataColorStyle::pack( stream );
 
     stream << d->m_scale;
-    stream << d->m_icon;
+    // Icons from files are loaded again when needed
+    stream << d->m_iconPath;
+    if ( d->m_iconPath.isEmpty() ) {
+        stream << d->m_icon;
+    }
     d->m_hotSpot.pack( stream );
 }
 
@@ -175,7 +179,10 @@ void GeoDataIconStyle::unpack( QDataStream& stream )
     GeoDataColorStyle::unpack( stream );
 
     stream >> d->m_scale;
-    stream >> d->m_icon;
+    stream >> d->m_iconPath;
+    if ( d->m_iconPath.isEmpty() ) {
+        stream >> d->m_icon;
+    }
     d->m_hotSpot.unpack( stream );
 }
 
@@ -18,6 +18,8 @@
 #include "Quaternion.h"
 #include "MarbleDebug.h"
 
+#include <QtCore/QAtomicInt>
+
 
 namespace Marble
 {
@@ -46,6 +48,12 @@ GeoDataLineString::~GeoDataLineString()
 #endif
 }
 
+int GeoDataLineStringPrivate::nextRevision()
+{
+    static QAtomicInt revision;
+    return revision.fetchAndAddRelaxed( 1 ) + 1;
+}
+
 GeoDataLineStringPrivate* GeoDataLineString::p() const
 {
     return static_cast<GeoDataLineStringPrivate*>(d);
@@ -139,6 +147,7 @@ int GeoDataLineString::size() const
 GeoDataCoordinates& GeoDataLineString::at( int pos )
 {
     GeoDataGeometry::detach();
+    p()->m_revision = GeoDataLineStringPrivate::nextRevision();
     return p()->m_vector[ pos ];
 }
 
@@ -150,6 +159,7 @@ const GeoDataCoordinates& GeoDataLineString::at( int pos ) const
 GeoDataCoordinates& GeoDataLineString::operator[]( int pos )
 {
     GeoDataGeometry::detach();
+    p()->m_revision = GeoDataLineStringPrivate::nextRevision();
     return p()->m_vector[ pos ];
 }
 
@@ -161,12 +171,14 @@ const GeoDataCoordinates& GeoDataLineString::operator[]( int pos ) const
 GeoDataCoordinates& GeoDataLineString::last()
 {
     GeoDataGeometry::detach();
+    p()->m_revision = GeoDataLineStringPrivate::nextRevision();
     return p()->m_vector.last();
 }
 
 GeoDataCoordinates& GeoDataLineString::first()
 {
     GeoDataGeometry::detach();
+    p()->m_revision = GeoDataLineStringPrivate::nextRevision();
     return p()->m_vector.first();
 }
 
@@ -183,12 +195,14 @@ const GeoDataCoordinates& GeoDataLineString::first() const
 QVector<GeoDataCoordinates>::Iterator GeoDataLineString::begin()
 {
     GeoDataGeometry::detach();
+    p()->m_revision = GeoDataLineStringPrivate::nextRevision();
     return p()->m_vector.begin();
 }
 
 QVector<GeoDataCoordinates>::Iterator GeoDataLineString::end()
 {
     GeoDataGeometry::detach();
+    p()->m_revision = GeoDataLineStringPrivate::nextRevision();
     return p()->m_vector.end();
 }
 
@@ -205,6 +219,7 @@ QVector<GeoDataCoordinates>::ConstIterator GeoDataLineString::constEnd() const
 void GeoDataLineString::append ( const GeoDataCoordinates& value )
 {
     GeoDataGeometry::detach();
+    p()->m_revision = GeoDataLineStringPrivate::nextRevision();
     GeoDataLineStringPrivate* d = p();
     qDeleteAll( d->m_rangeCorrected );
     d->m_rangeCorrected.clear();
@@ -213,9 +228,17 @@ void GeoDataLineString::append ( const GeoDataCoordinates& value )
     d->m_vector.append( value );
 }
 
+void GeoDataLineString::reserve( int size )
+{
+    GeoDataGeometry::detach();
+    p()->m_revision = GeoDataLineStringPrivate::nextRevision();
+    p()->m_vector.reserve( size );
+}
+
 GeoDataLineString& GeoDataLineString::operator << ( const GeoDataCoordinates& value )
 {
     GeoDataGeometry::detach();
+    p()->m_revision = GeoDataLineStringPrivate::nextRevision();
     GeoDataLineStringPrivate* d = p();
     qDeleteAll( d->m_rangeCorrected );
     d->m_rangeCorrected.clear();
@@ -228,6 +251,7 @@ GeoDataLineString& GeoDataLineString::operator << ( const GeoDataCoordinates& va
 GeoDataLineString& GeoDataLineString::operator << ( const GeoDataLineString& value )
 {
     GeoDataGeometry::detach();
+    p()->m_revision = GeoDataLineStringPrivate::nextRevision();
     GeoDataLineStringPrivate* d = p();
     //qDeleteAll( d->m_rangeCorrected );
     d->m_rangeCorrected.clear();
@@ -247,6 +271,7 @@ GeoDataLineString& GeoDataLineString::operator << ( const GeoDataLineString& val
 void GeoDataLineString::clear()
 {
     GeoDataGeometry::detach();
+    p()->m_revision = GeoDataLineStringPrivate::nextRevision();
     GeoDataLineStringPrivate* d = p();
     //qDeleteAll( d->m_rangeCorrected );
     d->m_rangeCorrected.clear();
@@ -269,6 +294,7 @@ bool GeoDataLineString::tessellate() const
 void GeoDataLineString::setTessellate( bool tessellate )
 {
     GeoDataGeometry::detach();
+    p()->m_revision = GeoDataLineStringPrivate::nextRevision();
     // According to the KML reference the tesselation of line strings in Google Earth
     // is generally done along great circles. However for subsequent points that share
     // the same latitude the latitude circles are followed. Our Tesselate and RespectLatitude
@@ -290,9 +316,16 @@ TessellationFlags GeoDataLineString::tessellationFlags() const
 
 void GeoDataLineString::setTessellationFlags( TessellationFlags f )
 {
+    GeoDataGeometry::detach();
+    p()->m_revision = GeoDataLineStringPrivate::nextRevision();
     p()->m_tessellationFlags = f;
 }
 
+int GeoDataLineString::revision() const
+{
+    return p()->m_revision;
+}
+
 GeoDataLineString GeoDataLineString::toNormalized() const
 {
     GeoDataLineString normalizedLineString;
@@ -568,6 +601,7 @@ qreal GeoDataLineString::length( qreal planetRadius, int offset ) const
 QVector<GeoDataCoordinates>::Iterator GeoDataLineString::erase ( QVector<GeoDataCoordinates>::Iterator pos )
 {
     GeoDataGeometry::detach();
+    p()->m_revision = GeoDataLineStringPrivate::nextRevision();
     GeoDataLineStringPrivate* d = p();
     d->m_rangeCorrected.clear();
     d->m_dirtyRange = true;
@@ -579,6 +613,7 @@ QVector<GeoDataCoordinates>::Iterator GeoDataLineString::erase ( QVector<GeoData
                                                                  QVector<GeoDataCoordinates>::Iterator end )
 {
     GeoDataGeometry::detach();
+    p()->m_revision = GeoDataLineStringPrivate::nextRevision();
     GeoDataLineStringPrivate* d = p();
     d->m_rangeCorrected.clear();
     d->m_dirtyRange = true;
@@ -589,6 +624,7 @@ QVector<GeoDataCoordinates>::Iterator GeoDataLineString::erase ( QVector<GeoData
 void GeoDataLineString::remove ( int i )
 {
     GeoDataGeometry::detach();
+    p()->m_revision = GeoDataLineStringPrivate::nextRevision();
     GeoDataLineStringPrivate* d = p();
     d->m_dirtyRange = true;
     d->m_dirtyBox = true;
@@ -606,9 +642,7 @@ void GeoDataLineString::pack( QDataStream& stream ) const
           = p()->m_vector.constBegin();
          iterator != p()->m_vector.constEnd();
          ++iterator ) {
-        mDebug() << "innerRing: size" << p()->m_vector.size();
-        GeoDataCoordinates coord = ( *iterator );
-        coord.pack( stream );
+        iterator->pack( stream );
     }
 
 }
@@ -616,6 +650,7 @@ void GeoDataLineString::pack( QDataStream& stream ) const
 void GeoDataLineString::unpack( QDataStream& stream )
 {
     GeoDataGeometry::detach();
+    p()->m_revision = GeoDataLineStringPrivate::nextRevision();
     GeoDataGeometry::unpack( stream );
     qint32 size;
     qint32 tessellationFlags;
@@ -625,6 +660,7 @@ void GeoDataLineString::unpack( QDataStream& stream )
 
     p()->m_tessellationFlags = (TessellationFlags)(tessellationFlags);
 
+    p()->m_vector.reserve( p()->m_vector.size() + size );
     for(qint32 i = 0; i < size; i++ ) {
         GeoDataCoordinates coord;
         coord.unpack( stream );
@@ -216,6 +216,14 @@ class GEODATA_EXPORT GeoDataLineString : public GeoDataGeometry
 */
     int size() const;
 
+/*!
+    \brief Returns a number that changes whenever the line string is modified.
+
+    Caches of data derived from the line string can compare it to find out
+    whether they are still valid.
+*/
+    int revision() const;
+
 
 /*!
     \brief Returns a reference to the coordinates of a node at a given position.
@@ -279,6 +287,12 @@ class GEODATA_EXPORT GeoDataLineString : public GeoDataGeometry
     void append ( const GeoDataCoordinates& position );
 
 
+/*!
+    \brief Reserves space for @p size nodes to avoid reallocations when appending them.
+*/
+    void reserve( int size );
+
+
 /*!
     \brief Appends a given geodesic position as a new node to the LineString.
 */
@@ -24,13 +24,15 @@ class GeoDataLineStringPrivate : public GeoDataGeometryPrivate
     GeoDataLineStringPrivate( TessellationFlags f )
          : m_dirtyRange( true ),
            m_dirtyBox( true ),
-           m_tessellationFlags( f )
+           m_tessellationFlags( f ),
+           m_revision( nextRevision() )
     {
     }
 
     GeoDataLineStringPrivate()
          : m_dirtyRange( true ),
-           m_dirtyBox( true )
+           m_dirtyBox( true ),
+           m_revision( nextRevision() )
     {
     }
 
@@ -52,6 +54,7 @@ class GeoDataLineStringPrivate : public GeoDataGeometryPrivate
         m_latLonAltBox = other.m_latLonAltBox;
         m_dirtyBox = other.m_dirtyBox;
         m_tessellationFlags = other.m_tessellationFlags;
+        m_revision = other.m_revision;
     }
 
 
@@ -72,6 +75,13 @@ class GeoDataLineStringPrivate : public GeoDataGeometryPrivate
         return GeoDataLineStringId;
     }
 
+    /**
+     * Returns a revision number no line string had before. Unlike a
+     * counter per line string it also changes when the memory of a
+     * deleted line string is reused for a new one.
+     */
+    static int nextRevision();
+
     void toPoleCorrected( const GeoDataLineString & q, GeoDataLineString & poleCorrected );
 
     void toDateLineCorrected( const GeoDataLineString & q,
@@ -96,6 +106,8 @@ class GeoDataLineStringPrivate : public GeoDataGeometryPrivate
                                             // GeoDataPoints since the LatLonAltBox has 
                                             // been calculated. Saves performance. 
     TessellationFlags           m_tessellationFlags;
+
+    int                         m_revision; // changes with every modification
 };
 
 } // namespace Marble
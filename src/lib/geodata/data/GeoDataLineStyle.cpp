@@ -142,6 +142,7 @@ void GeoDataLineStyle::pack( QDataStream& stream ) const
     stream << (int)d->m_penStyle;
     stream << (int)d->m_capStyle;
     stream << d->m_background;
+    stream << d->m_pattern;
 }
 
 void GeoDataLineStyle::unpack( QDataStream& stream )
@@ -156,6 +157,7 @@ void GeoDataLineStyle::unpack( QDataStream& stream )
     stream >> style;
     d->m_capStyle = ( Qt::PenCapStyle ) style;
     stream >> d->m_background;
+    stream >> d->m_pattern;
 }
 
 }
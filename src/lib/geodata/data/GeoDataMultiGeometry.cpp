@@ -16,6 +16,7 @@
 #include "GeoDataLinearRing.h"
 #include "GeoDataPoint.h"
 #include "GeoDataPolygon.h"
+#include "GeoDataTrack.h"
 
 #include "MarbleDebug.h"
 
@@ -269,6 +270,13 @@ void GeoDataMultiGeometry::unpack( QDataStream& stream )
                 p()->m_vector.append( multiGeometry );
                 }
                 break;
+            case GeoDataTrackId:
+                {
+                GeoDataTrack *track = new GeoDataTrack;
+                track->unpack( stream );
+                p()->m_vector.append( track );
+                }
+                break;
             case GeoDataModelId:
                 break;
             default: break;
@@ -23,6 +23,7 @@
 // Qt
 #include <QtCore/QDataStream>
 #include "MarbleDebug.h"
+#include "GeoDataMultiTrack.h"
 #include "GeoDataTrack.h"
 
 namespace Marble
@@ -189,6 +190,7 @@ void GeoDataPlacemark::pack( QDataStream& stream ) const
     stream << p()->m_countrycode;
     stream << p()->m_area;
     stream << p()->m_population;
+    stream << p()->m_state;
     if ( p()->m_geometry )
     {
         stream << p()->m_geometry->geometryId();
@@ -222,6 +224,7 @@ void GeoDataPlacemark::unpack( QDataStream& stream )
     stream >> p()->m_countrycode;
     stream >> p()->m_area;
     stream >> p()->m_population;
+    stream >> p()->m_state;
     int geometryId;
     stream >> geometryId;
     switch( geometryId ) {
@@ -267,10 +270,29 @@ void GeoDataPlacemark::unpack( QDataStream& stream )
             p()->m_geometry = multiGeometry;
             }
             break;
+        case GeoDataTrackId:
+            {
+            GeoDataTrack* track = new GeoDataTrack;
+            track->unpack( stream );
+            delete p()->m_geometry;
+            p()->m_geometry = track;
+            }
+            break;
+        case GeoDataMultiTrackId:
+            {
+            GeoDataMultiTrack* multiTrack = new GeoDataMultiTrack;
+            multiTrack->unpack( stream );
+            delete p()->m_geometry;
+            p()->m_geometry = multiTrack;
+            }
+            break;
         case GeoDataModelId:
             break;
         default: break;
     };
+    if ( p()->m_geometry ) {
+        p()->m_geometry->setParent( this );
+    }
 }
 
 }
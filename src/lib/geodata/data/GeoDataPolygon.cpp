@@ -117,9 +117,7 @@ void GeoDataPolygon::pack( QDataStream& stream ) const
           = p()->inner.constBegin(); 
          iterator != p()->inner.constEnd();
          ++iterator ) {
-        mDebug() << "innerRing: size" << p()->inner.size();
-        GeoDataLinearRing linearRing = ( *iterator );
-        linearRing.pack( stream );
+        iterator->pack( stream );
     }
 }
 
@@ -138,6 +136,7 @@ void GeoDataPolygon::unpack( QDataStream& stream )
 
     p()->m_tessellationFlags = (TessellationFlags)(tessellationFlags);
 
+    p()->inner.reserve( p()->inner.size() + size );
     for(qint32 i = 0; i < size; i++ ) {
         GeoDataLinearRing linearRing;
         linearRing.unpack( stream );
@@ -13,6 +13,7 @@
 #include "GeoDataTypes.h"
 #include "MarbleDebug.h"
 
+#include <QtCore/QDataStream>
 #include <QtCore/QMap>
 #include <QtCore/QLinkedList>
 
@@ -72,11 +73,15 @@ const char* GeoDataSimpleArrayData::nodeType() const
 void GeoDataSimpleArrayData::pack( QDataStream& stream ) const
 {
     GeoDataObject::pack( stream );
+
+    stream << d->m_values;
 }
 
 void GeoDataSimpleArrayData::unpack( QDataStream& stream )
 {
     GeoDataObject::unpack( stream );
+
+    stream >> d->m_values;
 }
 
 }
@@ -17,8 +17,8 @@
 
 #include "GeoDataLineString.h"
 
-#include <QtCore/QMap>
-#include <QtCore/QLinkedList>
+#include <QtCore/QDataStream>
+#include <QtCore/QtAlgorithms>
 #include "GeoDataExtendedData.h"
 
 namespace Marble {
@@ -29,6 +29,8 @@ public:
     GeoDataTrackPrivate()
         : m_lineString( new GeoDataLineString() ),
           m_lineStringNeedsUpdate( false ),
+          m_sorted( true ),
+          m_timeOrderNeedsUpdate( false ),
           m_interpolate( false )
     {
     }
@@ -37,21 +39,109 @@ public:
     {
         while ( m_when.size() < m_coordinates.size() ) {
             //fill coordinates without time information with null QDateTime
-            m_when.append( QDateTime() );
+            appendWhen( QDateTime() );
         }
     }
 
+    void appendWhen( const QDateTime &when )
+    {
+        m_sorted = m_sorted && when.isValid() && ( m_when.isEmpty() || !( when < m_when.last() ) );
+        m_timeOrderNeedsUpdate = true;
+        m_when.append( when );
+    }
+
+    int pointCount() const
+    {
+        return qMin( m_when.size(), m_coordinates.size() );
+    }
+
+    void updateTimeOrder();
+
+    int timeOrderSize() const
+    {
+        return m_sorted ? pointCount() : m_timeOrder.size();
+    }
+
+    int indexAt( int position ) const
+    {
+        return m_sorted ? position : m_timeOrder.at( position );
+    }
+
+    int bound( const QDateTime &when, bool after ) const;
+
     GeoDataLineString *m_lineString;
     bool m_lineStringNeedsUpdate;
 
-    QList<QDateTime> m_when;
-    QList<GeoDataCoordinates> m_coordinates;
+    QVector<QDateTime> m_when;
+    QVector<GeoDataCoordinates> m_coordinates;
+
+    // Whether all times are valid and ascending, which is the case for
+    // nearly all tracks and lets lookups search m_when directly
+    bool m_sorted;
+
+    // Otherwise the indexes of the points with a valid time in time order
+    QVector<int> m_timeOrder;
+    bool m_timeOrderNeedsUpdate;
 
     GeoDataExtendedData m_extendedData;
 
     bool m_interpolate;
 };
 
+class TimeLessThan
+{
+public:
+    explicit TimeLessThan( const QVector<QDateTime> &when )
+        : m_when( when )
+    {
+    }
+
+    bool operator()( int a, int b ) const
+    {
+        return m_when.at( a ) < m_when.at( b );
+    }
+
+private:
+    const QVector<QDateTime> &m_when;
+};
+
+void GeoDataTrackPrivate::updateTimeOrder()
+{
+    if ( m_sorted || !m_timeOrderNeedsUpdate ) {
+        return;
+    }
+
+    m_timeOrder.clear();
+    const int count = pointCount();
+    for ( int i = 0; i < count; ++i ) {
+        if ( m_when.at( i ).isValid() ) {
+            m_timeOrder.append( i );
+        }
+    }
+    qStableSort( m_timeOrder.begin(), m_timeOrder.end(), TimeLessThan( m_when ) );
+    m_timeOrderNeedsUpdate = false;
+}
+
+int GeoDataTrackPrivate::bound( const QDateTime &when, bool after ) const
+{
+    // Binary search for the first position in time order whose time is not
+    // before @p when or, with @p after, is after it
+    int first = 0;
+    int count = timeOrderSize();
+    while ( count > 0 ) {
+        const int step = count / 2;
+        const QDateTime &time = m_when.at( indexAt( first + step ) );
+        if ( after ? !( when < time ) : time < when ) {
+            first += step + 1;
+            count -= step + 1;
+        } else {
+            count = step;
+        }
+    }
+
+    return first;
+}
+
 GeoDataTrack::GeoDataTrack()
     : d( new GeoDataTrackPrivate() )
 {
@@ -99,10 +189,20 @@ QDateTime GeoDataTrack::lastWhen() const
 
 QList<GeoDataCoordinates> GeoDataTrack::coordinatesList() const
 {
-    return d->m_coordinates;
+    return d->m_coordinates.toList();
 }
 
 QList<QDateTime> GeoDataTrack::whenList() const
+{
+    return d->m_when.toList();
+}
+
+QVector<GeoDataCoordinates> GeoDataTrack::coordinatesVector() const
+{
+    return d->m_coordinates;
+}
+
+QVector<QDateTime> GeoDataTrack::whenVector() const
 {
     return d->m_when;
 }
@@ -113,40 +213,37 @@ GeoDataCoordinates GeoDataTrack::coordinatesAt( const QDateTime &when ) const
         return GeoDataCoordinates();
     }
 
-    if ( d->m_when.contains( when ) ) {
+    d->updateTimeOrder();
+    const int size = d->timeOrderSize();
+    const int first = d->bound( when, false );
+    if ( first < size && d->m_when.at( d->indexAt( first ) ) == when ) {
         //exact match found
-        int index = d->m_when.indexOf( when );
-        if ( index < d->m_coordinates.size() ) {
-            return d->m_coordinates.at( index );
-        }
+        return d->m_coordinates.at( d->indexAt( first ) );
     }
 
     if ( !interpolate() ) {
         return GeoDataCoordinates();
     }
 
-    typedef QMap<QDateTime, GeoDataCoordinates> PointMap;
-    PointMap pointMap;
-    for ( int i = 0; i < qMin( d->m_when.size(), d->m_coordinates.size() ); ++i) {
-        if ( d->m_when.at( i ).isValid() ) {
-            pointMap[ d->m_when.at( i ) ] = d->m_coordinates.at( i );
-        }
-    }
-
-    QMap<QDateTime, GeoDataCoordinates>::const_iterator nextEntry = const_cast<const PointMap&>(pointMap).upperBound( when );
-
     // No tracked point happened before "when"
-    if ( nextEntry == pointMap.constBegin() ) {
+    if ( first == 0 ) {
         mDebug() << "No tracked point before " << when;
         return GeoDataCoordinates();
     }
 
-    QMap<QDateTime, GeoDataCoordinates>::const_iterator previousEntry = nextEntry - 1;
-    GeoDataCoordinates previousCoord = previousEntry.value();
+    if ( first == size ) {
+        mDebug() << "No tracked point after " << when;
+        return GeoDataCoordinates();
+    }
+
+    // Of several points with the same time the last one is used
+    const int previousIndex = d->indexAt( first - 1 );
+    const int nextIndex = d->indexAt( d->bound( d->m_when.at( d->indexAt( first ) ), true ) - 1 );
 
-    QDateTime previousWhen = previousEntry.key();
-    QDateTime nextWhen = nextEntry.key();
-    GeoDataCoordinates nextCoord = nextEntry.value();
+    const GeoDataCoordinates &previousCoord = d->m_coordinates.at( previousIndex );
+    const QDateTime &previousWhen = d->m_when.at( previousIndex );
+    const QDateTime &nextWhen = d->m_when.at( nextIndex );
+    const GeoDataCoordinates &nextCoord = d->m_coordinates.at( nextIndex );
 
 #if QT_VERSION < 0x040700	
     int interval = 1000 * previousWhen.secsTo( nextWhen );
@@ -175,44 +272,63 @@ GeoDataCoordinates GeoDataTrack::coordinatesAt( int index ) const
 void GeoDataTrack::addPoint( const QDateTime &when, const GeoDataCoordinates &coord )
 {
     d->equalizeWhenSize();
-    d->m_lineStringNeedsUpdate = true;
-    int i=0;
-    while ( i < d->m_when.size() ) {
-        if ( d->m_when.at( i ) > when ) {
-            break;
+
+    // Points usually come in time order and are just appended
+    int i = d->m_when.size();
+    if ( d->m_sorted ) {
+        if ( !d->m_when.isEmpty() && when < d->m_when.last() ) {
+            i = qUpperBound( d->m_when.constBegin(), d->m_when.constEnd(), when ) - d->m_when.constBegin();
         }
-        ++i;
+    } else {
+        i = 0;
+        while ( i < d->m_when.size() ) {
+            if ( d->m_when.at( i ) > when ) {
+                break;
+            }
+            ++i;
+        }
+    }
+
+    if ( i == d->m_when.size() ) {
+        d->appendWhen( when );
+        d->m_coordinates.append( coord );
+    } else {
+        d->m_sorted = d->m_sorted && when.isValid();
+        d->m_timeOrderNeedsUpdate = true;
+        d->m_lineStringNeedsUpdate = true;
+        d->m_when.insert( i, when );
+        d->m_coordinates.insert( i, coord );
     }
-    d->m_when.insert(i, when );
-    d->m_coordinates.insert(i, coord );
 }
 
 void GeoDataTrack::appendCoordinates( const GeoDataCoordinates &coord )
 {
     d->equalizeWhenSize();
-    d->m_lineStringNeedsUpdate = true;
+    d->m_timeOrderNeedsUpdate = true;
     d->m_coordinates.append( coord );
 }
 
 void GeoDataTrack::appendAltitude( qreal altitude )
 {
-    d->m_lineStringNeedsUpdate = true;
     Q_ASSERT( !d->m_coordinates.isEmpty() );
     if ( d->m_coordinates.isEmpty() ) return;
-    GeoDataCoordinates coordinates = d->m_coordinates.takeLast();
-    coordinates.setAltitude( altitude );
-    d->m_coordinates.append( coordinates );
+    if ( d->m_lineString->size() == d->m_coordinates.size() ) {
+        d->m_lineStringNeedsUpdate = true;
+    }
+    d->m_coordinates.last().setAltitude( altitude );
 }
 
 void GeoDataTrack::appendWhen( const QDateTime &when )
 {
-    d->m_when.append( when );
+    d->appendWhen( when );
 }
 
 void GeoDataTrack::clear()
 {
     d->m_when.clear();
     d->m_coordinates.clear();
+    d->m_sorted = true;
+    d->m_timeOrderNeedsUpdate = true;
     d->m_lineStringNeedsUpdate = true;
 }
 
@@ -224,9 +340,20 @@ void GeoDataTrack::removeBefore( const QDateTime &when )
     }
     d->equalizeWhenSize();
 
-    while ( !d->m_when.isEmpty() && d->m_when.first() < when ) {
-        d->m_when.takeFirst();
-        d->m_coordinates.takeFirst();
+    int count = 0;
+    if ( d->m_sorted ) {
+        count = qLowerBound( d->m_when.constBegin(), d->m_when.constEnd(), when ) - d->m_when.constBegin();
+    } else {
+        while ( count < d->m_when.size() && d->m_when.at( count ) < when ) {
+            ++count;
+        }
+    }
+
+    if ( count > 0 ) {
+        d->m_when.remove( 0, count );
+        d->m_coordinates.remove( 0, qMin( count, d->m_coordinates.size() ) );
+        d->m_timeOrderNeedsUpdate = true;
+        d->m_lineStringNeedsUpdate = true;
     }
 }
 
@@ -237,23 +364,39 @@ void GeoDataTrack::removeAfter( const QDateTime &when )
         return;
     }
     d->equalizeWhenSize();
-    while ( !d->m_when.isEmpty() && d->m_when.last() > when ) {
-        d->m_when.takeLast();
-        d->m_coordinates.takeLast();
 
+    int size = d->m_when.size();
+    if ( d->m_sorted ) {
+        size = qUpperBound( d->m_when.constBegin(), d->m_when.constEnd(), when ) - d->m_when.constBegin();
+    } else {
+        while ( size > 0 && d->m_when.at( size - 1 ) > when ) {
+            --size;
+        }
+    }
+
+    if ( size < d->m_when.size() ) {
+        d->m_coordinates.resize( qMax( 0, d->m_coordinates.size() - ( d->m_when.size() - size ) ) );
+        d->m_when.resize( size );
+        d->m_timeOrderNeedsUpdate = true;
+        d->m_lineStringNeedsUpdate = true;
     }
 }
 
 const GeoDataLineString *GeoDataTrack::lineString() const
 {
     if ( d->m_lineStringNeedsUpdate ) {
-        delete d->m_lineString;
-        d->m_lineString = new GeoDataLineString();
-        foreach ( const GeoDataCoordinates &coordinates, coordinatesList() ) {
-            d->m_lineString->append( coordinates );
-        }
+        d->m_lineString->clear();
         d->m_lineStringNeedsUpdate = false;
     }
+
+    // Only the points appended since the last call are added
+    if ( d->m_lineString->size() < d->m_coordinates.size() ) {
+        d->m_lineString->reserve( d->m_coordinates.size() );
+        for ( int i = d->m_lineString->size(); i < d->m_coordinates.size(); ++i ) {
+            d->m_lineString->append( d->m_coordinates.at( i ) );
+        }
+    }
+
     return d->m_lineString;
 }
 
@@ -282,15 +425,43 @@ const GeoDataLatLonAltBox& GeoDataTrack::latLonAltBox() const
     return lineString()->latLonAltBox();
 }
 
-//TODO
 void GeoDataTrack::pack( QDataStream& stream ) const
 {
     GeoDataGeometry::pack( stream );
+
+    stream << d->m_when;
+    stream << d->m_coordinates.size();
+    foreach ( const GeoDataCoordinates &coordinates, d->m_coordinates ) {
+        coordinates.pack( stream );
+    }
+    stream << d->m_interpolate;
+    d->m_extendedData.pack( stream );
 }
-//TODO
+
 void GeoDataTrack::unpack( QDataStream& stream )
 {
     GeoDataGeometry::unpack( stream );
+
+    clear();
+
+    QVector<QDateTime> when;
+    stream >> when;
+    d->m_when.reserve( when.size() );
+    foreach ( const QDateTime &time, when ) {
+        d->appendWhen( time );
+    }
+
+    int size;
+    stream >> size;
+    d->m_coordinates.reserve( size );
+    for ( int i = 0; i < size; ++i ) {
+        GeoDataCoordinates coordinates;
+        coordinates.unpack( stream );
+        d->m_coordinates.append( coordinates );
+    }
+
+    stream >> d->m_interpolate;
+    d->m_extendedData.unpack( stream );
 }
 
 }
@@ -16,6 +16,7 @@
 
 #include <QtCore/QDateTime>
 #include <QtCore/QList>
+#include <QtCore/QVector>
 
 namespace Marble {
 
@@ -102,6 +103,16 @@ public:
      */
     QList<QDateTime> whenList() const;
 
+    /**
+     * Returns the same as coordinatesList() without copying the points.
+     */
+    QVector<GeoDataCoordinates> coordinatesVector() const;
+
+    /**
+     * Returns the same as whenList() without copying the time values.
+     */
+    QVector<QDateTime> whenVector() const;
+
     /**
      * If interpolate() is true, return the coordinates interpolated from the
      * time values before and after @p when, otherwise return the coordinates
@@ -119,7 +130,8 @@ public:
 
     /**
      * Add a new point with coordinates @p coord associated with the
-     * time value @p when
+     * time value @p when. Points later than all others are appended in
+     * constant time.
      */
     void addPoint( const QDateTime &when, const GeoDataCoordinates &coord );
 
@@ -21,8 +21,7 @@
 
 #include "KmlCoordinatesTagHandler.h"
 
-#include <QtCore/QStringList>
-#include <QtCore/QRegExp>
+#include <QtCore/QString>
 
 #include "MarbleDebug.h"
 #include "KmlElementDictionary.h"
@@ -49,6 +48,155 @@ static const bool kmlStrictSpecs = false;
 static GeoTagHandlerRegistrar s_handlercoordkmlTag_nameSpaceGx22(GeoParser::QualifiedName(kmlTag_coord, kmlTag_nameSpaceGx22 ),
                                                                  new KmlcoordinatesTagHandler());
 
+// Same as QChar::isSpace(), but without a function call for ASCII
+static inline bool isSpace( QChar c )
+{
+    const ushort u = c.unicode();
+    return u == ' ' || ( u >= '\t' && u <= '\r' ) || ( u >= 0x80 && c.isSpace() );
+}
+
+static inline void skipSpace( const QChar *&pos, const QChar *end )
+{
+    while ( pos != end && isSpace( *pos ) ) {
+        ++pos;
+    }
+}
+
+// Exact powers of ten, see below
+static const double powersOfTen[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/**
+ * Returns the same as QString( begin, end - begin ).toDouble() without
+ * copying the characters.
+ */
+static double toDouble( const QChar *begin, const QChar *end )
+{
+    if ( begin == end ) {
+        return 0.0;
+    }
+
+    // Plain decimals like "-122.365662" have an integer mantissa of at most
+    // 15 digits and at most 22 decimals. Both the mantissa and the power of
+    // ten are exact doubles then, so the division rounds exactly like a full
+    // string to double conversion.
+    const QChar *pos = begin;
+    const bool negative = *pos == QLatin1Char( '-' );
+    if ( negative ) {
+        ++pos;
+    }
+
+    quint64 mantissa = 0;
+    int digits = 0;
+    int decimals = -1;
+    for ( ; pos != end; ++pos ) {
+        const ushort c = pos->unicode();
+        if ( c >= '0' && c <= '9' ) {
+            mantissa = 10 * mantissa + ( c - '0' );
+            ++digits;
+            if ( decimals >= 0 ) {
+                ++decimals;
+            }
+        } else if ( c == '.' && decimals < 0 && digits > 0 ) {
+            decimals = 0;
+        } else {
+            break;
+        }
+    }
+
+    if ( pos == end && digits > 0 && digits <= 15 && decimals != 0 && decimals <= 22 ) {
+        const double value = double( mantissa ) / powersOfTen[qMax( decimals, 0 )];
+        return negative ? -value : value;
+    }
+
+    // Exponents, long mantissas and garbage
+    return QString::fromRawData( begin, end - begin ).toDouble();
+}
+
+/**
+ * Reads the whitespace separated tuple at @p pos and returns its number of
+ * comma separated components. The first three of them are stored in
+ * @p values unless it is 0. @p pos is moved to the next tuple.
+ */
+static int readTuple( const QChar *&pos, const QChar *end, double *values )
+{
+    int count = 0;
+    while ( true ) {
+        const QChar *const start = pos;
+        while ( pos != end && *pos != QLatin1Char( ',' ) && !isSpace( *pos ) ) {
+            ++pos;
+        }
+
+        if ( values && count < 3 ) {
+            values[count] = toDouble( start, pos );
+        }
+        ++count;
+
+        // Spaces before and after commas do not separate tuples
+        const QChar *next = pos;
+        if ( !kmlStrictSpecs ) {
+            skipSpace( next, end );
+        }
+        if ( next == end || *next != QLatin1Char( ',' ) ) {
+            break;
+        }
+        pos = next + 1;
+        if ( !kmlStrictSpecs ) {
+            skipSpace( pos, end );
+        }
+    }
+
+    skipSpace( pos, end );
+    return count;
+}
+
+/**
+ * Reads the whitespace separated values of a gx:coord element. Spaces
+ * around commas do not separate values, like in readTuple().
+ */
+static int readCoord( const QChar *&pos, const QChar *end, double *values )
+{
+    int count = 0;
+    while ( pos != end ) {
+        const QChar *const start = pos;
+        while ( pos != end && !isSpace( *pos ) ) {
+            if ( !kmlStrictSpecs && *pos == QLatin1Char( ',' ) ) {
+                ++pos;
+                skipSpace( pos, end );
+                continue;
+            }
+            ++pos;
+            if ( !kmlStrictSpecs ) {
+                const QChar *next = pos;
+                skipSpace( next, end );
+                if ( next != end && *next == QLatin1Char( ',' ) ) {
+                    pos = next;
+                }
+            }
+        }
+
+        if ( count < 3 ) {
+            values[count] = toDouble( start, pos );
+        }
+        ++count;
+
+        skipSpace( pos, end );
+    }
+
+    return count;
+}
+
+static void setCoordinates( GeoDataCoordinates &coordinates, const double *values, int count )
+{
+    if ( count == 2 ) {
+        coordinates.set( DEG2RAD * values[0], DEG2RAD * values[1] );
+    } else if ( count == 3 ) {
+        coordinates.set( DEG2RAD * values[0], DEG2RAD * values[1], values[2] );
+    }
+}
+
 GeoNode* KmlcoordinatesTagHandler::parse( GeoParser& parser ) const
 {
     Q_ASSERT( parser.isStartElement()
@@ -61,84 +209,47 @@ GeoNode* KmlcoordinatesTagHandler::parse( GeoParser& parser ) const
      || parentItem.represents( kmlTag_LineString )
      || parentItem.represents( kmlTag_MultiGeometry )
      || parentItem.represents( kmlTag_LinearRing ) ) {
-        QStringList  coordinatesLines;// = parser.readElementText().trimmed().split( QRegExp("\\s"), QString::SkipEmptyParts );
-        // Splitting using the "\\s" regexp is slow, split manually instead.
-        QString text = parser.readElementText().trimmed();
+        // Numbers are read straight from the element text
+        const QString text = parser.readElementText();
+        const QChar *pos = text.constData();
+        const QChar *const end = pos + text.size();
+        skipSpace( pos, end );
 
-        if ( !kmlStrictSpecs ) {
-            // Removing spaces before and after commas
-            for ( int i = 1; i < text.size() - 1; ++i ) {
-                if ( text[i] == ',' ) {
-                    // Before
-                    int l = i - 1;
-                    while ( l > 0 && text[l].isSpace() ) {
-                        --l;
-                    }
-
-                    // After
-                    int r = i + 1;
-                    while ( r < text.size() && text[r].isSpace() ) {
-                        ++r;
-                    }
-
-                    text.remove( l + 1, r - l - 1 ).insert( l + 1, ',' );
-                }
-            }
+        GeoDataLineString *lineString = 0;
+        if ( parentItem.represents( kmlTag_LineString ) ) {
+            lineString = parentItem.nodeAs<GeoDataLineString>();
+        } else if ( parentItem.represents( kmlTag_LinearRing ) ) {
+            lineString = parentItem.nodeAs<GeoDataLinearRing>();
         }
 
-        int index = 0;
-        bool inside = true;
-        int const size = text.size();
-        for ( int i=0; i<size; ++i ) {
-            if ( text[i].isSpace() ) {
-                if ( inside ) {
-                    coordinatesLines.append( text.mid( index, i-index ) );
-                    inside = false;
-                }
-                index = i+1;
-            } else {
-                inside = true;
-            }
+        if ( lineString ) {
+            int size = 0;
+            const QChar *tuple = pos;
+            do {
+                readTuple( tuple, end, 0 );
+                ++size;
+            } while ( tuple != end );
+            lineString->reserve( lineString->size() + size );
         }
-        coordinatesLines.append( text.mid( index ) );
-        Q_FOREACH( const QString& line, coordinatesLines ) {
-            QStringList coordinates = line.trimmed().split( ',' );
+
+        // Even an empty element has one tuple
+        do {
+            double values[3];
+            const int count = readTuple( pos, end, values );
+
             if ( parentItem.represents( kmlTag_Point ) && parentItem.is<GeoDataFeature>() ) {
                 GeoDataPoint coord;
-                if ( coordinates.size() == 2 ) {
-                    coord.set( DEG2RAD * coordinates.at( 0 ).toDouble(),
-                              DEG2RAD * coordinates.at( 1 ).toDouble() );
-                } else if( coordinates.size() == 3 ) {
-                    coord.set( DEG2RAD * coordinates.at( 0 ).toDouble(),
-                              DEG2RAD * coordinates.at( 1 ).toDouble(),
-                              coordinates.at( 2 ).toDouble() );
-                }
+                setCoordinates( coord, values, count );
                 parentItem.nodeAs<GeoDataPlacemark>()->setCoordinate( coord );
             } else {
                 GeoDataCoordinates coord;
-                if ( coordinates.size() == 2 ) {
-                    coord.set( DEG2RAD * coordinates.at( 0 ).toDouble(),
-                              DEG2RAD * coordinates.at( 1 ).toDouble() );
-                } else if( coordinates.size() == 3 ) {
-                    coord.set( DEG2RAD * coordinates.at( 0 ).toDouble(),
-                              DEG2RAD * coordinates.at( 1 ).toDouble(),
-                              coordinates.at( 2 ).toDouble() );
-                }
+                setCoordinates( coord, values, count );
 
-                if ( parentItem.represents( kmlTag_LineString ) ) {
-                    parentItem.nodeAs<GeoDataLineString>()->append( coord );
-                } else if ( parentItem.represents( kmlTag_LinearRing ) ) {
-                    parentItem.nodeAs<GeoDataLinearRing>()->append( coord );
+                if ( lineString ) {
+                    lineString->append( coord );
                 } else if ( parentItem.represents( kmlTag_MultiGeometry ) ) {
                     GeoDataPoint *point = new GeoDataPoint;
-                    if ( coordinates.size() == 2 ) {
-                        point->set( DEG2RAD * coordinates.at( 0 ).toDouble(),
-                                   DEG2RAD * coordinates.at( 1 ).toDouble() );
-                    } else if ( coordinates.size() == 3 ) {
-                        point->set( DEG2RAD * coordinates.at( 0 ).toDouble(),
-                                   DEG2RAD * coordinates.at( 1 ).toDouble(),
-                                   coordinates.at( 2 ).toDouble() );
-                    }
+                    setCoordinates( *point, values, count );
                     parentItem.nodeAs<GeoDataMultiGeometry>()->append( point );
                 } else if ( parentItem.represents( kmlTag_Point ) ) {
                     // photo overlay
@@ -149,31 +260,26 @@ GeoNode* KmlcoordinatesTagHandler::parse( GeoParser& parser ) const
                     // raise warning as coordinates out of valid parents found
                 }
             }
+        } while ( pos != end );
+
 #ifdef DEBUG_TAGS
         mDebug() << "Parsed <" << parser.name()
-                 << ">" << coordinatesLines
+                 << ">" << text
                  << " parent item name: " << parentItem.qualifiedName().first;
 #endif // DEBUG_TAGS
-
-        }
     }
 
     if( parentItem.represents( kmlTag_Track ) ) {
-        QString input = parser.readElementText().trimmed();
-        if ( !kmlStrictSpecs ) {
-            input = input.replace( QRegExp( "\\s*,\\s*" ), "," );
-        }
-        QStringList coordinates = input.split( ' ' );
+        const QString text = parser.readElementText();
+        const QChar *pos = text.constData();
+        const QChar *const end = pos + text.size();
+        skipSpace( pos, end );
+
+        double values[3];
+        const int count = readCoord( pos, end, values );
 
         GeoDataCoordinates coord;
-        if ( coordinates.size() == 2 ) {
-            coord.set( DEG2RAD * coordinates.at( 0 ).toDouble(),
-                       DEG2RAD * coordinates.at( 1 ).toDouble() );
-        } else if( coordinates.size() == 3 ) {
-            coord.set( DEG2RAD * coordinates.at( 0 ).toDouble(),
-                       DEG2RAD * coordinates.at( 1 ).toDouble(),
-                       coordinates.at( 2 ).toDouble() );
-        }
+        setCoordinates( coord, values, count );
         parentItem.nodeAs<GeoDataTrack>()->appendCoordinates( coord );
     }
 
@@ -39,7 +39,9 @@ namespace Marble
 GeoParser::GeoParser( GeoDataGenericSourceType source )
     : QXmlStreamReader(),
       m_document( 0 ),
-      m_source( source )
+      m_source( source ),
+      m_listener( 0 ),
+      m_documentNode( 0 )
 {
 }
 
@@ -77,6 +79,7 @@ bool GeoParser::read( QIODevice* device )
     Q_ASSERT( !m_document );
     m_document = createDocument();
     Q_ASSERT( m_document );
+    m_documentNode = dynamic_cast<GeoNode*>( m_document );
 
     // Set data source
     setDevice( device );
@@ -175,6 +178,11 @@ void GeoParser::parseDocument()
 
             if ( isStartElement() ) {
                 parseDocument();
+
+                if ( m_listener && stackItem.associatedNode() && stackItem.associatedNode() == m_documentNode
+                     && !m_listener->documentChildParsed( *this ) ) {
+                    raiseError( QObject::tr( "Parsing was canceled" ) );
+                }
             }
         }
     }
@@ -206,7 +214,13 @@ GeoDocument* GeoParser::releaseDocument()
 {
     GeoDocument* document = m_document;
     m_document = 0;
+    m_documentNode = 0;
     return document;
 }
 
+void GeoParser::setListener( GeoParserListener* listener )
+{
+    m_listener = listener;
+}
+
 }
@@ -35,6 +35,7 @@ typedef int GeoDataGenericSourceType;
 
 class GeoDocument;
 class GeoNode;
+class GeoParserListener;
 class GeoStackItem;
 
 class GEODATA_EXPORT GeoParser : public QXmlStreamReader
@@ -61,6 +62,14 @@ class GEODATA_EXPORT GeoParser : public QXmlStreamReader
     GeoDocument* releaseDocument();
     GeoDocument* activeDocument() { return m_document; }
 
+    /**
+     * @brief report completed parts of the document while reading
+     * The @p listener is called each time an element directly below the
+     * document element has been parsed, so it can take over finished parts
+     * of the document before the whole device is read. Pass 0 to stop.
+     */
+    void setListener( GeoParserListener* listener );
+
     // Used by tag handlers, to be overridden by GeoDataParser/GeoSceneParser
     virtual bool isValidElement( const QString& tagName ) const;
 
@@ -92,6 +101,20 @@ protected:
 private:
     void parseDocument();
     QStack<GeoStackItem> m_nodeStack;
+    GeoParserListener* m_listener;
+    GeoNode* m_documentNode;
+};
+
+class GeoParserListener
+{
+ public:
+    virtual ~GeoParserListener() {}
+
+    /**
+     * Called after an element directly below the document element of
+     * @p parser has been parsed. Return false to stop reading.
+     */
+    virtual bool documentChildParsed( GeoParser& parser ) = 0;
 };
 
 class GeoStackItem
@@ -27,12 +27,14 @@ bool KmlTrackWriter::write( const GeoNode *node, GeoWriter &writer ) const
 
     writer.writeStartElement( "gx:Track" );
 
+    const QVector<QDateTime> when = track->whenVector();
+    const QVector<GeoDataCoordinates> coordinates = track->coordinatesVector();
     int points = track->size();
     for ( int i = 0; i < points; i++ ) {
-        writer.writeElement( "when", track->whenList().at( i ).toString( Qt::ISODate ) );
+        writer.writeElement( "when", when.at( i ).toString( Qt::ISODate ) );
 
         qreal lon, lat, alt;
-        track->coordinatesList().at( i ).geoCoordinates( lon, lat, alt, GeoDataCoordinates::Degree );
+        coordinates.at( i ).geoCoordinates( lon, lat, alt, GeoDataCoordinates::Degree );
         QString coord = QString::number( lon, 'f', 10 ) + ' '
                         + QString::number( lat, 'f', 10 ) + ' ' + QString::number( alt, 'f', 10 );
 
@@ -28,6 +28,7 @@
 #include "MarbleDebug.h"
 #include "GeoDataFeature.h"
 #include "GeoPainter.h"
+#include "ProjectedGeometryCache.h"
 #include "ViewportParams.h"
 #include "GeoGraphicsScene.h"
 #include "GeoGraphicsItem.h"
@@ -65,6 +66,7 @@ public:
 
     const QAbstractItemModel *const m_model;
     GeoGraphicsScene m_scene;
+    ProjectedGeometryCache m_projectionCache;
     QString m_runtimeTrace;
     QList<MarbleGraphicsItem*> m_items;
 
@@ -105,7 +107,7 @@ GeometryLayer::GeometryLayer( const QAbstractItemModel *model )
     connect( model, SIGNAL( dataChanged( QModelIndex, QModelIndex ) ),
              this, SLOT( invalidateScene() ) );
     connect( model, SIGNAL( rowsInserted(const QModelIndex&, int, int) ),
-             this, SLOT( invalidateScene() ) );
+             this, SLOT( addPlacemarks(const QModelIndex&, int, int) ) );
     connect( model, SIGNAL( rowsRemoved(const QModelIndex&, int, int) ),
              this, SLOT( invalidateScene() ) );
     connect( model, SIGNAL( modelReset() ),
@@ -248,6 +250,13 @@ bool GeometryLayer::render( GeoPainter *painter, ViewportParams *viewport,
     int maxZoomLevel = qMin<int>( qLn( viewport->radius() *4 / 256 ) / qLn( 2.0 ), GeometryLayerPrivate::maximumZoomLevel() );
 
     QList<GeoGraphicsItem*> items = d->m_scene.items( viewport->viewLatLonAltBox(), maxZoomLevel );
+
+    // The geometries of the scene items stay alive until invalidateScene()
+    // is called, so their screen polygons can be reused in later repaints.
+    d->m_projectionCache.resetStatistics();
+    d->m_projectionCache.setViewport( viewport );
+    painter->setProjectionCache( &d->m_projectionCache );
+
     int painted = 0;
     foreach( GeoGraphicsItem* item, items )
     {
@@ -257,15 +266,20 @@ bool GeometryLayer::render( GeoPainter *painter, ViewportParams *viewport,
         }
     }
 
+    painter->setProjectionCache( 0 );
+
     foreach( MarbleGraphicsItem* item, d->m_items ) {
         item->paintEvent( painter, viewport );
     }
 
     painter->restore();
-    d->m_runtimeTrace = QString( "Items: %1 Drawn: %2 Zoom: %3")
+    d->m_runtimeTrace = QString( "Items: %1 Drawn: %2 Zoom: %3 Projection cache: %4 hits, %5 misses, %6 points" )
                 .arg( items.size() )
                 .arg( painted )
-                .arg( maxZoomLevel );
+                .arg( maxZoomLevel )
+                .arg( d->m_projectionCache.hits() )
+                .arg( d->m_projectionCache.misses() )
+                .arg( d->m_projectionCache.totalPoints() );
     return true;
 }
 
@@ -372,8 +386,21 @@ void GeometryLayerPrivate::createGraphicsItemFromOverlay( const GeoDataOverlay *
     }
 }
 
+void GeometryLayer::addPlacemarks( const QModelIndex &parent, int first, int last )
+{
+    // Files loaded in batches insert rows many times, so only add the new items
+    for ( int row = first; row <= last; ++row ) {
+        const GeoDataObject *object = static_cast<GeoDataObject*>( d->m_model->index( row, 0, parent ).internalPointer() );
+        if ( object ) {
+            d->createGraphicsItems( object );
+        }
+    }
+    emit repaintNeeded();
+}
+
 void GeometryLayer::invalidateScene()
 {
+    d->m_projectionCache.clear();
     d->m_scene.eraseAll();
     qDeleteAll( d->m_items );
     d->m_items.clear();
@@ -17,6 +17,7 @@
 #include "LayerInterface.h"
 
 class QAbstractItemModel;
+class QModelIndex;
 
 namespace Marble
 {
@@ -44,6 +45,9 @@ public Q_SLOTS:
 Q_SIGNALS:
     void repaintNeeded();
 
+private Q_SLOTS:
+    void addPlacemarks( const QModelIndex &parent, int first, int last );
+
 private:
     GeometryLayerPrivate *d;
 };
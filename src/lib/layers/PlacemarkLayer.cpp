@@ -20,6 +20,7 @@
 #include "AbstractProjection.h"
 #include "GeoDataStyle.h"
 #include "GeoPainter.h"
+#include "PlacemarkPixmapCache.h"
 #include "ViewportParams.h"
 #include "VisiblePlacemark.h"
 
@@ -61,6 +62,22 @@ bool PlacemarkLayer::render( GeoPainter *geoPainter, ViewportParams *viewport,
     Q_UNUSED( layer )
 
     QVector<VisiblePlacemark*> visiblePlacemarks = m_layout.generateLayout( viewport );
+
+    // Put all symbols into the atlas before painting, so that it gets
+    // converted to a pixmap once per frame rather than once per new icon.
+    // If it got cleared meanwhile, the rects resolved before are stale and
+    // get resolved once more.
+    PlacemarkPixmapCache *const pixmapCache = PlacemarkPixmapCache::instance();
+    for ( int pass = 0; pass < 2; ++pass ) {
+        const int generation = pixmapCache->generation();
+        foreach ( const VisiblePlacemark *mark, visiblePlacemarks ) {
+            mark->symbolRect();
+        }
+        if ( generation == pixmapCache->generation() ) {
+            break;
+        }
+    }
+
     // draw placemarks less important first
     QVector<VisiblePlacemark*>::const_iterator visit = visiblePlacemarks.constEnd();
     QVector<VisiblePlacemark*>::const_iterator itEnd = visiblePlacemarks.constBegin();
@@ -74,6 +91,8 @@ bool PlacemarkLayer::render( GeoPainter *geoPainter, ViewportParams *viewport,
 
         QRect labelRect( mark->labelRect().toRect() );
         QPoint symbolPos( mark->symbolPosition() );
+        const QRect symbolRect( mark->symbolRect() );
+        const QPixmap &symbolPixmap = mark->symbolPixmap();
 
         // when the map is such zoomed out that a given place
         // appears many times, we draw one placemark at each
@@ -88,11 +107,15 @@ bool PlacemarkLayer::render( GeoPainter *geoPainter, ViewportParams *viewport,
                 labelRect.moveLeft(i - symbolX + textX );
                 symbolPos.setX( i );
 
-                painter->drawPixmap( symbolPos, mark->symbolPixmap() );
+                if ( !symbolRect.isEmpty() ) {
+                    painter->drawPixmap( symbolPos, symbolPixmap, symbolRect );
+                }
                 painter->drawPixmap( labelRect, mark->labelPixmap() );
             }
         } else { // simple case, one draw per placemark
-            painter->drawPixmap( symbolPos, mark->symbolPixmap() );
+            if ( !symbolRect.isEmpty() ) {
+                painter->drawPixmap( symbolPos, symbolPixmap, symbolRect );
+            }
             painter->drawPixmap( labelRect, mark->labelPixmap() );
         }
     }
@@ -150,6 +173,11 @@ void PlacemarkLayer::requestStyleReset()
     m_layout.requestStyleReset();
 }
 
+void PlacemarkLayer::requestVisibilityUpdate()
+{
+    m_layout.requestVisibilityUpdate();
+}
+
 
 // Test if there a bug in the X server which makes 
 // text fully transparent if it gets written on 
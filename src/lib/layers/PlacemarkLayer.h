@@ -87,6 +87,7 @@ class PlacemarkLayer : public QObject, public LayerInterface
    void setShowMaria( bool show );
 
    void requestStyleReset();
+   void requestVisibilityUpdate();
 
  Q_SIGNALS:
    void repaintNeeded();
@@ -14,7 +14,9 @@
 
 #include <QtCore/qmath.h>
 #include <QtCore/QCache>
+#include <QtCore/QHash>
 #include <QtCore/QPointer>
+#include <QtCore/QSet>
 #include <QtCore/QTimer>
 
 #include "VectorTileMapper.h"
@@ -33,26 +35,19 @@
 #include "ViewportParams.h"
 #include "GeoDataTreeModel.h"
 #include "GeoDataLatLonAltBox.h"
+#include "GeoDataLinearRing.h"
+#include "GeoDataMultiGeometry.h"
+#include "GeoDataPlacemark.h"
+#include "GeoDataPolygon.h"
+#include "GeoDataTypes.h"
 
 namespace Marble
 {
 
 const int REPAINT_SCHEDULING_INTERVAL = 1000;
 
-struct CacheDocument
-{
-    /** The CacheDocument takes ownership of doc */
-    CacheDocument( GeoDataDocument* doc, GeoDataTreeModel* model );
-
-    /** Remove the document from the tree and delete the document */
-    ~CacheDocument();
-
-    GeoDataDocument* document;
-    GeoDataTreeModel* owner;
-
-private:
-    Q_DISABLE_COPY( CacheDocument )
-};
+// Parsed tiles that are not displayed any more are kept up to this many kilobytes
+const int DEFAULT_DOCUMENT_CACHE_LIMIT = 30000;
 
 class VectorTileLayer::Private
 {
@@ -66,6 +61,21 @@ public:
 
     void updateTextureLayers();
 
+    void loadTile( TileId const &stackedTileId );
+
+    void updateTileData( TileId const &tileId, GeoDataDocument *document, QString const &format );
+
+    /** Adds @p document to the tree model, it is owned by m_attachedDocuments then */
+    void attach( TileId const &tileId, GeoDataDocument *document );
+
+    /** Removes the document of @p tileId from the tree model and moves it to m_documentCache */
+    void detach( TileId const &tileId );
+
+    void detachAll();
+
+    /** Rough estimate of the memory used by @p document in kilobytes */
+    static int documentCost( const GeoDataDocument *document );
+
 public:
     VectorTileLayer  *const m_parent;
     const SunLocator *const m_sunLocator;
@@ -76,6 +86,7 @@ public:
     VectorTileMapper *m_texmapper;
     TextureColorizer *m_texcolorizer;
     QVector<const GeoSceneTiled *> m_textures;
+    QVector<const GeoSceneTiled *> m_activeTextures;
     GeoSceneGroup *m_textureLayerSettings;
 
     // For scheduling repaints
@@ -86,27 +97,21 @@ public:
     // TreeModel for displaying GeoDataDocuments
     GeoDataTreeModel *m_treeModel;
 
-    // GeoDataDocuments cache. GeoDataDocuments being displayed
-    // will be here. When map changes, if we remove one GeoDataDocument
-    // from the TreeModel and the cache, the GeoDataDocument can't be deleted
-    // because a StackedTile in TileLoader will be pointing to it not to have it
-    // already parsed if necessary. In order to delete GeoDataDocuments, we will have
-    // to notify the TileLoader.
-    QCache< GeoDataLatLonAltBox, CacheDocument> m_documents;
+    // Documents of the tiles that are in the tree model at the moment
+    QHash<TileId, GeoDataDocument *> m_attachedDocuments;
 
-};
+    // Parsed documents of all levels that are not in the tree model any more.
+    // They get attached again without parsing when their tile is needed, the
+    // least recently used ones get deleted when the cache runs full.
+    QCache<TileId, GeoDataDocument> m_documentCache;
 
-CacheDocument::CacheDocument( GeoDataDocument* doc, GeoDataTreeModel* model ) :
-    document( doc ), owner( model )
-{
-    // nothing to do
-}
+    // Tiles that missed the cache and are being loaded, so that requesting
+    // them again until they arrive does not count as another miss
+    QSet<TileId> m_pendingTiles;
 
-CacheDocument::~CacheDocument()
-{
-    Q_ASSERT( owner );
-    owner->removeDocument( document );
-}
+    int m_cacheHits;
+    int m_cacheMisses;
+};
 
 VectorTileLayer::Private::Private(HttpDownloadManager *downloadManager,
                                   const SunLocator *sunLocator,
@@ -125,6 +130,9 @@ VectorTileLayer::Private::Private(HttpDownloadManager *downloadManager,
     , m_textureLayerSettings( 0 )
     , m_repaintTimer()
     , m_treeModel( treeModel )
+    , m_documentCache( DEFAULT_DOCUMENT_CACHE_LIMIT )
+    , m_cacheHits( 0 )
+    , m_cacheMisses( 0 )
 {
 }
 
@@ -158,9 +166,138 @@ void VectorTileLayer::Private::updateTextureLayers()
         m_layerDecorator.setThemeId( "maps/" + firstTexture->sourceDir() );
     }
 
+    if ( result != m_activeTextures ) {
+        // Documents of disabled textures stay in the cache in case they come back
+        detachAll();
+        if ( m_texmapper ) {
+            m_texmapper->initTileRangeCoords();
+        }
+    }
+
+    m_activeTextures = result;
     m_tileLoader.setTextureLayers( result );
 }
 
+void VectorTileLayer::Private::loadTile( TileId const &stackedTileId )
+{
+    foreach ( const GeoSceneTiled *texture, m_activeTextures ) {
+        const TileId tileId( texture->sourceDir(), stackedTileId.zoomLevel(),
+                             stackedTileId.x(), stackedTileId.y() );
+
+        if ( m_attachedDocuments.contains( tileId ) ) {
+            continue;
+        }
+
+        GeoDataDocument *const document = m_documentCache.take( tileId );
+        if ( document ) {
+            ++m_cacheHits;
+            attach( tileId, document );
+            if ( !m_repaintTimer.isActive() ) {
+                m_repaintTimer.start();
+            }
+            continue;
+        }
+
+        // The document is delivered to updateTileData()
+        if ( !m_pendingTiles.contains( tileId ) ) {
+            m_pendingTiles.insert( tileId );
+            ++m_cacheMisses;
+        }
+        m_loader.loadTileVectorData( texture, tileId, DownloadBrowse, texture->fileFormat() );
+    }
+}
+
+void VectorTileLayer::Private::updateTileData( TileId const &tileId, GeoDataDocument *document, QString const &format )
+{
+    Q_UNUSED( format );
+
+    m_pendingTiles.remove( tileId );
+
+    // The tile was requested again while it was parsed
+    if ( m_attachedDocuments.contains( tileId ) || m_documentCache.contains( tileId ) ) {
+        delete document;
+        return;
+    }
+
+    // Tiles of other levels are kept for later. Tiles that went out of view
+    // while they were parsed get detached again by the next render().
+    if ( m_texmapper && tileId.zoomLevel() == m_texmapper->tileZoomLevel() ) {
+        attach( tileId, document );
+    } else {
+        m_documentCache.insert( tileId, document, documentCost( document ) );
+        return;
+    }
+
+    if ( !m_repaintTimer.isActive() ) {
+        m_repaintTimer.start();
+    }
+}
+
+void VectorTileLayer::Private::attach( TileId const &tileId, GeoDataDocument *document )
+{
+    m_treeModel->addDocument( document );
+    m_attachedDocuments.insert( tileId, document );
+}
+
+void VectorTileLayer::Private::detach( TileId const &tileId )
+{
+    GeoDataDocument *const document = m_attachedDocuments.take( tileId );
+    m_treeModel->removeDocument( document );
+    m_documentCache.insert( tileId, document, documentCost( document ) );
+}
+
+void VectorTileLayer::Private::detachAll()
+{
+    foreach ( const TileId &tileId, m_attachedDocuments.keys() ) {
+        detach( tileId );
+    }
+}
+
+int VectorTileLayer::Private::documentCost( const GeoDataDocument *document )
+{
+    // Counting the coordinates is cheap compared to parsing them
+    int features = 0;
+    int coordinates = 0;
+
+    QVector<const GeoDataGeometry *> geometries;
+    foreach ( const GeoDataFeature *feature, document->featureList() ) {
+        ++features;
+        if ( feature->nodeType() == GeoDataTypes::GeoDataPlacemarkType ) {
+            geometries << static_cast<const GeoDataPlacemark *>( feature )->geometry();
+        }
+    }
+
+    while ( !geometries.isEmpty() ) {
+        const GeoDataGeometry *const geometry = geometries.last();
+        geometries.pop_back();
+
+        if ( !geometry ) {
+            continue;
+        }
+
+        const char *const type = geometry->nodeType();
+        if ( type == GeoDataTypes::GeoDataLineStringType || type == GeoDataTypes::GeoDataLinearRingType ) {
+            coordinates += static_cast<const GeoDataLineString *>( geometry )->size();
+        } else if ( type == GeoDataTypes::GeoDataPolygonType ) {
+            const GeoDataPolygon *const polygon = static_cast<const GeoDataPolygon *>( geometry );
+            coordinates += polygon->outerBoundary().size();
+            foreach ( const GeoDataLinearRing &ring, polygon->innerBoundaries() ) {
+                coordinates += ring.size();
+            }
+        } else if ( type == GeoDataTypes::GeoDataMultiGeometryType ) {
+            const GeoDataMultiGeometry *const multiGeometry = static_cast<const GeoDataMultiGeometry *>( geometry );
+            for ( int i = 0; i < multiGeometry->size(); ++i ) {
+                geometries << &multiGeometry->at( i );
+            }
+        } else {
+            ++coordinates;
+        }
+    }
+
+    // A placemark with its private data and a coordinate with its private data
+    return qMax( 1, ( features * 512 + coordinates * 64 ) / 1024 );
+}
+
 VectorTileLayer::VectorTileLayer(HttpDownloadManager *downloadManager,
                                  const SunLocator *sunLocator,
                                  VectorComposer *veccomposer ,
@@ -172,17 +309,21 @@ VectorTileLayer::VectorTileLayer(HttpDownloadManager *downloadManager,
     qRegisterMetaType<TileId>( "TileId" );
     qRegisterMetaType<GeoDataDocument*>( "GeoDataDocument*" );
 
+    connect( &d->m_loader, SIGNAL( tileCompleted( TileId, GeoDataDocument*, QString ) ),
+             this, SLOT( updateTileData( TileId, GeoDataDocument*, QString ) ) );
+
+    d->m_repaintTimer.setSingleShot( true );
+    d->m_repaintTimer.setInterval( REPAINT_SCHEDULING_INTERVAL );
+    connect( &d->m_repaintTimer, SIGNAL( timeout() ),
+             this, SIGNAL( repaintNeeded() ) );
 }
 
 VectorTileLayer::~VectorTileLayer()
 {
-    foreach( GeoDataLatLonAltBox box , d->m_documents.keys() ){
-            CacheDocument * document = d->m_documents.take( box );
-            d->m_treeModel->removeDocument( document->document );
-            d->m_documents.remove( box );
-            delete document;
-        }
-    d->m_documents.clear();
+    foreach ( GeoDataDocument *document, d->m_attachedDocuments ) {
+        d->m_treeModel->removeDocument( document );
+        delete document;
+    }
     delete d->m_texmapper;
     delete d->m_texcolorizer;
     delete d;
@@ -203,17 +344,6 @@ bool VectorTileLayer::showCityLights() const
     return d->m_layerDecorator.showCityLights();
 }
 
-void VectorTileLayer::updateTile(TileId const & tileId, GeoDataDocument * document, QString const &format )
-{
-    Q_UNUSED( format );
-    Q_UNUSED( tileId );
-
-    if ( !d->m_documents.contains( document->latLonAltBox() ) ){
-        d->m_treeModel->addDocument( document );
-        d->m_documents.insert( document->latLonAltBox(), new CacheDocument( document, d->m_treeModel ) );
-    }
-}
-
 bool VectorTileLayer::render( GeoPainter *painter, ViewportParams *viewport,
                               const QString &renderPos, GeoSceneLayer *layer )
 {
@@ -256,20 +386,18 @@ bool VectorTileLayer::render( GeoPainter *painter, ViewportParams *viewport,
 
     d->m_texmapper->setTileLevel( tileLevel );
 
-    // if zoom level has changed, empty vectortile cache
+    // if zoom level has changed, take all tiles off the map, they stay in the cache
     if ( changedTileLevel ) {
-        d->m_documents.clear();
-        d->m_tileLoader.cleanupTilehash();
+        d->detachAll();
         d->m_texmapper->initTileRangeCoords();
     }
-    // else remove only tiles that are not shown on the screen
+    // else take off only tiles that are not shown on the screen
     else{
-        foreach( GeoDataLatLonAltBox box , d->m_documents.keys() )
-            if ( !box.intersects( viewport->viewLatLonAltBox() ) ){
-                CacheDocument * document = d->m_documents.take( box );
-                d->m_documents.remove( box );
-                delete document;
+        foreach ( const TileId &tileId, d->m_attachedDocuments.keys() ) {
+            if ( !d->m_attachedDocuments.value( tileId )->latLonAltBox().intersects( viewport->viewLatLonAltBox() ) ) {
+                d->detach( tileId );
             }
+        }
     }
 
     const QRect dirtyRect = QRect( QPoint( 0, 0), viewport->size() );
@@ -323,12 +451,12 @@ void VectorTileLayer::setupTextureMapper( )
     // FIXME: replace this with an approach based on the factory method pattern.
     delete d->m_texmapper;
 
-    d->m_texmapper = new VectorTileMapper( &d->m_tileLoader );
+    d->m_texmapper = new VectorTileMapper();
 
     Q_ASSERT( d->m_texmapper );
 
-    connect( d->m_texmapper, SIGNAL( tileCompleted( TileId, GeoDataDocument*, QString ) ),
-             this, SLOT( updateTile( TileId, GeoDataDocument*, QString ) ) );
+    connect( d->m_texmapper, SIGNAL( tileNeeded( TileId ) ),
+             this, SLOT( loadTile( TileId ) ) );
 }
 
 void VectorTileLayer::setNeedsUpdate()
@@ -340,24 +468,35 @@ void VectorTileLayer::setNeedsUpdate()
 
 void VectorTileLayer::setVolatileCacheLimit( quint64 kilobytes )
 {
-    d->m_tileLoader.setVolatileCacheLimit( kilobytes );
+    mDebug() << QString( "Setting vector tile cache to %1 kilobytes." ).arg( kilobytes );
+    d->m_documentCache.setMaxCost( kilobytes );
 }
 
 void VectorTileLayer::reset()
 {
-    foreach( GeoDataLatLonAltBox box , d->m_documents.keys() ){
-            CacheDocument * document = d->m_documents.take( box );
-            d->m_treeModel->removeDocument( document->document );
-            d->m_documents.remove( box );
-            delete document;
-        }
-    d->m_documents.clear();
+    foreach ( GeoDataDocument *document, d->m_attachedDocuments ) {
+        d->m_treeModel->removeDocument( document );
+        delete document;
+    }
+    d->m_attachedDocuments.clear();
+    d->m_documentCache.clear();
+    d->m_pendingTiles.clear();
     d->m_tileLoader.clear();
+
+    if ( d->m_texmapper ) {
+        d->m_texmapper->initTileRangeCoords();
+    }
 }
 
 void VectorTileLayer::reload()
 {
-    d->m_tileLoader.reloadVisibleTiles();
+    foreach ( const TileId &tileId, d->m_attachedDocuments.keys() ) {
+        foreach ( const GeoSceneTiled *texture, d->m_activeTextures ) {
+            if ( qHash( texture->sourceDir() ) == tileId.mapThemeIdHash() ) {
+                d->m_loader.downloadTile( texture, tileId, DownloadBrowse );
+            }
+        }
+    }
 }
 
 void VectorTileLayer::downloadTile( const TileId &tileId )
@@ -415,7 +554,7 @@ int VectorTileLayer::tileRowCount( int level ) const
 
 qint64 VectorTileLayer::volatileCacheLimit() const
 {
-    return d->m_tileLoader.volatileCacheLimit();
+    return d->m_documentCache.maxCost();
 }
 
 int VectorTileLayer::preferredRadiusCeil( int radius ) const
@@ -446,6 +585,16 @@ int VectorTileLayer::preferredRadiusFloor( int radius ) const
     return ( tileWidth * levelZeroColumns / 4 ) << tileLevel;
 }
 
+QString VectorTileLayer::runtimeTrace() const
+{
+    const int lookups = d->m_cacheHits + d->m_cacheMisses;
+    return QString( "Vector tiles: %1 shown, %2 cached (%3 kB), %4% hits" )
+            .arg( d->m_attachedDocuments.size() )
+            .arg( d->m_documentCache.count() )
+            .arg( d->m_documentCache.totalCost() )
+            .arg( lookups > 0 ? 100 * d->m_cacheHits / lookups : 0 );
+}
+
 }
 
 #include "VectorTileLayer.moc"
@@ -69,11 +69,17 @@ class VectorTileLayer : public QObject, public LayerInterface
     int tileColumnCount( int level ) const;
     int tileRowCount( int level ) const;
 
+    /**
+     * @brief Return the limit in kilobytes of the cache that keeps parsed
+     *        vector tiles around once they are not displayed any more.
+     */
     qint64 volatileCacheLimit() const;
 
     int preferredRadiusCeil( int radius ) const;
     int preferredRadiusFloor( int radius ) const;
 
+    virtual QString runtimeTrace() const;
+
  public Q_SLOTS:
     bool render( GeoPainter *painter, ViewportParams *viewport,
                  const QString &renderPos = "NONE", GeoSceneLayer *layer = 0 );
@@ -104,14 +110,14 @@ class VectorTileLayer : public QObject, public LayerInterface
 
     void downloadTile( const TileId &tileId );
 
-    void updateTile(TileId const & tileId, GeoDataDocument *document, QString const & format );
-
  Q_SIGNALS:
     void tileLevelChanged( int );
     void repaintNeeded();
 
  private:
     Q_PRIVATE_SLOT( d, void updateTextureLayers() )
+    Q_PRIVATE_SLOT( d, void loadTile( TileId const &stackedTileId ) )
+    Q_PRIVATE_SLOT( d, void updateTileData( TileId const &tileId, GeoDataDocument *document, QString const &format ) )
 
 
  private:
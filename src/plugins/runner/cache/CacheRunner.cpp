@@ -11,14 +11,15 @@
 
 #include "GeoDataDocument.h"
 #include "GeoDataExtendedData.h"
+#include "GeoDataLatLonBox.h"
+#include "PlacemarkCache.h"
 
+#include <QtCore/QDataStream>
 #include <QtCore/QFile>
 
 namespace Marble
 {
 
-const quint32 MarbleMagicNumber = 0x31415926;
-
 CacheRunner::CacheRunner(QObject *parent) :
     MarbleAbstractRunner(parent)
 {
@@ -42,33 +43,46 @@ void CacheRunner::parseFile( const QString &fileName, DocumentRole role = Unknow
         return;
     }
 
-    file.open( QIODevice::ReadOnly );
-    QDataStream in( &file );
-
-    // Read and check the header
-    quint32 magic;
-    in >> magic;
-    if ( magic != MarbleMagicNumber ) {
+    // Check the header
+    const qint32 version = PlacemarkCache::fileVersion( fileName );
+    if ( version == 0 ) {
         emit parsingFinished( 0 );
         return;
     }
-
-    // Read the version
-    qint32 version;
-    in >> version;
-    if ( version < 015 ) {
+    if ( version < PlacemarkCache::streamVersion ) {
         qDebug( "Bad Cache file - too old!" );
         emit parsingFinished( 0 );
         return;
     }
-    /*
-      if (version > 002) {
-      qDebug( "Bad file - too new!" );
-      return;
-      }
-    */
+    if ( version > PlacemarkCache::version ) {
+        qDebug( "Bad Cache file - too new!" );
+        emit parsingFinished( 0 );
+        return;
+    }
+
+    GeoDataDocument *document = 0;
+    if ( version == PlacemarkCache::streamVersion ) {
+        file.open( QIODevice::ReadOnly );
+        document = readStream( file );
+        file.close();
+    } else {
+        document = readMapped( fileName );
+    }
+
+    if ( document ) {
+        document->setDocumentRole( role );
+    }
+    emit parsingFinished( document );
+}
+
+GeoDataDocument *CacheRunner::readStream( QFile &file )
+{
+    QDataStream in( &file );
+    quint32 magic;
+    qint32 version;
+    in >> magic >> version;
+
     GeoDataDocument *document = new GeoDataDocument();
-    document->setDocumentRole( role );
 
     in.setVersion( QDataStream::Qt_4_2 );
 
@@ -110,8 +124,24 @@ void CacheRunner::parseFile( const QString &fileName, DocumentRole role = Unknow
         document->append( mark );
     }
 
-    file.close();
-    emit parsingFinished( document );
+    return document;
+}
+
+GeoDataDocument *CacheRunner::readMapped( const QString &fileName )
+{
+    // FileLoader only creates the placemarks that are needed, whoever parses
+    // the file gets all of them
+    PlacemarkCache cache;
+    if ( !cache.open( fileName ) ) {
+        return 0;
+    }
+
+    GeoDataDocument *document = new GeoDataDocument();
+    foreach ( GeoDataFeature *placemark, cache.materialize( cache.records( GeoDataLatLonBox(), PlacemarkCache::levelCount ) ) ) {
+        document->append( placemark );
+    }
+
+    return document;
 }
 
 }
@@ -12,6 +12,8 @@
 
 #include "MarbleAbstractRunner.h"
 
+class QFile;
+
 namespace Marble
 {
 
@@ -24,6 +26,16 @@ public:
     GeoDataFeature::GeoDataVisualCategory category() const;
     virtual void parseFile( const QString &fileName, DocumentRole role );
 
+private:
+    /**
+      * Reads the QDataStream of the first cache file version.
+      */
+    static GeoDataDocument *readStream( QFile &file );
+
+    /**
+      * Reads the current cache file version, see PlacemarkCache.h.
+      */
+    static GeoDataDocument *readMapped( const QString &fileName );
 };
 
 }
@@ -11,11 +11,12 @@
 #define MARBLEGPXRUNNER_H
 
 #include "MarbleAbstractRunner.h"
+#include "GeoParser.h"
 
 namespace Marble
 {
 
-class GpxRunner : public MarbleAbstractRunner
+class GpxRunner : public MarbleAbstractRunner, private GeoParserListener
 {
     Q_OBJECT
 public:
@@ -28,6 +29,8 @@ signals:
 
 public slots:
 
+private:
+    virtual bool documentChildParsed( GeoParser &parser );
 };
 
 }
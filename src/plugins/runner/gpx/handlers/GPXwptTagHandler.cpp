@@ -60,9 +60,8 @@ GeoNode* GPXwptTagHandler::parse(GeoParser& parser) const
         placemark->setCoordinate( lon, lat, 0, GeoDataPoint::Degree );
         placemark->setRole("Waypoint");
 
-        placemark->setStyle(&doc->style("waypoint"));
-
         doc->append(placemark);
+        placemark->setStyleUrl("#map-waypoint");
 #ifdef DEBUG_TAGS
         mDebug() << "Parsed <" << gpxTag_wpt << "> waypoint: " << doc->size();
 #endif
@@ -15,7 +15,6 @@
 #include "MarbleDebug.h"
 
 #include <QtCore/QFile>
-#include <QFileInfo>
 
 namespace Marble
 {
@@ -44,13 +43,6 @@ void JsonRunner::parseFile( const QString &fileName, DocumentRole role = Unknown
         return;
     }
 
-    // Check file extension
-    QFileInfo fileinfo( fileName );
-    if( fileinfo.suffix().compare( "js", Qt::CaseInsensitive ) != 0 ) {
-        emit parsingFinished( 0 );
-        return;
-    }
-
     // Open file in right mode
     file.open( QIODevice::ReadOnly );
 
@@ -44,6 +44,7 @@ void KmlRunner::parseFile( const QString &fileName, DocumentRole role = UnknownD
     file.open( QIODevice::ReadOnly );
 
     KmlParser parser;
+    parser.setListener( this );
 
     if ( !parser.read( &file ) ) {
         emit parsingFinished( 0, parser.errorString() );
@@ -58,6 +59,11 @@ void KmlRunner::parseFile( const QString &fileName, DocumentRole role = UnknownD
     emit parsingFinished( doc );
 }
 
+bool KmlRunner::documentChildParsed( GeoParser &parser )
+{
+    return streamFeatures( static_cast<GeoDataDocument*>( parser.activeDocument() ), parser.device() );
+}
+
 }
 
 #include "KmlRunner.moc"
@@ -11,11 +11,12 @@
 #define MARBLEKMLRUNNER_H
 
 #include "MarbleAbstractRunner.h"
+#include "GeoParser.h"
 
 namespace Marble
 {
 
-class KmlRunner : public MarbleAbstractRunner
+class KmlRunner : public MarbleAbstractRunner, private GeoParserListener
 {
     Q_OBJECT
 public:
@@ -28,6 +29,8 @@ signals:
 
 public slots:
 
+private:
+    virtual bool documentChildParsed( GeoParser &parser );
 };
 
 }
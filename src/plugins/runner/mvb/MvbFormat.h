@@ -0,0 +1,74 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_MVBFORMAT_H
+#define MARBLE_MVBFORMAT_H
+
+#include <QtCore/QtGlobal>
+
+/**
+ * Marble Vector Binary (.mvb) is a compact encoding of vector tiles.
+ *
+ * All integers are unsigned LEB128 varints, signed ones are zigzag encoded
+ * first. Strings are referenced by their index in the string table plus one,
+ * zero stands for no string.
+ *
+ *   magic            "MVB" followed by the version byte
+ *   string count     then each string as byte length and UTF-8 bytes
+ *   document name    string reference
+ *   feature count    then the placemarks, see below
+ *
+ * A placemark consists of
+ *
+ *   geometry type    one byte, see Mvb::GeometryType
+ *   name             string reference
+ *   visual category  GeoDataFeature::GeoDataVisualCategory
+ *   tag count        then pairs of key and value string references
+ *   tessellation     one byte of TessellationFlags, not for points
+ *   coordinates      a point is a single coordinate, line strings and rings
+ *                    start with their node count, polygons with their ring
+ *                    count followed by the outer and inner rings
+ *
+ * Coordinates are longitude and latitude in units of 1e-7 degrees, each
+ * stored as the signed difference to the previous coordinate of the file.
+ */
+
+namespace Marble
+{
+
+namespace Mvb
+{
+
+const char magic[] = { 'M', 'V', 'B' };
+const quint8 version = 1;
+
+enum GeometryType {
+    Point = 1,
+    LineString = 2,
+    LinearRing = 3,
+    Polygon = 4
+};
+
+// Degrees per coordinate unit
+const double coordinateUnit = 1e-7;
+
+inline quint64 zigzagEncode( qint64 value )
+{
+    return ( quint64( value ) << 1 ) ^ quint64( value >> 63 );
+}
+
+inline qint64 zigzagDecode( quint64 value )
+{
+    return qint64( value >> 1 ) ^ -qint64( value & 1 );
+}
+
+}
+
+}
+
+#endif
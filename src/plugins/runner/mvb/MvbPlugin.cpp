@@ -0,0 +1,69 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "MvbPlugin.h"
+#include "MvbRunner.h"
+
+namespace Marble
+{
+
+MvbPlugin::MvbPlugin( QObject *parent ) :
+    ParseRunnerPlugin( parent )
+{
+}
+
+QString MvbPlugin::name() const
+{
+    return tr( "Marble Vector Binary File Parser" );
+}
+
+QString MvbPlugin::nameId() const
+{
+    return "Mvb";
+}
+
+QString MvbPlugin::version() const
+{
+    return "1.0";
+}
+
+QString MvbPlugin::description() const
+{
+    return tr( "Create GeoDataDocument from Marble Vector Binary Files" );
+}
+
+QString MvbPlugin::copyrightYears() const
+{
+    return "2012";
+}
+
+QList<PluginAuthor> MvbPlugin::pluginAuthors() const
+{
+    return QList<PluginAuthor>();
+}
+
+QString MvbPlugin::fileFormatDescription() const
+{
+    return tr( "Marble Vector Binary Tiles" );
+}
+
+QStringList MvbPlugin::fileExtensions() const
+{
+    return QStringList() << "mvb";
+}
+
+MarbleAbstractRunner* MvbPlugin::newRunner() const
+{
+    return new MvbRunner;
+}
+
+}
+
+Q_EXPORT_PLUGIN2( MvbPlugin, Marble::MvbPlugin )
+
+#include "MvbPlugin.moc"
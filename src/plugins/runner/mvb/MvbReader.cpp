@@ -0,0 +1,237 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "MvbReader.h"
+
+#include "MvbFormat.h"
+
+#include "GeoDataDocument.h"
+#include "GeoDataExtendedData.h"
+#include "GeoDataData.h"
+#include "GeoDataLinearRing.h"
+#include "GeoDataPlacemark.h"
+#include "GeoDataPoint.h"
+#include "GeoDataPolygon.h"
+#include "MarbleGlobal.h"
+
+namespace Marble
+{
+
+// Radians per coordinate unit
+static const qreal unitToRadian = Mvb::coordinateUnit * DEG2RAD;
+
+MvbReader::MvbReader()
+    : m_position( 0 ),
+      m_end( 0 ),
+      m_lon( 0 ),
+      m_lat( 0 )
+{
+}
+
+GeoDataDocument *MvbReader::read( const QByteArray &data )
+{
+    m_position = reinterpret_cast<const uchar *>( data.constData() );
+    m_end = m_position + data.size();
+    m_errorString.clear();
+    m_strings.clear();
+    m_lon = 0;
+    m_lat = 0;
+
+    if ( data.size() < int( sizeof( Mvb::magic ) ) + 1
+         || qstrncmp( data.constData(), Mvb::magic, sizeof( Mvb::magic ) ) != 0 ) {
+        setError( "Not a Marble Vector Binary file" );
+        return 0;
+    }
+    m_position += sizeof( Mvb::magic );
+
+    if ( *m_position++ != Mvb::version ) {
+        setError( QString( "Unsupported version %1" ).arg( m_position[-1] ) );
+        return 0;
+    }
+
+    const int stringCount = readCount();
+    m_strings.reserve( stringCount );
+    for ( int i = 0; i < stringCount; ++i ) {
+        const int size = readCount();
+        m_strings << QString::fromUtf8( reinterpret_cast<const char *>( m_position ), size );
+        m_position += size;
+    }
+
+    GeoDataDocument *const document = new GeoDataDocument;
+    document->setName( readString() );
+
+    const int featureCount = readCount();
+    document->reserve( featureCount );
+    for ( int i = 0; i < featureCount && m_errorString.isEmpty(); ++i ) {
+        GeoDataPlacemark *const placemark = readPlacemark();
+        if ( placemark ) {
+            document->append( placemark );
+        }
+    }
+
+    if ( !m_errorString.isEmpty() ) {
+        delete document;
+        return 0;
+    }
+
+    return document;
+}
+
+QString MvbReader::errorString() const
+{
+    return m_errorString;
+}
+
+GeoDataPlacemark *MvbReader::readPlacemark()
+{
+    if ( m_position == m_end ) {
+        setError( "Unexpected end of file" );
+        return 0;
+    }
+
+    const int geometryType = *m_position++;
+
+    GeoDataPlacemark *const placemark = new GeoDataPlacemark;
+    placemark->setName( readString() );
+
+    // Categories this version does not know of, or garbage, are shown as default
+    const quint64 visualCategory = readVarint();
+    placemark->setVisualCategory( visualCategory < quint64( GeoDataFeature::LastIndex )
+                                  ? GeoDataFeature::GeoDataVisualCategory( visualCategory )
+                                  : GeoDataFeature::Default );
+
+    const int tagCount = readCount();
+    if ( tagCount > 0 ) {
+        GeoDataExtendedData extendedData;
+        for ( int i = 0; i < tagCount; ++i ) {
+            const QString key = readString();
+            extendedData.addValue( GeoDataData( key, readString() ) );
+        }
+        placemark->setExtendedData( extendedData );
+    }
+
+    if ( geometryType == Mvb::Point ) {
+        placemark->setGeometry( new GeoDataPoint( readCoordinates() ) );
+        return placemark;
+    }
+
+    if ( m_position == m_end ) {
+        setError( "Unexpected end of file" );
+        delete placemark;
+        return 0;
+    }
+
+    const TessellationFlags flags( QFlag( *m_position++ ) );
+
+    switch ( geometryType ) {
+    case Mvb::LineString: {
+        GeoDataLineString *const lineString = new GeoDataLineString( flags );
+        readLineString( *lineString );
+        placemark->setGeometry( lineString );
+        break;
+    }
+    case Mvb::LinearRing: {
+        GeoDataLinearRing *const linearRing = new GeoDataLinearRing( flags );
+        readLineString( *linearRing );
+        placemark->setGeometry( linearRing );
+        break;
+    }
+    case Mvb::Polygon: {
+        GeoDataPolygon *const polygon = new GeoDataPolygon( flags );
+        const int ringCount = readCount();
+        if ( ringCount > 0 ) {
+            readLineString( polygon->outerBoundary() );
+        }
+        for ( int i = 1; i < ringCount; ++i ) {
+            GeoDataLinearRing ring( flags );
+            readLineString( ring );
+            polygon->appendInnerBoundary( ring );
+        }
+        placemark->setGeometry( polygon );
+        break;
+    }
+    default:
+        setError( QString( "Unknown geometry type %1" ).arg( geometryType ) );
+        delete placemark;
+        return 0;
+    }
+
+    return placemark;
+}
+
+void MvbReader::readLineString( GeoDataLineString &lineString )
+{
+    const int size = readCount();
+    lineString.reserve( size );
+    for ( int i = 0; i < size; ++i ) {
+        lineString.append( readCoordinates() );
+    }
+}
+
+GeoDataCoordinates MvbReader::readCoordinates()
+{
+    m_lon += Mvb::zigzagDecode( readVarint() );
+    m_lat += Mvb::zigzagDecode( readVarint() );
+
+    return GeoDataCoordinates( m_lon * unitToRadian, m_lat * unitToRadian );
+}
+
+QString MvbReader::readString()
+{
+    const quint64 reference = readVarint();
+    if ( reference == 0 ) {
+        return QString();
+    }
+
+    if ( reference > quint64( m_strings.size() ) ) {
+        setError( QString( "Invalid string reference %1" ).arg( reference ) );
+        return QString();
+    }
+
+    return m_strings.at( reference - 1 );
+}
+
+quint64 MvbReader::readVarint()
+{
+    quint64 value = 0;
+    for ( int shift = 0; m_position != m_end && shift < 64; shift += 7 ) {
+        const uchar byte = *m_position++;
+        value |= quint64( byte & 0x7f ) << shift;
+        if ( !( byte & 0x80 ) ) {
+            return value;
+        }
+    }
+
+    setError( "Unexpected end of file" );
+    return 0;
+}
+
+int MvbReader::readCount()
+{
+    // Every counted item takes at least one byte, which keeps broken files
+    // from reserving huge amounts of memory
+    const quint64 count = readVarint();
+    if ( count > quint64( m_end - m_position ) ) {
+        setError( "Unexpected end of file" );
+        return 0;
+    }
+
+    return int( count );
+}
+
+void MvbReader::setError( const QString &errorString )
+{
+    if ( m_errorString.isEmpty() ) {
+        m_errorString = errorString;
+    }
+
+    // Stop reading
+    m_position = m_end;
+}
+
+}
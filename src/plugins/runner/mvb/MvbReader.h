@@ -0,0 +1,62 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_MVBREADER_H
+#define MARBLE_MVBREADER_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QString>
+#include <QtCore/QVector>
+
+namespace Marble
+{
+
+class GeoDataCoordinates;
+class GeoDataDocument;
+class GeoDataLineString;
+class GeoDataPlacemark;
+
+/**
+ * Decodes documents in the Marble Vector Binary format, see MvbFormat.h.
+ *
+ * The containers of the document and its geometries are sized from the counts
+ * stored in the file before they get filled.
+ */
+class MvbReader
+{
+ public:
+    MvbReader();
+
+    /**
+     * Returns the document encoded in @p data, or 0 if @p data is not a
+     * valid file. The caller takes ownership of the document.
+     */
+    GeoDataDocument *read( const QByteArray &data );
+
+    QString errorString() const;
+
+ private:
+    GeoDataPlacemark *readPlacemark();
+    void readLineString( GeoDataLineString &lineString );
+    GeoDataCoordinates readCoordinates();
+    QString readString();
+    quint64 readVarint();
+    int readCount();
+    void setError( const QString &errorString );
+
+    const uchar *m_position;
+    const uchar *m_end;
+    QString m_errorString;
+    QVector<QString> m_strings;
+    qint64 m_lon;
+    qint64 m_lat;
+};
+
+}
+
+#endif
@@ -0,0 +1,62 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "MvbRunner.h"
+
+#include "MvbReader.h"
+
+#include "GeoDataDocument.h"
+#include "MarbleDebug.h"
+
+#include <QtCore/QFile>
+
+namespace Marble
+{
+
+MvbRunner::MvbRunner( QObject *parent ) :
+    MarbleAbstractRunner( parent )
+{
+}
+
+MvbRunner::~MvbRunner()
+{
+}
+
+GeoDataFeature::GeoDataVisualCategory MvbRunner::category() const
+{
+    return GeoDataFeature::Folder;
+}
+
+void MvbRunner::parseFile( const QString &fileName, DocumentRole role = UnknownDocument )
+{
+    QFile file( fileName );
+    if ( !file.open( QIODevice::ReadOnly ) ) {
+        emit parsingFinished( 0, file.errorString() );
+        return;
+    }
+
+    // Decode straight from the mapped file if possible
+    const uchar *const mapped = file.map( 0, file.size() );
+    const QByteArray data = mapped ? QByteArray::fromRawData( reinterpret_cast<const char *>( mapped ), file.size() )
+                                   : file.readAll();
+
+    MvbReader reader;
+    GeoDataDocument *const document = reader.read( data );
+    if ( !document ) {
+        mDebug() << Q_FUNC_INFO << fileName << reader.errorString();
+        emit parsingFinished( 0, reader.errorString() );
+        return;
+    }
+
+    document->setDocumentRole( role );
+    emit parsingFinished( document );
+}
+
+}
+
+#include "MvbRunner.moc"
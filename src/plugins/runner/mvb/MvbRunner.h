@@ -0,0 +1,28 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_MVBRUNNER_H
+#define MARBLE_MVBRUNNER_H
+
+#include "MarbleAbstractRunner.h"
+
+namespace Marble
+{
+
+class MvbRunner : public MarbleAbstractRunner
+{
+    Q_OBJECT
+public:
+    explicit MvbRunner( QObject *parent = 0 );
+    ~MvbRunner();
+    GeoDataFeature::GeoDataVisualCategory category() const;
+    virtual void parseFile( const QString &fileName, DocumentRole role );
+};
+
+}
+#endif // MARBLE_MVBRUNNER_H
@@ -0,0 +1,220 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "MvbWriter.h"
+
+#include "MvbFormat.h"
+
+#include "GeoDataDocument.h"
+#include "GeoDataExtendedData.h"
+#include "GeoDataData.h"
+#include "GeoDataLinearRing.h"
+#include "GeoDataMultiGeometry.h"
+#include "GeoDataMultiTrack.h"
+#include "GeoDataPlacemark.h"
+#include "GeoDataPoint.h"
+#include "GeoDataPolygon.h"
+#include "GeoDataTrack.h"
+#include "GeoDataTypes.h"
+
+#include <QtCore/QIODevice>
+
+namespace Marble
+{
+
+MvbWriter::MvbWriter()
+    : m_featureCount( 0 ),
+      m_skippedCount( 0 ),
+      m_lon( 0 ),
+      m_lat( 0 )
+{
+}
+
+bool MvbWriter::write( QIODevice *device, const GeoDataDocument &document )
+{
+    m_features.clear();
+    m_featureCount = 0;
+    m_skippedCount = 0;
+    m_strings.clear();
+    m_stringIndex.clear();
+    m_lon = 0;
+    m_lat = 0;
+
+    // The string table goes first, so encode everything else before
+    writeString( document.name() );
+    QByteArray const name = m_features;
+    m_features.clear();
+
+    writeContainer( document );
+
+    QByteArray header( Mvb::magic, sizeof( Mvb::magic ) );
+    header.append( char( Mvb::version ) );
+
+    writeVarint( header, m_strings.size() );
+    foreach ( const QString &string, m_strings ) {
+        const QByteArray utf8 = string.toUtf8();
+        writeVarint( header, utf8.size() );
+        header.append( utf8 );
+    }
+
+    header.append( name );
+    writeVarint( header, m_featureCount );
+
+    return device->write( header ) == header.size()
+        && device->write( m_features ) == m_features.size();
+}
+
+int MvbWriter::skippedCount() const
+{
+    return m_skippedCount;
+}
+
+void MvbWriter::writeContainer( const GeoDataContainer &container )
+{
+    foreach ( const GeoDataFeature *feature, container.featureList() ) {
+        if ( feature->nodeType() == GeoDataTypes::GeoDataPlacemarkType ) {
+            writePlacemark( *static_cast<const GeoDataPlacemark *>( feature ) );
+        } else if ( const GeoDataContainer *child = dynamic_cast<const GeoDataContainer *>( feature ) ) {
+            writeContainer( *child );
+        }
+    }
+}
+
+void MvbWriter::writePlacemark( const GeoDataPlacemark &placemark )
+{
+    if ( writeGeometry( placemark, placemark.geometry() ) == 0 ) {
+        ++m_skippedCount;
+    }
+}
+
+int MvbWriter::writeGeometry( const GeoDataPlacemark &placemark, const GeoDataGeometry *geometry )
+{
+    if ( !geometry ) {
+        return 0;
+    }
+
+    const char *const type = geometry->nodeType();
+    if ( type == GeoDataTypes::GeoDataMultiGeometryType ) {
+        const GeoDataMultiGeometry *const multiGeometry = static_cast<const GeoDataMultiGeometry *>( geometry );
+        int count = 0;
+        for ( int i = 0; i < multiGeometry->size(); ++i ) {
+            count += writeGeometry( placemark, &multiGeometry->at( i ) );
+        }
+        return count;
+    }
+    if ( type == GeoDataTypes::GeoDataMultiTrackType ) {
+        const GeoDataMultiTrack *const multiTrack = static_cast<const GeoDataMultiTrack *>( geometry );
+        int count = 0;
+        for ( int i = 0; i < multiTrack->size(); ++i ) {
+            count += writeGeometry( placemark, &multiTrack->at( i ) );
+        }
+        return count;
+    }
+    if ( type == GeoDataTypes::GeoDataTrackType ) {
+        return writeGeometry( placemark, static_cast<const GeoDataTrack *>( geometry )->lineString() );
+    }
+
+    Mvb::GeometryType geometryType;
+    if ( type == GeoDataTypes::GeoDataPointType ) {
+        geometryType = Mvb::Point;
+    } else if ( type == GeoDataTypes::GeoDataLineStringType ) {
+        geometryType = Mvb::LineString;
+    } else if ( type == GeoDataTypes::GeoDataLinearRingType ) {
+        geometryType = Mvb::LinearRing;
+    } else if ( type == GeoDataTypes::GeoDataPolygonType ) {
+        geometryType = Mvb::Polygon;
+    } else {
+        return 0;
+    }
+
+    m_features.append( char( geometryType ) );
+    writeString( placemark.name() );
+    writeVarint( m_features, placemark.visualCategory() );
+
+    const GeoDataExtendedData &extendedData = placemark.extendedData();
+    writeVarint( m_features, extendedData.size() );
+    QHash<QString, GeoDataData>::const_iterator it = extendedData.constBegin();
+    for ( ; it != extendedData.constEnd(); ++it ) {
+        writeString( it.key() );
+        writeString( it.value().value().toString() );
+    }
+
+    switch ( geometryType ) {
+    case Mvb::Point:
+        writeCoordinates( *static_cast<const GeoDataPoint *>( geometry ) );
+        break;
+    case Mvb::LineString:
+    case Mvb::LinearRing: {
+        const GeoDataLineString *const lineString = static_cast<const GeoDataLineString *>( geometry );
+        m_features.append( char( lineString->tessellationFlags() ) );
+        writeLineString( *lineString );
+        break;
+    }
+    case Mvb::Polygon: {
+        const GeoDataPolygon *const polygon = static_cast<const GeoDataPolygon *>( geometry );
+        m_features.append( char( polygon->tessellationFlags() ) );
+        writeVarint( m_features, 1 + polygon->innerBoundaries().size() );
+        writeLineString( polygon->outerBoundary() );
+        foreach ( const GeoDataLinearRing &ring, polygon->innerBoundaries() ) {
+            writeLineString( ring );
+        }
+        break;
+    }
+    }
+
+    ++m_featureCount;
+    return 1;
+}
+
+void MvbWriter::writeLineString( const GeoDataLineString &lineString )
+{
+    writeVarint( m_features, lineString.size() );
+    QVector<GeoDataCoordinates>::const_iterator it = lineString.constBegin();
+    for ( ; it != lineString.constEnd(); ++it ) {
+        writeCoordinates( *it );
+    }
+}
+
+void MvbWriter::writeCoordinates( const GeoDataCoordinates &coordinates )
+{
+    const qint64 lon = qRound64( coordinates.longitude( GeoDataCoordinates::Degree ) / Mvb::coordinateUnit );
+    const qint64 lat = qRound64( coordinates.latitude( GeoDataCoordinates::Degree ) / Mvb::coordinateUnit );
+
+    writeVarint( m_features, Mvb::zigzagEncode( lon - m_lon ) );
+    writeVarint( m_features, Mvb::zigzagEncode( lat - m_lat ) );
+
+    m_lon = lon;
+    m_lat = lat;
+}
+
+void MvbWriter::writeString( const QString &string )
+{
+    if ( string.isEmpty() ) {
+        writeVarint( m_features, 0 );
+        return;
+    }
+
+    QHash<QString, int>::const_iterator it = m_stringIndex.constFind( string );
+    if ( it == m_stringIndex.constEnd() ) {
+        it = m_stringIndex.insert( string, m_strings.size() );
+        m_strings << string;
+    }
+
+    writeVarint( m_features, it.value() + 1 );
+}
+
+void MvbWriter::writeVarint( QByteArray &data, quint64 value )
+{
+    while ( value >= 0x80 ) {
+        data.append( char( ( value & 0x7f ) | 0x80 ) );
+        value >>= 7;
+    }
+    data.append( char( value ) );
+}
+
+}
@@ -0,0 +1,79 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_MVBWRITER_H
+#define MARBLE_MVBWRITER_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QHash>
+#include <QtCore/QStringList>
+
+class QIODevice;
+
+namespace Marble
+{
+
+class GeoDataContainer;
+class GeoDataCoordinates;
+class GeoDataDocument;
+class GeoDataGeometry;
+class GeoDataLineString;
+class GeoDataPlacemark;
+
+/**
+ * Encodes documents in the Marble Vector Binary format, see MvbFormat.h.
+ *
+ * Placemarks of nested folders end up in the top level of the result.
+ * A placemark with a multi geometry or multi track becomes one placemark
+ * per part, and tracks become line strings. Placemarks without any
+ * geometry that can be encoded are left out and counted, see
+ * skippedCount(). Styles and altitudes are left out as well.
+ */
+class MvbWriter
+{
+ public:
+    MvbWriter();
+
+    /**
+     * Writes @p document to @p device. Returns false if writing failed.
+     */
+    bool write( QIODevice *device, const GeoDataDocument &document );
+
+    /**
+     * Returns the number of placemarks the last write() left out because
+     * their geometry cannot be encoded.
+     */
+    int skippedCount() const;
+
+ private:
+    void writeContainer( const GeoDataContainer &container );
+    void writePlacemark( const GeoDataPlacemark &placemark );
+
+    /**
+     * Writes @p placemark with @p geometry, one of its parts. Returns the
+     * number of features written, which is 0 if @p geometry is not supported.
+     */
+    int writeGeometry( const GeoDataPlacemark &placemark, const GeoDataGeometry *geometry );
+    void writeLineString( const GeoDataLineString &lineString );
+    void writeCoordinates( const GeoDataCoordinates &coordinates );
+    void writeString( const QString &string );
+
+    static void writeVarint( QByteArray &data, quint64 value );
+
+    QByteArray m_features;
+    int m_featureCount;
+    int m_skippedCount;
+    QStringList m_strings;
+    QHash<QString, int> m_stringIndex;
+    qint64 m_lon;
+    qint64 m_lat;
+};
+
+}
+
+#endif
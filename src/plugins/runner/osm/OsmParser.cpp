@@ -10,25 +10,46 @@
 #include "OsmParser.h"
 #include "OsmElementDictionary.h"
 #include "GeoDataDocument.h"
-
-#include "OsmNodeFactory.h"
-#include "OsmWayFactory.h"
-#include "OsmRelationFactory.h"
-#include "OsmGlobals.h"
+#include "GeoDataPlacemark.h"
+#include "GeoDataPoint.h"
 
 namespace Marble {
 
 OsmParser::OsmParser()
-    : GeoParser( 0 )
+    : GeoParser( 0 ),
+      m_nodePoint( new GeoDataPoint )
 {
 }
 
 OsmParser::~OsmParser()
 {
-    osm::OsmRelationFactory::clear();
-    osm::OsmWayFactory::clear();
-    osm::OsmNodeFactory::clear();
-    osm::OsmGlobals::cleanUpDummyPlacemarks();
+    delete m_nodePoint;
+    qDeleteAll( m_dummyPlacemarks );
+}
+
+osm::OsmNodeFactory &OsmParser::nodes()
+{
+    return m_nodes;
+}
+
+osm::OsmWayFactory &OsmParser::ways()
+{
+    return m_ways;
+}
+
+osm::OsmRelationFactory &OsmParser::relations()
+{
+    return m_relations;
+}
+
+GeoDataPoint *OsmParser::nodePoint()
+{
+    return m_nodePoint;
+}
+
+void OsmParser::addDummyPlacemark( GeoDataPlacemark *placemark )
+{
+    m_dummyPlacemarks << placemark;
 }
 
 bool OsmParser::isValidRootElement()
@@ -12,20 +12,54 @@
 
 #include "GeoParser.h"
 
+#include "OsmNodeFactory.h"
+#include "OsmWayFactory.h"
+#include "OsmRelationFactory.h"
+
+#include <QtCore/QList>
+
 namespace Marble {
 
+class GeoDataPlacemark;
+class GeoDataPoint;
+
+/**
+ * Parses OSM XML files. The elements of a file refer to each other by id,
+ * the parser keeps what they need for their lookups until it is destroyed.
+ */
 class OsmParser : public GeoParser
 {
 public:
     OsmParser();
     virtual ~OsmParser();
 
+    osm::OsmNodeFactory &nodes();
+    osm::OsmWayFactory &ways();
+    osm::OsmRelationFactory &relations();
+
+    /**
+     * Returns the point of the node that is being parsed, which gets
+     * reused for every node.
+     */
+    GeoDataPoint *nodePoint();
+
+    /**
+     * Takes ownership of @p placemark, which has been replaced in the
+     * document but may still be referred to while parsing.
+     */
+    void addDummyPlacemark( GeoDataPlacemark *placemark );
+
 private:
     virtual bool isValidElement(const QString& tagName) const;
     virtual bool isValidRootElement();
 
     virtual GeoDocument* createDocument() const;
 
+    osm::OsmNodeFactory m_nodes;
+    osm::OsmWayFactory m_ways;
+    osm::OsmRelationFactory m_relations;
+    GeoDataPoint *m_nodePoint;
+    QList<GeoDataPlacemark*> m_dummyPlacemarks;
 };
 
 }
@@ -10,9 +10,11 @@
 #include "OsmRunner.h"
 
 #include "GeoDataDocument.h"
+#include "MarbleDebug.h"
 #include "OsmParser.h"
 
 #include <QtCore/QFile>
+#include <QtCore/QTime>
 
 namespace Marble
 {
@@ -45,10 +47,17 @@ void OsmRunner::parseFile( const QString &fileName, DocumentRole role = UnknownD
 
     OsmParser parser;
 
+    QTime time;
+    time.start();
     if ( !parser.read( &file ) ) {
         emit parsingFinished( 0, parser.errorString() );
         return;
     }
+
+    const int elapsed = qMax( 1, time.elapsed() );
+    const int nodes = parser.nodes().size();
+    mDebug() << "Parsed" << fileName << "with" << file.size() / 1048576.0 * 1000 / elapsed << "MB/s,"
+             << nodes << "nodes take" << ( nodes > 0 ? parser.nodes().memoryUsage() / nodes : 0 ) << "bytes each";
     GeoDocument* document = parser.releaseDocument();
     Q_ASSERT( document );
     GeoDataDocument* doc = static_cast<GeoDataDocument*>( document );
@@ -19,8 +19,9 @@
 
 namespace Marble
 {
+class GeoDataLineString;
+class GeoDataPolygon;
 class GeoDataStyle;
-class GeoDataPlacemark;
 
 namespace osm
 {
@@ -29,18 +30,19 @@ class OsmGlobals
 {
 public:
     static bool tagNeedArea( const QString& keyValue );
-    static void addDummyPlacemark( GeoDataPlacemark *placemark );
-    static void cleanUpDummyPlacemarks();
+
+    /**
+     * Joins the outer way @p line of a multipolygon relation to the outer
+     * boundary of @p polygon.
+     */
+    static void appendOuterWay( GeoDataPolygon *polygon, const GeoDataLineString &line );
 
     static QColor buildingColor;
     static QColor backgroundColor;
 
 private:
     static void setupCategories();
-    static void setupAreaTags();
-    
-    static QList<QString> m_areaTags;
-    static QList<GeoDataPlacemark*> dummyPlacemarks;
+    static QList<QString> setupAreaTags();
 };
 
 }
@@ -11,7 +11,7 @@
 #include "OsmNdTagHandler.h"
 
 #include "GeoParser.h"
-#include "OsmNodeFactory.h"
+#include "OsmParser.h"
 #include "GeoDataDocument.h"
 #include "GeoDataPlacemark.h"
 #include "GeoDataParser.h"
@@ -38,10 +38,11 @@ GeoNode* OsmNdTagHandler::parse( GeoParser& parser ) const
     {
         GeoDataLineString *s = parentItem.nodeAs<GeoDataLineString>();
         Q_ASSERT( s );
-        quint64 id = parser.attribute( "ref" ).toULongLong();
-        if ( GeoDataPoint *p = osm::OsmNodeFactory::getPoint( id ) )
+        qint64 id = parser.attribute( "ref" ).toLongLong();
+        GeoDataCoordinates coordinates;
+        if ( static_cast<OsmParser &>( parser ).nodes().coordinates( id, coordinates ) )
         {
-            s->append( GeoDataCoordinates( p->longitude(), p->latitude() ) );
+            s->append( coordinates );
         }
 
         return 0;
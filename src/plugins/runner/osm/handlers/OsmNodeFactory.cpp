@@ -9,35 +9,93 @@
 //
 
 #include "OsmNodeFactory.h"
-#include "GeoDataPoint.h"
+
+#include "GeoDataCoordinates.h"
+#include "MarbleGlobal.h"
+
+#include <QtCore/QtAlgorithms>
 
 namespace Marble
 {
 namespace osm
 {
-QMap<quint64, GeoDataPoint *> OsmNodeFactory::m_points;
 
-// This is a class for keeping all the nodes accesible
-// for when needed by ways. Ways have only the ids of
-// nodes so with that id the GeoDataPoint is returned
+// Radians per coordinate unit
+static const qreal unitToRadian = 1e-7 * DEG2RAD;
 
-void OsmNodeFactory::appendPoint( quint64 id, GeoDataPoint* p )
+static bool lessThan( const OsmNode &node1, const OsmNode &node2 )
 {
-    m_points[id] = p;
+    return node1.id < node2.id;
 }
 
-GeoDataPoint* OsmNodeFactory::getPoint( quint64 id )
+OsmNodeFactory::OsmNodeFactory()
+    : m_sorted( true )
 {
-    return m_points.value( id );
+}
+
+void OsmNodeFactory::appendNode( qint64 id, qreal lon, qreal lat )
+{
+    // Files written by the OSM servers are sorted, edited ones need not be
+    if ( !m_nodes.isEmpty() && id <= m_nodes.last().id ) {
+        m_sorted = false;
+    }
+
+    OsmNode node;
+    node.id = id;
+    node.lon = qRound( lon * 1e7 );
+    node.lat = qRound( lat * 1e7 );
+    m_nodes.append( node );
+}
+
+bool OsmNodeFactory::coordinates( qint64 id, GeoDataCoordinates &coordinates )
+{
+    if ( !m_sorted ) {
+        sort();
+    }
+
+    OsmNode key;
+    key.id = id;
+    const QVector<OsmNode>::const_iterator it = qLowerBound( m_nodes.constBegin(), m_nodes.constEnd(), key, lessThan );
+    if ( it == m_nodes.constEnd() || it->id != id ) {
+        return false;
+    }
+
+    coordinates.set( it->lon * unitToRadian, it->lat * unitToRadian );
+    return true;
+}
+
+int OsmNodeFactory::size() const
+{
+    return m_nodes.size();
+}
+
+qint64 OsmNodeFactory::memoryUsage() const
+{
+    return qint64( m_nodes.capacity() ) * sizeof( OsmNode );
 }
 
 void OsmNodeFactory::clear()
 {
-    foreach( GeoDataPoint *p, m_points )
-    {
-        delete p;
+    m_nodes.clear();
+    m_sorted = true;
+}
+
+void OsmNodeFactory::sort()
+{
+    qStableSort( m_nodes.begin(), m_nodes.end(), lessThan );
+
+    // A node appearing twice was changed, keep its last version
+    int size = 0;
+    for ( int i = 0; i < m_nodes.size(); ++i ) {
+        if ( size > 0 && m_nodes[size - 1].id == m_nodes[i].id ) {
+            m_nodes[size - 1] = m_nodes[i];
+        } else {
+            m_nodes[size++] = m_nodes[i];
+        }
     }
-    m_points.clear();
+    m_nodes.resize( size );
+
+    m_sorted = true;
 }
 
 }
@@ -11,35 +11,73 @@
 #ifndef MARBLE_OSMNODEFACTORY_H
 #define MARBLE_OSMNODEFACTORY_H
 
-#include <QMap>
+#include <QtCore/QVector>
 
 namespace Marble
 {
 
-class GeoDataPoint;
+class GeoDataCoordinates;
 
 namespace osm
 {
 
-// This is a class for keeping all the nodes accesible
-// for when needed by ways. Ways have only the ids of
-// nodes so with that id the GeoDataPoint is returned
+/**
+ * A node with its coordinates in units of 10^-7 degrees, the precision
+ * OSM stores them with.
+ */
+struct OsmNode
+{
+    qint64 id;
+    qint32 lon;
+    qint32 lat;
+};
+
+}
+}
+
+Q_DECLARE_TYPEINFO( Marble::osm::OsmNode, Q_PRIMITIVE_TYPE );
+
+namespace Marble
+{
+namespace osm
+{
 
+/**
+ * Keeps the nodes of a file in an array sorted by id, so each of them takes
+ * just 16 bytes. Coordinates only get created for the nodes ways refer to.
+ */
 class OsmNodeFactory
 {
 public:
-    static void appendPoint( quint64 id, GeoDataPoint *p );
-    static GeoDataPoint *getPoint( quint64 id );
+    OsmNodeFactory();
+
+    void appendNode( qint64 id, qreal lon, qreal lat );
+
+    /**
+     * @brief Look up a node
+     * Sets @p coordinates to the position of node @p id.
+     * @return false if there is no such node
+     */
+    bool coordinates( qint64 id, GeoDataCoordinates &coordinates );
+
+    int size() const;
+
+    /**
+     * Returns the number of bytes taken by the nodes.
+     */
+    qint64 memoryUsage() const;
 
     /**
      * @brief Clean up nodes
      * Removes all nodes from factory.
-     * This function must be called only after file loaded.
      */
-    static void clear();
+    void clear();
 
 private:
-    static QMap<quint64, GeoDataPoint *> m_points;
+    void sort();
+
+    QVector<OsmNode> m_nodes;
+    bool m_sorted;
 };
 
 }
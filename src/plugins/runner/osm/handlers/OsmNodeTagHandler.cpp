@@ -13,7 +13,7 @@
 #include "GeoParser.h"
 #include "GeoDataPoint.h"
 #include "MarbleDebug.h"
-#include "OsmNodeFactory.h"
+#include "OsmParser.h"
 #include "GeoDataDocument.h"
 #include "GeoDataPlacemark.h"
 #include "GeoDataParser.h"
@@ -37,8 +37,14 @@ GeoNode* OsmNodeTagHandler::parse( GeoParser& parser ) const
     qreal lon = parser.attribute( "lon" ).toDouble();
     qreal lat = parser.attribute( "lat" ).toDouble();
 
-    GeoDataPoint *point = new GeoDataPoint( GeoDataCoordinates( lon, lat, 0, GeoDataCoordinates::Degree ) );
-    osm::OsmNodeFactory::appendPoint( parser.attribute( "id" ).toULongLong(), point );
+    OsmParser &osmParser = static_cast<OsmParser &>( parser );
+    osmParser.nodes().appendNode( parser.attribute( "id" ).toLongLong(), lon, lat );
+
+    // Most nodes are just parts of ways, so only the point of the current
+    // node exists for its tags. A POI gets created from a copy of it.
+    GeoDataPoint *point = osmParser.nodePoint();
+    point->set( lon, lat, 0, GeoDataCoordinates::Degree );
+    point->setParent( 0 );
     return point;
 }
 
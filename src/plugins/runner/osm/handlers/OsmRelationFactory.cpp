@@ -17,19 +17,17 @@ namespace Marble
 {
 namespace osm
 {
-QMap<quint64, GeoDataPolygon *> OsmRelationFactory::m_polygons;
-
 // This is a class for keeping all the relations accesible
 // for when needed by other relations. As OSM detail level
 // increases its getting more common to have relations as
 // members of other relations
 
-void OsmRelationFactory::appendPolygon( quint64 id, GeoDataPolygon* p )
+void OsmRelationFactory::appendPolygon( qint64 id, GeoDataPolygon* p )
 {
     m_polygons[id] = p;
 }
 
-GeoDataPolygon* OsmRelationFactory::polygon( quint64 id )
+GeoDataPolygon* OsmRelationFactory::polygon( qint64 id ) const
 {
     return m_polygons.value( id );
 }
@@ -13,7 +13,7 @@
 #ifndef MARBLE_OSMRELATIONFACTORY_H
 #define MARBLE_OSMRELATIONFACTORY_H
 
-#include <QMap>
+#include <QtCore/QHash>
 
 namespace Marble
 {
@@ -31,18 +31,17 @@ namespace osm
 class OsmRelationFactory
 {
 public:
-    static void appendPolygon( quint64 id, GeoDataPolygon *p );
-    static GeoDataPolygon * polygon( quint64 id );
+    void appendPolygon( qint64 id, GeoDataPolygon *p );
+    GeoDataPolygon *polygon( qint64 id ) const;
 
     /**
      * @brief Clean up relations
      * Removes all relations from factory.
-     * This function must be called only after file loaded.
      */
-    static void clear();
+    void clear();
 
 private:
-    static QMap<quint64, GeoDataPolygon *> m_polygons;
+    QHash<qint64, GeoDataPolygon *> m_polygons;
 };
 
 }
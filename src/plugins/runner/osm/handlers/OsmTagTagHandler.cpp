@@ -11,7 +11,7 @@
 #include "OsmTagTagHandler.h"
 
 #include "GeoParser.h"
-#include "OsmNodeFactory.h"
+#include "OsmParser.h"
 #include "GeoDataDocument.h"
 #include "GeoDataPlacemark.h"
 #include "GeoDataParser.h"
@@ -76,7 +76,7 @@ GeoNode* OsmTagTagHandler::parse( GeoParser& parser ) const
         //Convert area ways or relations to polygons
         if( !dynamic_cast<GeoDataPolygon*>( geometry ) && OsmGlobals::tagNeedArea( key + "=" + value ) )
         {
-            placemark = convertWayToPolygon( doc, placemark, geometry );
+            placemark = convertWayToPolygon( static_cast<OsmParser &>( parser ), doc, placemark, geometry );
         }
         if ( key == "building" && value == "yes" && placemark->visualCategory() == GeoDataFeature::Default )
         {
@@ -157,12 +157,12 @@ GeoDataPlacemark* OsmTagTagHandler::createPOI( GeoDataDocument* doc, GeoDataGeom
     return placemark;
 }
 
-GeoDataPlacemark *OsmTagTagHandler::convertWayToPolygon( GeoDataDocument *doc, GeoDataPlacemark *placemark, GeoDataGeometry *geometry ) const
+GeoDataPlacemark *OsmTagTagHandler::convertWayToPolygon( OsmParser &parser, GeoDataDocument *doc, GeoDataPlacemark *placemark, GeoDataGeometry *geometry ) const
 {
     GeoDataLineString *polyline = dynamic_cast<GeoDataLineString *>( geometry );
     Q_ASSERT( polyline );
     doc->remove( doc->childPosition( placemark ) );
-    OsmGlobals::addDummyPlacemark( placemark );
+    parser.addDummyPlacemark( placemark );
     GeoDataPlacemark *newPlacemark = new GeoDataPlacemark( *placemark );
     GeoDataPolygon *polygon = new GeoDataPolygon;
     polygon->setOuterBoundary( *polyline );
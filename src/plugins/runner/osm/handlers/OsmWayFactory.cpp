@@ -17,18 +17,16 @@ namespace Marble
 {
 namespace osm
 {
-QMap<quint64, GeoDataLineString *> OsmWayFactory::m_lines;
-
 // This is a class for keeping all the ways accesible
 // for when needed by relations. Relations have only the ids of
 // ways so with that id the GeoDataLineString is returned
 
-void OsmWayFactory::appendLine( quint64 id, GeoDataLineString* l )
+void OsmWayFactory::appendLine( qint64 id, GeoDataLineString* l )
 {
     m_lines[id] = l;
 }
 
-GeoDataLineString* OsmWayFactory::line( quint64 id )
+GeoDataLineString* OsmWayFactory::line( qint64 id ) const
 {
     return m_lines.value( id );
 }
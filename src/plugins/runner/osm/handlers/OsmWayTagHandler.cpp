@@ -11,7 +11,7 @@
 #include "OsmWayTagHandler.h"
 
 #include "GeoParser.h"
-#include "OsmWayFactory.h"
+#include "OsmParser.h"
 #include "GeoDataDocument.h"
 #include "GeoDataPlacemark.h"
 #include "GeoDataParser.h"
@@ -45,7 +45,7 @@ GeoNode* OsmWayTagHandler::parse( GeoParser& parser ) const
     placemark->setVisible( false );
     doc->append( placemark );
 
-    osm::OsmWayFactory::appendLine( parser.attribute( "id" ).toULongLong(), polyline );
+    static_cast<OsmParser &>( parser ).ways().appendLine( parser.attribute( "id" ).toLongLong(), polyline );
 
     return polyline;
 }
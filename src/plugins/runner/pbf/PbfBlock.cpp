@@ -0,0 +1,477 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "PbfBlock.h"
+
+#include "PbfWireReader.h"
+
+#include <QtCore/QtEndian>
+
+namespace Marble
+{
+
+// Degrees per nanodegree, the unit of the granularity and offsets
+static const qreal nanodegree = 1e-9;
+
+PbfBlock::PbfBlock()
+    : m_granularity( 100 ),
+      m_lonOffset( 0 ),
+      m_latOffset( 0 )
+{
+}
+
+PbfBlock::PbfBlock( const QByteArray &blob )
+    : m_blob( blob ),
+      m_granularity( 100 ),
+      m_lonOffset( 0 ),
+      m_latOffset( 0 )
+{
+}
+
+bool PbfBlock::decode()
+{
+    QByteArray data;
+    if ( !uncompress( m_blob, data, m_errorString ) ) {
+        return false;
+    }
+
+    // The coordinate scale is stored after the groups, so these get
+    // decoded once the whole block has been read
+    QVector<QByteArray> groups;
+
+    PbfWireReader reader( data );
+    while ( reader.next() ) {
+        switch ( reader.field() ) {
+        case 1: { // stringtable
+            PbfWireReader stringTable = reader.message();
+            while ( stringTable.next() ) {
+                if ( stringTable.field() == 1 ) {
+                    const QByteArray string = stringTable.bytes();
+                    m_strings << QString::fromUtf8( string.constData(), string.size() );
+                } else {
+                    stringTable.skip();
+                }
+            }
+            if ( stringTable.hasError() ) {
+                setError( "Broken string table" );
+                return false;
+            }
+            break;
+        }
+        case 2: // primitivegroup
+            groups << reader.bytes();
+            break;
+        case 17: // granularity
+            m_granularity = qint64( reader.varint() );
+            break;
+        case 19: // lat_offset
+            m_latOffset = qint64( reader.varint() );
+            break;
+        case 20: // lon_offset
+            m_lonOffset = qint64( reader.varint() );
+            break;
+        default:
+            reader.skip();
+        }
+    }
+
+    if ( reader.hasError() ) {
+        setError( "Broken primitive block" );
+        return false;
+    }
+
+    foreach ( const QByteArray &group, groups ) {
+        PbfWireReader groupReader( group );
+        readPrimitiveGroup( groupReader );
+        if ( !m_errorString.isEmpty() ) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+QString PbfBlock::errorString() const
+{
+    return m_errorString;
+}
+
+const QVector<QString> &PbfBlock::strings() const
+{
+    return m_strings;
+}
+
+const QVector<PbfTag> &PbfBlock::tags() const
+{
+    return m_tags;
+}
+
+const QVector<PbfNode> &PbfBlock::nodes() const
+{
+    return m_nodes;
+}
+
+const QVector<PbfWay> &PbfBlock::ways() const
+{
+    return m_ways;
+}
+
+const QVector<qint64> &PbfBlock::refs() const
+{
+    return m_refs;
+}
+
+const QVector<PbfMember> &PbfBlock::members() const
+{
+    return m_members;
+}
+
+const QVector<PbfRelation> &PbfBlock::relations() const
+{
+    return m_relations;
+}
+
+bool PbfBlock::uncompress( const QByteArray &blob, QByteArray &data, QString &errorString )
+{
+    QByteArray raw;
+    QByteArray zlibData;
+    qint64 rawSize = 0;
+
+    PbfWireReader reader( blob );
+    while ( reader.next() ) {
+        switch ( reader.field() ) {
+        case 1: // raw
+            raw = reader.bytes();
+            break;
+        case 2: // raw_size
+            rawSize = qint64( reader.varint() );
+            break;
+        case 3: // zlib_data
+            zlibData = reader.bytes();
+            break;
+        case 4: // lzma_data
+            errorString = "LZMA compressed blocks are not supported";
+            return false;
+        default:
+            reader.skip();
+        }
+    }
+
+    if ( reader.hasError() ) {
+        errorString = "Broken blob";
+        return false;
+    }
+
+    if ( zlibData.isEmpty() ) {
+        data = raw;
+        return true;
+    }
+
+    // qUncompress expects the size of the result in front of the zlib stream
+    QByteArray compressed;
+    compressed.reserve( 4 + zlibData.size() );
+    compressed.resize( 4 );
+    qToBigEndian<quint32>( quint32( rawSize ), reinterpret_cast<uchar *>( compressed.data() ) );
+    compressed += zlibData;
+
+    data = qUncompress( compressed );
+    if ( data.size() != rawSize ) {
+        errorString = "Cannot uncompress block";
+        return false;
+    }
+
+    return true;
+}
+
+void PbfBlock::readPrimitiveGroup( PbfWireReader &reader )
+{
+    while ( reader.next() && m_errorString.isEmpty() ) {
+        switch ( reader.field() ) {
+        case 1: { // nodes
+            PbfWireReader node = reader.message();
+            readNode( node );
+            break;
+        }
+        case 2: { // dense
+            PbfWireReader dense = reader.message();
+            readDenseNodes( dense );
+            break;
+        }
+        case 3: { // ways
+            PbfWireReader way = reader.message();
+            readWay( way );
+            break;
+        }
+        case 4: { // relations
+            PbfWireReader relation = reader.message();
+            readRelation( relation );
+            break;
+        }
+        default:
+            reader.skip();
+        }
+    }
+
+    if ( reader.hasError() ) {
+        setError( "Broken primitive group" );
+    }
+}
+
+void PbfBlock::readNode( PbfWireReader &reader )
+{
+    PbfNode node;
+    node.id = 0;
+    qint64 lon = 0;
+    qint64 lat = 0;
+    QVector<qint64> keys;
+    QVector<qint64> values;
+
+    while ( reader.next() ) {
+        switch ( reader.field() ) {
+        case 1:
+            node.id = reader.signedVarint();
+            break;
+        case 2:
+            reader.readRepeated( keys, false );
+            break;
+        case 3:
+            reader.readRepeated( values, false );
+            break;
+        case 8:
+            lat = reader.signedVarint();
+            break;
+        case 9:
+            lon = reader.signedVarint();
+            break;
+        default:
+            reader.skip();
+        }
+    }
+
+    if ( reader.hasError() ) {
+        setError( "Broken node" );
+        return;
+    }
+
+    node.lon = nanodegree * ( m_lonOffset + m_granularity * lon );
+    node.lat = nanodegree * ( m_latOffset + m_granularity * lat );
+    node.firstTag = m_tags.size();
+    appendTags( keys, values );
+    node.tagCount = m_tags.size() - node.firstTag;
+    m_nodes.append( node );
+}
+
+void PbfBlock::readDenseNodes( PbfWireReader &reader )
+{
+    QVector<qint64> ids;
+    QVector<qint64> lons;
+    QVector<qint64> lats;
+    QVector<qint64> keysValues;
+
+    while ( reader.next() ) {
+        switch ( reader.field() ) {
+        case 1:
+            reader.readRepeated( ids, true );
+            break;
+        case 8:
+            reader.readRepeated( lats, true );
+            break;
+        case 9:
+            reader.readRepeated( lons, true );
+            break;
+        case 10:
+            reader.readRepeated( keysValues, false );
+            break;
+        default:
+            reader.skip();
+        }
+    }
+
+    if ( reader.hasError() || lons.size() != ids.size() || lats.size() != ids.size() ) {
+        setError( "Broken dense nodes" );
+        return;
+    }
+
+    m_nodes.reserve( m_nodes.size() + ids.size() );
+
+    // Ids and coordinates are stored as differences to the previous node,
+    // the tags of each node are pairs of strings followed by a 0
+    PbfNode node;
+    node.id = 0;
+    qint64 lon = 0;
+    qint64 lat = 0;
+    int tag = 0;
+    for ( int i = 0; i < ids.size(); ++i ) {
+        node.id += ids.at( i );
+        lon += lons.at( i );
+        lat += lats.at( i );
+        node.lon = nanodegree * ( m_lonOffset + m_granularity * lon );
+        node.lat = nanodegree * ( m_latOffset + m_granularity * lat );
+        node.firstTag = m_tags.size();
+
+        for ( ; tag < keysValues.size() && keysValues.at( tag ) != 0; tag += 2 ) {
+            if ( tag + 1 == keysValues.size() || !isString( keysValues.at( tag ) ) || !isString( keysValues.at( tag + 1 ) ) ) {
+                setError( "Broken dense node tags" );
+                return;
+            }
+
+            PbfTag pbfTag;
+            pbfTag.key = int( keysValues.at( tag ) );
+            pbfTag.value = int( keysValues.at( tag + 1 ) );
+            m_tags.append( pbfTag );
+        }
+        ++tag;
+
+        node.tagCount = m_tags.size() - node.firstTag;
+        m_nodes.append( node );
+    }
+}
+
+void PbfBlock::readWay( PbfWireReader &reader )
+{
+    PbfWay way;
+    way.id = 0;
+    QVector<qint64> keys;
+    QVector<qint64> values;
+    QVector<qint64> refs;
+
+    while ( reader.next() ) {
+        switch ( reader.field() ) {
+        case 1:
+            way.id = qint64( reader.varint() );
+            break;
+        case 2:
+            reader.readRepeated( keys, false );
+            break;
+        case 3:
+            reader.readRepeated( values, false );
+            break;
+        case 8:
+            reader.readRepeated( refs, true );
+            break;
+        default:
+            reader.skip();
+        }
+    }
+
+    if ( reader.hasError() ) {
+        setError( "Broken way" );
+        return;
+    }
+
+    way.firstTag = m_tags.size();
+    appendTags( keys, values );
+    way.tagCount = m_tags.size() - way.firstTag;
+
+    way.firstRef = m_refs.size();
+    way.refCount = refs.size();
+    qint64 ref = 0;
+    foreach ( qint64 delta, refs ) {
+        ref += delta;
+        m_refs.append( ref );
+    }
+
+    m_ways.append( way );
+}
+
+void PbfBlock::readRelation( PbfWireReader &reader )
+{
+    PbfRelation relation;
+    relation.id = 0;
+    QVector<qint64> keys;
+    QVector<qint64> values;
+    QVector<qint64> roles;
+    QVector<qint64> ids;
+    QVector<qint64> types;
+
+    while ( reader.next() ) {
+        switch ( reader.field() ) {
+        case 1:
+            relation.id = qint64( reader.varint() );
+            break;
+        case 2:
+            reader.readRepeated( keys, false );
+            break;
+        case 3:
+            reader.readRepeated( values, false );
+            break;
+        case 8:
+            reader.readRepeated( roles, false );
+            break;
+        case 9:
+            reader.readRepeated( ids, true );
+            break;
+        case 10:
+            reader.readRepeated( types, false );
+            break;
+        default:
+            reader.skip();
+        }
+    }
+
+    if ( reader.hasError() || roles.size() != ids.size() || types.size() != ids.size() ) {
+        setError( "Broken relation" );
+        return;
+    }
+
+    relation.firstTag = m_tags.size();
+    appendTags( keys, values );
+    relation.tagCount = m_tags.size() - relation.firstTag;
+
+    relation.firstMember = m_members.size();
+    relation.memberCount = ids.size();
+    PbfMember member;
+    member.id = 0;
+    for ( int i = 0; i < ids.size(); ++i ) {
+        if ( !isString( roles.at( i ) ) || types.at( i ) < PbfMember::Node || types.at( i ) > PbfMember::Relation ) {
+            setError( "Broken relation member" );
+            return;
+        }
+
+        member.id += ids.at( i );
+        member.type = PbfMember::Type( types.at( i ) );
+        member.role = int( roles.at( i ) );
+        m_members.append( member );
+    }
+
+    m_relations.append( relation );
+}
+
+void PbfBlock::appendTags( const QVector<qint64> &keys, const QVector<qint64> &values )
+{
+    if ( keys.size() != values.size() ) {
+        setError( "Broken tags" );
+        return;
+    }
+
+    PbfTag tag;
+    for ( int i = 0; i < keys.size(); ++i ) {
+        if ( !isString( keys.at( i ) ) || !isString( values.at( i ) ) ) {
+            setError( "Broken tags" );
+            return;
+        }
+
+        tag.key = int( keys.at( i ) );
+        tag.value = int( values.at( i ) );
+        m_tags.append( tag );
+    }
+}
+
+bool PbfBlock::isString( qint64 index ) const
+{
+    return index >= 0 && index < m_strings.size();
+}
+
+void PbfBlock::setError( const QString &errorString )
+{
+    if ( m_errorString.isEmpty() ) {
+        m_errorString = errorString;
+    }
+}
+
+}
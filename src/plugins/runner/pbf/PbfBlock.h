@@ -0,0 +1,149 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_PBFBLOCK_H
+#define MARBLE_PBFBLOCK_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QString>
+#include <QtCore/QVector>
+
+namespace Marble
+{
+
+class PbfWireReader;
+
+/**
+ * A tag of an OSM element, both strings are indexes into the string table
+ * of the block.
+ */
+struct PbfTag
+{
+    int key;
+    int value;
+};
+
+struct PbfNode
+{
+    qint64 id;
+    qreal lon;
+    qreal lat;
+    int firstTag;
+    int tagCount;
+};
+
+struct PbfWay
+{
+    qint64 id;
+    int firstTag;
+    int tagCount;
+    int firstRef;
+    int refCount;
+};
+
+struct PbfMember
+{
+    enum Type {
+        Node = 0,
+        Way = 1,
+        Relation = 2
+    };
+
+    qint64 id;
+    Type type;
+    int role;
+};
+
+struct PbfRelation
+{
+    qint64 id;
+    int firstTag;
+    int tagCount;
+    int firstMember;
+    int memberCount;
+};
+
+}
+
+Q_DECLARE_TYPEINFO( Marble::PbfTag, Q_PRIMITIVE_TYPE );
+Q_DECLARE_TYPEINFO( Marble::PbfNode, Q_PRIMITIVE_TYPE );
+Q_DECLARE_TYPEINFO( Marble::PbfWay, Q_PRIMITIVE_TYPE );
+Q_DECLARE_TYPEINFO( Marble::PbfMember, Q_PRIMITIVE_TYPE );
+Q_DECLARE_TYPEINFO( Marble::PbfRelation, Q_PRIMITIVE_TYPE );
+
+namespace Marble
+{
+
+/**
+ * The primitives of one data block of an OSM PBF file, see
+ * http://wiki.openstreetmap.org/wiki/PBF_Format
+ *
+ * Blocks can be decoded independently of each other, which is done on
+ * worker threads. Coordinates are kept in degrees, the elements refer to
+ * their tags, way nodes and relation members by index.
+ */
+class PbfBlock
+{
+ public:
+    PbfBlock();
+
+    /**
+     * Creates a block for the encoded @p blob, which must stay valid until
+     * the block got decoded.
+     */
+    explicit PbfBlock( const QByteArray &blob );
+
+    /**
+     * Uncompresses the blob and decodes the primitives in it.
+     */
+    bool decode();
+
+    QString errorString() const;
+
+    const QVector<QString> &strings() const;
+    const QVector<PbfTag> &tags() const;
+    const QVector<PbfNode> &nodes() const;
+    const QVector<PbfWay> &ways() const;
+    const QVector<qint64> &refs() const;
+    const QVector<PbfMember> &members() const;
+    const QVector<PbfRelation> &relations() const;
+
+    /**
+     * Returns the content of the encoded @p blob in @p data.
+     */
+    static bool uncompress( const QByteArray &blob, QByteArray &data, QString &errorString );
+
+ private:
+    void readPrimitiveGroup( PbfWireReader &reader );
+    void readNode( PbfWireReader &reader );
+    void readDenseNodes( PbfWireReader &reader );
+    void readWay( PbfWireReader &reader );
+    void readRelation( PbfWireReader &reader );
+    void appendTags( const QVector<qint64> &keys, const QVector<qint64> &values );
+    bool isString( qint64 index ) const;
+    void setError( const QString &errorString );
+
+    QByteArray m_blob;
+    QString m_errorString;
+
+    qint64 m_granularity;
+    qint64 m_lonOffset;
+    qint64 m_latOffset;
+
+    QVector<QString> m_strings;
+    QVector<PbfTag> m_tags;
+    QVector<PbfNode> m_nodes;
+    QVector<PbfWay> m_ways;
+    QVector<qint64> m_refs;
+    QVector<PbfMember> m_members;
+    QVector<PbfRelation> m_relations;
+};
+
+}
+
+#endif
@@ -0,0 +1,289 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "PbfDocumentBuilder.h"
+
+#include "PbfBlock.h"
+
+#include "GeoDataDocument.h"
+#include "GeoDataLineString.h"
+#include "GeoDataPlacemark.h"
+#include "GeoDataPoint.h"
+#include "GeoDataPolygon.h"
+#include "GeoDataPolyStyle.h"
+#include "GeoDataStyle.h"
+#include "MarbleDebug.h"
+#include "OsmGlobals.h"
+
+namespace Marble
+{
+
+PbfDocumentBuilder::PbfDocumentBuilder()
+    : m_document( new GeoDataDocument )
+{
+    GeoDataPolyStyle backgroundPolyStyle;
+    backgroundPolyStyle.setFill( true );
+    backgroundPolyStyle.setOutline( false );
+    backgroundPolyStyle.setColor( osm::OsmGlobals::backgroundColor );
+    GeoDataStyle backgroundStyle;
+    backgroundStyle.setPolyStyle( backgroundPolyStyle );
+    backgroundStyle.setStyleId( "background" );
+    m_document->addStyle( backgroundStyle );
+}
+
+PbfDocumentBuilder::~PbfDocumentBuilder()
+{
+    delete m_document;
+    qDeleteAll( m_areaLines );
+}
+
+void PbfDocumentBuilder::addBlock( const PbfBlock &block )
+{
+    foreach ( const PbfNode &node, block.nodes() ) {
+        addNode( block, node );
+    }
+
+    foreach ( const PbfWay &way, block.ways() ) {
+        addWay( block, way );
+    }
+
+    foreach ( const PbfRelation &relation, block.relations() ) {
+        addRelation( block, relation );
+    }
+}
+
+GeoDataDocument *PbfDocumentBuilder::takeDocument()
+{
+    buildRelations();
+
+    GeoDataDocument *const document = m_document;
+    m_document = 0;
+    return document;
+}
+
+const osm::OsmNodeFactory &PbfDocumentBuilder::nodes() const
+{
+    return m_nodes;
+}
+
+void PbfDocumentBuilder::addNode( const PbfBlock &block, const PbfNode &node )
+{
+    m_nodes.appendNode( node.id, node.lon, node.lat );
+
+    // Only named nodes and nodes with a POI category get a placemark
+    GeoDataPlacemark *placemark = 0;
+    for ( int i = node.firstTag; i < node.firstTag + node.tagCount; ++i ) {
+        const QString &key = block.strings().at( block.tags().at( i ).key );
+        const QString &value = block.strings().at( block.tags().at( i ).value );
+
+        if ( key == "created_by" ) {
+            continue;
+        }
+
+        if ( !placemark ) {
+            if ( key != "name" && !GeoDataFeature::OsmVisualCategory( key + '=' + value ) ) {
+                continue;
+            }
+
+            placemark = addPlacemark( new GeoDataPoint( node.lon, node.lat, 0, GeoDataCoordinates::Degree ) );
+            placemark->setZoomLevel( 18 );
+        }
+
+        if ( key == "name" ) {
+            placemark->setName( value );
+        } else {
+            addCategory( placemark, key, value );
+        }
+    }
+}
+
+void PbfDocumentBuilder::addWay( const PbfBlock &block, const PbfWay &way )
+{
+    GeoDataLineString *const line = new GeoDataLineString;
+    line->reserve( way.refCount );
+    GeoDataCoordinates coordinates;
+    for ( int i = way.firstRef; i < way.firstRef + way.refCount; ++i ) {
+        if ( m_nodes.coordinates( block.refs().at( i ), coordinates ) ) {
+            line->append( coordinates );
+        }
+    }
+    m_ways.appendLine( way.id, line );
+
+    // Ways with area tags like buildings are drawn as polygons
+    bool isArea = false;
+    for ( int i = way.firstTag; i < way.firstTag + way.tagCount && !isArea; ++i ) {
+        const QString &key = block.strings().at( block.tags().at( i ).key );
+        const QString &value = block.strings().at( block.tags().at( i ).value );
+        isArea = osm::OsmGlobals::tagNeedArea( key + '=' + value );
+    }
+
+    GeoDataPlacemark *placemark = 0;
+    if ( isArea ) {
+        GeoDataPolygon *const polygon = new GeoDataPolygon;
+        polygon->setOuterBoundary( *line );
+        m_areaLines << line;
+        placemark = addPlacemark( polygon );
+    } else {
+        placemark = addPlacemark( line );
+    }
+
+    addTags( block, way.firstTag, way.tagCount, placemark );
+}
+
+void PbfDocumentBuilder::addRelation( const PbfBlock &block, const PbfRelation &relation )
+{
+    Relation pending;
+    pending.id = relation.id;
+
+    pending.tags.reserve( relation.tagCount );
+    for ( int i = relation.firstTag; i < relation.firstTag + relation.tagCount; ++i ) {
+        pending.tags << qMakePair( block.strings().at( block.tags().at( i ).key ),
+                                   block.strings().at( block.tags().at( i ).value ) );
+    }
+
+    pending.members.reserve( relation.memberCount );
+    for ( int i = relation.firstMember; i < relation.firstMember + relation.memberCount; ++i ) {
+        const PbfMember &member = block.members().at( i );
+        Relation::Member pendingMember;
+        pendingMember.id = member.id;
+        pendingMember.type = member.type;
+        pendingMember.role = block.strings().at( member.role );
+        pending.members << pendingMember;
+    }
+
+    m_pendingRelations << pending;
+}
+
+void PbfDocumentBuilder::buildRelations()
+{
+    // The polygons of all relations are built from their ways first, so
+    // that relations can take the outer boundaries of the relations they
+    // refer to in a second pass regardless of their order in the file.
+    QVector<GeoDataPolygon *> polygons;
+    polygons.reserve( m_pendingRelations.size() );
+    foreach ( const Relation &relation, m_pendingRelations ) {
+        GeoDataPolygon *const polygon = new GeoDataPolygon;
+        m_relations.appendPolygon( relation.id, polygon );
+        polygons << polygon;
+
+        foreach ( const Relation::Member &member, relation.members ) {
+            if ( member.type != PbfMember::Way ) {
+                continue;
+            }
+
+            GeoDataLineString *const line = m_ways.line( member.id );
+            if ( !line ) {
+                continue;
+            }
+
+            if ( member.role == "outer" || member.role.isEmpty() ) {
+                osm::OsmGlobals::appendOuterWay( polygon, *line );
+            } else if ( member.role == "inner" ) {
+                polygon->appendInnerBoundary( GeoDataLinearRing( *line ) );
+            }
+        }
+    }
+
+    for ( int i = 0; i < m_pendingRelations.size(); ++i ) {
+        const Relation &relation = m_pendingRelations.at( i );
+        GeoDataPolygon *const polygon = polygons.at( i );
+
+        foreach ( const Relation::Member &member, relation.members ) {
+            if ( member.type != PbfMember::Relation ) {
+                continue;
+            }
+
+            if ( member.role == "outer" ) {
+                mDebug() << "Parsed relation with a relation outer member";
+            } else if ( member.role == "inner" || member.role == "subarea" || member.role.isEmpty() ) {
+                if ( GeoDataPolygon *const innerPolygon = m_relations.polygon( member.id ) ) {
+                    polygon->appendInnerBoundary( innerPolygon->outerBoundary() );
+                }
+            }
+        }
+
+        GeoDataPlacemark *const placemark = addPlacemark( polygon );
+        typedef QPair<QString, QString> Tag;
+        foreach ( const Tag &tag, relation.tags ) {
+            addTag( placemark, tag.first, tag.second );
+        }
+    }
+
+    m_pendingRelations.clear();
+}
+
+GeoDataPlacemark *PbfDocumentBuilder::addPlacemark( GeoDataGeometry *geometry )
+{
+    GeoDataPlacemark *const placemark = new GeoDataPlacemark;
+    placemark->setGeometry( geometry );
+
+    // Tags decide whether the placemark is displayed
+    placemark->setVisible( false );
+    m_document->append( placemark );
+
+    return placemark;
+}
+
+void PbfDocumentBuilder::addTags( const PbfBlock &block, int firstTag, int tagCount, GeoDataPlacemark *placemark )
+{
+    for ( int i = firstTag; i < firstTag + tagCount; ++i ) {
+        addTag( placemark, block.strings().at( block.tags().at( i ).key ),
+                block.strings().at( block.tags().at( i ).value ) );
+    }
+}
+
+void PbfDocumentBuilder::addTag( GeoDataPlacemark *placemark, const QString &key, const QString &value )
+{
+    if ( key == "created_by" ) {
+        return;
+    }
+
+    if ( key == "name" ) {
+        placemark->setName( value );
+        return;
+    }
+
+    if ( key == "building" && value == "yes" && placemark->visualCategory() == GeoDataFeature::Default ) {
+        placemark->setVisualCategory( GeoDataFeature::Building );
+        placemark->setVisible( true );
+    }
+
+    addCategory( placemark, key, value );
+}
+
+void PbfDocumentBuilder::addCategory( GeoDataPlacemark *placemark, const QString &key, const QString &value )
+{
+    GeoDataFeature::GeoDataVisualCategory category = GeoDataFeature::OsmVisualCategory( key + '=' + value );
+
+    // A building may become something more specific, but only by a key and value pair
+    bool replacesBuilding = true;
+    if ( !category ) {
+        category = GeoDataFeature::OsmVisualCategory( key );
+        replacesBuilding = false;
+    }
+
+    if ( !category ) {
+        return;
+    }
+
+    const GeoDataFeature::GeoDataVisualCategory current = placemark->visualCategory();
+    if ( current == GeoDataFeature::Default || ( current == GeoDataFeature::Building && replacesBuilding ) ) {
+        placemark->setStyle( 0 );
+        placemark->setVisualCategory( category );
+        placemark->setVisible( true );
+    } else {
+        // Features of several categories get a placemark for each of them
+        GeoDataPlacemark *const copy = new GeoDataPlacemark( *placemark );
+        copy->setVisualCategory( category );
+        copy->setStyle( 0 );
+        copy->setVisible( true );
+        m_document->append( copy );
+    }
+}
+
+}
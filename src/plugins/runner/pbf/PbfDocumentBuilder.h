@@ -0,0 +1,101 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_PBFDOCUMENTBUILDER_H
+#define MARBLE_PBFDOCUMENTBUILDER_H
+
+#include "OsmNodeFactory.h"
+#include "OsmRelationFactory.h"
+#include "OsmWayFactory.h"
+
+#include <QtCore/QList>
+#include <QtCore/QPair>
+#include <QtCore/QString>
+#include <QtCore/QVector>
+
+namespace Marble
+{
+
+class GeoDataDocument;
+class GeoDataGeometry;
+class GeoDataLineString;
+class GeoDataPlacemark;
+class PbfBlock;
+struct PbfNode;
+struct PbfRelation;
+struct PbfWay;
+
+/**
+ * Turns the decoded blocks of a PBF file into placemarks the way the XML
+ * runner does for .osm files: tagged nodes become POIs, ways line strings
+ * or areas and multipolygon relations polygons.
+ *
+ * Blocks have to be added in file order, as nodes and ways only refer to
+ * the elements that precede them. Relations may refer to ways and relations
+ * anywhere in the file, so they are built by takeDocument() once all blocks
+ * are there.
+ */
+class PbfDocumentBuilder
+{
+ public:
+    PbfDocumentBuilder();
+    ~PbfDocumentBuilder();
+
+    void addBlock( const PbfBlock &block );
+
+    /**
+     * Builds the relations and returns the document. The caller takes
+     * ownership.
+     */
+    GeoDataDocument *takeDocument();
+
+    const osm::OsmNodeFactory &nodes() const;
+
+ private:
+    /**
+     * A relation with its strings, which outlives the block it comes from.
+     */
+    struct Relation
+    {
+        struct Member
+        {
+            qint64 id;
+            int type;
+            QString role;
+        };
+
+        qint64 id;
+        QVector< QPair<QString, QString> > tags;
+        QVector<Member> members;
+    };
+
+    void addNode( const PbfBlock &block, const PbfNode &node );
+    void addWay( const PbfBlock &block, const PbfWay &way );
+    void addRelation( const PbfBlock &block, const PbfRelation &relation );
+    void buildRelations();
+
+    GeoDataPlacemark *addPlacemark( GeoDataGeometry *geometry );
+    void addTags( const PbfBlock &block, int firstTag, int tagCount, GeoDataPlacemark *placemark );
+    void addTag( GeoDataPlacemark *placemark, const QString &key, const QString &value );
+    void addCategory( GeoDataPlacemark *placemark, const QString &key, const QString &value );
+
+    GeoDataDocument *m_document;
+    osm::OsmNodeFactory m_nodes;
+    osm::OsmWayFactory m_ways;
+    osm::OsmRelationFactory m_relations;
+
+    // Lines of ways drawn as areas, which relations may still refer to
+    QList<GeoDataLineString *> m_areaLines;
+
+    // Relations in file order, built by takeDocument()
+    QVector<Relation> m_pendingRelations;
+};
+
+}
+
+#endif
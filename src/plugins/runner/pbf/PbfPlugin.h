@@ -0,0 +1,45 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_PBFPLUGIN_H
+#define MARBLE_PBFPLUGIN_H
+
+#include "ParseRunnerPlugin.h"
+
+namespace Marble
+{
+
+class PbfPlugin : public ParseRunnerPlugin
+{
+    Q_OBJECT
+    Q_INTERFACES( Marble::ParseRunnerPlugin )
+
+public:
+    explicit PbfPlugin( QObject *parent = 0 );
+
+    QString name() const;
+
+    QString nameId() const;
+
+    QString version() const;
+
+    QString description() const;
+
+    QString copyrightYears() const;
+
+    QList<PluginAuthor> pluginAuthors() const;
+
+    QString fileFormatDescription() const;
+
+    QStringList fileExtensions() const;
+
+    virtual MarbleAbstractRunner* newRunner() const;
+};
+
+}
+#endif // MARBLE_PBFPLUGIN_H
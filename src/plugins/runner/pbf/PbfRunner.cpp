@@ -0,0 +1,216 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "PbfRunner.h"
+
+#include "PbfBlock.h"
+#include "PbfDocumentBuilder.h"
+#include "PbfWireReader.h"
+
+#include "GeoDataDocument.h"
+#include "MarbleDebug.h"
+
+#include <QtCore/QFile>
+#include <QtCore/QThread>
+#include <QtCore/QTime>
+#include <QtCore/QtConcurrentMap>
+#include <QtCore/QtEndian>
+
+namespace Marble
+{
+
+// Limits of the format, larger sizes mean the file is broken
+static const quint32 maxBlobHeaderSize = 64 * 1024;
+static const quint64 maxBlobSize = 32 * 1024 * 1024;
+
+/**
+ * Reads the header and content of the next blob of @p file.
+ */
+static bool readBlob( QFile &file, QString &type, QByteArray &blob, QString &errorString )
+{
+    const QByteArray size = file.read( 4 );
+    if ( size.size() < 4 ) {
+        errorString = "Unexpected end of file";
+        return false;
+    }
+
+    const quint32 headerSize = qFromBigEndian<quint32>( reinterpret_cast<const uchar *>( size.constData() ) );
+    if ( headerSize > maxBlobHeaderSize ) {
+        errorString = "Broken blob header";
+        return false;
+    }
+
+    const QByteArray headerData = file.read( headerSize );
+    if ( headerData.size() < int( headerSize ) ) {
+        errorString = "Unexpected end of file";
+        return false;
+    }
+
+    PbfWireReader header( headerData );
+
+    quint64 blobSize = 0;
+    type.clear();
+    while ( header.next() ) {
+        switch ( header.field() ) {
+        case 1: { // type
+            const QByteArray typeName = header.bytes();
+            type = QString::fromUtf8( typeName.constData(), typeName.size() );
+            break;
+        }
+        case 3: // datasize
+            blobSize = header.varint();
+            break;
+        default:
+            header.skip();
+        }
+    }
+
+    if ( header.hasError() || blobSize > maxBlobSize ) {
+        errorString = "Broken blob header";
+        return false;
+    }
+
+    blob = file.read( blobSize );
+    if ( blob.size() < int( blobSize ) ) {
+        errorString = "Unexpected end of file";
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Checks that the file only needs features the runner supports.
+ */
+static bool readHeader( const QByteArray &blob, QString &errorString )
+{
+    QByteArray data;
+    if ( !PbfBlock::uncompress( blob, data, errorString ) ) {
+        return false;
+    }
+
+    PbfWireReader reader( data );
+    while ( reader.next() ) {
+        if ( reader.field() == 4 ) { // required_features
+            const QByteArray feature = reader.bytes();
+            if ( feature != "OsmSchema-V0.6" && feature != "DenseNodes" ) {
+                errorString = QString( "Unsupported feature %1" ).arg( QString::fromUtf8( feature.constData(), feature.size() ) );
+                return false;
+            }
+        } else {
+            reader.skip();
+        }
+    }
+
+    if ( reader.hasError() ) {
+        errorString = "Broken file header";
+        return false;
+    }
+
+    return true;
+}
+
+static void decodeBlock( PbfBlock &block )
+{
+    block.decode();
+}
+
+/**
+ * Decodes @p blocks in parallel and adds them to @p builder in file order.
+ */
+static bool addBlocks( QList<PbfBlock> &blocks, PbfDocumentBuilder &builder, QString &errorString )
+{
+    QtConcurrent::blockingMap( blocks, decodeBlock );
+
+    foreach ( const PbfBlock &block, blocks ) {
+        if ( !block.errorString().isEmpty() ) {
+            errorString = block.errorString();
+            return false;
+        }
+
+        builder.addBlock( block );
+    }
+
+    blocks.clear();
+    return true;
+}
+
+PbfRunner::PbfRunner( QObject *parent ) :
+    MarbleAbstractRunner( parent )
+{
+}
+
+PbfRunner::~PbfRunner()
+{
+}
+
+GeoDataFeature::GeoDataVisualCategory PbfRunner::category() const
+{
+    return GeoDataFeature::Folder;
+}
+
+void PbfRunner::parseFile( const QString &fileName, DocumentRole role = UnknownDocument )
+{
+    QFile file( fileName );
+    if ( !file.open( QIODevice::ReadOnly ) ) {
+        emit parsingFinished( 0, file.errorString() );
+        return;
+    }
+
+    QTime time;
+    time.start();
+
+    // Enough blocks to keep all cores busy, but not the whole file. Blobs are
+    // read one after another, so files of any size can be parsed.
+    const int batchSize = 4 * QThread::idealThreadCount();
+
+    PbfDocumentBuilder builder;
+    QList<PbfBlock> blocks;
+    QString errorString;
+    bool success = true;
+    while ( success && !file.atEnd() ) {
+        QString type;
+        QByteArray blob;
+        success = readBlob( file, type, blob, errorString );
+        if ( !success ) {
+            break;
+        }
+
+        // Blobs of unknown types are to be skipped
+        if ( type == "OSMHeader" ) {
+            success = readHeader( blob, errorString );
+        } else if ( type == "OSMData" ) {
+            blocks << PbfBlock( blob );
+            if ( blocks.size() == batchSize ) {
+                success = addBlocks( blocks, builder, errorString );
+            }
+        }
+    }
+
+    if ( success ) {
+        success = addBlocks( blocks, builder, errorString );
+    }
+
+    if ( !success ) {
+        mDebug() << Q_FUNC_INFO << fileName << errorString;
+        emit parsingFinished( 0, errorString );
+        return;
+    }
+
+    const int elapsed = qMax( 1, time.elapsed() );
+    mDebug() << "Parsed" << fileName << "with" << file.size() / 1048576.0 * 1000 / elapsed << "MB/s,"
+             << builder.nodes().size() << "nodes";
+
+    GeoDataDocument *const document = builder.takeDocument();
+    document->setDocumentRole( role );
+    emit parsingFinished( document );
+}
+
+}
+
+#include "PbfRunner.moc"
@@ -0,0 +1,162 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "PbfWireReader.h"
+
+namespace Marble
+{
+
+PbfWireReader::PbfWireReader( const char *data, int size )
+    : m_position( reinterpret_cast<const uchar *>( data ) ),
+      m_end( m_position + size ),
+      m_key( 0 ),
+      m_error( false )
+{
+}
+
+PbfWireReader::PbfWireReader( const QByteArray &data )
+    : m_position( reinterpret_cast<const uchar *>( data.constData() ) ),
+      m_end( m_position + data.size() ),
+      m_key( 0 ),
+      m_error( false )
+{
+}
+
+bool PbfWireReader::next()
+{
+    if ( m_error || m_position == m_end ) {
+        return false;
+    }
+
+    m_key = quint32( varint() );
+    return !m_error;
+}
+
+int PbfWireReader::field() const
+{
+    return m_key >> 3;
+}
+
+PbfWireReader::WireType PbfWireReader::wireType() const
+{
+    return WireType( m_key & 0x7 );
+}
+
+quint64 PbfWireReader::varint()
+{
+    quint64 value = 0;
+    for ( int shift = 0; m_position != m_end && shift < 64; shift += 7 ) {
+        const uchar byte = *m_position++;
+        value |= quint64( byte & 0x7f ) << shift;
+        if ( !( byte & 0x80 ) ) {
+            return value;
+        }
+    }
+
+    setError();
+    return 0;
+}
+
+qint64 PbfWireReader::signedVarint()
+{
+    return zigzagDecode( varint() );
+}
+
+QByteArray PbfWireReader::bytes()
+{
+    const quint64 size = varint();
+    if ( size > quint64( m_end - m_position ) ) {
+        setError();
+        return QByteArray();
+    }
+
+    const QByteArray result = QByteArray::fromRawData( reinterpret_cast<const char *>( m_position ), int( size ) );
+    m_position += size;
+    return result;
+}
+
+PbfWireReader PbfWireReader::message()
+{
+    const quint64 size = varint();
+    if ( size > quint64( m_end - m_position ) ) {
+        setError();
+        return PbfWireReader( 0, 0 );
+    }
+
+    PbfWireReader result( reinterpret_cast<const char *>( m_position ), int( size ) );
+    m_position += size;
+    return result;
+}
+
+void PbfWireReader::readRepeated( QVector<qint64> &values, bool zigzag )
+{
+    if ( wireType() == Varint ) {
+        const quint64 value = varint();
+        values.append( zigzag ? zigzagDecode( value ) : qint64( value ) );
+        return;
+    }
+
+    if ( wireType() != LengthDelimited ) {
+        skip();
+        return;
+    }
+
+    PbfWireReader packed = message();
+    while ( packed.m_position != packed.m_end && !packed.m_error ) {
+        const quint64 value = packed.varint();
+        values.append( zigzag ? zigzagDecode( value ) : qint64( value ) );
+    }
+
+    if ( packed.m_error ) {
+        setError();
+    }
+}
+
+void PbfWireReader::skip()
+{
+    switch ( wireType() ) {
+    case Varint:
+        varint();
+        break;
+    case Fixed64:
+    case Fixed32: {
+        const int size = wireType() == Fixed64 ? 8 : 4;
+        if ( m_end - m_position < size ) {
+            setError();
+        } else {
+            m_position += size;
+        }
+        break;
+    }
+    case LengthDelimited:
+        bytes();
+        break;
+    default:
+        setError();
+    }
+}
+
+bool PbfWireReader::hasError() const
+{
+    return m_error;
+}
+
+qint64 PbfWireReader::zigzagDecode( quint64 value )
+{
+    return qint64( value >> 1 ) ^ -qint64( value & 1 );
+}
+
+void PbfWireReader::setError()
+{
+    m_error = true;
+
+    // Stop reading
+    m_position = m_end;
+}
+
+}
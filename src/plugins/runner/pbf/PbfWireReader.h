@@ -0,0 +1,78 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_PBFWIREREADER_H
+#define MARBLE_PBFWIREREADER_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QVector>
+
+namespace Marble
+{
+
+/**
+ * Reads the fields of a message in the Protocol Buffers wire format, see
+ * https://developers.google.com/protocol-buffers/docs/encoding
+ *
+ * Only the parts the OSM PBF format uses are supported. After an error all
+ * reads return 0 and next() returns false.
+ */
+class PbfWireReader
+{
+ public:
+    enum WireType {
+        Varint = 0,
+        Fixed64 = 1,
+        LengthDelimited = 2,
+        Fixed32 = 5
+    };
+
+    PbfWireReader( const char *data, int size );
+    explicit PbfWireReader( const QByteArray &data );
+
+    /**
+     * Reads the key of the next field. Returns false at the end of the
+     * message or after an error.
+     */
+    bool next();
+
+    int field() const;
+    WireType wireType() const;
+
+    quint64 varint();
+    qint64 signedVarint();
+
+    /**
+     * Returns the content of a length delimited field without copying it.
+     */
+    QByteArray bytes();
+    PbfWireReader message();
+
+    /**
+     * Appends the values of a repeated number field, which may be packed.
+     * Signed values are zigzag decoded if @p zigzag is set.
+     */
+    void readRepeated( QVector<qint64> &values, bool zigzag );
+
+    void skip();
+
+    bool hasError() const;
+
+ private:
+    static qint64 zigzagDecode( quint64 value );
+    void setError();
+
+    const uchar *m_position;
+    const uchar *m_end;
+    quint32 m_key;
+    bool m_error;
+};
+
+}
+
+#endif
@@ -14,7 +14,6 @@
 #include "MarbleDebug.h"
 
 #include <QtCore/QFile>
-#include <QtCore/QFileInfo>
 
 namespace Marble
 {
@@ -38,22 +37,26 @@ GeoDataFeature::GeoDataVisualCategory PntRunner::category() const
 
 void PntRunner::parseFile( const QString &fileName, DocumentRole role = UnknownDocument )
 {
-    QFileInfo fileinfo( fileName );
-    if( fileinfo.suffix().compare( "pnt", Qt::CaseInsensitive ) != 0 ) {
+    QFile  file( fileName );
+    if ( !file.exists() ) {
+        qWarning( "File does not exist!" );
         emit parsingFinished( 0 );
         return;
     }
 
-    QFile  file( fileName );
-    if ( !file.exists() ) {
-        qWarning( "File does not exist!" );
+    // Decode the little endian records straight from the mapped file
+    // instead of going through a QDataStream one short at a time.
+    const uchar *src = 0;
+    if ( file.open( QIODevice::ReadOnly ) ) {
+        src = file.map( 0, file.size() );
+    }
+    if ( !src ) {
+        qWarning( "File could not be mapped!" );
         emit parsingFinished( 0 );
         return;
     }
 
-    file.open( QIODevice::ReadOnly );
-    QDataStream stream( &file );  // read the data serialized from the file
-    stream.setByteOrder( QDataStream::LittleEndian );
+    const int recordCount = file.size() / 6;
 
     GeoDataDocument *document = new GeoDataDocument();
     document->setDocumentRole( role );
@@ -61,12 +64,10 @@ void PntRunner::parseFile( const QString &fileName, DocumentRole role = UnknownD
 
     int count = 0;
     bool error = false;
-    while( !stream.atEnd() || error ){
-        short  header = -1;
-        short  iLat = -5400 - 1;
-        short  iLon = -10800 - 1;
-
-        stream >> header >> iLat >> iLon;
+    for ( const uchar *record = src; count < recordCount; record += 6 ) {
+        const short header = (short)( record[0] | ( record[1] << 8 ) );
+        const short iLat   = (short)( record[2] | ( record[3] << 8 ) );
+        const short iLon   = (short)( record[4] | ( record[5] << 8 ) );
 
         // make sure iLat is within valid range
         if ( !( -5400 <= iLat && iLat <= 5400 ) ) {
@@ -195,6 +196,7 @@ void PntRunner::parseFile( const QString &fileName, DocumentRole role = UnknownD
         ++count;
     }
 
+    file.unmap( const_cast<uchar *>( src ) );
     file.close();
     if ( document->size() == 0 || error ) {
         delete document;
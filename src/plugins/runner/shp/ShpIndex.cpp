@@ -0,0 +1,366 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "ShpIndex.h"
+
+#include "GeoDataLatLonBox.h"
+#include "MarbleDebug.h"
+#include "MarbleDirs.h"
+
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDataStream>
+#include <QtCore/QDateTime>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QtEndian>
+
+#include <cmath>
+#include <cstring>
+
+namespace Marble
+{
+
+// Identifies index files, to be changed along with their layout
+static const quint32 indexMagic = 0x4d534931;
+
+// Size of the .shx header, followed by 8 bytes per record
+static const int shxHeaderSize = 100;
+
+// Shapes per grid cell if they were spread evenly, and the grid size limit
+static const int shapesPerCell = 4;
+static const int maxGridSize = 1024;
+
+// Shapes covering more cells than this are not put into the grid
+static const int maxCellsPerShape = 64;
+
+// Point shapes store their coordinates where other shapes have their box
+static bool isPoint( qint32 shapeType )
+{
+    return shapeType == 1 || shapeType == 11 || shapeType == 21;
+}
+
+static double readDouble( const uchar *data )
+{
+    const quint64 bits = qFromLittleEndian<quint64>( data );
+    double value;
+    memcpy( &value, &bits, sizeof( value ) );
+    return value;
+}
+
+ShpIndex::ShpIndex()
+    : m_gridWest( 0 ),
+      m_gridSouth( 0 ),
+      m_cellWidth( 1 ),
+      m_cellHeight( 1 ),
+      m_columns( 0 ),
+      m_rows( 0 )
+{
+}
+
+bool ShpIndex::load( const QString &shpFileName )
+{
+    const QFileInfo shpInfo( shpFileName );
+    const QString cacheFileName = indexFileName( shpFileName );
+    if ( !read( cacheFileName, shpInfo ) ) {
+        if ( !build( shpFileName ) ) {
+            return false;
+        }
+
+        write( cacheFileName, shpInfo );
+    }
+
+    buildGrid();
+    return true;
+}
+
+int ShpIndex::size() const
+{
+    return m_bounds.size();
+}
+
+QVector<int> ShpIndex::shapes( const GeoDataLatLonBox &latLonBox ) const
+{
+    // Collect the candidates from the grid, both sides of the date line
+    // separately if the box crosses it
+    QVector<int> candidates = m_largeShapes;
+    const double west = latLonBox.west( GeoDataCoordinates::Degree );
+    const double south = latLonBox.south( GeoDataCoordinates::Degree );
+    const double east = latLonBox.east( GeoDataCoordinates::Degree );
+    const double north = latLonBox.north( GeoDataCoordinates::Degree );
+    if ( latLonBox.crossesDateLine() ) {
+        gridShapes( west, south, 180, north, candidates );
+        gridShapes( -180, south, east, north, candidates );
+    } else {
+        gridShapes( west, south, east, north, candidates );
+    }
+
+    qSort( candidates );
+
+    QVector<int> result;
+    GeoDataLatLonBox shapeBox;
+    int previous = -1;
+    foreach ( int i, candidates ) {
+        if ( i == previous ) {
+            continue;
+        }
+        previous = i;
+
+        const ShpBounds &bounds = m_bounds.at( i );
+        shapeBox.setBoundaries( bounds.north, bounds.south, bounds.east, bounds.west, GeoDataCoordinates::Degree );
+        if ( latLonBox.intersects( shapeBox ) ) {
+            result << i;
+        }
+    }
+
+    return result;
+}
+
+int ShpIndex::gridColumn( double lon ) const
+{
+    return qBound( 0, int( ( lon - m_gridWest ) / m_cellWidth ), m_columns - 1 );
+}
+
+int ShpIndex::gridRow( double lat ) const
+{
+    return qBound( 0, int( ( lat - m_gridSouth ) / m_cellHeight ), m_rows - 1 );
+}
+
+void ShpIndex::buildGrid()
+{
+    m_columns = 0;
+    m_rows = 0;
+    m_cellStarts.clear();
+    m_cellShapes.clear();
+    m_largeShapes.clear();
+
+    // Shapes with a box that crosses the date line go to the large ones
+    double west = 180;
+    double south = 90;
+    double east = -180;
+    double north = -90;
+    int count = 0;
+    foreach ( const ShpBounds &bounds, m_bounds ) {
+        if ( !bounds.isNull && bounds.west <= bounds.east ) {
+            west = qMin( west, bounds.west );
+            south = qMin( south, bounds.south );
+            east = qMax( east, bounds.east );
+            north = qMax( north, bounds.north );
+            ++count;
+        }
+    }
+
+    if ( count > 0 ) {
+        const int size = qBound( 1, int( sqrt( double( count ) / shapesPerCell ) ), maxGridSize );
+        m_columns = size;
+        m_rows = size;
+        m_gridWest = west;
+        m_gridSouth = south;
+        m_cellWidth = east > west ? ( east - west ) / size : 1;
+        m_cellHeight = north > south ? ( north - south ) / size : 1;
+    }
+
+    // Count the shapes of each cell first, then fill them in, so that
+    // each cell lists its shapes in ascending order
+    QVector<int> cellCounts( m_columns * m_rows + 1, 0 );
+    for ( int pass = 0; pass < 2; ++pass ) {
+        for ( int i = 0; i < m_bounds.size(); ++i ) {
+            const ShpBounds &bounds = m_bounds.at( i );
+            if ( bounds.isNull ) {
+                continue;
+            }
+
+            const int x1 = gridColumn( bounds.west );
+            const int x2 = gridColumn( bounds.east );
+            const int y1 = gridRow( bounds.south );
+            const int y2 = gridRow( bounds.north );
+            if ( bounds.west > bounds.east || ( x2 - x1 + 1 ) * ( y2 - y1 + 1 ) > maxCellsPerShape ) {
+                if ( pass == 1 ) {
+                    m_largeShapes << i;
+                }
+                continue;
+            }
+
+            for ( int y = y1; y <= y2; ++y ) {
+                for ( int x = x1; x <= x2; ++x ) {
+                    const int cell = y * m_columns + x;
+                    if ( pass == 0 ) {
+                        ++cellCounts[cell + 1];
+                    } else {
+                        m_cellShapes[cellCounts[cell]++] = i;
+                    }
+                }
+            }
+        }
+
+        if ( pass == 0 ) {
+            for ( int cell = 1; cell < cellCounts.size(); ++cell ) {
+                cellCounts[cell] += cellCounts.at( cell - 1 );
+            }
+            m_cellStarts = cellCounts;
+            m_cellShapes.resize( cellCounts.last() );
+        }
+    }
+}
+
+void ShpIndex::gridShapes( double west, double south, double east, double north, QVector<int> &shapes ) const
+{
+    if ( m_columns == 0 ) {
+        return;
+    }
+
+    // Nothing to find outside of the grid
+    const double gridEast = m_gridWest + m_columns * m_cellWidth;
+    const double gridNorth = m_gridSouth + m_rows * m_cellHeight;
+    if ( east < m_gridWest || west > gridEast || north < m_gridSouth || south > gridNorth ) {
+        return;
+    }
+
+    const int x1 = gridColumn( west );
+    const int x2 = gridColumn( east );
+    const int y1 = gridRow( south );
+    const int y2 = gridRow( north );
+    for ( int y = y1; y <= y2; ++y ) {
+        for ( int x = x1; x <= x2; ++x ) {
+            const int cell = y * m_columns + x;
+            for ( int j = m_cellStarts.at( cell ); j < m_cellStarts.at( cell + 1 ); ++j ) {
+                shapes << m_cellShapes.at( j );
+            }
+        }
+    }
+}
+
+bool ShpIndex::build( const QString &shpFileName )
+{
+    const QFileInfo shpInfo( shpFileName );
+    const QString baseName = shpInfo.path() + '/' + shpInfo.completeBaseName();
+    QFile shx( baseName + ".shx" );
+    if ( !shx.exists() ) {
+        shx.setFileName( baseName + ".SHX" );
+    }
+
+    QFile shp( shpFileName );
+    if ( !shx.open( QIODevice::ReadOnly ) || !shp.open( QIODevice::ReadOnly ) ) {
+        mDebug() << "Cannot index" << shpFileName << "without its .shx file";
+        return false;
+    }
+
+    const QByteArray offsets = shx.readAll();
+    if ( offsets.size() < shxHeaderSize ) {
+        return false;
+    }
+
+    const int count = ( offsets.size() - shxHeaderSize ) / 8;
+    const uchar *const records = reinterpret_cast<const uchar *>( offsets.constData() ) + shxHeaderSize;
+
+    // The shape type followed by the box, or by the coordinates of a point
+    const int contentSize = 36;
+    const uchar *const mapped = shp.map( 0, shp.size() );
+    QByteArray buffer;
+
+    m_bounds.clear();
+    m_bounds.reserve( count );
+    for ( int i = 0; i < count; ++i ) {
+        // Offsets count 16 bit words and point to the 8 byte record header
+        const qint64 position = 2 * qint64( qFromBigEndian<quint32>( records + 8 * i ) ) + 8;
+
+        const uchar *content = 0;
+        qint64 available = 0;
+        if ( mapped ) {
+            content = mapped + position;
+            available = shp.size() - position;
+        } else if ( shp.seek( position ) ) {
+            buffer = shp.read( contentSize );
+            content = reinterpret_cast<const uchar *>( buffer.constData() );
+            available = buffer.size();
+        }
+
+        ShpBounds bounds;
+        bounds.west = bounds.south = bounds.east = bounds.north = 0;
+        bounds.isNull = true;
+
+        const qint32 shapeType = available >= 4 ? qFromLittleEndian<qint32>( content ) : 0;
+        if ( isPoint( shapeType ) && available >= 20 ) {
+            bounds.west = bounds.east = readDouble( content + 4 );
+            bounds.south = bounds.north = readDouble( content + 12 );
+            bounds.isNull = false;
+        } else if ( shapeType != 0 && !isPoint( shapeType ) && available >= contentSize ) {
+            bounds.west = readDouble( content + 4 );
+            bounds.south = readDouble( content + 12 );
+            bounds.east = readDouble( content + 20 );
+            bounds.north = readDouble( content + 28 );
+            bounds.isNull = false;
+        }
+
+        m_bounds.append( bounds );
+    }
+
+    return true;
+}
+
+bool ShpIndex::read( const QString &indexFileName, const QFileInfo &shpInfo )
+{
+    QFile file( indexFileName );
+    if ( !file.open( QIODevice::ReadOnly ) ) {
+        return false;
+    }
+
+    QDataStream stream( &file );
+    quint32 magic = 0;
+    qint64 shpSize = 0;
+    quint32 shpLastModified = 0;
+    qint32 count = 0;
+    stream >> magic >> shpSize >> shpLastModified >> count;
+
+    // Each box takes 33 bytes
+    if ( stream.status() != QDataStream::Ok || magic != indexMagic
+         || shpSize != shpInfo.size() || shpLastModified != shpInfo.lastModified().toTime_t()
+         || count < 0 || count > file.size() / 33 ) {
+        return false;
+    }
+
+    m_bounds.resize( count );
+    for ( int i = 0; i < count; ++i ) {
+        ShpBounds &bounds = m_bounds[i];
+        stream >> bounds.west >> bounds.south >> bounds.east >> bounds.north >> bounds.isNull;
+    }
+
+    if ( stream.status() != QDataStream::Ok ) {
+        m_bounds.clear();
+        return false;
+    }
+
+    return true;
+}
+
+void ShpIndex::write( const QString &indexFileName, const QFileInfo &shpInfo ) const
+{
+    QDir().mkpath( QFileInfo( indexFileName ).path() );
+
+    QFile file( indexFileName );
+    if ( !file.open( QIODevice::WriteOnly ) ) {
+        mDebug() << "Cannot write shapefile index" << indexFileName;
+        return;
+    }
+
+    QDataStream stream( &file );
+    stream << indexMagic << qint64( shpInfo.size() ) << quint32( shpInfo.lastModified().toTime_t() )
+           << qint32( m_bounds.size() );
+    foreach ( const ShpBounds &bounds, m_bounds ) {
+        stream << bounds.west << bounds.south << bounds.east << bounds.north << bounds.isNull;
+    }
+}
+
+QString ShpIndex::indexFileName( const QString &shpFileName )
+{
+    const QByteArray path = QFileInfo( shpFileName ).absoluteFilePath().toUtf8();
+    const QByteArray hash = QCryptographicHash::hash( path, QCryptographicHash::Md5 ).toHex();
+    return MarbleDirs::localPath() + "/cache/shp/" + QString::fromLatin1( hash ) + ".idx";
+}
+
+}
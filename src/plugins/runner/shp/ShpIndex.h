@@ -0,0 +1,113 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_SHPINDEX_H
+#define MARBLE_SHPINDEX_H
+
+#include <QtCore/QString>
+#include <QtCore/QVector>
+
+class QFileInfo;
+
+namespace Marble
+{
+
+class GeoDataLatLonBox;
+
+/**
+ * The bounding box of a shape in degrees. Null shapes have no box.
+ */
+struct ShpBounds
+{
+    double west;
+    double south;
+    double east;
+    double north;
+    bool isNull;
+};
+
+}
+
+Q_DECLARE_TYPEINFO( Marble::ShpBounds, Q_PRIMITIVE_TYPE );
+
+namespace Marble
+{
+
+/**
+ * Knows the bounding boxes of all shapes of a shapefile, so that only the
+ * shapes of a region need to be read.
+ *
+ * The boxes are taken from the record headers of the .shp file, which are
+ * found through the .shx file, without reading the shapes themselves. They
+ * are cached in Marble's local directory and read from there as long as
+ * the shapefile does not change.
+ *
+ * Queries go through a uniform grid over the extent of all shapes, with
+ * each cell listing the shapes that overlap it. Shapes covering too many
+ * cells are kept in a separate list that every query checks.
+ */
+class ShpIndex
+{
+ public:
+    ShpIndex();
+
+    /**
+     * Loads the index of @p shpFileName from the cache, or creates it and
+     * adds it to the cache.
+     * @return false if the shapefile could not be read
+     */
+    bool load( const QString &shpFileName );
+
+    int size() const;
+
+    /**
+     * Returns the numbers of the shapes whose bounding box intersects
+     * @p latLonBox in ascending order.
+     */
+    QVector<int> shapes( const GeoDataLatLonBox &latLonBox ) const;
+
+    /**
+     * Returns the file the index of @p shpFileName is cached in.
+     */
+    static QString indexFileName( const QString &shpFileName );
+
+ private:
+    bool build( const QString &shpFileName );
+    bool read( const QString &indexFileName, const QFileInfo &shpInfo );
+    void write( const QString &indexFileName, const QFileInfo &shpInfo ) const;
+
+    void buildGrid();
+
+    /**
+     * Appends the shapes of the grid cells overlapping the given area to
+     * @p shapes, with west <= east in degrees.
+     */
+    void gridShapes( double west, double south, double east, double north, QVector<int> &shapes ) const;
+
+    /**
+     * Returns the column or row of the grid cell holding @p value.
+     */
+    int gridColumn( double lon ) const;
+    int gridRow( double lat ) const;
+
+    QVector<ShpBounds> m_bounds;
+
+    double m_gridWest;
+    double m_gridSouth;
+    double m_cellWidth;
+    double m_cellHeight;
+    int m_columns;
+    int m_rows;
+    QVector<int> m_cellStarts;    // where the shapes of each cell start in m_cellShapes
+    QVector<int> m_cellShapes;
+    QVector<int> m_largeShapes;
+};
+
+}
+
+#endif
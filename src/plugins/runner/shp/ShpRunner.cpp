@@ -9,11 +9,13 @@
 
 #include "ShpRunner.h"
 
+#include "ShpIndex.h"
+
 #include "GeoDataDocument.h"
 #include "GeoDataPolygon.h"
 #include "MarbleDebug.h"
 
-#include <QtCore/QFileInfo>
+#include <QtCore/QTime>
 
 #include <shapefil.h>
 
@@ -36,17 +38,14 @@ GeoDataFeature::GeoDataVisualCategory ShpRunner::category() const
 
 void ShpRunner::parseFile( const QString &fileName, DocumentRole role = UnknownDocument )
 {
-    QFileInfo fileinfo( fileName );
-    if( fileinfo.suffix().compare( "shp", Qt::CaseInsensitive ) != 0 ) {
-        emit parsingFinished( 0 );
-        return;
-    }
-
     SHPHandle handle = SHPOpen( fileName.toStdString().c_str(), "rb" );
     if ( !handle ) {
         emit parsingFinished( 0 );
         return;
     }
+    QTime time;
+    time.start();
+
     int entities;
     int shapeType;
     SHPGetInfo( handle, &entities, &shapeType, NULL, NULL );
@@ -61,28 +60,44 @@ void ShpRunner::parseFile( const QString &fileName, DocumentRole role = UnknownD
     GeoDataDocument *document = new GeoDataDocument;
     document->setDocumentRole( role );
 
-    for ( int i=0; i< entities; ++i ) {
+    // With a region given only the shapes intersecting it are read, which
+    // the index finds without reading any shape
+    QVector<int> shapes;
+    bool filtered = !latLonBox().isEmpty();
+    if ( filtered ) {
+        ShpIndex index;
+        if ( index.load( fileName ) && index.size() == entities ) {
+            shapes = index.shapes( latLonBox() );
+        } else {
+            filtered = false;
+        }
+    }
+
+    const int count = filtered ? shapes.size() : entities;
+    for ( int n = 0; n < count; ++n ) {
+        const int i = filtered ? shapes.at( n ) : n;
+        SHPObject *shape = SHPReadObject( handle, i );
+        if ( !shape ) {
+            continue;
+        }
+
         GeoDataPlacemark  *placemark = 0;
         placemark = new GeoDataPlacemark;
         document->append( placemark );
 
-        SHPObject *shape = SHPReadObject( handle, i );
-        if( nameField ) {
+        if( nameField >= 0 ) {
             const char* info = DBFReadStringAttribute( dbfhandle, i, nameField );
             placemark->setName( info );
-            mDebug() << "name " << placemark->name();
         }
-        if( noteField ) {
+        if( noteField >= 0 ) {
             const char* note = DBFReadStringAttribute( dbfhandle, i, noteField );
             placemark->setDescription( note );
-            mDebug() << "desc " << placemark->description();
         }
 
         switch ( shapeType ) {
             case SHPT_POINT: {
                 placemark->setCoordinate( *shape->padfX, *shape->padfY,
                                          0, GeoDataCoordinates::Degree );
-                mDebug() << "point " << placemark->name();
                 break;
             }
 
@@ -94,7 +109,6 @@ void ShpRunner::parseFile( const QString &fileName, DocumentRole role = UnknownD
                                   0, GeoDataCoordinates::Degree ) ) );
                 }
                 placemark->setGeometry( geom );
-                mDebug() << "multipoint " << placemark->name();
                 break;
             }
 
@@ -111,7 +125,6 @@ void ShpRunner::parseFile( const QString &fileName, DocumentRole role = UnknownD
                         geom->append( line );
                     }
                     placemark->setGeometry( geom );
-                    mDebug() << "arc " << placemark->name() << " " << shape->nParts;
 
                 } else {
                     GeoDataLineString *line = new GeoDataLineString;
@@ -121,7 +134,6 @@ void ShpRunner::parseFile( const QString &fileName, DocumentRole role = UnknownD
                                       0, GeoDataCoordinates::Degree ) );
                     }
                     placemark->setGeometry( line );
-                    mDebug() << "arc " << placemark->name() << " " << shape->nParts;
                 }
                 break;
             }
@@ -145,7 +157,6 @@ void ShpRunner::parseFile( const QString &fileName, DocumentRole role = UnknownD
                         }
                     }
                     placemark->setGeometry( poly );
-                    mDebug() << "donut " << placemark->name() << " " << shape->nParts;
 
                 } else {
                     GeoDataPolygon *poly = new GeoDataPolygon;
@@ -157,14 +168,17 @@ void ShpRunner::parseFile( const QString &fileName, DocumentRole role = UnknownD
                     }
                     poly->setOuterBoundary( ring );
                     placemark->setGeometry( poly );
-                    mDebug() << "poly " << placemark->name() << " " << shape->nParts;
                 }
                 break;
             }
         }
 
+        SHPDestroyObject( shape );
     }
 
+    mDebug() << "Read" << count << "of" << entities << "shapes from" << fileName
+             << "in" << time.elapsed() << "ms";
+
     SHPClose( handle );
 
     DBFClose( dbfhandle );
@@ -0,0 +1,343 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include <QtTest/QtTest>
+#include <QtCore/QDataStream>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+
+#include "GeoDataData.h"
+#include "GeoDataDocument.h"
+#include "GeoDataExtendedData.h"
+#include "GeoDataLatLonBox.h"
+#include "GeoDataPlacemark.h"
+#include "MarbleAbstractRunner.h"
+#include "MarbleDirs.h"
+#include "ParseRunnerPlugin.h"
+#include "PlacemarkCache.h"
+#include "PluginManager.h"
+
+namespace Marble
+{
+
+class CacheRunnerTest : public QObject
+{
+    Q_OBJECT
+
+ public slots:
+    void setDocument( GeoDataDocument *document, const QString &error );
+
+ private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void readPlacemarks();
+    void readMappedPlacemarks();
+    void mappedRegions();
+    void mappedNames();
+    void rejectOtherFiles();
+
+ private:
+    /**
+     * Writes @p placemarks in the format FileLoader saves caches in.
+     */
+    void writeCache( const QList<GeoDataPlacemark> &placemarks, quint32 magic = 0x31415926 );
+
+    GeoDataDocument *parse();
+
+    static QList<GeoDataPlacemark> testPlacemarks();
+
+    /**
+     * Returns @p count placemarks spread over the world at all zoom levels.
+     */
+    static QList<GeoDataPlacemark> randomPlacemarks( int count );
+
+    void writeMappedCache( const QList<GeoDataPlacemark> &placemarks );
+
+    PluginManager m_pluginManager;
+    const ParseRunnerPlugin *m_plugin;
+    GeoDataDocument *m_document;
+    QString m_fileName;
+};
+
+void CacheRunnerTest::setDocument( GeoDataDocument *document, const QString &error )
+{
+    Q_UNUSED( error );
+
+    m_document = document;
+}
+
+void CacheRunnerTest::initTestCase()
+{
+    MarbleDirs::setMarblePluginPath( PLUGIN_PATH );
+
+    m_plugin = 0;
+    foreach ( const ParseRunnerPlugin *plugin, m_pluginManager.parsingRunnerPlugins() ) {
+        if ( plugin->nameId() == "Cache" ) {
+            m_plugin = plugin;
+        }
+    }
+
+    if ( !m_plugin ) {
+        QSKIP( "The Cache plugin is needed", SkipAll );
+    }
+
+    m_fileName = QDir::tempPath() + "/CacheRunnerTest.cache";
+}
+
+void CacheRunnerTest::cleanupTestCase()
+{
+    QFile::remove( m_fileName );
+}
+
+void CacheRunnerTest::writeCache( const QList<GeoDataPlacemark> &placemarks, quint32 magic )
+{
+    QFile file( m_fileName );
+    QVERIFY( file.open( QIODevice::WriteOnly | QIODevice::Truncate ) );
+
+    QDataStream out( &file );
+    out << magic << qint32( 015 );
+    out.setVersion( QDataStream::Qt_4_2 );
+
+    qreal lon;
+    qreal lat;
+    qreal alt;
+    foreach ( const GeoDataPlacemark &placemark, placemarks ) {
+        out << placemark.name();
+        placemark.coordinate().geoCoordinates( lon, lat, alt );
+        out << double( lon ) << double( lat ) << double( alt );
+        out << placemark.role() << placemark.description() << placemark.countryCode() << placemark.state();
+        out << double( placemark.area() ) << qint64( placemark.population() );
+        out << qint16( placemark.extendedData().value( "gmt" ).value().toInt() );
+        out << qint8( placemark.extendedData().value( "dst" ).value().toInt() );
+    }
+}
+
+GeoDataDocument *CacheRunnerTest::parse()
+{
+    m_document = 0;
+
+    MarbleAbstractRunner *const runner = m_plugin->newRunner();
+    connect( runner, SIGNAL( parsingFinished( GeoDataDocument*, QString ) ),
+             this, SLOT( setDocument( GeoDataDocument*, QString ) ), Qt::DirectConnection );
+    runner->parseFile( m_fileName, UserDocument );
+    delete runner;
+
+    return m_document;
+}
+
+QList<GeoDataPlacemark> CacheRunnerTest::testPlacemarks()
+{
+    GeoDataPlacemark berlin;
+    berlin.setName( "Berlin" );
+    berlin.setCoordinate( 13.4, 52.5, 34, GeoDataCoordinates::Degree );
+    berlin.setRole( "PC" );
+    berlin.setDescription( QString::fromUtf8( "Hauptstadt, Bundesland und Großstadt" ) );
+    berlin.setCountryCode( "DE" );
+    berlin.setState( "Berlin" );
+    berlin.setArea( 891.8 );
+    berlin.setPopulation( 3460725 );
+    berlin.extendedData().addValue( GeoDataData( "gmt", 100 ) );
+    berlin.extendedData().addValue( GeoDataData( "dst", 1 ) );
+
+    GeoDataPlacemark honolulu;
+    honolulu.setName( "Honolulu" );
+    honolulu.setCoordinate( -157.86, 21.31, 0, GeoDataCoordinates::Degree );
+    honolulu.setRole( "PR" );
+    honolulu.setCountryCode( "US" );
+    honolulu.setPopulation( 337256 );
+    honolulu.extendedData().addValue( GeoDataData( "gmt", -1000 ) );
+    honolulu.extendedData().addValue( GeoDataData( "dst", 0 ) );
+
+    return QList<GeoDataPlacemark>() << berlin << honolulu;
+}
+
+QList<GeoDataPlacemark> CacheRunnerTest::randomPlacemarks( int count )
+{
+    qsrand( 42 );
+    QList<GeoDataPlacemark> placemarks;
+    for ( int i = 0; i < count; ++i ) {
+        GeoDataPlacemark placemark;
+        placemark.setName( QString( "Place %1" ).arg( i ) );
+        placemark.setCoordinate( -180 + 360.0 * ( qrand() % 10000 ) / 10000.0,
+                                 -90 + 180.0 * ( qrand() % 10000 ) / 10000.0, 0, GeoDataCoordinates::Degree );
+        placemark.setRole( i % 2 ? "PPL" : "PPLA" );
+        placemark.setZoomLevel( qrand() % 19 );
+        placemarks << placemark;
+    }
+
+    return placemarks;
+}
+
+void CacheRunnerTest::writeMappedCache( const QList<GeoDataPlacemark> &placemarks )
+{
+    QVector<const GeoDataPlacemark*> pointers;
+    for ( int i = 0; i < placemarks.size(); ++i ) {
+        pointers << &placemarks.at( i );
+    }
+
+    QVERIFY( PlacemarkCache::write( m_fileName, pointers, QDateTime() ) );
+    QCOMPARE( PlacemarkCache::fileVersion( m_fileName ), PlacemarkCache::version );
+}
+
+void CacheRunnerTest::readPlacemarks()
+{
+    const QList<GeoDataPlacemark> placemarks = testPlacemarks();
+    writeCache( placemarks );
+
+    GeoDataDocument *const document = parse();
+    QVERIFY( document );
+    QCOMPARE( document->placemarkList().size(), placemarks.size() );
+
+    for ( int i = 0; i < placemarks.size(); ++i ) {
+        const GeoDataPlacemark &expected = placemarks.at( i );
+        const GeoDataPlacemark *const placemark = document->placemarkList().at( i );
+        QCOMPARE( placemark->name(), expected.name() );
+        QCOMPARE( placemark->coordinate(), expected.coordinate() );
+        QCOMPARE( placemark->role(), expected.role() );
+        QCOMPARE( placemark->description(), expected.description() );
+        QCOMPARE( placemark->countryCode(), expected.countryCode() );
+        QCOMPARE( placemark->state(), expected.state() );
+        QCOMPARE( placemark->area(), expected.area() );
+        QCOMPARE( placemark->population(), expected.population() );
+        QCOMPARE( placemark->extendedData().value( "gmt" ).value().toInt(),
+                  expected.extendedData().value( "gmt" ).value().toInt() );
+        QCOMPARE( placemark->extendedData().value( "dst" ).value().toInt(),
+                  expected.extendedData().value( "dst" ).value().toInt() );
+    }
+
+    delete document;
+}
+
+void CacheRunnerTest::readMappedPlacemarks()
+{
+    QList<GeoDataPlacemark> placemarks = testPlacemarks();
+    placemarks[0].setZoomLevel( 5 );
+    placemarks[0].setPopularity( 3460725 );
+    placemarks[0].setVisualCategory( GeoDataFeature::LargeNationCapital );
+    placemarks[1].setZoomLevel( 6 );
+    placemarks[1].setPopularity( 337256 );
+    placemarks[1].setVisualCategory( GeoDataFeature::MediumStateCapital );
+    writeMappedCache( placemarks );
+
+    GeoDataDocument *const document = parse();
+    QVERIFY( document );
+    QCOMPARE( document->placemarkList().size(), placemarks.size() );
+
+    // Records are sorted by zoom level
+    for ( int i = 0; i < placemarks.size(); ++i ) {
+        const GeoDataPlacemark &expected = placemarks.at( i );
+        const GeoDataPlacemark *const placemark = document->placemarkList().at( i );
+        QCOMPARE( placemark->name(), expected.name() );
+        QCOMPARE( placemark->coordinate(), expected.coordinate() );
+        QCOMPARE( placemark->role(), expected.role() );
+        QCOMPARE( placemark->description(), expected.description() );
+        QCOMPARE( placemark->countryCode(), expected.countryCode() );
+        QCOMPARE( placemark->state(), expected.state() );
+        QCOMPARE( placemark->area(), expected.area() );
+        QCOMPARE( placemark->population(), expected.population() );
+        QCOMPARE( placemark->popularity(), expected.popularity() );
+        QCOMPARE( placemark->zoomLevel(), expected.zoomLevel() );
+        QCOMPARE( placemark->visualCategory(), expected.visualCategory() );
+        QCOMPARE( placemark->extendedData().value( "gmt" ).value().toInt(),
+                  expected.extendedData().value( "gmt" ).value().toInt() );
+        QCOMPARE( placemark->extendedData().value( "dst" ).value().toInt(),
+                  expected.extendedData().value( "dst" ).value().toInt() );
+    }
+
+    delete document;
+}
+
+void CacheRunnerTest::mappedRegions()
+{
+    const QList<GeoDataPlacemark> placemarks = randomPlacemarks( 5000 );
+    writeMappedCache( placemarks );
+
+    PlacemarkCache cache;
+    QVERIFY( cache.open( m_fileName ) );
+    QCOMPARE( cache.size(), placemarks.size() );
+
+    const QList<GeoDataLatLonBox> boxes = QList<GeoDataLatLonBox>()
+        << GeoDataLatLonBox( 90, -90, 180, -180, GeoDataCoordinates::Degree )
+        << GeoDataLatLonBox( 52.6, 52.4, 13.6, 13.2, GeoDataCoordinates::Degree )
+        << GeoDataLatLonBox( 56, 45, 5, -12, GeoDataCoordinates::Degree )
+        << GeoDataLatLonBox( 20, -20, -170, 170, GeoDataCoordinates::Degree )
+        << GeoDataLatLonBox( -80, -90, 180, -180, GeoDataCoordinates::Degree );
+
+    // The index must find exactly what looking at each record finds
+    foreach ( const GeoDataLatLonBox &box, boxes ) {
+        foreach ( int zoomLevel, QList<int>() << 0 << 4 << 18 ) {
+            QStringList expected;
+            foreach ( const GeoDataPlacemark &placemark, placemarks ) {
+                if ( placemark.zoomLevel() <= zoomLevel && box.contains( placemark.coordinate() ) ) {
+                    expected << placemark.name();
+                }
+            }
+
+            QStringList names;
+            foreach ( int record, cache.records( box, zoomLevel ) ) {
+                GeoDataPlacemark *placemark = cache.placemark( record );
+                QVERIFY( placemark->zoomLevel() <= zoomLevel );
+                names << placemark->name();
+                delete placemark;
+            }
+
+            expected.sort();
+            names.sort();
+            QCOMPARE( names, expected );
+        }
+    }
+
+    // Placemarks are only created once
+    const QVector<int> records = cache.records( boxes.at( 2 ), 18 );
+    const QVector<GeoDataFeature*> created = cache.materialize( records );
+    QCOMPARE( created.size(), records.size() );
+    QVERIFY( cache.materialize( records ).isEmpty() );
+    qDeleteAll( created );
+}
+
+void CacheRunnerTest::mappedNames()
+{
+    const QList<GeoDataPlacemark> placemarks = randomPlacemarks( 100 );
+    writeMappedCache( placemarks );
+
+    PlacemarkCache cache;
+    QVERIFY( cache.open( m_fileName ) );
+
+    QStringList names;
+    foreach ( int record, cache.records( "place 1" ) ) {
+        GeoDataPlacemark *placemark = cache.placemark( record );
+        names << placemark->name();
+        delete placemark;
+    }
+    names.sort();
+
+    QStringList expected;
+    expected << "Place 1";
+    for ( int i = 10; i < 20; ++i ) {
+        expected << QString( "Place %1" ).arg( i );
+    }
+    expected.sort();
+
+    QCOMPARE( names, expected );
+}
+
+void CacheRunnerTest::rejectOtherFiles()
+{
+    GeoDataPlacemark placemark;
+    placemark.setName( "Berlin" );
+    writeCache( QList<GeoDataPlacemark>() << placemark, 0x4d534e50 );
+
+    QVERIFY( !parse() );
+}
+
+}
+
+QTEST_MAIN( Marble::CacheRunnerTest )
+
+#include "CacheRunnerTest.moc"
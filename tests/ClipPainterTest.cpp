@@ -0,0 +1,348 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include <QtTest/QtTest>
+#include <QtGui/QImage>
+#include <QtGui/QPolygonF>
+
+#include "ClipPainter.h"
+
+#include <cmath>
+
+Q_DECLARE_METATYPE( QPolygonF )
+
+namespace Marble
+{
+
+class ClipPainterTest : public QObject
+{
+    Q_OBJECT
+
+ private slots:
+    void drawInside();
+    void drawOutside();
+
+    void clipPolygon_data();
+    void clipPolygon();
+
+    void clipPolyline_data();
+    void clipPolyline();
+
+    void drawPolygon_data();
+    void drawPolygon();
+
+    void drawPolyline_data();
+    void drawPolyline();
+
+ private:
+    enum PolyObjectType {
+        CoastlineInside,
+        CoastlineOutside,
+        CoastlineCrossing,
+        CoastlineSurrounding,
+        Route
+    };
+
+    static void addPolyObjects();
+    static QPolygonF polyObject( int type );
+
+    /**
+     * A closed, jagged outline of @p size nodes around @p center, roughly
+     * the way a coastline looks on screen.
+     */
+    static QPolygonF coastline( const QPointF &center, qreal radius, int size );
+
+    /**
+     * A random walk of @p size nodes starting at @p start, roughly the way
+     * a route or a track looks on screen.
+     */
+    static QPolygonF route( const QPointF &start, qreal step, int size );
+
+    /**
+     * A polyline of @p size nodes from @p from to @p to whose nodes are
+     * alternately displaced by +@p offset and -@p offset, so that it crosses
+     * the line between @p from and @p to over and over again.
+     */
+    static QPolygonF zigzag( const QPointF &from, const QPointF &to, const QPointF &offset, int size );
+
+    /**
+     * Renders @p polyObject with and without ClipPainter's own clipping and
+     * returns the number of pixels that differ between both images.
+     */
+    static int differingPixels( const QPolygonF &polyObject, bool isClosed, int *painted );
+};
+
+QPolygonF ClipPainterTest::coastline( const QPointF &center, qreal radius, int size )
+{
+    qsrand( size );
+
+    QPolygonF polygon;
+    polygon.reserve( size );
+    for ( int i = 0; i < size; ++i ) {
+        const qreal angle = 2 * M_PI * i / size;
+        const qreal r = radius * ( 0.8 + 0.2 * ( qrand() % 1000 ) / 1000.0 );
+        polygon << QPointF( center.x() + r * cos( angle ), center.y() + r * sin( angle ) );
+    }
+
+    return polygon;
+}
+
+QPolygonF ClipPainterTest::route( const QPointF &start, qreal step, int size )
+{
+    qsrand( size );
+
+    QPolygonF polyline;
+    polyline.reserve( size );
+    QPointF point = start;
+    qreal heading = 0;
+    for ( int i = 0; i < size; ++i ) {
+        polyline << point;
+        heading += ( ( qrand() % 1000 ) / 1000.0 - 0.5 ) * 0.5;
+        point += QPointF( step * cos( heading ), step * sin( heading ) );
+    }
+
+    return polyline;
+}
+
+QPolygonF ClipPainterTest::zigzag( const QPointF &from, const QPointF &to, const QPointF &offset, int size )
+{
+    QPolygonF polyline;
+    polyline.reserve( size );
+    for ( int i = 0; i < size; ++i ) {
+        const QPointF point = from + ( to - from ) * i / ( size - 1 );
+        polyline << ( i % 2 ? point - offset : point + offset );
+    }
+
+    return polyline;
+}
+
+int ClipPainterTest::differingPixels( const QPolygonF &polyObject, bool isClosed, int *painted )
+{
+    QImage clipped( 400, 300, QImage::Format_ARGB32_Premultiplied );
+    clipped.fill( 0 );
+    QImage unclipped( clipped.size(), QImage::Format_ARGB32_Premultiplied );
+    unclipped.fill( 0 );
+
+    {
+        ClipPainter painter( &clipped, true );
+        painter.setBrush( Qt::blue );
+        if ( isClosed )
+            painter.drawPolygon( polyObject );
+        else
+            painter.drawPolyline( polyObject );
+    }
+
+    {
+        ClipPainter painter( &unclipped, false );
+        painter.setBrush( Qt::blue );
+        if ( isClosed )
+            painter.drawPolygon( polyObject );
+        else
+            painter.drawPolyline( polyObject );
+    }
+
+    int differing = 0;
+    *painted = 0;
+    for ( int y = 0; y < clipped.height(); ++y ) {
+        const QRgb *clippedLine = reinterpret_cast<const QRgb *>( clipped.scanLine( y ) );
+        const QRgb *unclippedLine = reinterpret_cast<const QRgb *>( unclipped.scanLine( y ) );
+        for ( int x = 0; x < clipped.width(); ++x ) {
+            if ( unclippedLine[x] != 0 )
+                ++*painted;
+            if ( clippedLine[x] != unclippedLine[x] )
+                ++differing;
+        }
+    }
+
+    return differing;
+}
+
+void ClipPainterTest::drawInside()
+{
+    const QPolygonF polygon = coastline( QPointF( 200, 150 ), 100, 500 );
+
+    QImage clipped( 400, 300, QImage::Format_ARGB32_Premultiplied );
+    clipped.fill( 0 );
+    QImage unclipped( clipped.size(), QImage::Format_ARGB32_Premultiplied );
+    unclipped.fill( 0 );
+
+    {
+        ClipPainter painter( &clipped, true );
+        painter.setBrush( Qt::blue );
+        painter.drawPolygon( polygon );
+        painter.drawPolyline( polygon );
+    }
+
+    {
+        ClipPainter painter( &unclipped, false );
+        painter.setBrush( Qt::blue );
+        painter.drawPolygon( polygon );
+        painter.drawPolyline( polygon );
+    }
+
+    QCOMPARE( clipped, unclipped );
+}
+
+void ClipPainterTest::drawOutside()
+{
+    QImage image( 400, 300, QImage::Format_ARGB32_Premultiplied );
+    image.fill( 0 );
+    const QImage empty = image;
+
+    {
+        ClipPainter painter( &image, true );
+        painter.setBrush( Qt::blue );
+        painter.drawPolygon( coastline( QPointF( -500, 150 ), 100, 500 ) );
+        painter.drawPolygon( coastline( QPointF( 200, 1000 ), 100, 500 ) );
+        painter.drawPolyline( route( QPointF( 1000, -1000 ), 1, 500 ) );
+        painter.drawPolyline( QPolygonF() );
+    }
+
+    QCOMPARE( image, empty );
+}
+
+void ClipPainterTest::clipPolygon_data()
+{
+    QTest::addColumn<QPolygonF>( "polygon" );
+
+    // Coastlines around each edge and each corner of the 400x300 viewport
+    QTest::newRow( "left edge" ) << coastline( QPointF( 0, 150 ), 80, 60 );
+    QTest::newRow( "right edge" ) << coastline( QPointF( 400, 150 ), 80, 60 );
+    QTest::newRow( "top edge" ) << coastline( QPointF( 200, 0 ), 80, 60 );
+    QTest::newRow( "bottom edge" ) << coastline( QPointF( 200, 300 ), 80, 60 );
+    QTest::newRow( "top left corner" ) << coastline( QPointF( 0, 0 ), 80, 60 );
+    QTest::newRow( "top right corner" ) << coastline( QPointF( 400, 0 ), 80, 60 );
+    QTest::newRow( "bottom left corner" ) << coastline( QPointF( 0, 300 ), 80, 60 );
+    QTest::newRow( "bottom right corner" ) << coastline( QPointF( 400, 300 ), 80, 60 );
+    QTest::newRow( "all edges" ) << coastline( QPointF( 200, 150 ), 260, 60 );
+    QTest::newRow( "jagged left edge" ) << QPolygonF( zigzag( QPointF( 0, -50 ), QPointF( 0, 350 ), QPointF( 40, 0 ), 21 )
+                                                    << QPointF( 200, 350 ) << QPointF( 200, -50 ) );
+}
+
+void ClipPainterTest::clipPolygon()
+{
+    QFETCH( QPolygonF, polygon );
+
+    int painted = 0;
+    const int differing = differingPixels( polygon, true, &painted );
+
+    QVERIFY( painted > 0 );
+    // Only the rounding of the interpolated nodes may show at the edges
+    QVERIFY2( differing <= painted / 200,
+              qPrintable( QString( "%1 of %2 pixels differ" ).arg( differing ).arg( painted ) ) );
+}
+
+void ClipPainterTest::clipPolyline_data()
+{
+    QTest::addColumn<QPolygonF>( "polyline" );
+
+    // Zigzags across each edge and each corner of the 400x300 viewport
+    QTest::newRow( "left edge" ) << zigzag( QPointF( 0, 10 ), QPointF( 0, 290 ), QPointF( 40, 0 ), 15 );
+    QTest::newRow( "right edge" ) << zigzag( QPointF( 400, 10 ), QPointF( 400, 290 ), QPointF( 40, 0 ), 15 );
+    QTest::newRow( "top edge" ) << zigzag( QPointF( 10, 0 ), QPointF( 390, 0 ), QPointF( 0, 40 ), 20 );
+    QTest::newRow( "bottom edge" ) << zigzag( QPointF( 10, 300 ), QPointF( 390, 300 ), QPointF( 0, 40 ), 20 );
+    QTest::newRow( "top left corner" ) << zigzag( QPointF( -60, 60 ), QPointF( 60, -60 ), QPointF( 30, 30 ), 9 );
+    QTest::newRow( "top right corner" ) << zigzag( QPointF( 340, -60 ), QPointF( 460, 60 ), QPointF( -30, 30 ), 9 );
+    QTest::newRow( "bottom left corner" ) << zigzag( QPointF( -60, 240 ), QPointF( 60, 360 ), QPointF( 30, -30 ), 9 );
+    QTest::newRow( "bottom right corner" ) << zigzag( QPointF( 340, 360 ), QPointF( 460, 240 ), QPointF( -30, -30 ), 9 );
+    QTest::newRow( "through the viewport" ) << ( QPolygonF() << QPointF( -100, -100 ) << QPointF( 500, 400 )
+                                                             << QPointF( 500, -100 ) << QPointF( -100, 400 ) );
+    QTest::newRow( "route" ) << route( QPointF( -50, 150 ), 10, 200 );
+}
+
+void ClipPainterTest::clipPolyline()
+{
+    QFETCH( QPolygonF, polyline );
+
+    int painted = 0;
+    const int differing = differingPixels( polyline, false, &painted );
+
+    QVERIFY( painted > 0 );
+    // Only the rounding of the interpolated nodes may show at the edges
+    QVERIFY2( differing <= painted / 50,
+              qPrintable( QString( "%1 of %2 pixels differ" ).arg( differing ).arg( painted ) ) );
+}
+
+void ClipPainterTest::addPolyObjects()
+{
+    QTest::addColumn<int>( "type" );
+    QTest::addColumn<bool>( "clip" );
+
+    QTest::newRow( "coastline inside" ) << (int)CoastlineInside << true;
+    QTest::newRow( "coastline inside, no clipping" ) << (int)CoastlineInside << false;
+    QTest::newRow( "coastline outside" ) << (int)CoastlineOutside << true;
+    QTest::newRow( "coastline crossing" ) << (int)CoastlineCrossing << true;
+    QTest::newRow( "coastline surrounding" ) << (int)CoastlineSurrounding << true;
+    QTest::newRow( "route" ) << (int)Route << true;
+}
+
+QPolygonF ClipPainterTest::polyObject( int type )
+{
+    // Inside, outside, crossing and surrounding the 800x600 viewport
+    switch ( type ) {
+    case CoastlineInside:
+        return coastline( QPointF( 400, 300 ), 200, 10000 );
+    case CoastlineOutside:
+        return coastline( QPointF( -2000, 300 ), 1000, 10000 );
+    case CoastlineCrossing:
+        return coastline( QPointF( 0, 0 ), 500, 10000 );
+    case CoastlineSurrounding:
+        return coastline( QPointF( 400, 300 ), 5000, 10000 );
+    case Route:
+        return route( QPointF( -1000, 300 ), 1, 10000 );
+    }
+
+    return QPolygonF();
+}
+
+void ClipPainterTest::drawPolygon_data()
+{
+    addPolyObjects();
+}
+
+void ClipPainterTest::drawPolygon()
+{
+    QFETCH( int, type );
+    QFETCH( bool, clip );
+
+    const QPolygonF polygon = polyObject( type );
+
+    QImage image( 800, 600, QImage::Format_ARGB32_Premultiplied );
+    ClipPainter painter( &image, clip );
+    painter.setBrush( Qt::blue );
+
+    QBENCHMARK {
+        painter.drawPolygon( polygon );
+    }
+}
+
+void ClipPainterTest::drawPolyline_data()
+{
+    addPolyObjects();
+}
+
+void ClipPainterTest::drawPolyline()
+{
+    QFETCH( int, type );
+    QFETCH( bool, clip );
+
+    const QPolygonF polygon = polyObject( type );
+
+    QImage image( 800, 600, QImage::Format_ARGB32_Premultiplied );
+    ClipPainter painter( &image, clip );
+
+    QBENCHMARK {
+        painter.drawPolyline( polygon );
+    }
+}
+
+}
+
+QTEST_MAIN( Marble::ClipPainterTest )
+
+#include "ClipPainterTest.moc"
@@ -0,0 +1,128 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include <QtTest/QtTest>
+#include <QtCore/QAtomicInt>
+
+#include "GeoDataCoordinates.h"
+#include "GeoPainter.h"
+#include "MarbleMap.h"
+#include "TileId.h"
+#include "ViewportParams.h"
+
+#include <cstdlib>
+#include <new>
+
+// Count every allocation made through operator new in this executable.
+static QAtomicInt s_allocations;
+
+// Dynamic exception specifications are deprecated since C++11 and have to
+// match the declarations of <new> before
+#if __cplusplus >= 201103L
+#define ALLOCATION_THROWS
+#define ALLOCATION_NOTHROW noexcept
+#else
+#define ALLOCATION_THROWS throw( std::bad_alloc )
+#define ALLOCATION_NOTHROW throw()
+#endif
+
+void *operator new( size_t size ) ALLOCATION_THROWS
+{
+    s_allocations.ref();
+    void *p = std::malloc( size ? size : 1 );
+    if ( !p ) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete( void *p ) ALLOCATION_NOTHROW
+{
+    std::free( p );
+}
+
+void *operator new[]( size_t size ) ALLOCATION_THROWS
+{
+    return operator new( size );
+}
+
+void operator delete[]( void *p ) ALLOCATION_NOTHROW
+{
+    operator delete( p );
+}
+
+namespace Marble
+{
+
+class FrameAllocationTest : public QObject
+{
+    Q_OBJECT
+
+ private slots:
+    void coordinatesTemporaries();
+    void paintFrame_data();
+    void paintFrame();
+};
+
+void FrameAllocationTest::coordinatesTemporaries()
+{
+    const int before = s_allocations;
+
+    qreal sum = 0;
+    for ( int i = 0; i < 10000; ++i ) {
+        GeoDataCoordinates coordinates( i * 0.01, i * 0.005, 0, GeoDataCoordinates::Degree );
+        GeoDataCoordinates copy( coordinates );
+        GeoDataCoordinates assigned;
+        assigned = copy;
+        assigned.setAltitude( i );
+        sum += TileId::fromCoordinates( assigned, 10 ).x();
+    }
+
+    QVERIFY( sum > 0 );
+    QCOMPARE( s_allocations - before, 0 );
+}
+
+void FrameAllocationTest::paintFrame_data()
+{
+    QTest::addColumn<QString>( "mapThemeId" );
+
+    QTest::newRow( "plain" ) << "earth/plain/plain.dgml";
+    QTest::newRow( "atlas" ) << "earth/srtm/srtm.dgml";
+}
+
+void FrameAllocationTest::paintFrame()
+{
+    QFETCH( QString, mapThemeId );
+
+    MarbleMap map;
+    map.setMapThemeId( mapThemeId );
+    map.setSize( 800, 600 );
+    map.setRadius( 1000 );
+
+    QImage image( map.size(), QImage::Format_ARGB32_Premultiplied );
+    GeoPainter painter( &image, map.viewport(), map.mapQuality(), true );
+
+    map.paint( painter, QRect() ); // loads tiles and placemarks
+    QThreadPool::globalInstance()->waitForDone();
+
+    const int before = s_allocations;
+    map.paint( painter, QRect() );
+    qDebug() << mapThemeId << "allocations per frame:" << s_allocations - before;
+
+    QBENCHMARK {
+        map.paint( painter, QRect() );
+    }
+
+    QThreadPool::globalInstance()->waitForDone();  // wait for all runners to terminate
+}
+
+}
+
+QTEST_MAIN( Marble::FrameAllocationTest )
+
+#include "FrameAllocationTest.moc"
@@ -12,6 +12,7 @@
 #include "GeoPainter.h"
 #include "MarbleMap.h"
 #include "MarbleModel.h"
+#include "VectorComposer.h"
 
 namespace QTest
 {
@@ -84,7 +85,14 @@ class MarbleMapTest : public QObject
     void paint_data();
     void paint();
 
+    void paintVectorMap_data();
+    void paintVectorMap();
+
+    void loadVectorMap();
+
  private:
+    static bool waitForVectorMap( VectorComposer &composer );
+
     MarbleModel m_model;
 };
 
@@ -614,6 +622,91 @@ void MarbleMapTest::paint()
     QThreadPool::globalInstance()->waitForDone();  // wait for all runners to terminate
 }
 
+void MarbleMapTest::paintVectorMap_data()
+{
+    QTest::addColumn<int>( "projection" );
+    QTest::addColumn<int>( "radius" );
+
+    addRow() << (int)Spherical << 250;
+    addRow() << (int)Spherical << 2000;
+    addRow() << (int)Spherical << 20000;
+    addRow() << (int)Spherical << 200000;
+    addRow() << (int)Equirectangular << 2000;
+    addRow() << (int)Equirectangular << 200000;
+    addRow() << (int)Mercator << 2000;
+    addRow() << (int)Mercator << 200000;
+}
+
+/*
+ * Frame time of the plain map, which is made up of the coastlines, lakes,
+ * rivers and borders of the PNT datasets, at different zoom levels.
+ */
+void MarbleMapTest::paintVectorMap()
+{
+    QFETCH( int, projection );
+    QFETCH( int, radius );
+
+    MarbleMap map;
+    map.setMapThemeId( "earth/plain/plain.dgml" );
+    map.setSize( 800, 600 );
+    map.setProjection( (Projection)projection );
+    map.setRadius( radius );
+    map.centerOn( 8.4, 49.0 );
+
+    // Shares the PNT datasets with the vector composer of the map
+    VectorComposer composer;
+
+    QPixmap paintDevice( map.size() );
+    GeoPainter painter( &paintDevice, map.viewport(), map.mapQuality(), true );
+
+    map.paint( painter, QRect() ); // starts loading the PNT files
+    QVERIFY( waitForVectorMap( composer ) );
+
+    QBENCHMARK {
+        map.paint( painter, QRect() );
+    }
+}
+
+/*
+ * Time from the first paint of the plain map until all of its PNT datasets
+ * are decoded, which makes up most of the startup time of that map.
+ */
+void MarbleMapTest::loadVectorMap()
+{
+    QBENCHMARK_ONCE {
+        VectorComposer composer;
+
+        MarbleMap map;
+        map.setMapThemeId( "earth/plain/plain.dgml" );
+        map.setSize( 800, 600 );
+
+        QPixmap paintDevice( map.size() );
+        GeoPainter painter( &paintDevice, map.viewport(), map.mapQuality(), true );
+
+        map.paint( painter, QRect() );
+        QVERIFY( waitForVectorMap( composer ) );
+    }
+}
+
+bool MarbleMapTest::waitForVectorMap( VectorComposer &composer )
+{
+    QSignalSpy loaded( &composer, SIGNAL( datasetLoaded() ) );
+
+    // Each dataset reports back once its loader thread is done
+    while ( !composer.isLoaded() ) {
+        const int count = loaded.count();
+        QEventLoop loop;
+        connect( &composer, SIGNAL( datasetLoaded() ), &loop, SLOT( quit() ) );
+        QTimer::singleShot( 10000, &loop, SLOT( quit() ) );
+        loop.exec();
+        if ( loaded.count() == count ) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 }
 
 QTEST_MAIN( Marble::MarbleMapTest )
@@ -10,12 +10,17 @@
 
 #include <QtTest/QtTest>
 #include <QtTest/QSignalSpy>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
 #include <QtCore/QMetaType>
 
 #include "MarbleDebug.h"
 #include "MarbleDirs.h"
 #include "MarbleRunnerManager.h"
+#include "ParseRunnerPlugin.h"
+#include "ParseRunnerSelection.h"
 #include "PluginManager.h"
+#include "GeoDataDocument.h"
 #include "GeoDataPlacemark.h"
 #include "routing/RouteRequest.h"
 
@@ -56,6 +61,11 @@ private slots:
     void testAsyncParsing_data();
     void testAsyncParsing();
 
+    void testParsingByContent();
+
+    void testRunnerSelection_data();
+    void testRunnerSelection();
+
 public:
     PluginManager m_pluginManager;
     int m_time;
@@ -329,6 +339,69 @@ void MarbleRunnerManagerTest::testAsyncParsing()
     QThreadPool::globalInstance()->waitForDone();
 }
 
+void MarbleRunnerManagerTest::testParsingByContent()
+{
+    // A kml file without the kml extension is still given to the kml runner
+    const QString fileName = QDir::tempPath() + "/MarbleRunnerManagerTest.txt";
+    QFile file( fileName );
+    QVERIFY( file.open( QIODevice::WriteOnly ) );
+    file.write( "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                "<!-- <gpx> in a comment -->\n"
+                "<kml xmlns=\"http://www.opengis.net/kml/2.2\"><Document>"
+                "<Placemark><name>Berlin</name><Point><coordinates>13.4,52.5</coordinates></Point></Placemark>"
+                "</Document></kml>" );
+    file.close();
+
+    MarbleRunnerManager m_runnerManager(&m_pluginManager, this);
+
+    QSignalSpy finishSpy( &m_runnerManager, SIGNAL( parsingFinished() ) );
+
+    GeoDataDocument* document = m_runnerManager.openFile( fileName );
+    QFile::remove( fileName );
+
+    QVERIFY( document != 0 );
+    QCOMPARE( document->placemarkList().size(), 1 );
+    QCOMPARE( document->placemarkList().first()->name(), m_name );
+    QCOMPARE( finishSpy.count(), 1 );
+    delete document;
+}
+
+void MarbleRunnerManagerTest::testRunnerSelection_data()
+{
+    QTest::addColumn<QString>( "fileName" );
+    QTest::addColumn<QByteArray>( "content" );
+    QTest::addColumn<QString>( "runner" );
+
+    // Files are only read if no runner is registered for their extension
+    QTest::newRow( "Extension" ) << "MarbleRunnerManagerTest.kml" << QByteArray( "<gpx></gpx>" ) << "Kml";
+    QTest::newRow( "Upper case extension" ) << "MarbleRunnerManagerTest.GPX" << QByteArray() << "Gpx";
+    QTest::newRow( "Longest extension" ) << "MarbleRunnerManagerTest.osm.pbf" << QByteArray() << "Pbf";
+    QTest::newRow( "Content" ) << "MarbleRunnerManagerTest.txt" << QByteArray( "<?xml version=\"1.0\"?><gpx></gpx>" ) << "Gpx";
+}
+
+void MarbleRunnerManagerTest::testRunnerSelection()
+{
+    QFETCH( QString, fileName );
+    QFETCH( QByteArray, content );
+    QFETCH( QString, runner );
+
+    if ( m_pluginManager.parsingRunnerPlugins().isEmpty() ) {
+        QSKIP( "No parse runner plugins installed", SkipAll );
+    }
+
+    QFile file( QDir::tempPath() + '/' + fileName );
+    QVERIFY( file.open( QIODevice::WriteOnly ) );
+    file.write( content );
+    file.close();
+
+    const ParseRunnerSelection selection( m_pluginManager.parsingRunnerPlugins() );
+    const QList<const ParseRunnerPlugin*> plugins = selection.plugins( file.fileName() );
+    file.remove();
+
+    QVERIFY( !plugins.isEmpty() );
+    QCOMPARE( plugins.first()->nameId(), runner );
+}
+
 }
 
 QTEST_MAIN( Marble::MarbleRunnerManagerTest )
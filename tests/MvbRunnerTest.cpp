@@ -0,0 +1,297 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include <QtTest/QtTest>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+
+#include "GeoDataDocument.h"
+#include "GeoDataLineString.h"
+#include "GeoDataMultiGeometry.h"
+#include "GeoDataPlacemark.h"
+#include "GeoDataPoint.h"
+#include "GeoDataPolygon.h"
+#include "GeoDataTypes.h"
+#include "MarbleAbstractRunner.h"
+#include "MarbleDirs.h"
+#include "ParseRunnerPlugin.h"
+#include "PluginManager.h"
+#include "MvbWriter.h"
+
+namespace Marble
+{
+
+class MvbRunnerTest : public QObject
+{
+    Q_OBJECT
+
+ public slots:
+    void setDocument( GeoDataDocument *document, const QString &error );
+
+ private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void roundTrip();
+    void invalidVisualCategory();
+    void multiGeometry();
+
+    void decode_data();
+    void decode();
+
+ private:
+    /**
+     * Writes a tile in Kothic's JSON format with @p size line strings and
+     * polygons of @p nodes nodes each.
+     */
+    static void writeJsonTile( const QString &fileName, int size, int nodes );
+
+    static void writeMvbTile( const GeoDataDocument &document, const QString &fileName );
+
+    GeoDataDocument *parse( const ParseRunnerPlugin *plugin, const QString &fileName );
+
+    PluginManager m_pluginManager;
+    const ParseRunnerPlugin *m_jsonPlugin;
+    const ParseRunnerPlugin *m_mvbPlugin;
+    GeoDataDocument *m_document;
+    QString m_jsonFileName;
+    QString m_mvbFileName;
+};
+
+void MvbRunnerTest::setDocument( GeoDataDocument *document, const QString &error )
+{
+    Q_UNUSED( error );
+
+    m_document = document;
+}
+
+void MvbRunnerTest::initTestCase()
+{
+    MarbleDirs::setMarblePluginPath( PLUGIN_PATH );
+
+    m_jsonPlugin = 0;
+    m_mvbPlugin = 0;
+    foreach ( const ParseRunnerPlugin *plugin, m_pluginManager.parsingRunnerPlugins() ) {
+        if ( plugin->nameId() == "Json" ) {
+            m_jsonPlugin = plugin;
+        } else if ( plugin->nameId() == "Mvb" ) {
+            m_mvbPlugin = plugin;
+        }
+    }
+
+    if ( !m_jsonPlugin || !m_mvbPlugin ) {
+        QSKIP( "The Json and Mvb plugins are needed", SkipAll );
+    }
+
+    m_jsonFileName = QDir::tempPath() + "/MvbRunnerTest.js";
+    m_mvbFileName = QDir::tempPath() + "/MvbRunnerTest.mvb";
+}
+
+void MvbRunnerTest::cleanupTestCase()
+{
+    QFile::remove( m_jsonFileName );
+    QFile::remove( m_mvbFileName );
+}
+
+void MvbRunnerTest::writeJsonTile( const QString &fileName, int size, int nodes )
+{
+    qsrand( size );
+
+    const int granularity = 10000;
+
+    QByteArray json = "onKothicDataResponse({\"features\":[";
+    for ( int i = 0; i < size; ++i ) {
+        const bool polygon = i % 2;
+        json += polygon ? QByteArray( "{\"type\":\"Polygon\",\"properties\":{\"building\":\"yes\"},\"coordinates\":[[" )
+                        : "{\"type\":\"LineString\",\"properties\":{\"name\":\"Street " + QByteArray::number( i % 100 )
+                          + "\",\"highway\":\"residential\"},\"coordinates\":[";
+        for ( int j = 0; j < nodes; ++j ) {
+            json += ( j > 0 ? ",[" : "[" ) + QByteArray::number( qrand() % granularity )
+                    + ',' + QByteArray::number( qrand() % granularity ) + ']';
+        }
+        json += polygon ? "]]}" : "]}";
+        json += i + 1 < size ? "," : "";
+    }
+    json += "],\"bbox\":[13.35,52.5,13.4,52.53],\"granularity\":" + QByteArray::number( granularity ) + "},15,17600,10750);";
+
+    QFile file( fileName );
+    QVERIFY( file.open( QIODevice::WriteOnly ) );
+    QCOMPARE( file.write( json ), qint64( json.size() ) );
+}
+
+void MvbRunnerTest::writeMvbTile( const GeoDataDocument &document, const QString &fileName )
+{
+    QFile file( fileName );
+    QVERIFY( file.open( QIODevice::WriteOnly ) );
+    QVERIFY( MvbWriter().write( &file, document ) );
+}
+
+GeoDataDocument *MvbRunnerTest::parse( const ParseRunnerPlugin *plugin, const QString &fileName )
+{
+    m_document = 0;
+
+    MarbleAbstractRunner *const runner = plugin->newRunner();
+    connect( runner, SIGNAL( parsingFinished( GeoDataDocument*, QString ) ),
+             this, SLOT( setDocument( GeoDataDocument*, QString ) ), Qt::DirectConnection );
+    runner->parseFile( fileName, UserDocument );
+    delete runner;
+
+    return m_document;
+}
+
+void MvbRunnerTest::roundTrip()
+{
+    writeJsonTile( m_jsonFileName, 100, 20 );
+
+    GeoDataDocument *const json = parse( m_jsonPlugin, m_jsonFileName );
+    QVERIFY( json );
+    QCOMPARE( json->size(), 100 );
+
+    writeMvbTile( *json, m_mvbFileName );
+    QVERIFY( QFileInfo( m_mvbFileName ).size() < QFileInfo( m_jsonFileName ).size() );
+
+    GeoDataDocument *const mvb = parse( m_mvbPlugin, m_mvbFileName );
+    QVERIFY( mvb );
+    QCOMPARE( mvb->name(), json->name() );
+    QCOMPARE( mvb->size(), json->size() );
+
+    for ( int i = 0; i < json->size(); ++i ) {
+        const GeoDataPlacemark *const expected = static_cast<const GeoDataPlacemark *>( json->featureList().at( i ) );
+        const GeoDataPlacemark *const actual = static_cast<const GeoDataPlacemark *>( mvb->featureList().at( i ) );
+        QCOMPARE( actual->name(), expected->name() );
+        QCOMPARE( int( actual->visualCategory() ), int( expected->visualCategory() ) );
+        QCOMPARE( QString( actual->geometry()->nodeType() ), QString( expected->geometry()->nodeType() ) );
+
+        const GeoDataPolygon *const expectedPolygon = dynamic_cast<const GeoDataPolygon *>( expected->geometry() );
+        const GeoDataLineString &expectedLine = expectedPolygon ? expectedPolygon->outerBoundary()
+                                                                : *static_cast<const GeoDataLineString *>( expected->geometry() );
+        const GeoDataPolygon *const actualPolygon = dynamic_cast<const GeoDataPolygon *>( actual->geometry() );
+        const GeoDataLineString &actualLine = actualPolygon ? actualPolygon->outerBoundary()
+                                                            : *static_cast<const GeoDataLineString *>( actual->geometry() );
+        QCOMPARE( int( actualLine.tessellationFlags() ), int( expectedLine.tessellationFlags() ) );
+        QCOMPARE( actualLine.size(), expectedLine.size() );
+        for ( int j = 0; j < expectedLine.size(); ++j ) {
+            QVERIFY( qAbs( actualLine.at( j ).longitude( GeoDataCoordinates::Degree )
+                           - expectedLine.at( j ).longitude( GeoDataCoordinates::Degree ) ) < 1e-6 );
+            QVERIFY( qAbs( actualLine.at( j ).latitude( GeoDataCoordinates::Degree )
+                           - expectedLine.at( j ).latitude( GeoDataCoordinates::Degree ) ) < 1e-6 );
+        }
+    }
+
+    delete json;
+    delete mvb;
+}
+
+void MvbRunnerTest::invalidVisualCategory()
+{
+    GeoDataDocument document;
+    for ( int i = 0; i < 3; ++i ) {
+        GeoDataPlacemark *const placemark = new GeoDataPlacemark( QString( "Place %1" ).arg( i ) );
+        placemark->setCoordinate( 13.4, 52.5, 0.0, GeoDataCoordinates::Degree );
+        document.append( placemark );
+    }
+    static_cast<GeoDataPlacemark *>( document.featureList().at( 0 ) )->setVisualCategory( GeoDataFeature::SmallCity );
+    static_cast<GeoDataPlacemark *>( document.featureList().at( 1 ) )->setVisualCategory( GeoDataFeature::LastIndex );
+    static_cast<GeoDataPlacemark *>( document.featureList().at( 2 ) )->setVisualCategory( GeoDataFeature::GeoDataVisualCategory( 1 << 30 ) );
+
+    writeMvbTile( document, m_mvbFileName );
+
+    GeoDataDocument *const mvb = parse( m_mvbPlugin, m_mvbFileName );
+    QVERIFY( mvb );
+    QCOMPARE( mvb->size(), 3 );
+    QCOMPARE( int( static_cast<const GeoDataPlacemark *>( mvb->featureList().at( 0 ) )->visualCategory() ),
+              int( GeoDataFeature::SmallCity ) );
+    QCOMPARE( int( static_cast<const GeoDataPlacemark *>( mvb->featureList().at( 1 ) )->visualCategory() ),
+              int( GeoDataFeature::Default ) );
+    QCOMPARE( int( static_cast<const GeoDataPlacemark *>( mvb->featureList().at( 2 ) )->visualCategory() ),
+              int( GeoDataFeature::Default ) );
+
+    delete mvb;
+}
+
+void MvbRunnerTest::multiGeometry()
+{
+    GeoDataDocument document;
+
+    GeoDataMultiGeometry *const multiGeometry = new GeoDataMultiGeometry;
+    multiGeometry->append( new GeoDataPoint( 13.4, 52.5, 0.0, GeoDataCoordinates::Degree ) );
+    GeoDataLineString *const lineString = new GeoDataLineString;
+    lineString->append( GeoDataCoordinates( 13.4, 52.5, 0.0, GeoDataCoordinates::Degree ) );
+    lineString->append( GeoDataCoordinates( 13.5, 52.6, 0.0, GeoDataCoordinates::Degree ) );
+    multiGeometry->append( lineString );
+    GeoDataPlacemark *const parts = new GeoDataPlacemark( "Parts" );
+    parts->setGeometry( multiGeometry );
+    document.append( parts );
+
+    // Nothing to encode in an empty multi geometry
+    GeoDataPlacemark *const empty = new GeoDataPlacemark( "Empty" );
+    empty->setGeometry( new GeoDataMultiGeometry );
+    document.append( empty );
+
+    QFile file( m_mvbFileName );
+    QVERIFY( file.open( QIODevice::WriteOnly ) );
+    MvbWriter writer;
+    QVERIFY( writer.write( &file, document ) );
+    QCOMPARE( writer.skippedCount(), 1 );
+    file.close();
+
+    GeoDataDocument *const mvb = parse( m_mvbPlugin, m_mvbFileName );
+    QVERIFY( mvb );
+    QCOMPARE( mvb->size(), 2 );
+
+    const GeoDataPlacemark *const point = static_cast<const GeoDataPlacemark *>( mvb->featureList().at( 0 ) );
+    QCOMPARE( point->name(), QString( "Parts" ) );
+    QCOMPARE( QString( point->geometry()->nodeType() ), QString( GeoDataTypes::GeoDataPointType ) );
+    const GeoDataPlacemark *const line = static_cast<const GeoDataPlacemark *>( mvb->featureList().at( 1 ) );
+    QCOMPARE( line->name(), QString( "Parts" ) );
+    QCOMPARE( QString( line->geometry()->nodeType() ), QString( GeoDataTypes::GeoDataLineStringType ) );
+    QCOMPARE( static_cast<const GeoDataLineString *>( line->geometry() )->size(), 2 );
+
+    delete mvb;
+}
+
+void MvbRunnerTest::decode_data()
+{
+    QTest::addColumn<bool>( "binary" );
+    QTest::addColumn<int>( "size" );
+
+    // A city tile has a few thousand ways
+    QTest::newRow( "json, 500" ) << false << 500;
+    QTest::newRow( "mvb, 500" ) << true << 500;
+    QTest::newRow( "json, 5000" ) << false << 5000;
+    QTest::newRow( "mvb, 5000" ) << true << 5000;
+}
+
+void MvbRunnerTest::decode()
+{
+    QFETCH( bool, binary );
+    QFETCH( int, size );
+
+    writeJsonTile( m_jsonFileName, size, 20 );
+
+    if ( binary ) {
+        GeoDataDocument *const json = parse( m_jsonPlugin, m_jsonFileName );
+        QVERIFY( json );
+        writeMvbTile( *json, m_mvbFileName );
+        delete json;
+    }
+
+    const ParseRunnerPlugin *const plugin = binary ? m_mvbPlugin : m_jsonPlugin;
+    const QString fileName = binary ? m_mvbFileName : m_jsonFileName;
+
+    QBENCHMARK {
+        delete parse( plugin, fileName );
+    }
+}
+
+}
+
+QTEST_MAIN( Marble::MvbRunnerTest )
+
+#include "MvbRunnerTest.moc"
@@ -0,0 +1,469 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include <QtTest/QtTest>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QtEndian>
+
+#include "GeoDataDocument.h"
+#include "GeoDataLineString.h"
+#include "GeoDataPlacemark.h"
+#include "GeoDataPolygon.h"
+#include "MarbleAbstractRunner.h"
+#include "MarbleDirs.h"
+#include "ParseRunnerPlugin.h"
+#include "PluginManager.h"
+
+namespace Marble
+{
+
+/**
+ * A generated extract: a grid of nodes, some of them restaurants, streets
+ * and buildings on top of it and a forest relation around everything.
+ */
+struct Extract
+{
+    struct Node {
+        qint64 id;
+        qint64 lon;
+        qint64 lat;
+        bool restaurant;
+    };
+
+    struct Way {
+        qint64 id;
+        QVector<qint64> refs;
+        bool building;
+    };
+
+    explicit Extract( int ways );
+
+    QByteArray toXml() const;
+    QByteArray toPbf() const;
+
+    QVector<Node> nodes;
+    QVector<Way> ways;
+    qint64 relationId;
+
+    // Writes the relation block before the ways it refers to
+    bool relationsFirst;
+};
+
+// Nodes in a row of the grid and per way
+static const int wayNodes = 10;
+
+Extract::Extract( int wayCount )
+    : relationId( 1 ),
+      relationsFirst( false )
+{
+    // Coordinates in units of 1e-7 degrees
+    for ( int i = 0; i < wayCount * wayNodes; ++i ) {
+        Node node;
+        node.id = 1000 + i;
+        node.lon = 133500000 + ( i % wayNodes ) * 1000;
+        node.lat = 525000000 + ( i / wayNodes ) * 1000;
+        node.restaurant = i % 97 == 0;
+        nodes << node;
+    }
+
+    for ( int i = 0; i < wayCount; ++i ) {
+        Way way;
+        way.id = 100 + i;
+        way.building = i % 2;
+        for ( int j = 0; j < wayNodes; ++j ) {
+            way.refs << nodes.at( i * wayNodes + j ).id;
+        }
+        if ( way.building ) {
+            way.refs << way.refs.first();
+        }
+        ways << way;
+    }
+}
+
+static QByteArray coordinate( qint64 value )
+{
+    return QByteArray::number( value / 1e7, 'f', 7 );
+}
+
+QByteArray Extract::toXml() const
+{
+    QByteArray xml = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<osm version=\"0.6\">\n";
+    foreach ( const Node &node, nodes ) {
+        xml += "<node id=\"" + QByteArray::number( node.id ) + "\" lat=\"" + coordinate( node.lat )
+               + "\" lon=\"" + coordinate( node.lon ) + "\"";
+        xml += node.restaurant ? ">\n<tag k=\"name\" v=\"Restaurant " + QByteArray::number( node.id )
+                                 + "\"/>\n<tag k=\"amenity\" v=\"restaurant\"/>\n</node>\n"
+                               : QByteArray( "/>\n" );
+    }
+
+    foreach ( const Way &way, ways ) {
+        xml += "<way id=\"" + QByteArray::number( way.id ) + "\">\n";
+        foreach ( qint64 ref, way.refs ) {
+            xml += "<nd ref=\"" + QByteArray::number( ref ) + "\"/>\n";
+        }
+        xml += way.building ? QByteArray( "<tag k=\"building\" v=\"yes\"/>\n" )
+                            : "<tag k=\"name\" v=\"Street " + QByteArray::number( way.id )
+                              + "\"/>\n<tag k=\"highway\" v=\"residential\"/>\n";
+        xml += "</way>\n";
+    }
+
+    xml += "<relation id=\"" + QByteArray::number( relationId ) + "\">\n"
+           "<member type=\"way\" ref=\"" + QByteArray::number( ways.last().id ) + "\" role=\"outer\"/>\n"
+           "<tag k=\"type\" v=\"multipolygon\"/>\n<tag k=\"landuse\" v=\"forest\"/>\n</relation>\n";
+
+    xml += "</osm>\n";
+    return xml;
+}
+
+static void writeVarint( QByteArray &out, quint64 value )
+{
+    while ( value >= 0x80 ) {
+        out += char( ( value & 0x7f ) | 0x80 );
+        value >>= 7;
+    }
+    out += char( value );
+}
+
+static quint64 zigzag( qint64 value )
+{
+    return ( quint64( value ) << 1 ) ^ quint64( value >> 63 );
+}
+
+static void writeNumber( QByteArray &out, int field, quint64 value )
+{
+    writeVarint( out, field << 3 );
+    writeVarint( out, value );
+}
+
+static void writeBytes( QByteArray &out, int field, const QByteArray &bytes )
+{
+    writeVarint( out, ( field << 3 ) | 2 );
+    writeVarint( out, bytes.size() );
+    out += bytes;
+}
+
+static QByteArray packed( const QVector<qint64> &values, bool signedValues, bool delta )
+{
+    QByteArray result;
+    qint64 previous = 0;
+    foreach ( qint64 value, values ) {
+        const qint64 encoded = delta ? value - previous : value;
+        writeVarint( result, signedValues ? zigzag( encoded ) : quint64( encoded ) );
+        previous = value;
+    }
+    return result;
+}
+
+/**
+ * Appends a blob with a header of @p type that holds the compressed @p data.
+ */
+static void writeBlob( QByteArray &out, const QByteArray &type, const QByteArray &data )
+{
+    QByteArray blob;
+    writeNumber( blob, 2, data.size() );
+    writeBytes( blob, 3, qCompress( data ).mid( 4 ) );
+
+    QByteArray header;
+    writeBytes( header, 1, type );
+    writeNumber( header, 3, blob.size() );
+
+    uchar size[4];
+    qToBigEndian<quint32>( header.size(), size );
+    out += QByteArray( reinterpret_cast<const char *>( size ), 4 );
+    out += header;
+    out += blob;
+}
+
+/**
+ * A primitive block of the elements in @p group and the strings they use.
+ */
+static QByteArray primitiveBlock( const QStringList &strings, const QByteArray &group )
+{
+    QByteArray stringTable;
+    writeBytes( stringTable, 1, QByteArray() );
+    foreach ( const QString &string, strings ) {
+        writeBytes( stringTable, 1, string.toUtf8() );
+    }
+
+    QByteArray block;
+    writeBytes( block, 1, stringTable );
+    writeBytes( block, 2, group );
+    writeNumber( block, 17, 100 );
+    return block;
+}
+
+QByteArray Extract::toPbf() const
+{
+    QByteArray pbf;
+
+    QByteArray header;
+    writeBytes( header, 4, "OsmSchema-V0.6" );
+    writeBytes( header, 4, "DenseNodes" );
+    writeBlob( pbf, "OSMHeader", header );
+
+    QByteArray relation;
+    writeNumber( relation, 1, relationId );
+    writeBytes( relation, 2, packed( QVector<qint64>() << 1 << 3, false, false ) );
+    writeBytes( relation, 3, packed( QVector<qint64>() << 2 << 4, false, false ) );
+    writeBytes( relation, 8, packed( QVector<qint64>() << 5, false, false ) );
+    writeBytes( relation, 9, packed( QVector<qint64>() << ways.last().id, true, true ) );
+    writeBytes( relation, 10, packed( QVector<qint64>() << 1, false, false ) );
+    QByteArray relationGroup;
+    writeBytes( relationGroup, 4, relation );
+    const QStringList relationStrings = QStringList() << "type" << "multipolygon" << "landuse" << "forest" << "outer";
+    const QByteArray relationBlock = primitiveBlock( relationStrings, relationGroup );
+    if ( relationsFirst ) {
+        writeBlob( pbf, "OSMData", relationBlock );
+    }
+
+    // Tags refer to the string table by index, 0 is the empty string
+    QStringList strings = QStringList() << "name" << "amenity" << "restaurant";
+    QVector<qint64> ids, lons, lats, keysValues;
+    foreach ( const Node &node, nodes ) {
+        ids << node.id;
+        lons << node.lon;
+        lats << node.lat;
+        if ( node.restaurant ) {
+            strings << "Restaurant " + QString::number( node.id );
+            keysValues << 1 << strings.size() << 2 << 3;
+        }
+        keysValues << 0;
+    }
+
+    QByteArray dense;
+    writeBytes( dense, 1, packed( ids, true, true ) );
+    writeBytes( dense, 8, packed( lats, true, true ) );
+    writeBytes( dense, 9, packed( lons, true, true ) );
+    writeBytes( dense, 10, packed( keysValues, false, false ) );
+    QByteArray nodeGroup;
+    writeBytes( nodeGroup, 2, dense );
+    writeBlob( pbf, "OSMData", primitiveBlock( strings, nodeGroup ) );
+
+    // Several blocks of ways so they get decoded in parallel
+    const int waysPerBlock = 1000;
+    for ( int first = 0; first < ways.size(); first += waysPerBlock ) {
+        QStringList wayStrings = QStringList() << "name" << "highway" << "residential" << "building" << "yes";
+        QByteArray group;
+        for ( int i = first; i < qMin( first + waysPerBlock, ways.size() ); ++i ) {
+            const Way &way = ways.at( i );
+            QVector<qint64> keys, values;
+            if ( way.building ) {
+                keys << 4;
+                values << 5;
+            } else {
+                wayStrings << "Street " + QString::number( way.id );
+                keys << 1 << 2;
+                values << wayStrings.size() << 3;
+            }
+
+            QByteArray wayMessage;
+            writeNumber( wayMessage, 1, way.id );
+            writeBytes( wayMessage, 2, packed( keys, false, false ) );
+            writeBytes( wayMessage, 3, packed( values, false, false ) );
+            writeBytes( wayMessage, 8, packed( way.refs, true, true ) );
+            writeBytes( group, 3, wayMessage );
+        }
+
+        writeBlob( pbf, "OSMData", primitiveBlock( wayStrings, group ) );
+    }
+
+    if ( !relationsFirst ) {
+        writeBlob( pbf, "OSMData", relationBlock );
+    }
+
+    return pbf;
+}
+
+class PbfRunnerTest : public QObject
+{
+    Q_OBJECT
+
+ public slots:
+    void setDocument( GeoDataDocument *document, const QString &error );
+
+ private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void compareWithXml();
+    void relationBeforeWays();
+
+    void parse_data();
+    void parse();
+
+ private:
+    static void writeFile( const QString &fileName, const QByteArray &content );
+
+    /**
+     * Describes each placemark of @p document in a sorted list.
+     */
+    static QStringList placemarks( const GeoDataDocument *document );
+
+    GeoDataDocument *parse( const ParseRunnerPlugin *plugin, const QString &fileName );
+
+    PluginManager m_pluginManager;
+    const ParseRunnerPlugin *m_osmPlugin;
+    const ParseRunnerPlugin *m_pbfPlugin;
+    GeoDataDocument *m_document;
+    QString m_osmFileName;
+    QString m_pbfFileName;
+};
+
+void PbfRunnerTest::setDocument( GeoDataDocument *document, const QString &error )
+{
+    Q_UNUSED( error );
+
+    m_document = document;
+}
+
+void PbfRunnerTest::initTestCase()
+{
+    MarbleDirs::setMarblePluginPath( PLUGIN_PATH );
+
+    m_osmPlugin = 0;
+    m_pbfPlugin = 0;
+    foreach ( const ParseRunnerPlugin *plugin, m_pluginManager.parsingRunnerPlugins() ) {
+        if ( plugin->nameId() == "Osm" ) {
+            m_osmPlugin = plugin;
+        } else if ( plugin->nameId() == "Pbf" ) {
+            m_pbfPlugin = plugin;
+        }
+    }
+
+    if ( !m_osmPlugin || !m_pbfPlugin ) {
+        QSKIP( "The Osm and Pbf plugins are needed", SkipAll );
+    }
+
+    m_osmFileName = QDir::tempPath() + "/PbfRunnerTest.osm";
+    m_pbfFileName = QDir::tempPath() + "/PbfRunnerTest.osm.pbf";
+}
+
+void PbfRunnerTest::cleanupTestCase()
+{
+    QFile::remove( m_osmFileName );
+    QFile::remove( m_pbfFileName );
+}
+
+void PbfRunnerTest::writeFile( const QString &fileName, const QByteArray &content )
+{
+    QFile file( fileName );
+    QVERIFY( file.open( QIODevice::WriteOnly ) );
+    QCOMPARE( file.write( content ), qint64( content.size() ) );
+}
+
+QStringList PbfRunnerTest::placemarks( const GeoDataDocument *document )
+{
+    QStringList result;
+    foreach ( const GeoDataPlacemark *placemark, document->placemarkList() ) {
+        const GeoDataGeometry *const geometry = placemark->geometry();
+        const GeoDataPolygon *const polygon = dynamic_cast<const GeoDataPolygon *>( geometry );
+        const GeoDataLineString *const line = polygon ? &polygon->outerBoundary()
+                                                      : dynamic_cast<const GeoDataLineString *>( geometry );
+        const GeoDataCoordinates first = line ? ( line->isEmpty() ? GeoDataCoordinates() : line->first() )
+                                              : placemark->coordinate();
+
+        result << QString( "%1 %2 %3 %4 %5 %6 %7" ).arg( geometry->nodeType() ).arg( placemark->name() )
+                  .arg( int( placemark->visualCategory() ) ).arg( placemark->isVisible() )
+                  .arg( line ? line->size() : 1 )
+                  .arg( first.longitude( GeoDataCoordinates::Degree ), 0, 'f', 6 )
+                  .arg( first.latitude( GeoDataCoordinates::Degree ), 0, 'f', 6 );
+    }
+
+    result.sort();
+    return result;
+}
+
+GeoDataDocument *PbfRunnerTest::parse( const ParseRunnerPlugin *plugin, const QString &fileName )
+{
+    m_document = 0;
+
+    MarbleAbstractRunner *const runner = plugin->newRunner();
+    connect( runner, SIGNAL( parsingFinished( GeoDataDocument*, QString ) ),
+             this, SLOT( setDocument( GeoDataDocument*, QString ) ), Qt::DirectConnection );
+    runner->parseFile( fileName, UserDocument );
+    delete runner;
+
+    return m_document;
+}
+
+void PbfRunnerTest::compareWithXml()
+{
+    const Extract extract( 2500 );
+    writeFile( m_osmFileName, extract.toXml() );
+    writeFile( m_pbfFileName, extract.toPbf() );
+
+    GeoDataDocument *const xml = parse( m_osmPlugin, m_osmFileName );
+    QVERIFY( xml );
+    GeoDataDocument *const pbf = parse( m_pbfPlugin, m_pbfFileName );
+    QVERIFY( pbf );
+
+    // Restaurants, streets and buildings, and the forest
+    int restaurants = 0;
+    foreach ( const Extract::Node &node, extract.nodes ) {
+        restaurants += node.restaurant;
+    }
+    QCOMPARE( pbf->size(), restaurants + extract.ways.size() + 1 );
+    QCOMPARE( placemarks( pbf ), placemarks( xml ) );
+
+    delete xml;
+    delete pbf;
+}
+
+void PbfRunnerTest::relationBeforeWays()
+{
+    Extract extract( 2500 );
+    extract.relationsFirst = true;
+    writeFile( m_osmFileName, extract.toXml() );
+    writeFile( m_pbfFileName, extract.toPbf() );
+
+    GeoDataDocument *const xml = parse( m_osmPlugin, m_osmFileName );
+    QVERIFY( xml );
+    GeoDataDocument *const pbf = parse( m_pbfPlugin, m_pbfFileName );
+    QVERIFY( pbf );
+
+    // The forest still gets the outer boundary of the way after it
+    QCOMPARE( placemarks( pbf ), placemarks( xml ) );
+
+    delete xml;
+    delete pbf;
+}
+
+void PbfRunnerTest::parse_data()
+{
+    QTest::addColumn<bool>( "binary" );
+    QTest::addColumn<int>( "ways" );
+
+    QTest::newRow( "xml, 5000" ) << false << 5000;
+    QTest::newRow( "pbf, 5000" ) << true << 5000;
+    QTest::newRow( "xml, 50000" ) << false << 50000;
+    QTest::newRow( "pbf, 50000" ) << true << 50000;
+}
+
+void PbfRunnerTest::parse()
+{
+    QFETCH( bool, binary );
+    QFETCH( int, ways );
+
+    const Extract extract( ways );
+    const QString fileName = binary ? m_pbfFileName : m_osmFileName;
+    writeFile( fileName, binary ? extract.toPbf() : extract.toXml() );
+    qDebug() << QFileInfo( fileName ).size() / 1024 << "kB";
+
+    const ParseRunnerPlugin *const plugin = binary ? m_pbfPlugin : m_osmPlugin;
+    QBENCHMARK {
+        delete parse( plugin, fileName );
+    }
+}
+
+}
+
+QTEST_MAIN( Marble::PbfRunnerTest )
+
+#include "PbfRunnerTest.moc"
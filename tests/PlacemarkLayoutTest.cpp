@@ -0,0 +1,577 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include <QtTest/QtTest>
+#include <QtCore/QAbstractListModel>
+#include <QtGui/QItemSelectionModel>
+
+#include "GeoDataPlacemark.h"
+#include "MarbleClock.h"
+#include "MarblePlacemarkModel.h"
+#include "PlacemarkLayout.h"
+#include "ViewportParams.h"
+#include "VisiblePlacemark.h"
+
+namespace Marble
+{
+
+/**
+ * A flat model that reports added and removed rows instead of resetting.
+ */
+class PlacemarkListModel : public QAbstractListModel
+{
+ public:
+    int rowCount( const QModelIndex &parent = QModelIndex() ) const
+    {
+        return parent.isValid() ? 0 : m_placemarks.size();
+    }
+
+    QVariant data( const QModelIndex &index, int role ) const
+    {
+        if ( !index.isValid() ) {
+            return QVariant();
+        }
+
+        GeoDataPlacemark *placemark = m_placemarks.at( index.row() );
+        if ( role == MarblePlacemarkModel::ObjectPointerRole ) {
+            return qVariantFromValue<GeoDataObject*>( placemark );
+        } else if ( role == MarblePlacemarkModel::PopularityIndexRole ) {
+            return placemark->zoomLevel();
+        } else if ( role == Qt::DisplayRole ) {
+            return placemark->name();
+        }
+
+        return QVariant();
+    }
+
+    void append( GeoDataPlacemark *placemark )
+    {
+        beginInsertRows( QModelIndex(), m_placemarks.size(), m_placemarks.size() );
+        m_placemarks.append( placemark );
+        endInsertRows();
+    }
+
+    void removeLast()
+    {
+        beginRemoveRows( QModelIndex(), m_placemarks.size() - 1, m_placemarks.size() - 1 );
+        m_placemarks.remove( m_placemarks.size() - 1 );
+        endRemoveRows();
+    }
+
+ private:
+    QVector<GeoDataPlacemark*> m_placemarks;
+};
+
+class PlacemarkLayoutTest : public QObject
+{
+    Q_OBJECT
+
+ private slots:
+    void init();
+    void cleanup();
+
+    void labelsDoNotOverlap();
+
+    void panningChurn_data();
+    void panningChurn();
+    void coherentLayoutAfterZoom();
+
+    void addRemovePlacemark();
+
+    void clustersSplitWhenZooming();
+    void clustersCountShownPlacemarksOnly();
+
+    void setCacheData_data();
+    void setCacheData();
+
+    void addRemovePlacemarkBenchmark_data();
+    void addRemovePlacemarkBenchmark();
+
+    void generateLayout_data();
+    void generateLayout();
+
+    void generateClusteredLayout_data();
+    void generateClusteredLayout();
+
+ private:
+    void createPlacemarks( int count );
+    void addPlacemarks( int count );
+
+    /**
+     * Adds up the counts that the cluster markers among @p marks are labelled with.
+     */
+    int clusteredCount( const QVector<VisiblePlacemark *> &marks ) const;
+    static void addModelSizes();
+
+    QVector<GeoDataPlacemark*> m_placemarks;
+    MarblePlacemarkModel *m_model;
+};
+
+void PlacemarkLayoutTest::init()
+{
+    m_model = new MarblePlacemarkModel;
+}
+
+void PlacemarkLayoutTest::cleanup()
+{
+    delete m_model;
+    m_model = 0;
+
+    qDeleteAll( m_placemarks );
+    m_placemarks.clear();
+}
+
+void PlacemarkLayoutTest::createPlacemarks( int count )
+{
+    // Cities spread over Europe, all of them visible at the lowest zoom level
+    qsrand( count );
+    for ( int i = 0; i < count; ++i ) {
+        GeoDataPlacemark *placemark = new GeoDataPlacemark( QString( "City %1" ).arg( i ) );
+        placemark->setCoordinate( -10.0 + 40.0 * ( qrand() % 10000 ) / 10000.0,
+                                   35.0 + 25.0 * ( qrand() % 10000 ) / 10000.0,
+                                   0.0, GeoDataCoordinates::Degree );
+        placemark->setVisualCategory( GeoDataFeature::SmallCity );
+        placemark->setZoomLevel( 1 );
+        m_placemarks << placemark;
+    }
+}
+
+void PlacemarkLayoutTest::addPlacemarks( int count )
+{
+    createPlacemarks( count );
+
+    m_model->setPlacemarkContainer( &m_placemarks );
+    m_model->addPlacemarks( 0, count );
+}
+
+int PlacemarkLayoutTest::clusteredCount( const QVector<VisiblePlacemark *> &marks ) const
+{
+    int count = 0;
+    foreach ( const VisiblePlacemark *mark, marks ) {
+        if ( !m_placemarks.contains( const_cast<GeoDataPlacemark*>( mark->placemark() ) ) ) {
+            count += mark->placemark()->name().toInt();
+        }
+    }
+
+    return count;
+}
+
+void PlacemarkLayoutTest::labelsDoNotOverlap()
+{
+    addPlacemarks( 5000 );
+
+    QItemSelectionModel selectionModel( m_model );
+    MarbleClock clock;
+    PlacemarkLayout layout( m_model, &selectionModel, &clock );
+    layout.setShowPlaces( true );
+    layout.setShowCities( true );
+
+    ViewportParams viewport;
+    viewport.setSize( QSize( 1000, 800 ) );
+    viewport.setRadius( 2000 );
+    viewport.centerOn( 10 * DEG2RAD, 47 * DEG2RAD );
+
+    const QVector<VisiblePlacemark *> marks = layout.generateLayout( &viewport );
+    QVERIFY( !marks.isEmpty() );
+
+    for ( int i = 0; i < marks.size(); ++i ) {
+        for ( int j = i + 1; j < marks.size(); ++j ) {
+            QVERIFY( !marks.at( i )->labelRect().intersects( marks.at( j )->labelRect() ) );
+        }
+    }
+}
+
+void PlacemarkLayoutTest::panningChurn_data()
+{
+    QTest::addColumn<int>( "count" );
+
+    QTest::newRow( "5k" ) << 5000;
+    QTest::newRow( "50k" ) << 50000;
+}
+
+void PlacemarkLayoutTest::panningChurn()
+{
+    QFETCH( int, count );
+
+    addPlacemarks( count );
+
+    QItemSelectionModel selectionModel( m_model );
+    MarbleClock clock;
+    PlacemarkLayout layout( m_model, &selectionModel, &clock );
+    layout.setShowPlaces( true );
+    layout.setShowCities( true );
+
+    ViewportParams viewport;
+    viewport.setSize( QSize( 1280, 800 ) );
+    viewport.setRadius( 1600 );
+
+    // Pan eastwards in steps of a few pixels and count the placemarks that
+    // appear or disappear between two frames while staying on screen.
+    int churn[2] = { 0, 0 };
+    for ( int coherent = 0; coherent < 2; ++coherent ) {
+        layout.setCoherentLayout( coherent );
+        viewport.centerOn( 0 * DEG2RAD, 47 * DEG2RAD );
+
+        QSet<const GeoDataPlacemark*> previous;
+        foreach ( const VisiblePlacemark *mark, layout.generateLayout( &viewport ) ) {
+            previous.insert( mark->placemark() );
+        }
+
+        for ( int step = 1; step <= 100; ++step ) {
+            viewport.centerOn( 0.05 * step * DEG2RAD, 47 * DEG2RAD );
+
+            QSet<const GeoDataPlacemark*> current;
+            foreach ( const VisiblePlacemark *mark, layout.generateLayout( &viewport ) ) {
+                current.insert( mark->placemark() );
+            }
+
+            // Labels moving off the screen are no churn.
+            foreach ( const GeoDataPlacemark *placemark, previous ) {
+                if ( current.contains( placemark ) ) {
+                    continue;
+                }
+
+                qreal x, y;
+                if ( viewport.screenCoordinates( placemark->coordinate(), x, y ) ) {
+                    ++churn[coherent];
+                }
+            }
+            churn[coherent] += ( current - previous ).size();
+
+            previous = current;
+        }
+    }
+
+    qDebug() << "label changes:" << churn[0] << "plain," << churn[1] << "coherent";
+    QVERIFY( churn[1] <= churn[0] );
+}
+
+void PlacemarkLayoutTest::coherentLayoutAfterZoom()
+{
+    addPlacemarks( 5000 );
+
+    QItemSelectionModel selectionModel( m_model );
+    MarbleClock clock;
+    PlacemarkLayout coherentLayout( m_model, &selectionModel, &clock );
+    coherentLayout.setShowPlaces( true );
+    coherentLayout.setShowCities( true );
+    coherentLayout.setCoherentLayout( true );
+    PlacemarkLayout plainLayout( m_model, &selectionModel, &clock );
+    plainLayout.setShowPlaces( true );
+    plainLayout.setShowCities( true );
+    QVERIFY( !plainLayout.coherentLayout() );
+
+    ViewportParams viewport;
+    viewport.setSize( QSize( 1000, 800 ) );
+    viewport.centerOn( 10 * DEG2RAD, 47 * DEG2RAD );
+    viewport.setRadius( 4000 );
+    QVERIFY( !coherentLayout.generateLayout( &viewport ).isEmpty() );
+
+    // The labels kept from the closer view must not crowd out the ones
+    // a fresh layout of the wider view shows.
+    viewport.setRadius( 1000 );
+    QSet<const GeoDataPlacemark*> coherent;
+    foreach ( const VisiblePlacemark *mark, coherentLayout.generateLayout( &viewport ) ) {
+        coherent.insert( mark->placemark() );
+    }
+    QSet<const GeoDataPlacemark*> plain;
+    foreach ( const VisiblePlacemark *mark, plainLayout.generateLayout( &viewport ) ) {
+        plain.insert( mark->placemark() );
+    }
+
+    QVERIFY( !plain.isEmpty() );
+    QCOMPARE( coherent, plain );
+}
+
+void PlacemarkLayoutTest::addRemovePlacemark()
+{
+    createPlacemarks( 1000 );
+
+    PlacemarkListModel model;
+    for ( int i = 0; i < m_placemarks.size(); ++i ) {
+        model.append( m_placemarks.at( i ) );
+    }
+
+    QItemSelectionModel selectionModel( &model );
+    MarbleClock clock;
+    PlacemarkLayout layout( &model, &selectionModel, &clock );
+    layout.setShowPlaces( true );
+    layout.setShowCities( true );
+
+    ViewportParams viewport;
+    viewport.setSize( QSize( 1000, 800 ) );
+    viewport.setRadius( 2000 );
+    viewport.centerOn( 10 * DEG2RAD, 47 * DEG2RAD );
+
+    // A capital outside of Europe shows up once it is added...
+    GeoDataPlacemark placemark( "Capital" );
+    placemark.setCoordinate( 10.0, 80.0, 0.0, GeoDataCoordinates::Degree );
+    placemark.setVisualCategory( GeoDataFeature::LargeNationCapital );
+    placemark.setZoomLevel( 0 );
+    viewport.centerOn( 10 * DEG2RAD, 80 * DEG2RAD );
+
+    QVERIFY( layout.generateLayout( &viewport ).isEmpty() );
+
+    model.append( &placemark );
+    QVector<VisiblePlacemark *> marks = layout.generateLayout( &viewport );
+    QCOMPARE( marks.size(), 1 );
+    QCOMPARE( marks.first()->placemark(), &placemark );
+
+    // ...and disappears again once it is removed.
+    model.removeLast();
+    QVERIFY( layout.generateLayout( &viewport ).isEmpty() );
+    QVERIFY( layout.whichPlacemarkAt( QPoint( viewport.width() / 2, viewport.height() / 2 ) ).isEmpty() );
+}
+
+void PlacemarkLayoutTest::clustersSplitWhenZooming()
+{
+    const int clusterThreshold = 12;
+
+    addPlacemarks( 20000 );
+
+    QSet<const GeoDataPlacemark*> placemarks;
+    foreach ( const GeoDataPlacemark *placemark, m_placemarks ) {
+        placemarks.insert( placemark );
+    }
+
+    QItemSelectionModel selectionModel( m_model );
+    MarbleClock clock;
+    PlacemarkLayout layout( m_model, &selectionModel, &clock );
+    layout.setShowPlaces( true );
+    layout.setShowCities( true );
+    layout.setClustering( true );
+
+    ViewportParams viewport;
+    viewport.setSize( QSize( 1000, 800 ) );
+    viewport.centerOn( 10 * DEG2RAD, 47 * DEG2RAD );
+
+    // Markers for placemarks not in the model are cluster markers. They
+    // are gone once the map is zoomed in far enough.
+    foreach ( int radius, QList<int>() << 250 << 2000 << 16000 << 64000 ) {
+        viewport.setRadius( radius );
+
+        int clusters = 0;
+        foreach ( const VisiblePlacemark *mark, layout.generateLayout( &viewport ) ) {
+            if ( !placemarks.contains( mark->placemark() ) ) {
+                ++clusters;
+                QVERIFY( mark->placemark()->name().toInt() > clusterThreshold );
+            }
+        }
+
+        if ( radius <= 2000 ) {
+            QVERIFY( clusters > 0 );
+        } else if ( radius == 64000 ) {
+            QCOMPARE( clusters, 0 );
+        }
+    }
+
+    viewport.setRadius( 250 );
+    layout.setClustering( false );
+    foreach ( const VisiblePlacemark *mark, layout.generateLayout( &viewport ) ) {
+        QVERIFY( placemarks.contains( mark->placemark() ) );
+    }
+}
+
+void PlacemarkLayoutTest::clustersCountShownPlacemarksOnly()
+{
+    addPlacemarks( 20000 );
+
+    QItemSelectionModel selectionModel( m_model );
+    MarbleClock clock;
+    PlacemarkLayout layout( m_model, &selectionModel, &clock );
+    layout.setShowPlaces( true );
+    layout.setShowCities( true );
+    layout.setClustering( true );
+
+    ViewportParams viewport;
+    viewport.setSize( QSize( 1000, 800 ) );
+    viewport.setRadius( 250 );
+    viewport.centerOn( 10 * DEG2RAD, 47 * DEG2RAD );
+
+    const int allShown = clusteredCount( layout.generateLayout( &viewport ) );
+    QVERIFY( allShown > 0 );
+
+    // Invisible placemarks are not counted...
+    for ( int i = 0; i < m_placemarks.size(); i += 2 ) {
+        m_placemarks[i]->setVisible( false );
+    }
+    layout.requestVisibilityUpdate();
+    const int halfShown = clusteredCount( layout.generateLayout( &viewport ) );
+    QVERIFY( halfShown > 0 );
+    QVERIFY( halfShown < allShown );
+
+    for ( int i = 0; i < m_placemarks.size(); i += 2 ) {
+        m_placemarks[i]->setVisible( true );
+    }
+    layout.requestVisibilityUpdate();
+
+    // ...nor are selected ones, which are shown on their own...
+    selectionModel.select( QItemSelection( m_model->index( 0, 0 ), m_model->index( m_model->rowCount() - 1, 0 ) ),
+                           QItemSelectionModel::Select );
+    QCOMPARE( clusteredCount( layout.generateLayout( &viewport ) ), 0 );
+    selectionModel.clear();
+
+    // ...nor those of hidden categories.
+    layout.setShowCities( false );
+    layout.requestStyleReset();
+    QVERIFY( layout.generateLayout( &viewport ).isEmpty() );
+}
+
+void PlacemarkLayoutTest::addModelSizes()
+{
+    QTest::addColumn<int>( "count" );
+
+    QTest::newRow( "1k" ) << 1000;
+    QTest::newRow( "10k" ) << 10000;
+    QTest::newRow( "50k" ) << 50000;
+}
+
+void PlacemarkLayoutTest::setCacheData_data()
+{
+    addModelSizes();
+}
+
+void PlacemarkLayoutTest::setCacheData()
+{
+    QFETCH( int, count );
+
+    addPlacemarks( count );
+
+    QItemSelectionModel selectionModel( m_model );
+    MarbleClock clock;
+    PlacemarkLayout layout( m_model, &selectionModel, &clock );
+
+    QBENCHMARK {
+        layout.setCacheData();
+    }
+}
+
+void PlacemarkLayoutTest::addRemovePlacemarkBenchmark_data()
+{
+    addModelSizes();
+}
+
+void PlacemarkLayoutTest::addRemovePlacemarkBenchmark()
+{
+    QFETCH( int, count );
+
+    createPlacemarks( count );
+
+    PlacemarkListModel model;
+    for ( int i = 0; i < m_placemarks.size(); ++i ) {
+        model.append( m_placemarks.at( i ) );
+    }
+
+    QItemSelectionModel selectionModel( &model );
+    MarbleClock clock;
+    PlacemarkLayout layout( &model, &selectionModel, &clock );
+
+    GeoDataPlacemark placemark( "Bookmark" );
+    placemark.setCoordinate( 10.0, 47.0, 0.0, GeoDataCoordinates::Degree );
+    placemark.setZoomLevel( 1 );
+
+    QBENCHMARK {
+        model.append( &placemark );
+        model.removeLast();
+    }
+}
+
+void PlacemarkLayoutTest::generateLayout_data()
+{
+    QTest::addColumn<int>( "count" );
+    QTest::addColumn<QSize>( "size" );
+    QTest::addColumn<int>( "selected" );
+
+    QTest::newRow( "5k, 1280x800" ) << 5000 << QSize( 1280, 800 ) << 0;
+    QTest::newRow( "50k, 1280x800" ) << 50000 << QSize( 1280, 800 ) << 0;
+    QTest::newRow( "50k, 3840x2160" ) << 50000 << QSize( 3840, 2160 ) << 0;
+    QTest::newRow( "50k, 1280x800, 1k selected" ) << 50000 << QSize( 1280, 800 ) << 1000;
+}
+
+void PlacemarkLayoutTest::generateLayout()
+{
+    QFETCH( int, count );
+    QFETCH( QSize, size );
+    QFETCH( int, selected );
+
+    addPlacemarks( count );
+
+    QItemSelectionModel selectionModel( m_model );
+    if ( selected > 0 ) {
+        selectionModel.select( QItemSelection( m_model->index( 0, 0 ), m_model->index( selected - 1, 0 ) ),
+                               QItemSelectionModel::Select );
+    }
+    MarbleClock clock;
+    PlacemarkLayout layout( m_model, &selectionModel, &clock );
+    layout.setShowPlaces( true );
+    layout.setShowCities( true );
+
+    ViewportParams viewport;
+    viewport.setSize( size );
+    viewport.setRadius( size.height() * 2 );
+    viewport.centerOn( 10 * DEG2RAD, 47 * DEG2RAD );
+
+    layout.generateLayout( &viewport ); // resets the styles
+
+    QBENCHMARK {
+        layout.generateLayout( &viewport );
+    }
+
+    qDebug() << layout.runtimeTrace();
+}
+
+void PlacemarkLayoutTest::generateClusteredLayout_data()
+{
+    QTest::addColumn<int>( "count" );
+    QTest::addColumn<int>( "radius" );
+    QTest::addColumn<bool>( "clustering" );
+
+    QTest::newRow( "200k, whole Europe" ) << 200000 << 800 << true;
+    QTest::newRow( "200k, whole Europe, no clustering" ) << 200000 << 800 << false;
+    QTest::newRow( "200k, region" ) << 200000 << 8000 << true;
+    QTest::newRow( "200k, region, no clustering" ) << 200000 << 8000 << false;
+    QTest::newRow( "5M, whole Europe" ) << 5000000 << 800 << true;
+    QTest::newRow( "5M, whole Europe, no clustering" ) << 5000000 << 800 << false;
+    QTest::newRow( "5M, region" ) << 5000000 << 8000 << true;
+    QTest::newRow( "5M, region, no clustering" ) << 5000000 << 8000 << false;
+}
+
+void PlacemarkLayoutTest::generateClusteredLayout()
+{
+    QFETCH( int, count );
+    QFETCH( int, radius );
+    QFETCH( bool, clustering );
+
+    addPlacemarks( count );
+
+    QItemSelectionModel selectionModel( m_model );
+    MarbleClock clock;
+    PlacemarkLayout layout( m_model, &selectionModel, &clock );
+    layout.setShowPlaces( true );
+    layout.setShowCities( true );
+    layout.setClustering( clustering );
+
+    ViewportParams viewport;
+    viewport.setSize( QSize( 1280, 800 ) );
+    viewport.setRadius( radius );
+    viewport.centerOn( 10 * DEG2RAD, 47 * DEG2RAD );
+
+    layout.generateLayout( &viewport ); // resets the styles
+
+    QBENCHMARK {
+        layout.generateLayout( &viewport );
+    }
+
+    qDebug() << layout.runtimeTrace();
+}
+
+}
+
+QTEST_MAIN( Marble::PlacemarkLayoutTest )
+
+#include "PlacemarkLayoutTest.moc"
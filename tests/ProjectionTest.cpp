@@ -14,6 +14,10 @@
 #include "MarbleMap.h"
 #include "GeoDataCoordinates.h"
 #include "GeoDataLineString.h"
+#include "ProjectedGeometryCache.h"
+#include "Quaternion.h"
+
+#include <cmath>
 
 namespace Marble
 {
@@ -29,8 +33,46 @@ class ProjectionTest : public QObject
     void drawLineString();
 
     void setInvalidRadius();
+
+    void tessellationAccuracy_data();
+    void tessellationAccuracy();
+
+    void tessellateStraightLine();
+
+    void tessellateRoute_data();
+    void tessellateRoute();
+
+    void projectedGeometryCache();
+
+ private:
+    static qreal distanceToPolygons( const QPointF &point, const QVector<QPolygonF*> &polygons );
 };
 
+qreal ProjectionTest::distanceToPolygons( const QPointF &point, const QVector<QPolygonF*> &polygons )
+{
+    qreal distance = -1;
+
+    foreach ( const QPolygonF *polygon, polygons ) {
+        for ( int i = 1; i < polygon->size(); ++i ) {
+            const QPointF a = polygon->at( i - 1 );
+            const QPointF ab = polygon->at( i ) - a;
+            const qreal lengthSquared = ab.x() * ab.x() + ab.y() * ab.y();
+            qreal t = 0;
+            if ( lengthSquared > 0 ) {
+                t = ( ( point.x() - a.x() ) * ab.x() + ( point.y() - a.y() ) * ab.y() ) / lengthSquared;
+                t = qBound( qreal( 0 ), t, qreal( 1 ) );
+            }
+            const QPointF e = point - ( a + t * ab );
+            const qreal segmentDistance = sqrt( e.x() * e.x() + e.y() * e.y() );
+            if ( distance < 0 || segmentDistance < distance ) {
+                distance = segmentDistance;
+            }
+        }
+    }
+
+    return distance;
+}
+
 void ProjectionTest::constructorDefaultValues()
 {
     const ViewportParams viewport;
@@ -189,6 +231,160 @@ void ProjectionTest::setInvalidRadius()
     QCOMPARE( viewport.radius(), radius );
 }
 
+void ProjectionTest::tessellationAccuracy_data()
+{
+    QTest::addColumn<Marble::Projection>( "projection" );
+
+    QTest::newRow( "Spherical" ) << Spherical;
+    QTest::newRow( "Equirectangular" ) << Equirectangular;
+    QTest::newRow( "Mercator" ) << Mercator;
+}
+
+void ProjectionTest::tessellationAccuracy()
+{
+    QFETCH( Marble::Projection, projection );
+
+    ViewportParams viewport;
+    viewport.setProjection( projection );
+    viewport.setSize( QSize( 1000, 1000 ) );
+    viewport.setRadius( 400 );
+    viewport.centerOn( 0, 20 * DEG2RAD );
+
+    const GeoDataCoordinates start( -50, 0, 0, GeoDataCoordinates::Degree );
+    const GeoDataCoordinates end( 40, 60, 0, GeoDataCoordinates::Degree );
+
+    GeoDataLineString line( Tessellate );
+    line << start << end;
+
+    QVector<QPolygonF*> polygons;
+    viewport.screenCoordinates( line, polygons );
+    QVERIFY( !polygons.isEmpty() );
+
+    // Sample the exact great circle: only the midpoints of the tessellated
+    // pieces are checked against the tolerance, so allow for some slack.
+    qreal maxError = 0;
+    for ( int i = 0; i <= 100; ++i ) {
+        const Quaternion itpos = Quaternion::slerp( start.quaternion(), end.quaternion(), i / 100.0 );
+        qreal lon, lat;
+        itpos.getSpherical( lon, lat );
+
+        qreal x, y;
+        QVERIFY( viewport.screenCoordinates( lon, lat, x, y ) );
+
+        const qreal error = distanceToPolygons( QPointF( x, y ), polygons );
+        QVERIFY( error >= 0 );
+        maxError = qMax( maxError, error );
+    }
+
+    qDeleteAll( polygons );
+
+    QVERIFY( maxError < 2 * viewport.tessellationTolerance() );
+}
+
+void ProjectionTest::tessellateStraightLine()
+{
+    ViewportParams viewport;
+    viewport.setProjection( Equirectangular );
+    viewport.setSize( QSize( 1000, 1000 ) );
+    viewport.setRadius( 400 );
+
+    // Meridians are straight lines in cylindrical projections,
+    // so tessellating them must not add any nodes.
+    GeoDataLineString line( Tessellate );
+    line << GeoDataCoordinates( 10, -40, 0, GeoDataCoordinates::Degree )
+         << GeoDataCoordinates( 10, 40, 0, GeoDataCoordinates::Degree );
+
+    QVector<QPolygonF*> polygons;
+    viewport.screenCoordinates( line, polygons );
+    QVERIFY( !polygons.isEmpty() );
+
+    foreach ( const QPolygonF *polygon, polygons ) {
+        QCOMPARE( polygon->size(), 2 );
+    }
+
+    qDeleteAll( polygons );
+}
+
+void ProjectionTest::tessellateRoute_data()
+{
+    QTest::addColumn<Marble::Projection>( "projection" );
+    QTest::addColumn<int>( "radius" );
+
+    QTest::newRow( "Spherical 250" ) << Spherical << 250;
+    QTest::newRow( "Spherical 2000" ) << Spherical << 2000;
+    QTest::newRow( "Mercator 250" ) << Mercator << 250;
+    QTest::newRow( "Mercator 2000" ) << Mercator << 2000;
+}
+
+void ProjectionTest::tessellateRoute()
+{
+    QFETCH( Marble::Projection, projection );
+    QFETCH( int, radius );
+
+    ViewportParams viewport;
+    viewport.setProjection( projection );
+    viewport.setSize( QSize( 1000, 1000 ) );
+    viewport.setRadius( radius );
+    viewport.centerOn( 10 * DEG2RAD, 50 * DEG2RAD );
+
+    // A route across Europe with nodes roughly 20 km apart
+    GeoDataLineString line( Tessellate );
+    for ( int i = 0; i < 1000; ++i ) {
+        const qreal t = i / 1000.0;
+        line << GeoDataCoordinates( -5 + 30 * t, 40 + 15 * t + 2 * sin( 20 * t ), 0, GeoDataCoordinates::Degree );
+    }
+
+    int nodes = 0;
+    QBENCHMARK {
+        QVector<QPolygonF*> polygons;
+        viewport.screenCoordinates( line, polygons );
+        nodes = 0;
+        foreach ( const QPolygonF *polygon, polygons ) {
+            nodes += polygon->size();
+        }
+        qDeleteAll( polygons );
+    }
+
+    qDebug() << "screen nodes:" << nodes;
+}
+
+void ProjectionTest::projectedGeometryCache()
+{
+    ViewportParams viewport;
+    viewport.setProjection( Equirectangular );
+    viewport.setSize( QSize( 1000, 1000 ) );
+    viewport.setRadius( 400 );
+
+    GeoDataLineString line;
+    line << GeoDataCoordinates( 10, -40, 0, GeoDataCoordinates::Degree )
+         << GeoDataCoordinates( 20, 40, 0, GeoDataCoordinates::Degree );
+
+    ProjectedGeometryCache cache;
+    cache.setViewport( &viewport );
+
+    QVector<QPolygonF> first;
+    cache.screenCoordinates( line, first );
+    QVector<QPolygonF> second;
+    cache.screenCoordinates( line, second );
+    QCOMPARE( cache.misses(), 1 );
+    QCOMPARE( cache.hits(), 1 );
+    QCOMPARE( second, first );
+
+    // Moving a node in place keeps size and bounding box
+    line[0] = GeoDataCoordinates( 20, -40, 0, GeoDataCoordinates::Degree );
+    line[1] = GeoDataCoordinates( 10, 40, 0, GeoDataCoordinates::Degree );
+    QVector<QPolygonF> moved;
+    cache.screenCoordinates( line, moved );
+    QCOMPARE( cache.misses(), 2 );
+    QVERIFY( moved != first );
+
+    viewport.setTessellationTolerance( 2.0 );
+    cache.setViewport( &viewport );
+    QVector<QPolygonF> coarse;
+    cache.screenCoordinates( line, coarse );
+    QCOMPARE( cache.misses(), 3 );
+}
+
 }
 
 Q_DECLARE_METATYPE( Marble::Projection )
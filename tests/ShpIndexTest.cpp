@@ -0,0 +1,279 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include <QtTest/QtTest>
+#include <QtCore/QDataStream>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+
+#include "GeoDataLatLonBox.h"
+#include "ShpIndex.h"
+
+Q_DECLARE_METATYPE( QVector<int> )
+
+namespace Marble
+{
+
+/**
+ * A shape of a test shapefile, a point only uses west and south.
+ */
+struct Shape
+{
+    enum Type { Null = 0, Point = 1, Polygon = 5 };
+
+    Shape( Type type, double west = 0, double south = 0, double east = 0, double north = 0 )
+        : type( type ), west( west ), south( south ), east( east ), north( north )
+    {
+    }
+
+    // Size of the record content in 16 bit words
+    int contentSize() const
+    {
+        switch ( type ) {
+        case Point:
+            return 10;
+        case Polygon:
+            return 64;
+        default:
+            return 2;
+        }
+    }
+
+    Type type;
+    double west;
+    double south;
+    double east;
+    double north;
+};
+
+class ShpIndexTest : public QObject
+{
+    Q_OBJECT
+
+ private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void build();
+    void shapes_data();
+    void shapes();
+    void rebuildWhenChanged();
+    void manyShapes();
+
+ private:
+    /**
+     * Writes @p shapes to the .shp and .shx files of m_fileName.
+     */
+    void writeShapefile( const QList<Shape> &shapes );
+
+    static void writeHeader( QDataStream &stream, int fileSize );
+
+    QString m_fileName;
+};
+
+void ShpIndexTest::initTestCase()
+{
+    m_fileName = QDir::tempPath() + "/ShpIndexTest.shp";
+}
+
+void ShpIndexTest::cleanupTestCase()
+{
+    QFile::remove( m_fileName );
+    QFile::remove( QDir::tempPath() + "/ShpIndexTest.shx" );
+    QFile::remove( ShpIndex::indexFileName( m_fileName ) );
+}
+
+void ShpIndexTest::writeHeader( QDataStream &stream, int fileSize )
+{
+    stream.setByteOrder( QDataStream::BigEndian );
+    stream << qint32( 9994 ) << qint32( 0 ) << qint32( 0 ) << qint32( 0 ) << qint32( 0 ) << qint32( 0 );
+    stream << qint32( fileSize );
+    stream.setByteOrder( QDataStream::LittleEndian );
+    stream << qint32( 1000 ) << qint32( Shape::Polygon );
+    for ( int i = 0; i < 8; ++i ) {
+        stream << double( 0 );
+    }
+}
+
+void ShpIndexTest::writeShapefile( const QList<Shape> &shapes )
+{
+    // Sizes and offsets count 16 bit words, a header takes 50 and a record
+    // header 4 of them
+    int shpSize = 50;
+    foreach ( const Shape &shape, shapes ) {
+        shpSize += 4 + shape.contentSize();
+    }
+
+    QFile shp( m_fileName );
+    QVERIFY( shp.open( QIODevice::WriteOnly | QIODevice::Truncate ) );
+    QFile shx( QDir::tempPath() + "/ShpIndexTest.shx" );
+    QVERIFY( shx.open( QIODevice::WriteOnly | QIODevice::Truncate ) );
+
+    QDataStream shpStream( &shp );
+    shpStream.setFloatingPointPrecision( QDataStream::DoublePrecision );
+    writeHeader( shpStream, shpSize );
+    QDataStream shxStream( &shx );
+    shxStream.setFloatingPointPrecision( QDataStream::DoublePrecision );
+    writeHeader( shxStream, 50 + 4 * shapes.size() );
+
+    int offset = 50;
+    for ( int i = 0; i < shapes.size(); ++i ) {
+        const Shape &shape = shapes.at( i );
+
+        shxStream.setByteOrder( QDataStream::BigEndian );
+        shxStream << qint32( offset ) << qint32( shape.contentSize() );
+
+        shpStream.setByteOrder( QDataStream::BigEndian );
+        shpStream << qint32( i + 1 ) << qint32( shape.contentSize() );
+        shpStream.setByteOrder( QDataStream::LittleEndian );
+        shpStream << qint32( shape.type );
+        if ( shape.type == Shape::Point ) {
+            shpStream << shape.west << shape.south;
+        } else if ( shape.type == Shape::Polygon ) {
+            // One ring around the box
+            shpStream << shape.west << shape.south << shape.east << shape.north;
+            shpStream << qint32( 1 ) << qint32( 5 ) << qint32( 0 );
+            shpStream << shape.west << shape.south << shape.west << shape.north
+                      << shape.east << shape.north << shape.east << shape.south
+                      << shape.west << shape.south;
+        }
+
+        offset += 4 + shape.contentSize();
+    }
+
+    QVERIFY( shp.flush() );
+    QCOMPARE( shp.size(), 2 * qint64( shpSize ) );
+}
+
+void ShpIndexTest::build()
+{
+    QFile::remove( ShpIndex::indexFileName( m_fileName ) );
+    writeShapefile( QList<Shape>() << Shape( Shape::Polygon, 13, 52, 14, 53 )
+                                   << Shape( Shape::Null )
+                                   << Shape( Shape::Point, 2.35, 48.85 ) );
+
+    ShpIndex index;
+    QVERIFY( index.load( m_fileName ) );
+    QCOMPARE( index.size(), 3 );
+    QVERIFY( QFile::exists( ShpIndex::indexFileName( m_fileName ) ) );
+
+    // Null shapes are never part of a region
+    const GeoDataLatLonBox world( 90, -90, 180, -180, GeoDataCoordinates::Degree );
+    QCOMPARE( index.shapes( world ), QVector<int>() << 0 << 2 );
+}
+
+void ShpIndexTest::shapes_data()
+{
+    QTest::addColumn<GeoDataLatLonBox>( "latLonBox" );
+    QTest::addColumn<QVector<int> >( "shapes" );
+
+    QTest::newRow( "World" ) << GeoDataLatLonBox( 90, -90, 180, -180, GeoDataCoordinates::Degree )
+                             << ( QVector<int>() << 0 << 2 << 3 << 4 );
+    QTest::newRow( "Berlin" ) << GeoDataLatLonBox( 52.6, 52.4, 13.6, 13.2, GeoDataCoordinates::Degree )
+                              << ( QVector<int>() << 0 );
+    QTest::newRow( "Paris" ) << GeoDataLatLonBox( 49, 48, 3, 2, GeoDataCoordinates::Degree )
+                             << ( QVector<int>() << 2 );
+    QTest::newRow( "Western Europe" ) << GeoDataLatLonBox( 56, 45, 5, -12, GeoDataCoordinates::Degree )
+                                      << ( QVector<int>() << 2 << 3 );
+    QTest::newRow( "Atlantic" ) << GeoDataLatLonBox( 10, 0, -20, -40, GeoDataCoordinates::Degree )
+                                << QVector<int>();
+    QTest::newRow( "Pacific" ) << GeoDataLatLonBox( 20, -20, -170, 170, GeoDataCoordinates::Degree )
+                               << ( QVector<int>() << 4 );
+}
+
+void ShpIndexTest::shapes()
+{
+    QFETCH( GeoDataLatLonBox, latLonBox );
+    QFETCH( QVector<int>, shapes );
+
+    writeShapefile( QList<Shape>() << Shape( Shape::Polygon, 13, 52, 14, 53 )
+                                   << Shape( Shape::Null )
+                                   << Shape( Shape::Point, 2.35, 48.85 )
+                                   << Shape( Shape::Polygon, -10, 51, -6, 55 )
+                                   << Shape( Shape::Polygon, -178, -18, -175, -15 ) );
+
+    ShpIndex index;
+    QVERIFY( index.load( m_fileName ) );
+    QCOMPARE( index.shapes( latLonBox ), shapes );
+}
+
+void ShpIndexTest::rebuildWhenChanged()
+{
+    writeShapefile( QList<Shape>() << Shape( Shape::Polygon, 13, 52, 14, 53 )
+                                   << Shape( Shape::Point, 2.35, 48.85 ) );
+
+    ShpIndex index;
+    QVERIFY( index.load( m_fileName ) );
+    QCOMPARE( index.size(), 2 );
+
+    // Without the .shx file the index can only come from the cache
+    QVERIFY( QFile::remove( QDir::tempPath() + "/ShpIndexTest.shx" ) );
+    ShpIndex cached;
+    QVERIFY( cached.load( m_fileName ) );
+    QCOMPARE( cached.size(), 2 );
+
+    writeShapefile( QList<Shape>() << Shape( Shape::Point, 2.35, 48.85 )
+                                   << Shape( Shape::Polygon, 13, 52, 14, 53 )
+                                   << Shape( Shape::Polygon, -10, 51, -6, 55 ) );
+
+    ShpIndex rebuilt;
+    QVERIFY( rebuilt.load( m_fileName ) );
+    QCOMPARE( rebuilt.size(), 3 );
+    const GeoDataLatLonBox berlin( 52.6, 52.4, 13.6, 13.2, GeoDataCoordinates::Degree );
+    QCOMPARE( rebuilt.shapes( berlin ), QVector<int>() << 1 );
+}
+
+void ShpIndexTest::manyShapes()
+{
+    // Small boxes and points all over the world, and some large boxes
+    qsrand( 42 );
+    QList<Shape> shapes;
+    for ( int i = 0; i < 5000; ++i ) {
+        const double west = -180 + 359.0 * ( qrand() % 10000 ) / 10000.0;
+        const double south = -90 + 179.0 * ( qrand() % 10000 ) / 10000.0;
+        const double size = i % 100 == 0 ? 60 : 0.5 * ( qrand() % 10 );
+        if ( size == 0 ) {
+            shapes << Shape( Shape::Point, west, south );
+        } else {
+            shapes << Shape( Shape::Polygon, west, south, qMin( 180.0, west + size ), qMin( 90.0, south + size ) );
+        }
+    }
+    writeShapefile( shapes );
+
+    ShpIndex index;
+    QVERIFY( index.load( m_fileName ) );
+    QCOMPARE( index.size(), shapes.size() );
+
+    const QList<GeoDataLatLonBox> boxes = QList<GeoDataLatLonBox>()
+        << GeoDataLatLonBox( 90, -90, 180, -180, GeoDataCoordinates::Degree )
+        << GeoDataLatLonBox( 52.6, 52.4, 13.6, 13.2, GeoDataCoordinates::Degree )
+        << GeoDataLatLonBox( 56, 45, 5, -12, GeoDataCoordinates::Degree )
+        << GeoDataLatLonBox( 20, -20, -170, 170, GeoDataCoordinates::Degree )
+        << GeoDataLatLonBox( -80, -90, 180, -180, GeoDataCoordinates::Degree );
+
+    // The grid must find exactly what looking at each shape finds
+    foreach ( const GeoDataLatLonBox &box, boxes ) {
+        QVector<int> expected;
+        for ( int i = 0; i < shapes.size(); ++i ) {
+            const Shape &shape = shapes.at( i );
+            const double east = shape.type == Shape::Point ? shape.west : shape.east;
+            const double north = shape.type == Shape::Point ? shape.south : shape.north;
+            const GeoDataLatLonBox shapeBox( north, shape.south, east, shape.west, GeoDataCoordinates::Degree );
+            if ( box.intersects( shapeBox ) ) {
+                expected << i;
+            }
+        }
+
+        QCOMPARE( index.shapes( box ), expected );
+    }
+}
+}
+
+QTEST_MAIN( Marble::ShpIndexTest )
+
+#include "ShpIndexTest.moc"
@@ -38,6 +38,8 @@
 #include "GeoDataStyleMap.h"
 
 // misc:
+#include "GeoDataData.h"
+#include "GeoDataExtendedData.h"
 #include "GeoDataHotSpot.h"
 #include "GeoDataLatLonBox.h"
 #include "GeoDataLatLonAltBox.h"
@@ -70,6 +72,8 @@ class TestGeoDataCopy : public QObject
         void copyDocument();
         void copyFolder();
         void copyPlacemark();
+        void createPlacemarks_data();
+        void createPlacemarks();
 
         // StyleSelector:
         void copyStyle();
@@ -447,6 +451,17 @@ void TestGeoDataCopy::copyPlacemark()
     QCOMPARE(placemark.population(), (qint64)123456789);
     QCOMPARE(placemark.name(), QString::fromLatin1("Patrick Spendrin"));
     QCOMPARE(other.name(), QString::fromLatin1("Patrick Spendrin"));
+
+    GeoDataExtendedData extendedData;
+    extendedData.addValue(GeoDataData("gmt", 1));
+    placemark.setExtendedData(extendedData);
+    GeoDataPlacemark third = placemark;
+    extendedData.addValue(GeoDataData("dst", 0));
+    third.setExtendedData(extendedData);
+
+    QCOMPARE(placemark.extendedData().size(), 1);
+    QCOMPARE(third.extendedData().size(), 2);
+    QCOMPARE(other.extendedData().size(), 0);
 }
 
 void TestGeoDataCopy::copyHotSpot()
@@ -620,6 +635,48 @@ void TestGeoDataCopy::copyPolyStyle()
     QVERIFY(other.color() == Qt::blue);
 }
 
+void TestGeoDataCopy::createPlacemarks_data()
+{
+    QTest::addColumn<bool>("optionalMembers");
+
+    // Features used to create all optional members when they were
+    // constructed, now they only create the ones they use
+    QTest::newRow("Created on demand") << false;
+    QTest::newRow("Created up front") << true;
+}
+
+void TestGeoDataCopy::createPlacemarks()
+{
+    QFETCH(bool, optionalMembers);
+
+    QBENCHMARK {
+        QVector<GeoDataPlacemark*> placemarks;
+        placemarks.reserve(20000);
+        for (int i = 0; i < 10000; ++i) {
+            GeoDataPlacemark *placemark = new GeoDataPlacemark("Placemark");
+            placemark->setCoordinate(0.001 * i, 0.0005 * i);
+            if (optionalMembers) {
+                placemark->timeSpan();
+                placemark->timeStamp();
+                placemark->extendedData();
+                placemark->region();
+            }
+            placemarks << placemark;
+
+            // Detaching copies whichever optional members exist
+            GeoDataPlacemark *copy = new GeoDataPlacemark(*placemark);
+            copy->setName("Copy");
+            placemarks << copy;
+        }
+
+        QCOMPARE(placemarks.last()->hasTimeSpan(), optionalMembers);
+        QCOMPARE(placemarks.last()->hasTimeStamp(), optionalMembers);
+        QCOMPARE(placemarks.last()->hasExtendedData(), optionalMembers);
+        QCOMPARE(placemarks.last()->hasRegion(), optionalMembers);
+        qDeleteAll(placemarks);
+    }
+}
+
 void TestGeoDataCopy::copyStyleMap()
 {
     GeoDataStyleMap styleMap;
@@ -18,7 +18,13 @@
 #include "MarbleDirs.h"
 #include "GeoDataParser.h"
 #include "GeoDataDocument.h"
+#include "GeoDataExtendedData.h"
+#include "GeoDataFolder.h"
+#include "GeoDataMultiGeometry.h"
 #include "GeoDataPlacemark.h"
+#include "GeoDataStyle.h"
+#include "GeoDataStyleMap.h"
+#include "GeoDataTrack.h"
 #include "GeoDataTypes.h"
 #include "GeoWriter.h"
 
@@ -34,6 +40,7 @@ class TestGeoDataPack : public QObject
         void loadKMLFromCache();
         void saveCitiesToCache();
         void loadCitiesFromCache();
+        void packDocument();
 
     private:
         QString content;
@@ -236,6 +243,98 @@ void TestGeoDataPack::loadCitiesFromCache()
 
 }
 
+void TestGeoDataPack::packDocument()
+{
+    QString content(
+"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+"<kml xmlns=\"http://www.opengis.net/kml/2.2\" xmlns:gx=\"http://www.google.com/kml/ext/2.2\">\n"
+"  <Document>\n"
+"    <Style id=\"red\">\n"
+"      <LineStyle><color>ff0000ff</color><width>3</width></LineStyle>\n"
+"    </Style>\n"
+"    <StyleMap id=\"redMap\">\n"
+"      <Pair><key>normal</key><styleUrl>#red</styleUrl></Pair>\n"
+"    </StyleMap>\n"
+"    <Folder>\n"
+"      <Placemark>\n"
+"        <name>Track</name>\n"
+"        <styleUrl>#red</styleUrl>\n"
+"        <ExtendedData><Data name=\"speed\"><value>12</value></Data></ExtendedData>\n"
+"        <gx:Track>\n"
+"          <when>2010-05-28T02:02:09Z</when>\n"
+"          <when>2010-05-28T02:02:35Z</when>\n"
+"          <gx:coord>-122.207881 37.371915 156.0</gx:coord>\n"
+"          <gx:coord>-122.205712 37.373288 152.0</gx:coord>\n"
+"        </gx:Track>\n"
+"      </Placemark>\n"
+"      <Placemark>\n"
+"        <name>Multi</name>\n"
+"        <MultiGeometry>\n"
+"          <Point><coordinates>13.4,52.5</coordinates></Point>\n"
+"          <LineString><coordinates>13.4,52.5 13.5,52.6</coordinates></LineString>\n"
+"        </MultiGeometry>\n"
+"      </Placemark>\n"
+"      <Placemark>\n"
+"        <name>Inline</name>\n"
+"        <Style><LineStyle><width>5</width></LineStyle></Style>\n"
+"        <LineString><coordinates>13.4,52.5 13.5,52.6</coordinates></LineString>\n"
+"      </Placemark>\n"
+"    </Folder>\n"
+"  </Document>\n"
+"</kml>" );
+
+    GeoDataParser parser( GeoData_KML );
+    QByteArray array( content.toUtf8() );
+    QBuffer buffer( &array );
+    buffer.open( QIODevice::ReadOnly );
+    QVERIFY( parser.read( &buffer ) );
+    GeoDataDocument *dataDocument = static_cast<GeoDataDocument*>( parser.releaseDocument() );
+    QVERIFY( dataDocument );
+
+    QByteArray data;
+    QDataStream out( &data, QIODevice::WriteOnly );
+    dataDocument->pack( out );
+    delete dataDocument;
+
+    GeoDataDocument cacheDocument;
+    QDataStream in( data );
+    cacheDocument.unpack( in );
+    QCOMPARE( in.status(), QDataStream::Ok );
+    QVERIFY( in.atEnd() );
+
+    QCOMPARE( cacheDocument.style( "red" ).lineStyle().width(), float( 3 ) );
+    QCOMPARE( cacheDocument.styleMap( "redMap" ).value( "normal" ), QString( "#red" ) );
+
+    QCOMPARE( cacheDocument.folderList().size(), 1 );
+    GeoDataFolder *folder = cacheDocument.folderList().first();
+    QCOMPARE( folder->placemarkList().size(), 3 );
+
+    GeoDataPlacemark *trackPlacemark = folder->placemarkList().at( 0 );
+    QCOMPARE( trackPlacemark->styleUrl(), QString( "#red" ) );
+    QCOMPARE( trackPlacemark->extendedData().value( "speed" ).value().toString(), QString( "12" ) );
+    QCOMPARE( trackPlacemark->geometry()->nodeType(), GeoDataTypes::GeoDataTrackType );
+    const GeoDataTrack *track = static_cast<const GeoDataTrack*>( trackPlacemark->geometry() );
+    QCOMPARE( track->size(), 2 );
+    QCOMPARE( track->lastWhen(), QDateTime( QDate( 2010, 5, 28 ), QTime( 2, 2, 35 ), Qt::UTC ) );
+    QCOMPARE( track->coordinatesAt( 1 ).altitude(), 152.0 );
+
+    GeoDataPlacemark *multiPlacemark = folder->placemarkList().at( 1 );
+    QCOMPARE( multiPlacemark->geometry()->nodeType(), GeoDataTypes::GeoDataMultiGeometryType );
+    const GeoDataMultiGeometry *multiGeometry = static_cast<const GeoDataMultiGeometry*>( multiPlacemark->geometry() );
+    QCOMPARE( multiGeometry->size(), 2 );
+    QCOMPARE( multiGeometry->child( 1 )->nodeType(), GeoDataTypes::GeoDataLineStringType );
+
+    // Copies share the inline style the placemark owns
+    GeoDataFeature *const inlinePlacemark = folder->child( 2 );
+    GeoDataPlacemark copy( *static_cast<GeoDataPlacemark*>( inlinePlacemark ) );
+    copy.setName( "Copy" );
+    folder->remove( 2 );
+    delete inlinePlacemark;
+    QCOMPARE( copy.style()->lineStyle().width(), float( 5 ) );
+}
+
+}
+
 QTEST_MAIN( Marble::TestGeoDataPack )
 
 #include "TestGeoDataPack.moc"
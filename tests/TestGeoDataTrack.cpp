@@ -35,6 +35,9 @@ private slots:
     void removeAfterTest();
     void extendedDataParseTest();
     void withoutTimeTest();
+    void interpolateTest();
+    void coordinatesAtBenchmark_data();
+    void coordinatesAtBenchmark();
 };
 
 void TestGeoDataTrack::initTestCase()
@@ -334,7 +337,85 @@ void TestGeoDataTrack::withoutTimeTest()
     delete dataDocument;
 }
 
+void TestGeoDataTrack::interpolateTest()
+{
+    const QDateTime start( QDate( 2011, 6, 24 ), QTime( 10, 0, 0 ), Qt::UTC );
+
+    // Added in time order and in reverse order with an extra point without time
+    GeoDataTrack sorted;
+    GeoDataTrack unsorted;
+    for ( int i = 0; i < 5; ++i ) {
+        sorted.addPoint( start.addSecs( 10 * i ), GeoDataCoordinates( i, 0, 10 * i, GeoDataCoordinates::Degree ) );
+    }
+    for ( int i = 4; i >= 0; --i ) {
+        unsorted.appendWhen( start.addSecs( 10 * i ) );
+        unsorted.appendCoordinates( GeoDataCoordinates( i, 0, 10 * i, GeoDataCoordinates::Degree ) );
+    }
+    unsorted.appendWhen( QDateTime() );
+    unsorted.appendCoordinates( GeoDataCoordinates( 90, 0, 0, GeoDataCoordinates::Degree ) );
+
+    QList<GeoDataTrack *> tracks;
+    tracks << &sorted << &unsorted;
+    foreach ( GeoDataTrack *track, tracks ) {
+        QCOMPARE( track->coordinatesAt( start.addSecs( 20 ) ).longitude( GeoDataCoordinates::Degree ), 2.0 );
+        QVERIFY( !track->coordinatesAt( start.addSecs( 15 ) ).isValid() );
+
+        track->setInterpolate( true );
+        const GeoDataCoordinates coordinates = track->coordinatesAt( start.addSecs( 15 ) );
+        QVERIFY( qAbs( coordinates.longitude( GeoDataCoordinates::Degree ) - 1.5 ) < 1e-6 );
+        QVERIFY( qAbs( coordinates.altitude() - 15.0 ) < 1e-6 );
+        QVERIFY( !track->coordinatesAt( start.addSecs( -5 ) ).isValid() );
+        QVERIFY( !track->coordinatesAt( start.addSecs( 45 ) ).isValid() );
+    }
+
+    // The line string follows appended points
+    QCOMPARE( sorted.lineString()->size(), 5 );
+    sorted.addPoint( start.addSecs( 50 ), GeoDataCoordinates( 5, 0, 50, GeoDataCoordinates::Degree ) );
+    QCOMPARE( sorted.lineString()->size(), 6 );
+    QCOMPARE( sorted.lineString()->last().longitude( GeoDataCoordinates::Degree ), 5.0 );
+    sorted.addPoint( start.addSecs( 5 ), GeoDataCoordinates( 0.5, 0, 5, GeoDataCoordinates::Degree ) );
+    QCOMPARE( sorted.lineString()->size(), 7 );
+    QCOMPARE( sorted.lineString()->at( 1 ).longitude( GeoDataCoordinates::Degree ), 0.5 );
+    sorted.removeBefore( start.addSecs( 20 ) );
+    QCOMPARE( sorted.lineString()->size(), 4 );
+    QCOMPARE( sorted.lineString()->at( 0 ).longitude( GeoDataCoordinates::Degree ), 2.0 );
+}
+
+void TestGeoDataTrack::coordinatesAtBenchmark_data()
+{
+    QTest::addColumn<int>( "size" );
+
+    QTest::newRow( "1000 points" ) << 1000;
+    QTest::newRow( "1000000 points" ) << 1000000;
+}
+
+void TestGeoDataTrack::coordinatesAtBenchmark()
+{
+    QFETCH( int, size );
+
+    const QDateTime start( QDate( 2011, 6, 24 ), QTime( 10, 0, 0 ), Qt::UTC );
+
+    QTime time;
+    time.start();
+
+    GeoDataTrack track;
+    track.setInterpolate( true );
+    for ( int i = 0; i < size; ++i ) {
+        track.addPoint( start.addSecs( 2 * i ),
+                        GeoDataCoordinates( 0.0001 * i, 0.00005 * i, 0, GeoDataCoordinates::Degree ) );
+    }
+    QCOMPARE( track.lineString()->size(), size );
+    qDebug() << "Added" << size << "points in" << time.elapsed() << "ms";
+
+    // Times between two points, spread over the whole track
+    const int step = size / 1000;
+    QBENCHMARK {
+        for ( int i = 0; i < 1000; ++i ) {
+            QVERIFY( track.coordinatesAt( start.addSecs( 2 * i * step + 1 ) ).isValid() );
+        }
+    }
+}
+
 QTEST_MAIN( TestGeoDataTrack )
 
 #include "TestGeoDataTrack.moc"
-
@@ -0,0 +1,200 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include <QtTest/QtTest>
+#include <QtCore/QBuffer>
+#include <QtCore/QByteArray>
+#include <QtCore/QTime>
+
+#include "GeoDataDocument.h"
+#include "GeoDataLineString.h"
+#include "GeoDataParser.h"
+#include "GeoDataPlacemark.h"
+#include "GeoDataTrack.h"
+
+namespace Marble
+{
+
+class TestKmlCoordinates : public QObject
+{
+    Q_OBJECT
+
+ private slots:
+    void lineString_data();
+    void lineString();
+
+    void track_data();
+    void track();
+
+    void throughput_data();
+    void throughput();
+
+ private:
+    static GeoDataDocument *parseKml( const QByteArray &content );
+    static GeoDataGeometry *firstGeometry( GeoDataDocument *document );
+};
+
+GeoDataDocument *TestKmlCoordinates::parseKml( const QByteArray &content )
+{
+    GeoDataParser parser( GeoData_KML );
+
+    QByteArray array( content );
+    QBuffer buffer( &array );
+    buffer.open( QIODevice::ReadOnly );
+    if ( !parser.read( &buffer ) ) {
+        return 0;
+    }
+
+    return static_cast<GeoDataDocument *>( parser.releaseDocument() );
+}
+
+GeoDataGeometry *TestKmlCoordinates::firstGeometry( GeoDataDocument *document )
+{
+    if ( !document || document->placemarkList().isEmpty() ) {
+        return 0;
+    }
+
+    return document->placemarkList().first()->geometry();
+}
+
+void TestKmlCoordinates::lineString_data()
+{
+    QTest::addColumn<QString>( "coordinates" );
+    QTest::addColumn<int>( "size" );
+    QTest::addColumn<qreal>( "lon" );
+    QTest::addColumn<qreal>( "lat" );
+    QTest::addColumn<qreal>( "alt" );
+
+    QTest::newRow( "two components" ) << "13.5,52.25 14,53" << 2 << 13.5 << 52.25 << 0.0;
+    QTest::newRow( "three components" ) << "-122.365662,37.826988,12.5" << 1 << -122.365662 << 37.826988 << 12.5;
+    QTest::newRow( "line breaks" ) << "\n\t 1,2,3\n\t 4,5,6\n\t 7,8,9\n" << 3 << 1.0 << 2.0 << 3.0;
+    QTest::newRow( "spaces around commas" ) << "1 , 2 ,3   4,  5" << 2 << 1.0 << 2.0 << 3.0;
+    QTest::newRow( "exponent" ) << "1.5e1,-2E-1" << 1 << 15.0 << -0.2 << 0.0;
+    QTest::newRow( "long mantissa" ) << "0.12345678901234567890,1" << 1 << 0.12345678901234567890 << 1.0 << 0.0;
+    QTest::newRow( "no number" ) << "a,b,c" << 1 << 0.0 << 0.0 << 0.0;
+    QTest::newRow( "four components" ) << "1,2,3,4" << 1 << 0.0 << 0.0 << 0.0;
+    QTest::newRow( "empty" ) << "" << 1 << 0.0 << 0.0 << 0.0;
+}
+
+void TestKmlCoordinates::lineString()
+{
+    QFETCH( QString, coordinates );
+    QFETCH( int, size );
+    QFETCH( qreal, lon );
+    QFETCH( qreal, lat );
+    QFETCH( qreal, alt );
+
+    const QByteArray content =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+        "<kml xmlns=\"http://www.opengis.net/kml/2.2\"><Document><Placemark><LineString>"
+        "<coordinates>" + coordinates.toUtf8() + "</coordinates>"
+        "</LineString></Placemark></Document></kml>";
+
+    GeoDataDocument *const document = parseKml( content );
+    const GeoDataLineString *const lineString = dynamic_cast<GeoDataLineString *>( firstGeometry( document ) );
+    QVERIFY( lineString );
+    QCOMPARE( lineString->size(), size );
+
+    const GeoDataCoordinates &first = lineString->first();
+    QCOMPARE( first.longitude( GeoDataCoordinates::Degree ), lon );
+    QCOMPARE( first.latitude( GeoDataCoordinates::Degree ), lat );
+    QCOMPARE( first.altitude(), alt );
+
+    delete document;
+}
+
+void TestKmlCoordinates::track_data()
+{
+    QTest::addColumn<QString>( "coord" );
+    QTest::addColumn<qreal>( "lon" );
+    QTest::addColumn<qreal>( "lat" );
+    QTest::addColumn<qreal>( "alt" );
+
+    QTest::newRow( "three values" ) << "-122.207881 37.371915 156.000000" << -122.207881 << 37.371915 << 156.0;
+    QTest::newRow( "two values" ) << " 8.4 49.0 " << 8.4 << 49.0 << 0.0;
+    QTest::newRow( "commas" ) << "8.4,49.0,100" << 0.0 << 0.0 << 0.0;
+}
+
+void TestKmlCoordinates::track()
+{
+    QFETCH( QString, coord );
+    QFETCH( qreal, lon );
+    QFETCH( qreal, lat );
+    QFETCH( qreal, alt );
+
+    const QByteArray content =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+        "<kml xmlns=\"http://www.opengis.net/kml/2.2\" xmlns:gx=\"http://www.google.com/kml/ext/2.2\">"
+        "<Document><Placemark><gx:Track><when>2010-05-28T02:02:09Z</when>"
+        "<gx:coord>" + coord.toUtf8() + "</gx:coord>"
+        "</gx:Track></Placemark></Document></kml>";
+
+    GeoDataDocument *const document = parseKml( content );
+    const GeoDataTrack *const track = dynamic_cast<GeoDataTrack *>( firstGeometry( document ) );
+    QVERIFY( track );
+    QCOMPARE( track->size(), 1 );
+
+    const GeoDataCoordinates coordinates = track->coordinatesList().first();
+    QCOMPARE( coordinates.longitude( GeoDataCoordinates::Degree ), lon );
+    QCOMPARE( coordinates.latitude( GeoDataCoordinates::Degree ), lat );
+    QCOMPARE( coordinates.altitude(), alt );
+
+    delete document;
+}
+
+void TestKmlCoordinates::throughput_data()
+{
+    QTest::addColumn<int>( "lineStrings" );
+    QTest::addColumn<int>( "nodes" );
+
+    // Country borders have few but long line strings, GPS tracks just one
+    QTest::newRow( "borders" ) << 200 << 2000;
+    QTest::newRow( "track" ) << 1 << 200000;
+}
+
+void TestKmlCoordinates::throughput()
+{
+    QFETCH( int, lineStrings );
+    QFETCH( int, nodes );
+
+    qsrand( nodes );
+
+    QByteArray content = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+                         "<kml xmlns=\"http://www.opengis.net/kml/2.2\"><Document>";
+    for ( int i = 0; i < lineStrings; ++i ) {
+        content += "<Placemark><LineString><coordinates>\n";
+        for ( int j = 0; j < nodes; ++j ) {
+            content += QByteArray::number( -180.0 + 360.0 * qrand() / RAND_MAX, 'f', 6 ) + ','
+                       + QByteArray::number( -90.0 + 180.0 * qrand() / RAND_MAX, 'f', 6 ) + ','
+                       + QByteArray::number( qrand() % 1000 ) + '\n';
+        }
+        content += "</coordinates></LineString></Placemark>\n";
+    }
+    content += "</Document></kml>";
+
+    QTime time;
+    time.start();
+    int runs = 0;
+
+    QBENCHMARK {
+        GeoDataDocument *const document = parseKml( content );
+        QVERIFY( document );
+        QCOMPARE( document->placemarkList().size(), lineStrings );
+        delete document;
+        ++runs;
+    }
+
+    const int elapsed = qMax( 1, time.elapsed() );
+    qDebug() << content.size() / 1048576.0 * runs * 1000 / elapsed << "MB/s";
+}
+
+}
+
+QTEST_MAIN( Marble::TestKmlCoordinates )
+
+#include "TestKmlCoordinates.moc"
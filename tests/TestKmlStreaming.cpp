@@ -0,0 +1,128 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include <QtTest/QtTest>
+#include <QtCore/QBuffer>
+#include <QtCore/QByteArray>
+
+#include "GeoDataDocument.h"
+#include "GeoDataFolder.h"
+#include "GeoDataParser.h"
+#include "GeoDataPlacemark.h"
+
+namespace Marble
+{
+
+/**
+ * Takes the finished top-level features out of the document while it is
+ * parsed, the way streaming runners do.
+ */
+class FeatureCollector : public GeoParserListener
+{
+ public:
+    explicit FeatureCollector( int limit )
+        : m_limit( limit ),
+          m_calls( 0 )
+    {
+    }
+
+    ~FeatureCollector()
+    {
+        qDeleteAll( m_features );
+    }
+
+    virtual bool documentChildParsed( GeoParser &parser )
+    {
+        ++m_calls;
+
+        GeoDataDocument *const document = static_cast<GeoDataDocument *>( parser.activeDocument() );
+        m_features += document->featureList();
+        while ( document->size() > 0 ) {
+            document->remove( document->size() - 1 );
+        }
+
+        return m_features.size() < m_limit;
+    }
+
+    int m_limit;
+    int m_calls;
+    QVector<GeoDataFeature *> m_features;
+};
+
+class TestKmlStreaming : public QObject
+{
+    Q_OBJECT
+
+ private slots:
+    void topLevelFeatures();
+    void cancel();
+
+ private:
+    static QByteArray kml();
+};
+
+QByteArray TestKmlStreaming::kml()
+{
+    return "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+           "<kml xmlns=\"http://www.opengis.net/kml/2.2\"><Document>"
+           "<name>Streamed</name>"
+           "<Style id=\"red\"><LineStyle><color>ff0000ff</color></LineStyle></Style>"
+           "<Placemark><name>first</name><styleUrl>#red</styleUrl><Point><coordinates>1,2</coordinates></Point></Placemark>"
+           "<Folder><name>folder</name>"
+           "<Placemark><name>nested 1</name><Point><coordinates>3,4</coordinates></Point></Placemark>"
+           "<Placemark><name>nested 2</name><Point><coordinates>5,6</coordinates></Point></Placemark>"
+           "</Folder>"
+           "<Placemark><name>last</name><Point><coordinates>7,8</coordinates></Point></Placemark>"
+           "</Document></kml>";
+}
+
+void TestKmlStreaming::topLevelFeatures()
+{
+    QByteArray content = kml();
+    QBuffer buffer( &content );
+    buffer.open( QIODevice::ReadOnly );
+
+    FeatureCollector collector( 1000 );
+    GeoDataParser parser( GeoData_KML );
+    parser.setListener( &collector );
+    QVERIFY( parser.read( &buffer ) );
+
+    // Called for name, Style and the three features, but not for nested elements
+    QCOMPARE( collector.m_calls, 5 );
+    QCOMPARE( collector.m_features.size(), 3 );
+    QCOMPARE( collector.m_features.at( 0 )->name(), QString( "first" ) );
+    QCOMPARE( collector.m_features.at( 1 )->name(), QString( "folder" ) );
+    QCOMPARE( static_cast<GeoDataFolder *>( collector.m_features.at( 1 ) )->size(), 2 );
+    QCOMPARE( collector.m_features.at( 2 )->name(), QString( "last" ) );
+
+    GeoDataDocument *const document = static_cast<GeoDataDocument *>( parser.releaseDocument() );
+    QCOMPARE( document->name(), QString( "Streamed" ) );
+    QCOMPARE( document->size(), 0 );
+    delete document;
+}
+
+void TestKmlStreaming::cancel()
+{
+    QByteArray content = kml();
+    QBuffer buffer( &content );
+    buffer.open( QIODevice::ReadOnly );
+
+    FeatureCollector collector( 1 );
+    GeoDataParser parser( GeoData_KML );
+    parser.setListener( &collector );
+    QVERIFY( !parser.read( &buffer ) );
+
+    QCOMPARE( collector.m_features.size(), 1 );
+    QCOMPARE( collector.m_features.first()->name(), QString( "first" ) );
+}
+
+}
+
+QTEST_MAIN( Marble::TestKmlStreaming )
+
+#include "TestKmlStreaming.moc"
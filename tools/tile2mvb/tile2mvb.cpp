@@ -0,0 +1,93 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+// Converts vector tiles that Marble's parse runners can read (like .js or
+// .kml tiles) to the Marble Vector Binary format. Given a directory, all
+// .js and .kml files below it get a .mvb file next to them.
+
+#include <GeoDataDocument.h>
+#include <MarbleRunnerManager.h>
+#include <PluginManager.h>
+
+#include "MvbWriter.h"
+
+#include <QtCore/QDirIterator>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtGui/QApplication>
+#include <iostream>
+
+using namespace std;
+using namespace Marble;
+
+bool convert( const PluginManager &pluginManager, const QString &input, const QString &output, int &skipped )
+{
+  // A manager keeps its last result, so use a new one for each file
+  MarbleRunnerManager manager( &pluginManager );
+  GeoDataDocument* document = manager.openFile( input );
+  if ( !document ) {
+    cerr << "Could not parse " << input.toStdString() << endl;
+    return false;
+  }
+
+  QFile file( output );
+  MvbWriter writer;
+  bool success = file.open( QIODevice::WriteOnly ) && writer.write( &file, *document );
+  if ( !success ) {
+    cerr << "Unable to write to " << output.toStdString() << endl;
+  } else if ( writer.skippedCount() > 0 ) {
+    cerr << "Skipped " << writer.skippedCount() << " placemarks of " << input.toStdString()
+         << " with unsupported geometries" << endl;
+    skipped += writer.skippedCount();
+  }
+
+  delete document;
+  return success;
+}
+
+QString mvbFileName( const QString &fileName )
+{
+  QFileInfo const info( fileName );
+  return info.path() + '/' + info.completeBaseName() + ".mvb";
+}
+
+int main(int argc, char** argv)
+{
+  QApplication app( argc, argv, false );
+
+  if ( argc < 2 || argc > 3 ) {
+    cout << "Usage: " << argv[0] << " input.js|input.kml [output.mvb]" << endl;
+    cout << "       " << argv[0] << " tile-directory" << endl;
+    return 1;
+  }
+
+  PluginManager pluginManager;
+
+  QString const input = QString::fromLocal8Bit( argv[1] );
+  if ( !QFileInfo( input ).isDir() ) {
+    QString const output = argc == 3 ? QString::fromLocal8Bit( argv[2] ) : mvbFileName( input );
+    int skipped = 0;
+    return convert( pluginManager, input, output, skipped ) ? 0 : 2;
+  }
+
+  int failed = 0;
+  int skipped = 0;
+  QDirIterator it( input, QStringList() << "*.js" << "*.kml", QDir::Files, QDirIterator::Subdirectories );
+  while ( it.hasNext() ) {
+    QString const fileName = it.next();
+    if ( !convert( pluginManager, fileName, mvbFileName( fileName ), skipped ) ) {
+      ++failed;
+    }
+  }
+
+  if ( skipped > 0 ) {
+    cerr << "Skipped " << skipped << " placemarks in total" << endl;
+  }
+
+  return failed == 0 ? 0 : 2;
+}